@@ -0,0 +1,206 @@
+#define _POSIX_C_SOURCE 199309L  /* clock_gettime */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "src/pdt.h"
+
+/*
+ * C consumer of libpdt.so (src/pdt.h), built as plain C against the shared library the
+ * way another runtime would call it. Tiles a numeric CSV (features then a label column)
+ * into a matrix of --rows rows and scores it through the C API in each layout:
+ *   copy        one packed heap copy and one pdt_predict call per row (the marshaling cost
+ *               the API avoids, as when filling a DataVector per row)
+ *   row_major   pdt_predict on the buffer as is, label column included (cols > features)
+ *   row_padded  pdt_predict on rows of a wider matrix (row_stride > cols)
+ *   col_major   pdt_predict_colmajor on the transposed buffer
+ * Every layout must agree with the copy path bit for bit, and the error paths must return
+ * their codes. Reports the best of --repeats runs per layout.
+ *
+ *   gcc -std=c99 -O2 benchmark_c_api.c -o benchmark_c_api -L. -lpdt -Wl,-rpath,'$ORIGIN'
+ *   ./benchmark_c_api [--model results/hmeq_model.bin] [--data data/hmeq_clean.csv]
+ *                     [--rows 1000000] [--repeats 5]
+ */
+
+#define PAD_COLUMNS 4
+
+typedef struct {
+    const char* layout;
+    double seconds;
+    int agrees;
+} CApiResult;
+
+static double now_seconds(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static double* read_csv(const char* path, size_t* rows, size_t* cols)
+{
+    /* Read a CSV of numbers (no header) into a row-major buffer; NULL on error. */
+    FILE* file = fopen(path, "r");
+    if (file == NULL) { return NULL; }
+    size_t capacity = 1024, count = 0, width = 0, row_cells = 0;
+    double* values = malloc(capacity * sizeof(double));
+    double value;
+    int separator;
+    while (fscanf(file, "%lf", &value) == 1) {
+        if (count == capacity) {
+            capacity *= 2;
+            values = realloc(values, capacity * sizeof(double));
+        }
+        values[count++] = value;
+        row_cells += 1;
+        separator = fgetc(file);
+        if ((separator == '\n') || (separator == EOF)) {
+            if (width == 0) { width = row_cells; }
+            if (row_cells != width) { break; }
+            row_cells = 0;
+        }
+    }
+    fclose(file);
+    if ((width == 0) || (count % width != 0)) {
+        free(values);
+        return NULL;
+    }
+    *rows = count / width;
+    *cols = width;
+    return values;
+}
+
+static int same_predictions(const double* a, const double* b, size_t n)
+{
+    return memcmp(a, b, n * sizeof(double)) == 0;
+}
+
+static void writeResultsToCSV(const CApiResult* results, int n_results, size_t rows, size_t cols, const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) { return; }
+
+    // Write header
+    fprintf(file, "version,layout,rows,cols,seconds,rows_per_sec,speedup_vs_copy,agrees\n");
+
+    // Write data
+    for (int i = 0; i < n_results; i++) {
+        fprintf(file, "c_api,%s,%zu,%zu,%.6f,%.0f,%.2f,%d\n", results[i].layout, rows, cols, results[i].seconds,
+                rows / results[i].seconds, results[0].seconds / results[i].seconds, results[i].agrees);
+    }
+    fclose(file);
+}
+
+int main(int argc, char** argv)
+{
+    const char* model_path = "results/hmeq_model.bin";
+    const char* data_path = "data/hmeq_clean.csv";
+    size_t rows = 1000000;
+    int repeats = 5;
+    for (int i = 1; i < argc; i++) {
+        const int has_value = (i + 1 < argc);
+        if (!strcmp(argv[i], "--model") && has_value) { model_path = argv[++i]; }
+        else if (!strcmp(argv[i], "--data") && has_value) { data_path = argv[++i]; }
+        else if (!strcmp(argv[i], "--rows") && has_value) { rows = strtoul(argv[++i], NULL, 10); }
+        else if (!strcmp(argv[i], "--repeats") && has_value) { repeats = atoi(argv[++i]); }
+        else {
+            fprintf(stderr, "Error: Unknown or incomplete option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (pdt_abi_version() != PDT_ABI_VERSION) {
+        fprintf(stderr, "Error: libpdt ABI %u, built against %d\n", pdt_abi_version(), PDT_ABI_VERSION);
+        return 1;
+    }
+    pdt_model* model = NULL;
+    if (pdt_model_load(model_path, &model) != PDT_OK) {
+        fprintf(stderr, "Error: %s\n", pdt_last_error());
+        return 1;
+    }
+    size_t data_rows, cols;
+    double* data = read_csv(data_path, &data_rows, &cols);
+    if (data == NULL) {
+        fprintf(stderr, "Error: Cannot read %s\n", data_path);
+        return 1;
+    }
+    const size_t features = pdt_model_num_features(model);
+    printf("Model: %zu nodes, %zu features (%s); data: %zu columns, tiled to %zu rows\n", pdt_model_num_nodes(model),
+           features, pdt_model_is_regression(model) ? "regression" : "classification", cols, rows);
+
+    // Three layouts of the same rows
+    const size_t padded_stride = cols + PAD_COLUMNS;
+    double* row_major = malloc(rows * cols * sizeof(double));
+    double* row_padded = malloc(rows * padded_stride * sizeof(double));
+    double* col_major = malloc(rows * cols * sizeof(double));
+    for (size_t r = 0; r < rows; r++) {
+        const double* source = data + (r % data_rows) * cols;
+        for (size_t c = 0; c < cols; c++) {
+            row_major[r * cols + c] = source[c];
+            row_padded[r * padded_stride + c] = source[c];
+            col_major[c * rows + r] = source[c];
+        }
+        for (size_t c = cols; c < padded_stride; c++) { row_padded[r * padded_stride + c] = NAN; }
+    }
+    double* expected = malloc(rows * sizeof(double));
+    double* out = malloc(rows * sizeof(double));
+
+    CApiResult results[4] = {{"copy", 1e300, 1}, {"row_major", 1e300, 0}, {"row_padded", 1e300, 0}, {"col_major", 1e300, 0}};
+    int ok = 1;
+    for (int repeat = 0; repeat < repeats; repeat++) {
+        double start = now_seconds();
+        for (size_t r = 0; r < rows; r++) {
+            double* copy = malloc(features * sizeof(double));
+            memcpy(copy, row_major + r * cols, features * sizeof(double));
+            ok = ok && (pdt_predict(model, copy, 1, features, features, expected + r) == PDT_OK);
+            free(copy);
+        }
+        double seconds = now_seconds() - start;
+        if (seconds < results[0].seconds) { results[0].seconds = seconds; }
+
+        for (int layout = 1; layout < 4; layout++) {
+            memset(out, 0, rows * sizeof(double));
+            start = now_seconds();
+            pdt_status status;
+            if (layout == 1) { status = pdt_predict(model, row_major, rows, cols, cols, out); }
+            else if (layout == 2) { status = pdt_predict(model, row_padded, rows, cols, padded_stride, out); }
+            else { status = pdt_predict_colmajor(model, col_major, rows, cols, rows, out); }
+            seconds = now_seconds() - start;
+            ok = ok && (status == PDT_OK);
+            if (seconds < results[layout].seconds) { results[layout].seconds = seconds; }
+            results[layout].agrees = (status == PDT_OK) && same_predictions(expected, out, rows);
+        }
+    }
+
+    // Error paths: codes and messages, never a crash
+    pdt_model* missing = NULL;
+    const int errors_ok = (pdt_model_load("no/such/model.bin", &missing) == PDT_ERROR_IO) && (missing == NULL)
+                          && (pdt_predict(model, row_major, rows, features - 1, cols, out) == PDT_ERROR_SHAPE)
+                          && (pdt_predict(model, row_major, rows, cols, cols - 1, out) == PDT_ERROR_INVALID_ARGUMENT)
+                          && (pdt_predict_colmajor(model, col_major, rows, cols, rows - 1, out) == PDT_ERROR_INVALID_ARGUMENT)
+                          && (pdt_predict(NULL, row_major, rows, cols, cols, out) == PDT_ERROR_INVALID_ARGUMENT)
+                          && (pdt_predict(model, NULL, 0, cols, 0, NULL) == PDT_OK)
+                          && (strlen(pdt_last_error()) == 0);
+    printf("Error paths %s\n", errors_ok ? "return their codes" : "FAILED");
+
+    printf("%-12s %12s %14s %10s %8s\n", "layout", "seconds", "rows/s", "speedup", "agrees");
+    for (int i = 0; i < 4; i++) {
+        printf("%-12s %12.6f %14.0f %9.2fx %8s\n", results[i].layout, results[i].seconds, rows / results[i].seconds,
+               results[0].seconds / results[i].seconds, results[i].agrees ? "yes" : "NO");
+        ok = ok && results[i].agrees;
+    }
+    writeResultsToCSV(results, 4, rows, cols, "benchmark_results_c_api.csv");
+    printf("Results saved to benchmark_results_c_api.csv\n");
+
+    free(out);
+    free(expected);
+    free(col_major);
+    free(row_padded);
+    free(row_major);
+    free(data);
+    pdt_model_free(model);
+    return (ok && errors_ok) ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <iomanip>
+#include <functional>
+#include <random>
+#include <cstdio>
+
+// Serial implementation includes
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#include "src/model.cpp"
+#include "src/typed_tree.cpp"
+
+struct CategoricalBenchmarkResult {
+    std::string task;  // "classification" or "regression".
+    std::string engine;  // "ordinal" (codes as numbers) or "categorical" (subset splits).
+    int max_depth;
+    double train_time_ms;
+    double predict_ns_per_row;  // TreeModel::predict, per row.
+    double test_metric;  // Accuracy (classification) or mean squared error (regression).
+    int tree_size;
+    int tree_height;
+};
+
+void writeResultsToCSV(const std::vector<CategoricalBenchmarkResult>& results, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,task,engine,max_depth,train_time_ms,predict_ns_per_row,test_metric,tree_size,tree_height\n";
+
+    // Write data
+    for (const auto& r : results) {
+        file << "categorical,"
+             << r.task << ","
+             << r.engine << ","
+             << r.max_depth << ","
+             << std::fixed << std::setprecision(4) << r.train_time_ms << ","
+             << std::fixed << std::setprecision(2) << r.predict_ns_per_row << ","
+             << std::fixed << std::setprecision(4) << r.test_metric << ","
+             << r.tree_size << ","
+             << r.tree_height << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+double medianTime(const std::function<void(int)>& train, int warmup_runs = 2, int measurement_runs = 5) {
+    /** Median training time in ms; train(seed) builds one tree. */
+    for (int i = 0; i < warmup_runs; i++) {
+        train(42 + i);
+    }
+    std::vector<double> times;
+    for (int i = 0; i < measurement_runs; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        train(42 + warmup_runs + i);
+        auto end = std::chrono::high_resolution_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+void writeSyntheticCSV(const std::string& filename, bool regression, int num_rows, unsigned seed) {
+    /**
+     * Rows of {x0, city, segment, x1, label} where city (60 levels) and segment (12 levels)
+     * are strings. The label depends on membership of city in a random half of its levels,
+     * on segment through a random effect per level, and on x1, so ordinal splits on the
+     * dictionary codes need many levels to isolate the right categories.
+     */
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    const int num_cities = 60;
+    const int num_segments = 12;
+    std::mt19937 levels(7);  // Same category effects for every file.
+    std::vector<int> city_effect(num_cities);
+    for (int c = 0; c < num_cities; c++) { city_effect[c] = (levels() % 2); }
+    std::vector<double> segment_effect(num_segments);
+    for (int s = 0; s < num_segments; s++) { segment_effect[s] = std::uniform_real_distribution<double>(-1.0, 1.0)(levels); }
+
+    std::ofstream file(filename);
+    file << std::setprecision(10);
+    for (int r = 0; r < num_rows; r++) {
+        const int city = gen() % num_cities;
+        const int segment = gen() % num_segments;
+        const double x0 = noise(gen);
+        const double x1 = noise(gen);
+        const double score = 2.0*city_effect[city] - 1.0 + segment_effect[segment] + 0.5*x1;
+        file << x0 << ",city_" << city << ",segment_" << segment << "," << x1 << ",";
+        if (regression) {
+            file << score + 0.3*noise(gen) << "\n";
+        } else {
+            file << ((unit(gen) < 1.0/(1.0 + std::exp(-3.0*score))) ? 1 : 0) << "\n";
+        }
+    }
+    file.close();
+}
+
+double testMetric(bool regression, DataVector labels, DataVector predictions) {
+    /** Accuracy for classification, mean squared error for regression. */
+    if (!regression) {
+        return accuracy(labels, predictions);
+    }
+    double total = 0.0;
+    for (int i = 0; i < labels.size(); i++) {
+        double error = labels.value(i) - predictions.value(i);
+        total += error*error;
+    }
+    return total / labels.size();
+}
+
+double predictNsPerRow(const TreeModel& model, DataFrame* testdata) {
+    /** Median time of TreeModel::predict over all test rows, in ns per row. */
+    std::vector<double> observations;
+    for (int r = 0; r < testdata->length(); r++) {
+        for (int c = 0; c < model.num_features(); c++) { observations.push_back(testdata->value(r, c)); }
+    }
+    std::vector<double> times;
+    volatile double sink = 0.0;
+    for (int run = 0; run < 21; run++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < testdata->length(); r++) {
+            sink = sink + model.predict(&observations[(size_t)r*model.num_features()]);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        times.push_back(std::chrono::duration<double, std::nano>(end - start).count() / testdata->length());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+std::vector<CategoricalBenchmarkResult> testTask(bool regression) {
+    const std::string task = regression ? "regression" : "classification";
+    std::cout << "\n=== Testing synthetic " << task << " data ===" << std::endl;
+
+    // Load with DataLoader, which dictionary-encodes the string columns
+    const std::string path = "categorical_synthetic.csv";
+    writeSyntheticCSV(path, regression, 5000, regression ? 11 : 12);
+    DataLoader loader(path);
+    std::remove(path.c_str());
+    DataFrame df = loader.load();
+    std::vector<int> categorical = loader.categorical_columns();
+    std::cout << "Categorical columns:";
+    for (int c : categorical) { std::cout << " " << c << " (" << loader.categories(c).size() << " levels)"; }
+    std::cout << std::endl;
+
+    std::vector<DataFrame> split_data = df.train_test_split(0.2, 42);
+    DataFrame train_data = split_data[0];
+    DataFrame test_data = split_data[1];
+    std::cout << "Train set: " << train_data.length() << " rows, Test set: " << test_data.length() << " rows" << std::endl;
+
+    const std::string loss = regression ? "mean_squared_error" : "gini_impurity";
+    std::vector<int> depths = {3, 4, 6, 8, 12};
+    std::vector<CategoricalBenchmarkResult> results;
+    bool round_trip = true;
+    for (int depth : depths) {
+        for (bool use_categories : {false, true}) {
+            const std::vector<int> columns = use_categories ? categorical : std::vector<int>();
+            double train_ms = medianTime([&] (int seed) {
+                typed::make_tree(train_data, regression, loss, -1, depth, -1, 5, -1, seed, false, columns);
+            });
+            std::unique_ptr<typed::AnyTree> tree = typed::make_tree(train_data, regression, loss, -1, depth, -1, 5, -1, 42, false, columns);
+            TreeModel model = tree->model();
+            DataVector predictions = model.predict(&test_data);
+
+            // Serialized model must predict the same:
+            model.save("categorical_model.bin");
+            round_trip = round_trip and (TreeModel::load("categorical_model.bin").predict(&test_data).vector() == predictions.vector())
+                                    and (tree->predict(&test_data).vector() == predictions.vector());
+            std::remove("categorical_model.bin");
+
+            results.push_back({task, use_categories ? "categorical" : "ordinal", depth, train_ms,
+                               predictNsPerRow(model, &test_data),
+                               testMetric(regression, test_data.col(-1), predictions),
+                               model.size(), model.height()});
+            const CategoricalBenchmarkResult& r = results.back();
+            std::cout << "  " << std::left << std::setw(12) << r.engine << std::right
+                      << " Depth=" << std::setw(2) << r.max_depth
+                      << ", Time=" << std::fixed << std::setprecision(2) << r.train_time_ms << "ms"
+                      << ", Predict=" << std::fixed << std::setprecision(1) << r.predict_ns_per_row << "ns/row"
+                      << ", " << (regression ? "MSE" : "Accuracy") << "=" << std::fixed << std::setprecision(4) << r.test_metric
+                      << ", Size=" << r.tree_size << ", Height=" << r.tree_height << std::endl;
+        }
+    }
+    std::cout << "Model save/load round trip: " << (round_trip ? "ok" : "MISMATCH") << std::endl;
+
+    return results;
+}
+
+int main() {
+    std::cout << "=== Categorical Subset Splits vs Ordinal Codes ===" << std::endl;
+
+    std::vector<CategoricalBenchmarkResult> all_results;
+
+    std::vector<CategoricalBenchmarkResult> classification_results = testTask(false);
+    all_results.insert(all_results.end(), classification_results.begin(), classification_results.end());
+
+    std::vector<CategoricalBenchmarkResult> regression_results = testTask(true);
+    all_results.insert(all_results.end(), regression_results.begin(), regression_results.end());
+
+    // Save combined results
+    writeResultsToCSV(all_results, "benchmark_results_categorical.csv");
+
+    std::cout << "\nCategorical benchmark completed! Results saved to benchmark_results_categorical.csv" << std::endl;
+
+    return 0;
+}
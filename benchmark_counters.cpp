@@ -0,0 +1,164 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <iomanip>
+
+// This benchmark always builds with the phase instrumentation (src/perf_counters.hpp):
+#ifndef PDT_PERF_COUNTERS
+#define PDT_PERF_COUNTERS
+#endif
+
+// Serial implementation includes
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/histogram.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+
+/*
+ * Hardware counters per phase of the serial runtime tree: load (CSV parsing), presort
+ * (bitset index; quantile binning of BinnedFrame), split_search (findBestSplit), partition
+ * (DataFrame::split and child bitsets), leaf (stopping checks and leaf collection) and
+ * predict. Counts are per run (totals over the measured runs / runs). IPC and misses per
+ * thousand instructions (MPKI) tell a memory-bound phase (low IPC, high cache/dTLB MPKI)
+ * from a branch-bound one (high branch MPKI). When perf_event_open is not permitted the
+ * counter columns are empty and "counters" reads wall_clock.
+ */
+
+struct CounterBenchmarkResult {
+    std::string dataset;
+    int max_depth;  // 0 for the load and binning rows.
+    std::string phase;
+    int runs;
+    PhaseCounts counts;  // Per run.
+};
+
+void writeResultsToCSV(const std::vector<CounterBenchmarkResult>& results, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,dataset,max_depth,phase,runs,calls,wall_ms";
+    for (int c = 0; c < kNumCounters; c++) { file << "," << counter_name(c); }
+    file << ",ipc,cache_mpki,branch_mpki,dtlb_mpki,counters\n";
+
+    // Write data
+    for (const CounterBenchmarkResult& r : results) {
+        const double* counters = r.counts.counters;
+        const bool hardware = (counters[0] >= 0.0) or (counters[1] >= 0.0);
+        file << "serial,"
+             << r.dataset << ","
+             << r.max_depth << ","
+             << r.phase << ","
+             << r.runs << ","
+             << r.counts.calls << ","
+             << std::fixed << std::setprecision(4) << r.counts.wall_ns / 1e6;
+        for (int c = 0; c < kNumCounters; c++) {
+            file << ",";
+            if (counters[c] >= 0.0) { file << std::fixed << std::setprecision(0) << counters[c]; }
+        }
+        // Ratios (empty when a counter is missing):
+        const double instructions = counters[1];
+        file << ",";
+        if ((counters[0] > 0.0) and (instructions >= 0.0)) { file << std::fixed << std::setprecision(3) << instructions / counters[0]; }
+        for (int c : {2, 3, 4}) {
+            file << ",";
+            if ((instructions > 0.0) and (counters[c] >= 0.0)) { file << std::fixed << std::setprecision(3) << 1000.0 * counters[c] / instructions; }
+        }
+        file << "," << (hardware ? "hardware" : "wall_clock") << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+CounterBenchmarkResult collect(const std::string& dataset, int depth, Phase phase, int runs) {
+    /** Totals of a phase since the last PhaseProfile::reset(), per run. */
+    CounterBenchmarkResult r = {dataset, depth, phase_name(phase), runs, PhaseProfile::get(phase)};
+    r.counts.calls /= runs;
+    r.counts.wall_ns /= runs;
+    for (int c = 0; c < kNumCounters; c++) {
+        if (r.counts.counters[c] >= 0.0) { r.counts.counters[c] /= runs; }
+    }
+    return r;
+}
+
+void printResult(const CounterBenchmarkResult& r) {
+    const double* counters = r.counts.counters;
+    std::cout << "  " << std::left << std::setw(13) << r.phase << std::right
+              << " Calls=" << std::setw(6) << r.counts.calls
+              << ", Wall=" << std::fixed << std::setprecision(3) << r.counts.wall_ns / 1e6 << "ms";
+    if ((counters[0] > 0.0) and (counters[1] >= 0.0)) {
+        std::cout << ", IPC=" << std::setprecision(2) << counters[1] / counters[0];
+    }
+    for (int c : {2, 3, 4}) {
+        if ((counters[1] > 0.0) and (counters[c] >= 0.0)) {
+            std::cout << ", " << counter_name(c) << "/kinstr=" << std::setprecision(2) << 1000.0 * counters[c] / counters[1];
+        }
+    }
+    std::cout << std::endl;
+}
+
+std::vector<CounterBenchmarkResult> testDataset(const std::string& dataset_name, int runs) {
+    std::cout << "\n=== Testing Dataset: " << dataset_name << " ===" << std::endl;
+    std::vector<CounterBenchmarkResult> results;
+    const std::string path = "data/" + dataset_name + "_clean.csv";
+
+    // Loading and binning, on their own:
+    PhaseProfile::reset();
+    DataFrame data;
+    for (int i = 0; i < runs; i++) { data = DataLoader(path).load(); }
+    results.push_back(collect(dataset_name, 0, Phase::load, runs));
+    PhaseProfile::reset();
+    for (int i = 0; i < runs; i++) { BinnedFrame binned(data, 256); }
+    results.push_back(collect(dataset_name, 0, Phase::presort, runs));
+    results.back().phase = "bin";
+    std::cout << "Depth=0 (data)" << std::endl;
+    printResult(results[results.size() - 2]);
+    printResult(results.back());
+
+    std::vector<DataFrame> split_data = data.train_test_split(0.2, 42);
+    DataFrame train_data = split_data[0];
+    DataFrame test_data = split_data[1];
+    for (int depth : {2, 4, 8, 12, 20}) {
+        DecisionTree warmup_tree(train_data, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+        PhaseProfile::reset();
+        for (int i = 0; i < runs; i++) {
+            DecisionTree tree(train_data, false, "gini_impurity", -1, depth, -1, 1, -1, 42 + i);
+            tree.predict(&test_data);
+        }
+        std::cout << "Depth=" << depth << std::endl;
+        for (Phase phase : {Phase::presort, Phase::split_search, Phase::partition, Phase::leaf, Phase::predict}) {
+            results.push_back(collect(dataset_name, depth, phase, runs));
+            printResult(results.back());
+        }
+    }
+    return results;
+}
+
+int main() {
+    std::cout << "=== Hardware Counters per Training Phase ===" << std::endl;
+    if (PhaseProfile::counters_available()) {
+        std::cout << "Counters: perf_event_open (user space), one group per thread" << std::endl;
+    } else {
+        std::cout << "Counters: unavailable (perf_event_open failed; check /proc/sys/kernel/perf_event_paranoid), wall clock only" << std::endl;
+    }
+
+    const int runs = 5;
+    std::vector<CounterBenchmarkResult> all_results;
+    for (const std::string& dataset : std::vector<std::string>{"cancer", "hmeq"}) {
+        std::vector<CounterBenchmarkResult> results = testDataset(dataset, runs);
+        all_results.insert(all_results.end(), results.begin(), results.end());
+    }
+
+    // Save combined results
+    writeResultsToCSV(all_results, "benchmark_results_counters.csv");
+
+    std::cout << "\nCounter benchmark completed! Counts are per run (" << runs << " runs)." << std::endl;
+
+    return 0;
+}
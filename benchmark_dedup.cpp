@@ -0,0 +1,164 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <iomanip>
+#include <functional>
+
+// Serial implementation includes
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/histogram.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#include "src/model.cpp"
+#include "src/typed_tree.cpp"
+
+struct DedupBenchmarkResult {
+    std::string dataset;
+    int bins;  // Quantization bins per feature.
+    std::string loss;
+    int max_depth;
+    int rows;  // Training rows.
+    int distinct_rows;  // Distinct (features, label) training rows.
+    double dedup_time_ms;  // DataFrame::deduplicate.
+    double full_train_time_ms;  // Trained on every row.
+    double dedup_train_time_ms;  // Trained on distinct rows with counts.
+    double speedup;  // full / (dedup + dedup_train).
+    bool matches_full;  // Same test predictions as the tree trained on every row.
+};
+
+void writeResultsToCSV(const std::vector<DedupBenchmarkResult>& results, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,dataset,bins,loss,max_depth,rows,distinct_rows,dedup_time_ms,full_train_time_ms,dedup_train_time_ms,speedup,matches_full\n";
+
+    // Write data
+    for (const auto& r : results) {
+        file << "dedup,"
+             << r.dataset << ","
+             << r.bins << ","
+             << r.loss << ","
+             << r.max_depth << ","
+             << r.rows << ","
+             << r.distinct_rows << ","
+             << std::fixed << std::setprecision(4) << r.dedup_time_ms << ","
+             << std::fixed << std::setprecision(4) << r.full_train_time_ms << ","
+             << std::fixed << std::setprecision(4) << r.dedup_train_time_ms << ","
+             << std::fixed << std::setprecision(3) << r.speedup << ","
+             << (r.matches_full ? 1 : 0) << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+double medianTime(const std::function<void(int)>& train, int warmup_runs = 2, int measurement_runs = 5) {
+    /** Median time in ms; train(seed) runs one repetition. */
+    for (int i = 0; i < warmup_runs; i++) {
+        train(42 + i);
+    }
+    std::vector<double> times;
+    for (int i = 0; i < measurement_runs; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        train(42 + warmup_runs + i);
+        auto end = std::chrono::high_resolution_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+DataFrame quantize(const DataFrame& df, int bins) {
+    /** Replace every feature value by the upper edge of its quantile bin (BinnedFrame). */
+    BinnedFrame binned(df, bins);
+    std::vector<std::vector<double>> matrix(df.length(), std::vector<double>(df.width()));
+    for (int c = 0; c < binned.width(); c++) {
+        const uint8_t* codes = binned.codes(c);
+        for (int r = 0; r < df.length(); r++) { matrix[r][c] = binned.threshold(c, codes[r]); }
+    }
+    for (int r = 0; r < df.length(); r++) { matrix[r][df.width()-1] = df.value(r, -1); }
+    return DataFrame(matrix);
+}
+
+std::vector<DedupBenchmarkResult> testDataset(const std::string& dataset_path, const std::string& dataset_name) {
+    std::cout << "\n=== Testing " << dataset_name << " Dataset ===" << std::endl;
+
+    // Load dataset and create train/test split (80/20)
+    DataLoader loader(dataset_path);
+    DataFrame df = loader.load();
+
+    std::vector<int> bin_counts = {4, 8, 16};
+    std::vector<std::string> losses = {"gini_impurity", "mean_squared_error"};
+    std::vector<int> depths = {4, 8, 12};
+    std::vector<DedupBenchmarkResult> results;
+    for (int bins : bin_counts) {
+        std::vector<DataFrame> split_data = quantize(df, bins).train_test_split(0.2, 42);
+        DataFrame train_data = split_data[0];
+        DataFrame test_data = split_data[1];
+        std::vector<int> counts;
+        DataFrame distinct;
+        double dedup_ms = medianTime([&] (int) {
+            distinct = train_data.deduplicate(counts);
+        });
+        std::cout << bins << " bins: " << train_data.length() << " training rows, " << distinct.length() << " distinct" << std::endl;
+
+        for (const std::string& loss : losses) {
+            const bool regression = (loss == "mean_squared_error");
+            for (int depth : depths) {
+                double full_ms = medianTime([&] (int seed) {
+                    typed::make_tree(train_data, regression, loss, -1, depth, -1, 1, -1, seed);
+                });
+                double dedup_train_ms = medianTime([&] (int seed) {
+                    typed::make_tree(distinct, regression, loss, -1, depth, -1, 1, -1, seed, false, {}, counts);
+                });
+                std::unique_ptr<typed::AnyTree> full_tree = typed::make_tree(train_data, regression, loss, -1, depth, -1, 1, -1, 42);
+                std::unique_ptr<typed::AnyTree> dedup_tree = typed::make_tree(distinct, regression, loss, -1, depth, -1, 1, -1, 42, false, {}, counts);
+                const std::vector<double> full_predictions = full_tree->predict(&test_data).vector();
+                const std::vector<double> dedup_predictions = dedup_tree->predict(&test_data).vector();
+                bool matches = (full_predictions.size() == dedup_predictions.size());
+                for (size_t i = 0; matches and (i < full_predictions.size()); i++) {
+                    // Regression means are summed as count*target instead of one row at a time.
+                    matches = std::abs(full_predictions[i] - dedup_predictions[i]) <= 1e-9 * std::max(1.0, std::abs(full_predictions[i]));
+                }
+                results.push_back({dataset_name, bins, loss, depth, train_data.length(), distinct.length(), dedup_ms,
+                                   full_ms, dedup_train_ms, full_ms / (dedup_ms + dedup_train_ms), matches});
+                const DedupBenchmarkResult& r = results.back();
+                std::cout << "  " << std::left << std::setw(20) << r.loss << std::right
+                          << " Depth=" << std::setw(2) << r.max_depth
+                          << ", Full=" << std::fixed << std::setprecision(2) << r.full_train_time_ms << "ms"
+                          << ", Dedup=" << std::fixed << std::setprecision(2) << r.dedup_time_ms << "+" << r.dedup_train_time_ms << "ms"
+                          << ", Speedup=" << std::fixed << std::setprecision(2) << r.speedup << "x"
+                          << (r.matches_full ? "" : "  (predictions differ from full tree)") << std::endl;
+            }
+        }
+    }
+
+    return results;
+}
+
+int main() {
+    std::cout << "=== Duplicate-row Compression (distinct rows + counts) ===" << std::endl;
+
+    std::vector<DedupBenchmarkResult> all_results;
+
+    // Test Cancer dataset
+    std::vector<DedupBenchmarkResult> cancer_results = testDataset("data/cancer_clean.csv", "cancer");
+    all_results.insert(all_results.end(), cancer_results.begin(), cancer_results.end());
+
+    // Test HMEQ dataset
+    std::vector<DedupBenchmarkResult> hmeq_results = testDataset("data/hmeq_clean.csv", "hmeq");
+    all_results.insert(all_results.end(), hmeq_results.begin(), hmeq_results.end());
+
+    // Save combined results
+    writeResultsToCSV(all_results, "benchmark_results_dedup.csv");
+
+    std::cout << "\nDedup benchmark completed! Results saved to benchmark_results_dedup.csv" << std::endl;
+
+    return 0;
+}
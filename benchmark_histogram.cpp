@@ -0,0 +1,217 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <iomanip>
+#include <random>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Serial implementation includes
+#include "src/datasets.cpp"
+#include "src/simd.cpp"
+#include "src/histogram.cpp"
+
+struct HistogramBenchmarkResult {
+    std::string dataset;
+    std::string kernel;
+    std::string histogram;  // "labels" or "gradients".
+    std::string membership;  // "all_rows" (contiguous) or "node_rows" (row index list).
+    int rows;
+    int features;
+    int threads;
+    double time_ms;
+    double rows_per_sec_per_core;
+};
+
+void writeResultsToCSV(const std::vector<HistogramBenchmarkResult>& results, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,dataset,kernel,histogram,membership,rows,features,threads,time_ms,rows_per_sec_per_core\n";
+
+    // Write data
+    for (const auto& r : results) {
+        file << "histogram,"
+             << r.dataset << ","
+             << r.kernel << ","
+             << r.histogram << ","
+             << r.membership << ","
+             << r.rows << ","
+             << r.features << ","
+             << r.threads << ","
+             << std::fixed << std::setprecision(4) << r.time_ms << ","
+             << std::fixed << std::setprecision(1) << r.rows_per_sec_per_core << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+int numThreads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+int threadNum() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+double timeHistograms(const BinnedFrame& binned, const std::vector<double>& gradients, const std::vector<int32_t>& rows,
+                      bool use_rows, bool use_gradients, HistogramKernel kernel, int measurement_runs,
+                      std::vector<uint32_t>& checksum) {
+    /**
+     * Build one histogram per feature, measurement_runs times, and return the median time in ms.
+     * Features are spread over threads when compiled with -fopenmp.
+     * The counts of the last run are returned in checksum so kernels can be cross-checked.
+     * Each thread reuses one HistogramScratch and builds only the bins its column uses,
+     * as a tree builder would for every node.
+     */
+    const int width = binned.width();
+    const int num_classes = binned.num_classes();
+    const int n_rows = use_rows ? (int)rows.size() : binned.length();
+    const int32_t* row_ptr = use_rows ? &rows[0] : nullptr;
+    const int hist_size = use_gradients ? kMaxBins : kMaxBins*num_classes;
+    std::vector<uint32_t> counts((size_t)width*hist_size, 0);
+    std::vector<double> sums((size_t)width*kMaxBins, 0.0);
+    std::vector<HistogramScratch> scratch(numThreads());
+
+    std::vector<double> times;
+    for (int m = 0; m < measurement_runs + 1; m++) {  // First run is a warmup.
+        std::fill(counts.begin(), counts.end(), 0);
+        std::fill(sums.begin(), sums.end(), 0.0);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        #pragma omp parallel for schedule(dynamic)
+        for (int c = 0; c < width; c++) {
+            if (use_gradients) {
+                build_gradient_histogram(binned.codes(c), &gradients[0], row_ptr, n_rows,
+                                         &sums[(size_t)c*kMaxBins], &counts[(size_t)c*hist_size], kernel,
+                                         binned.num_bins(c), &scratch[threadNum()]);
+            } else {
+                build_histogram(binned.codes(c), binned.labels(), row_ptr, n_rows, num_classes,
+                                &counts[(size_t)c*hist_size], kernel, binned.num_bins(c), &scratch[threadNum()]);
+            }
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        if (m > 0) {
+            times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+    checksum = counts;
+
+    // Return median time (more robust than mean)
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+std::vector<HistogramBenchmarkResult> testDataset(const std::string& dataset_path, const std::string& dataset_name, int target_rows) {
+    std::cout << "\n=== Testing " << dataset_name << " Dataset ===" << std::endl;
+
+    // Load dataset and repeat its rows (as pointers) up to the target size
+    DataLoader loader(dataset_path);
+    DataFrame df = loader.load();
+    DataFrame big = DataFrame();
+    for (int i = 0; i < target_rows; i++) {
+        big.addRow(df.row(i % df.length()));
+    }
+    BinnedFrame binned(big);
+
+    std::cout << "Dataset binned: " << binned.length() << " rows (" << df.length() << " unique), "
+              << binned.width() << " features, " << binned.num_classes() << " classes" << std::endl;
+
+    // Gradients of a squared loss around the mean label, as a boosting round would see them
+    std::vector<double> gradients(binned.length() + kCodePadding);
+    double mean = 0.0;
+    for (int i = 0; i < binned.length(); i++) mean += binned.labels()[i];
+    mean /= binned.length();
+    for (int i = 0; i < binned.length(); i++) gradients[i] = binned.labels()[i] - mean;
+
+    // A node containing a random half of the rows, in increasing order
+    std::vector<int32_t> node_rows;
+    std::mt19937 eng(42);
+    std::bernoulli_distribution coin(0.5);
+    for (int i = 0; i < binned.length(); i++) {
+        if (coin(eng)) node_rows.push_back(i);
+    }
+
+    std::vector<HistogramKernel> kernels = {HistogramKernel::scalar, HistogramKernel::unrolled,
+                                            HistogramKernel::avx2, HistogramKernel::avx512,
+                                            HistogramKernel::automatic};  // What the dispatch picks per shape.
+    const int measurement_runs = 5;
+    const int threads = numThreads();
+
+    std::vector<HistogramBenchmarkResult> results;
+    for (bool use_gradients : {false, true}) {
+        for (bool use_rows : {false, true}) {
+            std::vector<uint32_t> reference;
+            for (HistogramKernel kernel : kernels) {
+                if (!histogram_kernel_supported(kernel)) {
+                    std::cout << "  Skipping " << histogram_kernel_name(kernel) << " (not supported by this CPU)" << std::endl;
+                    continue;
+                }
+                std::vector<uint32_t> checksum;
+                double time_ms = timeHistograms(binned, gradients, node_rows, use_rows, use_gradients,
+                                                kernel, measurement_runs, checksum);
+                if (reference.empty()) {
+                    reference = checksum;
+                } else if (checksum != reference) {
+                    std::cout << "  WARNING: " << histogram_kernel_name(kernel) << " counts differ from scalar kernel" << std::endl;
+                }
+
+                int n_rows = use_rows ? (int)node_rows.size() : binned.length();
+                double row_features = (double)n_rows * binned.width();
+                HistogramBenchmarkResult result = {dataset_name, histogram_kernel_name(kernel),
+                                                   use_gradients ? "gradients" : "labels",
+                                                   use_rows ? "node_rows" : "all_rows",
+                                                   n_rows, binned.width(), threads, time_ms,
+                                                   row_features / (time_ms / 1000.0) / threads};
+                results.push_back(result);
+
+                std::cout << "  " << std::left << std::setw(10) << result.kernel
+                          << std::setw(10) << result.histogram
+                          << std::setw(10) << result.membership << std::right
+                          << " Time=" << std::fixed << std::setprecision(2) << result.time_ms << "ms"
+                          << ", Rows/s/core=" << std::scientific << std::setprecision(3) << result.rows_per_sec_per_core
+                          << std::defaultfloat << std::endl;
+            }
+        }
+    }
+
+    return results;
+}
+
+int main() {
+    std::cout << "=== Histogram Construction Microbenchmark ===" << std::endl;
+    std::cout << "Best supported instruction set: " << simd_level_name(detect_simd_level()) << std::endl;
+    std::cout << "Threads: " << numThreads() << std::endl;
+
+    std::vector<HistogramBenchmarkResult> all_results;
+    const int target_rows = 1 << 20;
+
+    // Test Cancer dataset
+    std::vector<HistogramBenchmarkResult> cancer_results = testDataset("data/cancer_clean.csv", "cancer", target_rows);
+    all_results.insert(all_results.end(), cancer_results.begin(), cancer_results.end());
+
+    // Test HMEQ dataset
+    std::vector<HistogramBenchmarkResult> hmeq_results = testDataset("data/hmeq_clean.csv", "hmeq", target_rows);
+    all_results.insert(all_results.end(), hmeq_results.begin(), hmeq_results.end());
+
+    // Save combined results
+    writeResultsToCSV(all_results, "benchmark_results_histogram.csv");
+
+    std::cout << "\nHistogram benchmark completed! Results saved to benchmark_results_histogram.csv" << std::endl;
+    std::cout << "Rows/s/core counts one (row, feature) pair per histogram update." << std::endl;
+
+    return 0;
+}
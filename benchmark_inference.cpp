@@ -0,0 +1,542 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <iomanip>
+#include <functional>
+#include <random>
+#include <cmath>
+#include <memory>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Serial implementation includes (inference is read-only, threads share one model)
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#include "src/model.cpp"
+#include "src/typed_tree.cpp"
+#include "src/sparse.cpp"
+#include "src/sparse_tree.cpp"
+#include "src/fixed_predictor.hpp"
+#include "src/synthetic.cpp"
+
+/*
+ * Scoring latency of every inference engine:
+ *   tree    DecisionTree::predict (runtime tree, DataFrame in)
+ *   model   TreeModel::predict (one row: const double*; batches: DataFrame in)
+ *   typed   typed::make_tree(...)->predict (same inputs as model)
+ *   fixed   FixedPredictor<N>::predict / predict_batch (std::array rows; hmeq and cancer only)
+ *   sparse  predict_sparse (CSR rows in)
+ * Every call predicts one batch of a pool of rows scaled from the held-out split. Each call
+ * is timed on its own and recorded in a latency histogram, from which the percentiles come.
+ * Warm calls run back to back over the pool; cold calls first evict the caches (by
+ * streaming a buffer larger than the last-level cache) and pick a random batch. With
+ * OpenMP, warm calls also run on 1..T threads sharing the model, for throughput curves.
+ *
+ *   ./benchmark_inference [--threads 1,2,4] [--batches 1,16,256,4096] [--datasets hmeq,cancer]
+ *                         [--engines tree,model,typed,fixed,sparse] [--depth 8] [--flush-mb 32]
+ */
+
+struct InferenceConfig {
+    std::vector<int> threads;
+    std::vector<int> batches;  // Rows per call (must divide the pool).
+    std::vector<std::string> datasets;
+    std::vector<std::string> engines;
+    int depth;
+    int flush_mb;  // Size of the buffer streamed before each cold call.
+};
+
+const int kPoolRows = 8192;  // Rows scored, cycled through by the warm calls.
+const int kRowsPerCase = 65536;  // Rows predicted per warm case and thread (16384 for the runtime tree).
+const int kColdCalls = 100;  // Calls per cold case.
+
+/*
+ * LATENCY HISTOGRAM :
+ */
+
+class LatencyHistogram
+{
+    /**
+     * Log-linear histogram of latencies in nanoseconds, after HdrHistogram: values below 128
+     * are counted exactly, larger ones in 64 sub-buckets per power of two, so every recorded
+     * value is known to within 1/64 (1.6%) whatever its magnitude, in constant memory.
+     * */
+
+private:
+
+    // Attributes:
+    std::vector<long long> counts_;  // Calls per bucket.
+    long long total_;  // Calls recorded.
+    double sum_;  // Sum of the recorded values (for the mean).
+    long long max_;  // Largest recorded value (exact).
+
+    // Utilities:
+    static int index(long long ns) {
+        if (ns < 128) { return (int)std::max(ns, 0LL); }
+        int shift = 63 - __builtin_clzll(ns) - 6;  // ns >> shift is in [64, 128).
+        return 128 + (shift - 1) * 64 + (int)((ns >> shift) - 64);
+    }
+    static long long highest(int index) {
+        if (index < 128) { return index; }
+        const int shift = (index - 128) / 64 + 1;
+        return ((long long)((index - 128) % 64 + 64 + 1) << shift) - 1;
+    }
+
+public:
+
+    // Accessors:
+    long long count() const { return this->total_; }
+    double mean() const { return (this->total_ > 0) ? this->sum_ / this->total_ : 0.0; }
+    long long max() const { return this->max_; }
+
+    // Utilities:
+    void record(long long ns) {
+        /** Count one call that took ns nanoseconds. */
+        this->counts_[index(ns)] += 1;
+        this->total_ += 1;
+        this->sum_ += ns;
+        this->max_ = std::max(this->max_, ns);
+    }
+    void merge(const LatencyHistogram& other) {
+        /** Add the calls of another histogram (e.g. of another thread). */
+        for (size_t i = 0; i < this->counts_.size(); i++) { this->counts_[i] += other.counts_[i]; }
+        this->total_ += other.total_;
+        this->sum_ += other.sum_;
+        this->max_ = std::max(this->max_, other.max_);
+    }
+    long long percentile(double p) const {
+        /** Smallest value (to histogram precision) that p percent of the calls do not exceed. */
+        const long long rank = std::max(1LL, (long long)std::ceil(p / 100.0 * this->total_));
+        long long seen = 0;
+        for (size_t i = 0; i < this->counts_.size(); i++) {
+            seen += this->counts_[i];
+            if (seen >= rank) { return std::min(highest(i), this->max_); }
+        }
+        return this->max_;
+    }
+
+    // Constructors:
+    LatencyHistogram() : counts_(128 + 48 * 64, 0), total_(0), sum_(0.0), max_(0) {}
+
+};
+
+const std::vector<double> kPercentiles = {50, 75, 90, 95, 99, 99.5, 99.9, 99.95, 99.99, 100};  // Distribution file levels.
+
+/*
+ * RESULTS :
+ */
+
+struct InferenceResult {
+    std::string dataset;
+    std::string engine;
+    int batch_size;
+    std::string cache;  // "warm" or "cold".
+    int threads;
+    long long calls;
+    LatencyHistogram latency;  // Nanoseconds per call.
+    double throughput_rows_per_sec;  // Rows predicted / wall time (warm cases; cold: over the timed calls only).
+    bool agrees;  // Predictions identical to TreeModel::predict.
+};
+
+void writeResultsToCSV(const std::vector<InferenceResult>& results, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,dataset,engine,batch_size,cache,threads,calls,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,mean_ns,"
+         << "p50_ns_per_row,p99_ns_per_row,throughput_rows_per_sec,agrees\n";
+
+    // Write data
+    for (const InferenceResult& r : results) {
+        file << "inference,"
+             << r.dataset << ","
+             << r.engine << ","
+             << r.batch_size << ","
+             << r.cache << ","
+             << r.threads << ","
+             << r.calls << ","
+             << r.latency.percentile(50) << ","
+             << r.latency.percentile(90) << ","
+             << r.latency.percentile(99) << ","
+             << r.latency.percentile(99.9) << ","
+             << r.latency.max() << ","
+             << std::fixed << std::setprecision(1) << r.latency.mean() << ","
+             << std::fixed << std::setprecision(2) << (double)r.latency.percentile(50) / r.batch_size << ","
+             << std::fixed << std::setprecision(2) << (double)r.latency.percentile(99) / r.batch_size << ","
+             << std::fixed << std::setprecision(0) << r.throughput_rows_per_sec << ","
+             << (r.agrees ? "true" : "false") << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+void writeDistributionToCSV(const std::vector<InferenceResult>& results, const std::string& filename) {
+    /** Latency at each level of kPercentiles for every case (one row per case and level). */
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,dataset,engine,batch_size,cache,threads,percentile,latency_ns\n";
+
+    // Write data
+    for (const InferenceResult& r : results) {
+        for (double p : kPercentiles) {
+            file << "inference,"
+                 << r.dataset << ","
+                 << r.engine << ","
+                 << r.batch_size << ","
+                 << r.cache << ","
+                 << r.threads << ","
+                 << p << ","
+                 << r.latency.percentile(p) << "\n";
+        }
+    }
+
+    file.close();
+    std::cout << "Latency distributions saved to " << filename << std::endl;
+}
+
+void printResult(const InferenceResult& r) {
+    std::cout << "  " << std::left << std::setw(7) << r.engine << std::right
+              << " Batch=" << std::setw(4) << r.batch_size
+              << ", " << r.cache
+              << ", Threads=" << r.threads
+              << ", p50=" << r.latency.percentile(50) << "ns"
+              << ", p99=" << r.latency.percentile(99) << "ns"
+              << ", p99.9=" << r.latency.percentile(99.9) << "ns"
+              << ", Max=" << r.latency.max() << "ns"
+              << ", p50/row=" << std::fixed << std::setprecision(1) << (double)r.latency.percentile(50) / r.batch_size << "ns"
+              << ", Rows/s=" << std::scientific << std::setprecision(3) << r.throughput_rows_per_sec
+              << std::defaultfloat << (r.agrees ? "" : "  PREDICTIONS DIFFER") << std::endl;
+}
+
+/*
+ * ENGINES :
+ */
+
+struct InferenceEngine {
+    std::string name;
+    std::function<void(int)> prepare;  // Lay the pool out in batches of the given size (untimed).
+    std::function<double(int)> predict;  // Predict batch b; returns the sum of its predictions.
+};
+
+template<std::size_t N>
+InferenceEngine fixedEngine(const TreeModel& model, DataFrame* pool, int* batch_size) {
+    /** FixedPredictor<N> over std::array rows of the pool. */
+    std::shared_ptr<FixedPredictor<N>> predictor(new FixedPredictor<N>(make_fixed_predictor<N>(model)));
+    std::shared_ptr<std::vector<std::array<double, N>>> rows(new std::vector<std::array<double, N>>(fixed_rows<N>(pool)));
+    InferenceEngine engine;
+    engine.name = "fixed";
+    engine.prepare = [] (int) {};
+    engine.predict = [=] (int b) {
+        if (*batch_size == 1) { return predictor->predict((*rows)[b]); }
+        // One output buffer per thread, so concurrent calls do not share it:
+        thread_local std::vector<double> buffer;
+        buffer.resize(*batch_size);
+        predictor->predict_batch(&(*rows)[(size_t)b * *batch_size], *batch_size, buffer.data());
+        double sum = 0.0;
+        for (double v : buffer) { sum += v; }
+        return sum;
+    };
+    return engine;
+}
+
+std::vector<InferenceEngine> makeEngines(const InferenceConfig& config, const DecisionTree& tree, const TreeModel& model,
+                                         const typed::AnyTree& typed_tree, DataFrame* pool, int* batch_size) {
+    /** Engines selected by config.engines, predicting from the pool in batches of *batch_size. */
+    const int features = model.num_features();
+    std::shared_ptr<std::vector<double>> observations(new std::vector<double>());
+    for (int r = 0; r < pool->length(); r++) {
+        for (int c = 0; c < features; c++) { observations->push_back(pool->value(r, c)); }
+    }
+    // Frames and CSR matrices of each batch, rebuilt by prepare():
+    std::shared_ptr<std::vector<DataFrame>> frames(new std::vector<DataFrame>());
+    auto prepareFrames = [=] (int size) {
+        frames->assign(pool->length() / size, DataFrame());
+        for (int r = 0; r < pool->length(); r++) { (*frames)[r / size].addRow(pool->row(r)); }
+    };
+    std::shared_ptr<std::vector<SparseMatrix>> matrices(new std::vector<SparseMatrix>());
+    auto prepareMatrices = [=] (int size) {
+        matrices->clear();
+        for (int b = 0; b < pool->length() / size; b++) {
+            DataFrame batch;
+            for (int r = b * size; r < (b + 1) * size; r++) { batch.addRow(pool->row(r)); }
+            matrices->push_back(SparseMatrix(batch));
+        }
+    };
+    auto sum = [] (const DataVector& predictions) {
+        double total = 0.0;
+        for (int i = 0; i < predictions.size(); i++) { total += predictions.value(i); }
+        return total;
+    };
+
+    std::vector<InferenceEngine> engines;
+    for (const std::string& name : config.engines) {
+        InferenceEngine engine;
+        engine.name = name;
+        if (name == "tree") {
+            engine.prepare = prepareFrames;
+            engine.predict = [=, &tree] (int b) { return sum(tree.predict(&(*frames)[b])); };
+        } else if ((name == "model") or (name == "typed")) {
+            const TreeModel* m = &model;
+            const typed::AnyTree* t = &typed_tree;
+            const bool is_model = (name == "model");
+            engine.prepare = [=] (int size) { if (size > 1) { prepareFrames(size); } };
+            engine.predict = [=] (int b) {
+                if (*batch_size == 1) {
+                    const double* row = &(*observations)[(size_t)b * features];
+                    return is_model ? m->predict(row) : t->predict(row);
+                }
+                return sum(is_model ? m->predict(&(*frames)[b]) : t->predict(&(*frames)[b]));
+            };
+        } else if (name == "fixed") {
+            if (features == 11) { engine = fixedEngine<11>(model, pool, batch_size); }
+            else if (features == 30) { engine = fixedEngine<30>(model, pool, batch_size); }
+            else {
+                std::cout << "  (fixed: no FixedPredictor instantiated for " << features << " features, skipped)" << std::endl;
+                continue;
+            }
+        } else if (name == "sparse") {
+            const TreeModel* m = &model;
+            engine.prepare = prepareMatrices;
+            engine.predict = [=] (int b) {
+                std::vector<double> predictions = predict_sparse(*m, (*matrices)[b]);
+                double total = 0.0;
+                for (double v : predictions) { total += v; }
+                return total;
+            };
+        } else {
+            throw std::invalid_argument( "Unknown engine: "+name );
+        }
+        engines.push_back(engine);
+    }
+    return engines;
+}
+
+/*
+ * MEASUREMENT :
+ */
+
+double evictCaches(int megabytes) {
+    /** Stream a buffer of the given size through the caches, evicting the model and the pool. */
+    static std::vector<char> buffer;
+    buffer.resize((size_t)megabytes << 20);
+    long long touched = 0;
+    for (size_t i = 0; i < buffer.size(); i += 64) {
+        buffer[i] += 1;
+        touched += buffer[i];
+    }
+    return (double)touched;
+}
+
+InferenceResult measureWarm(const InferenceEngine& engine, int batch_size, int threads, long long calls, volatile double& sink) {
+    /** Back-to-back calls on each thread, cycling through the pool; latency of every call. */
+    const int num_batches = kPoolRows / batch_size;
+    InferenceResult r;
+    r.engine = engine.name;
+    r.batch_size = batch_size;
+    r.cache = "warm";
+    r.threads = threads;
+    r.calls = calls * threads;
+    std::vector<LatencyHistogram> histograms(threads);
+    auto start = std::chrono::high_resolution_clock::now();
+    #pragma omp parallel num_threads(threads)
+    {
+#ifdef _OPENMP
+        const int t = omp_get_thread_num();
+#else
+        const int t = 0;
+#endif
+        double local = 0.0;
+        for (long long c = 0; c < calls; c++) {
+            const int b = (int)((c + (long long)t * num_batches / threads) % num_batches);
+            auto call_start = std::chrono::high_resolution_clock::now();
+            local += engine.predict(b);
+            auto call_end = std::chrono::high_resolution_clock::now();
+            histograms[t].record(std::chrono::duration_cast<std::chrono::nanoseconds>(call_end - call_start).count());
+        }
+        #pragma omp critical
+        sink = sink + local;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    for (const LatencyHistogram& h : histograms) { r.latency.merge(h); }
+    r.throughput_rows_per_sec = (double)r.calls * batch_size / std::chrono::duration<double>(end - start).count();
+    return r;
+}
+
+InferenceResult measureCold(const InferenceEngine& engine, int batch_size, int flush_mb, volatile double& sink) {
+    /** One thread; the caches are evicted before each call, which predicts a random batch. */
+    const int num_batches = kPoolRows / batch_size;
+    InferenceResult r;
+    r.engine = engine.name;
+    r.batch_size = batch_size;
+    r.cache = "cold";
+    r.threads = 1;
+    r.calls = kColdCalls;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> pick(0, num_batches - 1);
+    double busy_seconds = 0.0;
+    for (int c = 0; c < kColdCalls; c++) {
+        const int b = pick(gen);
+        sink = sink + evictCaches(flush_mb);
+        auto call_start = std::chrono::high_resolution_clock::now();
+        sink = sink + engine.predict(b);
+        auto call_end = std::chrono::high_resolution_clock::now();
+        r.latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(call_end - call_start).count());
+        busy_seconds += std::chrono::duration<double>(call_end - call_start).count();
+    }
+    r.throughput_rows_per_sec = (double)kColdCalls * batch_size / busy_seconds;
+    return r;
+}
+
+std::vector<InferenceResult> testDataset(const std::string& dataset_name, const InferenceConfig& config) {
+    std::cout << "\n=== Testing Dataset: " << dataset_name << " ===" << std::endl;
+
+    // Load data and train every engine's tree on the same split:
+    DataFrame data = DataLoader("data/" + dataset_name + "_clean.csv").load();
+    std::vector<DataFrame> split_data = data.train_test_split(0.2, 42);
+    DataFrame train_data = split_data[0];
+    DecisionTree tree(train_data, false, "gini_impurity", -1, config.depth, -1, 1, -1, 42);
+    TreeModel model(tree);
+    std::unique_ptr<typed::AnyTree> typed_tree = typed::make_tree(train_data, false, "gini_impurity", -1, config.depth, -1, 1, -1, 42);
+
+    // Rows to score: the held-out rows, resampled and jittered to kPoolRows.
+    DataFrame pool = SyntheticGenerator(split_data[1], kPoolRows, 0.05, 7).generate();
+    std::cout << "Depth=" << config.depth << ", Nodes=" << model.size() << ", Pool=" << pool.length()
+              << " rows x " << model.num_features() << " features" << std::endl;
+
+    int batch_size = kPoolRows;
+    std::vector<InferenceEngine> engines = makeEngines(config, tree, model, *typed_tree, &pool, &batch_size);
+    volatile double sink = 0.0;
+
+    // Reference checksum: TreeModel over the whole pool, one row at a time.
+    double reference = 0.0;
+    for (int r = 0; r < pool.length(); r++) {
+        std::vector<double> row(model.num_features());
+        for (int c = 0; c < model.num_features(); c++) { row[c] = pool.value(r, c); }
+        reference += model.predict(row.data());
+    }
+
+    std::vector<InferenceResult> results;
+    for (const InferenceEngine& engine : engines) {
+        batch_size = kPoolRows;
+        engine.prepare(batch_size);
+        const bool agrees = (engine.predict(0) == reference);
+        const int budget = (engine.name == "tree") ? kRowsPerCase / 4 : kRowsPerCase;
+        for (int size : config.batches) {
+            batch_size = size;
+            engine.prepare(size);
+            const long long calls = std::max(20, budget / size);
+            // Warm-up pass over the pool, then warm cases for each thread count, then the cold case:
+            for (int b = 0; b < kPoolRows / size; b++) { sink = sink + engine.predict(b); }
+            for (int threads : config.threads) {
+                results.push_back(measureWarm(engine, size, threads, calls, sink));
+            }
+            results.push_back(measureCold(engine, size, config.flush_mb, sink));
+            for (size_t i = results.size() - config.threads.size() - 1; i < results.size(); i++) {
+                results[i].dataset = dataset_name;
+                results[i].agrees = agrees;
+                printResult(results[i]);
+            }
+        }
+    }
+    return results;
+}
+
+/*
+ * COMMAND LINE :
+ */
+
+std::vector<int> parseInts(const std::string& list) {
+    std::vector<int> values;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) { values.push_back(std::stoi(item)); }
+    return values;
+}
+
+std::vector<std::string> parseStrings(const std::string& list) {
+    std::vector<std::string> values;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) { values.push_back(item); }
+    return values;
+}
+
+InferenceConfig parseArgs(int argc, char** argv) {
+    /** Defaults: threads 1,2,4,... up to the number of processors (1 without OpenMP). */
+    InferenceConfig config;
+#ifdef _OPENMP
+    for (int t = 1; t < omp_get_max_threads(); t *= 2) { config.threads.push_back(t); }
+    config.threads.push_back(omp_get_max_threads());
+#else
+    config.threads = {1};
+#endif
+    config.batches = {1, 16, 256, 4096};
+    config.datasets = {"hmeq", "cancer"};
+    config.engines = {"tree", "model", "typed", "fixed", "sparse"};
+    config.depth = 8;
+    config.flush_mb = 32;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool has_value = (i + 1 < argc);
+        if ((arg == "--threads") and has_value) { config.threads = parseInts(argv[++i]); }
+        else if ((arg == "--batches") and has_value) { config.batches = parseInts(argv[++i]); }
+        else if ((arg == "--datasets") and has_value) { config.datasets = parseStrings(argv[++i]); }
+        else if ((arg == "--engines") and has_value) { config.engines = parseStrings(argv[++i]); }
+        else if ((arg == "--depth") and has_value) { config.depth = std::stoi(argv[++i]); }
+        else if ((arg == "--flush-mb") and has_value) { config.flush_mb = std::stoi(argv[++i]); }
+        else { throw std::invalid_argument( "Unknown or incomplete option: "+arg ); }
+    }
+    for (int size : config.batches) {
+        if ((size < 1) or (kPoolRows % size != 0)) {
+            throw std::invalid_argument( "Batch sizes must divide "+std::to_string(kPoolRows)+", got "+std::to_string(size) );
+        }
+    }
+#ifndef _OPENMP
+    if ((config.threads.size() != 1) or (config.threads[0] != 1)) {
+        throw std::invalid_argument( "Thread counts above 1 need a build with -fopenmp" );
+    }
+#endif
+    return config;
+}
+
+int main(int argc, char** argv) {
+    InferenceConfig config;
+    try {
+        config = parseArgs(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << "=== Inference Latency Benchmark ===" << std::endl;
+    std::cout << "Threads:";
+    for (int t : config.threads) { std::cout << " " << t; }
+    std::cout << ", batch sizes:";
+    for (int b : config.batches) { std::cout << " " << b; }
+    std::cout << ", cold-cache flush: " << config.flush_mb << " MB" << std::endl;
+
+    std::vector<InferenceResult> all_results;
+    for (const std::string& dataset : config.datasets) {
+        std::vector<InferenceResult> results = testDataset(dataset, config);
+        all_results.insert(all_results.end(), results.begin(), results.end());
+    }
+
+    // Save combined results
+    writeResultsToCSV(all_results, "benchmark_results_inference.csv");
+    writeDistributionToCSV(all_results, "benchmark_results_inference_latency.csv");
+
+    std::cout << "\nInference benchmark completed!" << std::endl;
+    std::cout << "Latencies are per call (batch); p50/row divides by the batch size. Cold calls run after evicting the caches." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,256 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <iomanip>
+#include <functional>
+#include <random>
+#include <cstdlib>
+#include <new>
+
+// Allocations are counted (src/memory.hpp):
+#ifndef PDT_COUNT_ALLOCATIONS
+#define PDT_COUNT_ALLOCATIONS
+#endif
+
+// Serial implementation includes
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#include "src/model.cpp"
+#include "src/memory.hpp"
+
+/*
+ * MEASUREMENT :
+ */
+
+struct KernelBenchmarkResult {
+    std::string kernel;
+    int rows;
+    int features;
+    int cardinality;  // Distinct values per feature.
+    int classes;
+    double ns_per_row;  // Median over repetitions.
+    double mad_ns_per_row;  // Median absolute deviation over repetitions.
+    double allocations_per_row;  // operator new calls per row.
+    double bytes_per_row;  // Bytes requested from operator new per row.
+    double rows_per_sec;  // From the median.
+};
+
+void writeResultsToCSV(const std::vector<KernelBenchmarkResult>& results, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,kernel,rows,features,cardinality,classes,ns_per_row,mad_ns_per_row,allocations_per_row,bytes_per_row,rows_per_sec\n";
+
+    // Write data
+    for (const auto& r : results) {
+        file << "kernels,"
+             << r.kernel << ","
+             << r.rows << ","
+             << r.features << ","
+             << r.cardinality << ","
+             << r.classes << ","
+             << std::fixed << std::setprecision(3) << r.ns_per_row << ","
+             << std::fixed << std::setprecision(3) << r.mad_ns_per_row << ","
+             << std::fixed << std::setprecision(4) << r.allocations_per_row << ","
+             << std::fixed << std::setprecision(2) << r.bytes_per_row << ","
+             << std::fixed << std::setprecision(1) << r.rows_per_sec << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+KernelBenchmarkResult measure(const std::string& kernel, const std::function<void()>& run, int rows_per_run,
+                              int warmup_runs = 2, int measurement_runs = 15) {
+    /**
+     * Time `run` measurement_runs times after warmup_runs untimed calls.
+     * Allocations are those of the last repetition (every kernel here is deterministic).
+     * Frame parameters are filled in by the caller.
+     */
+    for (int i = 0; i < warmup_runs; i++) {
+        run();
+    }
+    std::vector<double> times;
+    long long allocations = 0;
+    long long bytes = 0;
+    for (int i = 0; i < measurement_runs; i++) {
+        MemoryScope memory;
+        auto start = std::chrono::high_resolution_clock::now();
+        run();
+        auto end = std::chrono::high_resolution_clock::now();
+        const MemoryUsage usage = memory.close();
+        allocations = usage.allocations;
+        bytes = usage.allocated_bytes;
+        times.push_back(std::chrono::duration<double, std::nano>(end - start).count() / rows_per_run);
+    }
+    const double ns_per_row = median(times);
+    std::vector<double> deviations;
+    for (double t : times) { deviations.push_back(std::abs(t - ns_per_row)); }
+    KernelBenchmarkResult result;
+    result.kernel = kernel;
+    result.ns_per_row = ns_per_row;
+    result.mad_ns_per_row = median(deviations);
+    result.allocations_per_row = (double)allocations / rows_per_run;
+    result.bytes_per_row = (double)bytes / rows_per_run;
+    result.rows_per_sec = 1e9 / ns_per_row;
+    return result;
+}
+
+/*
+ * KERNELS :
+ */
+
+DataFrame makeFrame(int rows, int features, int cardinality, int classes, unsigned seed) {
+    /**
+     * Features take `cardinality` integer levels uniformly at random. The label is the class
+     * of the mean level of the first two features (so splits are informative), flipped to a
+     * random class for 10% of rows.
+     */
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<std::vector<double>> matrix(rows, std::vector<double>(features + 1));
+    for (std::vector<double>& row : matrix) {
+        for (int c = 0; c < features; c++) { row[c] = (double)(gen() % cardinality); }
+        double level = (features > 1) ? (row[0] + row[1]) / 2 : row[0];
+        int label = std::min(classes - 1, (int)(classes * level / cardinality));
+        row[features] = (unit(gen) < 0.1) ? (double)(gen() % classes) : (double)label;
+    }
+    return DataFrame(matrix);
+}
+
+std::vector<KernelBenchmarkResult> testFrame(int rows, int features, int cardinality, int classes) {
+    std::cout << "\n=== Rows=" << rows << ", Features=" << features << ", Cardinality=" << cardinality
+              << ", Classes=" << classes << " ===" << std::endl;
+
+    DataFrame df = makeFrame(rows, features, cardinality, classes, 42);
+    DataVector labels = df.col(-1);
+    const double median_level = (double)(cardinality / 2);
+    volatile double sink = 0.0;
+    std::vector<KernelBenchmarkResult> results;
+
+    // Split search at the root (one LabelCounter, one findBestSplit and one DataFrame::split):
+    results.push_back(measure("find_best_split", [&] () {
+        DecisionTree stump(df, false, "gini_impurity", -1, 2);
+        sink = sink + stump.getSize();
+    }, rows));
+
+    // Inner loop of findBestSplit alone: sort + prefix counts + scoring, every feature.
+    std::vector<std::vector<double>> columns;
+    for (int c = 0; c < features; c++) { columns.push_back(df.col(c).vector()); }
+    std::vector<int> classes_of_rows;
+    for (double label : labels.vector()) { classes_of_rows.push_back((int)label); }
+    EntropyTable table(rows);
+    results.push_back(measure("threshold_sweep", [&] () {
+        ThresholdSweep sweep;
+        double loss;
+        for (int c = 0; c < features; c++) {
+            sweep.sweep_classes(columns[c], classes_of_rows, classes);
+            sink = sink + sweep.best(ImpurityMethod::gini_impurity, &loss, &table);
+        }
+    }, rows));
+
+    // LossFunction::calculate for each method:
+    for (const std::string& method : std::vector<std::string>{"misclassification_error", "cross_entropy", "gini_impurity", "mean_squared_error"}) {
+        LossFunction loss_func(method);
+        results.push_back(measure("loss_" + method, [&] () {
+            sink = sink + loss_func.calculate(&labels);
+        }, rows));
+    }
+
+    results.push_back(measure("label_counter", [&] () {
+        LabelCounter counter(&labels);
+        sink = sink + counter.get_most_frequent();
+    }, rows));
+
+    results.push_back(measure("dataframe_col", [&] () {
+        sink = sink + df.col(features / 2).value(0);
+    }, rows));
+
+    results.push_back(measure("dataframe_split", [&] () {
+        std::vector<DataFrame> halves = df.split(0, median_level, true);
+        sink = sink + halves[0].length();
+    }, rows));
+
+    // Prediction, one row per call vs the whole frame per call. The runtime tree recomputes
+    // the leaf label from the leaf's training rows, so it only predicts the first rows:
+    DecisionTree tree(df, false, "gini_impurity", -1, 8);
+    TreeModel model(tree);
+    const int tree_rows = std::min(rows, 1000);
+    DataFrame tree_batch = DataFrame();
+    std::vector<DataFrame> single_rows(tree_rows);
+    for (int r = 0; r < tree_rows; r++) {
+        tree_batch.addRow(df.row(r));
+        single_rows[r].addRow(df.row(r));
+    }
+    std::vector<double> observations;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < features; c++) { observations.push_back(df.value(r, c)); }
+    }
+    results.push_back(measure("predict_tree_single", [&] () {
+        for (int r = 0; r < tree_rows; r++) { sink = sink + tree.predict(&single_rows[r]).value(0); }
+    }, tree_rows, 1, 5));
+    results.push_back(measure("predict_tree_batch", [&] () {
+        sink = sink + tree.predict(&tree_batch).value(0);
+    }, tree_rows, 1, 5));
+    results.push_back(measure("predict_model_single", [&] () {
+        for (int r = 0; r < rows; r++) { sink = sink + model.predict(&observations[(size_t)r*features]); }
+    }, rows));
+    results.push_back(measure("predict_model_batch", [&] () {
+        sink = sink + model.predict(&df).value(0);
+    }, rows));
+
+    for (KernelBenchmarkResult& r : results) {
+        r.rows = rows;
+        r.features = features;
+        r.cardinality = cardinality;
+        r.classes = classes;
+        std::cout << "  " << std::left << std::setw(30) << r.kernel << std::right
+                  << " " << std::fixed << std::setprecision(2) << std::setw(10) << r.ns_per_row << " ns/row"
+                  << " (±" << std::setprecision(2) << r.mad_ns_per_row << ")"
+                  << ", Allocs/row=" << std::setprecision(3) << r.allocations_per_row
+                  << ", Bytes/row=" << std::setprecision(1) << r.bytes_per_row
+                  << ", Rows/s=" << std::scientific << std::setprecision(3) << r.rows_per_sec
+                  << std::defaultfloat << std::endl;
+    }
+
+    return results;
+}
+
+int main() {
+    std::cout << "=== Kernel Microbenchmarks (split, loss, partition, predict) ===" << std::endl;
+
+    std::vector<KernelBenchmarkResult> all_results;
+
+    // Vary one parameter at a time around a reference frame:
+    const int rows = 10000, features = 16, cardinality = 64, classes = 2;
+    std::vector<std::vector<int>> configs = {{rows, features, cardinality, classes}};
+    for (int n : {1000, 100000}) { configs.push_back({n, features, cardinality, classes}); }
+    for (int f : {4, 64}) { configs.push_back({rows, f, cardinality, classes}); }
+    for (int v : {2, 1024}) { configs.push_back({rows, features, v, classes}); }
+    for (int k : {4, 8}) { configs.push_back({rows, features, cardinality, k}); }
+
+    for (const std::vector<int>& config : configs) {
+        std::vector<KernelBenchmarkResult> results = testFrame(config[0], config[1], config[2], config[3]);
+        all_results.insert(all_results.end(), results.begin(), results.end());
+    }
+
+    // Save combined results
+    writeResultsToCSV(all_results, "benchmark_results_kernels.csv");
+
+    std::cout << "\nKernel benchmark completed! Results saved to benchmark_results_kernels.csv" << std::endl;
+    std::cout << "ns/row is per row of the frame (per row predicted for predict_*); ± is the median absolute deviation." << std::endl;
+
+    return 0;
+}
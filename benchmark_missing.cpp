@@ -0,0 +1,230 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <iomanip>
+#include <functional>
+#include <random>
+#include <cstdio>
+
+// Serial implementation includes
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#include "src/model.cpp"
+#include "src/typed_tree.cpp"
+
+struct MissingBenchmarkResult {
+    std::string dataset;
+    std::string method;  // "drop_rows", "mean_impute" or "native".
+    int max_depth;
+    int train_rows;  // Training rows actually used.
+    double preprocess_time_ms;  // Row filtering / imputation of train and test sets.
+    double train_time_ms;
+    double test_accuracy;  // On every test row, missing values included.
+    int tree_size;
+};
+
+void writeResultsToCSV(const std::vector<MissingBenchmarkResult>& results, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,dataset,method,max_depth,train_rows,preprocess_time_ms,train_time_ms,test_accuracy,tree_size\n";
+
+    // Write data
+    for (const auto& r : results) {
+        file << "missing,"
+             << r.dataset << ","
+             << r.method << ","
+             << r.max_depth << ","
+             << r.train_rows << ","
+             << std::fixed << std::setprecision(4) << r.preprocess_time_ms << ","
+             << std::fixed << std::setprecision(4) << r.train_time_ms << ","
+             << std::fixed << std::setprecision(4) << r.test_accuracy << ","
+             << r.tree_size << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+double medianTime(const std::function<void(int)>& train, int warmup_runs = 2, int measurement_runs = 5) {
+    /** Median time in ms; train(seed) runs one repetition. */
+    for (int i = 0; i < warmup_runs; i++) {
+        train(42 + i);
+    }
+    std::vector<double> times;
+    for (int i = 0; i < measurement_runs; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        train(42 + warmup_runs + i);
+        auto end = std::chrono::high_resolution_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+void writeWithMissing(const DataFrame& df, const std::string& filename, double rate, int informative_col, unsigned seed) {
+    /**
+     * Write df as CSV with empty cells: every feature cell is blanked with probability
+     * `rate`, and informative_col is blanked more often for label 1 than for label 0
+     * (as DEBTINC is in the raw HMEQ extract), so missingness itself carries signal.
+     */
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::ofstream file(filename);
+    file << std::setprecision(17);
+    for (int r = 0; r < df.length(); r++) {
+        const double label = df.value(r, -1);
+        for (int c = 0; c+1 < df.width(); c++) {
+            double p = (c == informative_col) ? ((label == 1) ? 4*rate : rate/2) : rate;
+            if (unit(gen) >= p) {
+                file << df.value(r, c);
+            }
+            file << ",";
+        }
+        file << label << "\n";
+    }
+    file.close();
+}
+
+DataFrame dropMissingRows(const DataFrame& df) {
+    /** Complete-case rows only. */
+    DataFrame out = DataFrame();
+    for (int r = 0; r < df.length(); r++) {
+        bool complete = true;
+        for (int c = 0; c < df.width(); c++) { complete = complete and !std::isnan(df.value(r, c)); }
+        if (complete) { out.addRow(df.row(r)); }
+    }
+    return out;
+}
+
+DataFrame imputeMeans(const DataFrame& df, const std::vector<double>& means) {
+    /** Copy of df with missing feature values replaced by the given column means. */
+    std::vector<std::vector<double>> matrix = df.matrix();
+    for (std::vector<double>& row : matrix) {
+        for (int c = 0; c+1 < (int)row.size(); c++) {
+            if (std::isnan(row[c])) { row[c] = means[c]; }
+        }
+    }
+    return DataFrame(matrix);
+}
+
+std::vector<double> columnMeans(const DataFrame& df) {
+    /** Mean of each feature column over its present values. */
+    std::vector<double> sums(df.width()-1, 0.0);
+    std::vector<int> counts(df.width()-1, 0);
+    for (int r = 0; r < df.length(); r++) {
+        for (int c = 0; c+1 < df.width(); c++) {
+            double v = df.value(r, c);
+            if (!std::isnan(v)) { sums[c] += v; counts[c] += 1; }
+        }
+    }
+    for (int c = 0; c+1 < df.width(); c++) { sums[c] /= std::max(counts[c], 1); }
+    return sums;
+}
+
+std::vector<MissingBenchmarkResult> testDataset(const std::string& dataset_path, const std::string& dataset_name, int informative_col) {
+    std::cout << "\n=== Testing " << dataset_name << " Dataset ===" << std::endl;
+
+    // Re-create a raw extract with missing cells and load it like any other CSV
+    DataFrame clean = DataLoader(dataset_path).load();
+    const std::string raw_path = "missing_" + dataset_name + ".csv";
+    writeWithMissing(clean, raw_path, 0.08, informative_col, 5);
+    DataLoader loader(raw_path, true);  // Missing cells load as NaN.
+    std::remove(raw_path.c_str());
+    DataFrame df = loader.load();
+    std::vector<DataFrame> split_data = df.train_test_split(0.2, 42);
+    DataFrame train_data = split_data[0];
+    DataFrame test_data = split_data[1];
+    std::cout << "Train set: " << train_data.length() << " rows (" << dropMissingRows(train_data).length()
+              << " complete), Test set: " << test_data.length() << " rows" << std::endl;
+
+    std::vector<int> depths = {4, 8, 12};
+    std::vector<MissingBenchmarkResult> results;
+    bool consistent = true;
+    for (int depth : depths) {
+        // Drop incomplete training rows (test rows still need imputation):
+        DataFrame complete, test_imputed;
+        double drop_prep_ms = medianTime([&] (int) {
+            complete = dropMissingRows(train_data);
+            test_imputed = imputeMeans(test_data, columnMeans(complete));
+        });
+        double drop_ms = medianTime([&] (int seed) {
+            typed::make_tree(complete, false, "gini_impurity", -1, depth, -1, 1, -1, seed);
+        });
+        std::unique_ptr<typed::AnyTree> drop_tree = typed::make_tree(complete, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+        results.push_back({dataset_name, "drop_rows", depth, complete.length(), drop_prep_ms, drop_ms,
+                           accuracy(test_data.col(-1), drop_tree->predict(&test_imputed)), drop_tree->getSize()});
+
+        // Mean imputation of both sets:
+        DataFrame train_imputed;
+        double impute_prep_ms = medianTime([&] (int) {
+            std::vector<double> means = columnMeans(train_data);
+            train_imputed = imputeMeans(train_data, means);
+            test_imputed = imputeMeans(test_data, means);
+        });
+        double impute_ms = medianTime([&] (int seed) {
+            typed::make_tree(train_imputed, false, "gini_impurity", -1, depth, -1, 1, -1, seed);
+        });
+        std::unique_ptr<typed::AnyTree> impute_tree = typed::make_tree(train_imputed, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+        results.push_back({dataset_name, "mean_impute", depth, train_imputed.length(), impute_prep_ms, impute_ms,
+                           accuracy(test_data.col(-1), impute_tree->predict(&test_imputed)), impute_tree->getSize()});
+
+        // Native routing of missing values:
+        double native_ms = medianTime([&] (int seed) {
+            typed::make_tree(train_data, false, "gini_impurity", -1, depth, -1, 1, -1, seed);
+        });
+        std::unique_ptr<typed::AnyTree> native_tree = typed::make_tree(train_data, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+        DataVector predictions = native_tree->predict(&test_data);
+        results.push_back({dataset_name, "native", depth, train_data.length(), 0.0, native_ms,
+                           accuracy(test_data.col(-1), predictions), native_tree->getSize()});
+
+        // Serialized model must route missing values the same way:
+        TreeModel model = native_tree->model();
+        model.save("missing_model.bin");
+        consistent = consistent and (model.predict(&test_data).vector() == predictions.vector())
+                                and (TreeModel::load("missing_model.bin").predict(&test_data).vector() == predictions.vector());
+        std::remove("missing_model.bin");
+
+        for (size_t i = results.size() - 3; i < results.size(); i++) {
+            const MissingBenchmarkResult& r = results[i];
+            std::cout << "  " << std::left << std::setw(12) << r.method << std::right
+                      << " Depth=" << std::setw(2) << r.max_depth
+                      << ", Rows=" << std::setw(4) << r.train_rows
+                      << ", Prep=" << std::fixed << std::setprecision(2) << r.preprocess_time_ms << "ms"
+                      << ", Time=" << std::fixed << std::setprecision(2) << r.train_time_ms << "ms"
+                      << ", Accuracy=" << std::fixed << std::setprecision(4) << r.test_accuracy
+                      << ", Size=" << r.tree_size << std::endl;
+        }
+    }
+    std::cout << "TreeModel / saved model routing: " << (consistent ? "ok" : "MISMATCH") << std::endl;
+
+    return results;
+}
+
+int main() {
+    std::cout << "=== Native Missing-value Routing vs Dropping / Imputing ===" << std::endl;
+
+    std::vector<MissingBenchmarkResult> all_results;
+
+    // Test Cancer dataset (informative missingness in the first column)
+    std::vector<MissingBenchmarkResult> cancer_results = testDataset("data/cancer_clean.csv", "cancer", 0);
+    all_results.insert(all_results.end(), cancer_results.begin(), cancer_results.end());
+
+    // Test HMEQ dataset (informative missingness in DEBTINC, the last feature)
+    std::vector<MissingBenchmarkResult> hmeq_results = testDataset("data/hmeq_clean.csv", "hmeq", 10);
+    all_results.insert(all_results.end(), hmeq_results.begin(), hmeq_results.end());
+
+    // Save combined results
+    writeResultsToCSV(all_results, "benchmark_results_missing.csv");
+
+    std::cout << "\nMissing-value benchmark completed! Results saved to benchmark_results_missing.csv" << std::endl;
+
+    return 0;
+}
@@ -4,12 +4,20 @@
 #include <vector>
 #include <iomanip>
 
+// Memory use of the accuracy tree is measured (src/memory.hpp). Allocations are only counted
+// when built with -DPDT_COUNT_ALLOCATIONS (the CSV reads -1 otherwise), which is kept out of
+// this timing binary by default: the counting operator new slows every allocation down.
+
 // Parallel implementation includes
 #include "src-openmp/datasets.cpp"
 #include "src-openmp/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
 #include "src-openmp/metrics.cpp"
 #include "src-openmp/tree_node.cpp"
 #include "src-openmp/decision_tree.cpp"
+#include "src/memory.hpp"
 
 struct BenchmarkResult {
     std::string dataset;
@@ -21,13 +29,14 @@ struct BenchmarkResult {
     int tree_height;
     int warmup_runs;
     int measurement_runs;
+    MemoryUsage memory;  // Training of the accuracy tree.
 };
 
 void writeResultsToCSV(const std::vector<BenchmarkResult>& results, const std::string& filename) {
     std::ofstream file(filename);
     
     // Write header
-    file << "version,dataset,max_depth,train_time_ms,train_accuracy,test_accuracy,tree_size,tree_height,warmup_runs,measurement_runs\n";
+    file << "version,dataset,max_depth,train_time_ms,train_accuracy,test_accuracy,tree_size,tree_height,warmup_runs,measurement_runs,allocations,allocated_bytes,peak_heap_bytes,peak_rss_bytes\n";
     
     // Write data
     for (const auto& r : results) {
@@ -40,7 +49,11 @@ void writeResultsToCSV(const std::vector<BenchmarkResult>& results, const std::s
              << r.tree_size << ","
              << r.tree_height << ","
              << r.warmup_runs << ","
-             << r.measurement_runs << "\n";
+             << r.measurement_runs << ","
+             << r.memory.allocations << ","
+             << r.memory.allocated_bytes << ","
+             << r.memory.peak_heap_bytes << ","
+             << r.memory.peak_rss_bytes << "\n";
     }
     
     file.close();
@@ -106,8 +119,10 @@ std::vector<BenchmarkResult> testDataset(const std::string& dataset_path, const
             // Measure training time with warmup
             double train_time_ms = measureTrainingTime(train_data, depth, warmup_runs, measurement_runs);
             
-            // Train final tree for accuracy measurement
+            // Train final tree for accuracy measurement (and its memory use)
+            MemoryScope memory;
             DecisionTree tree(train_data, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+            MemoryUsage tree_memory = memory.close();
             
             // Make predictions
             DataVector train_predictions = tree.predict(&train_data);
@@ -125,7 +140,7 @@ std::vector<BenchmarkResult> testDataset(const std::string& dataset_path, const
             std::cout << " Done! (" << std::fixed << std::setprecision(2) << train_time_ms << "ms)" << std::endl;
             
             BenchmarkResult result = {dataset_name, depth, train_time_ms, train_acc, test_acc, 
-                                    tree.getSize(), tree.getHeight(), warmup_runs, measurement_runs};
+                                    tree.getSize(), tree.getHeight(), warmup_runs, measurement_runs, tree_memory};
             results.push_back(result);
             
             // Print summary
@@ -134,7 +149,15 @@ std::vector<BenchmarkResult> testDataset(const std::string& dataset_path, const
                       << ", Train Acc=" << std::fixed << std::setprecision(3) << result.train_accuracy
                       << ", Test Acc=" << std::fixed << std::setprecision(3) << result.test_accuracy
                       << ", Tree Size=" << result.tree_size
-                      << ", Tree Height=" << result.tree_height << std::endl;
+                      << ", Tree Height=" << result.tree_height;
+            if (MemoryAccounting::enabled()) {
+                std::cout << ", Allocated=" << std::fixed << std::setprecision(1) << result.memory.allocated_bytes / 1024.0 << "KB"
+                          << " (" << result.memory.allocations << " allocations)"
+                          << ", Peak Heap=" << std::fixed << std::setprecision(1) << result.memory.peak_heap_bytes / 1024.0 << "KB";
+            } else {
+                std::cout << ", Peak RSS=" << std::fixed << std::setprecision(1) << result.memory.peak_rss_bytes / 1024.0 << "KB";
+            }
+            std::cout << std::endl;
             
         } catch (const std::exception& e) {
             std::cout << "Error with depth " << depth << ": " << e.what() << std::endl;
@@ -0,0 +1,288 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <iomanip>
+#include <random>
+#include <memory>
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// Serial implementation includes (workers score with a TreeModel or a MappedModel)
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#include "src/model.cpp"
+#include "src/prefork.cpp"
+#include "src/memory.hpp"
+
+/*
+ * Multi-process scoring with one model file. A complete regression tree of --depth levels
+ * is saved (2^depth-1 nodes of 40 bytes: 10 MiB at depth 18) and every worker process
+ * scores the same --rows rows with it, the model acquired in one of three ways:
+ *   load      each worker reads the file into its own heap copy (TreeModel::load)
+ *   map       each worker maps the file itself (MappedModel, MAP_SHARED)
+ *   prefork   the launcher maps and warms the file once, then forks the workers
+ *             (prefork_workers), which use the inherited mapping
+ * The file is dropped from the page cache before each case where the kernel allows it.
+ * Reports the time from fork to the last worker's exit, the mean time a worker took to
+ * get its model, the memory of the mapping holding the model's node table summed over the
+ * workers (its Pss, where a page mapped by N processes counts 1/N in each, and its private
+ * pages, measured while all workers are alive) and their page faults. Every worker's
+ * predictions are checked against TreeModel::predict_batch.
+ *
+ *   ./benchmark_prefork [--workers 1,2,4,8] [--depth 18] [--features 16] [--rows 200000]
+ */
+
+struct PreforkResult {
+    std::string mode;  // "load", "map" or "prefork".
+    int workers;
+    long long model_bytes;
+    int rows;
+    double seconds;
+    double rows_per_sec;  // All workers together.
+    double mean_ready_ms;
+    long long model_pss_bytes;  // Pss of the model's mapping, summed over workers.
+    long long model_private_bytes;  // Private pages of the model's mapping, summed over workers.
+    long long major_faults;
+    long long minor_faults;
+    bool agrees;
+};
+
+struct WorkerReport {
+    /** Written by a worker into memory shared with the launcher. */
+    double ready_seconds;
+    long long pss_bytes;
+    long long private_bytes;
+    long long major_faults;
+    long long minor_faults;
+};
+
+void writeResultsToCSV(const std::vector<PreforkResult>& results, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,mode,workers,model_bytes,rows_per_worker,seconds,rows_per_sec,mean_ready_ms,"
+         << "model_pss_bytes,model_private_bytes,major_faults,minor_faults,agrees\n";
+
+    // Write data
+    for (const PreforkResult& r : results) {
+        file << "prefork,"
+             << r.mode << ","
+             << r.workers << ","
+             << r.model_bytes << ","
+             << r.rows << ","
+             << std::fixed << std::setprecision(6) << r.seconds << ","
+             << std::setprecision(0) << r.rows_per_sec << ","
+             << std::setprecision(3) << r.mean_ready_ms << ","
+             << r.model_pss_bytes << ","
+             << r.model_private_bytes << ","
+             << r.major_faults << ","
+             << r.minor_faults << ","
+             << (r.agrees ? "true" : "false") << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+std::vector<int> parseInts(const std::string& list) {
+    std::vector<int> values;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) { values.push_back(std::stoi(item)); }
+    return values;
+}
+
+int addCompleteTree(std::vector<ModelNode>& nodes, int levels, int num_features, std::mt19937_64& rng) {
+    /** Append a complete subtree of the given levels in pre-order (random splits on [0,1) features) and return its index. */
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const int index = nodes.size();
+    nodes.push_back(ModelNode{-1, -1, -1, 0, 0.0, uniform(rng), -1, (int32_t)(rng() & 1)});
+    if (levels > 1) {
+        nodes[index].feature = rng() % num_features;
+        nodes[index].threshold = uniform(rng);
+        const int left = addCompleteTree(nodes, levels - 1, num_features, rng);
+        const int right = addCompleteTree(nodes, levels - 1, num_features, rng);
+        nodes[index].left = left;
+        nodes[index].right = right;
+    }
+    return index;
+}
+
+void dropFromPageCache(const std::string& path) {
+    /** Ask the kernel to evict the file's cached pages (a no-op where it keeps them, e.g. tmpfs). */
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) { return; }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+struct SharedState {
+    /** Counters the workers of a case meet at, in memory shared with the launcher. */
+    std::atomic<int> scored;
+    std::atomic<int> measured;
+};
+
+void waitFor(const std::atomic<int>& counter, int target) {
+    while (counter.load() < target) { usleep(100); }
+}
+
+WorkerReport finishWorker(const void* table, double ready_seconds, const struct rusage& usage_before, SharedState* state, int workers) {
+    /**
+     * Measure the memory of the mapping holding the model's node table once every worker
+     * has scored and before any exits, so a shared page is split among all of them.
+     */
+    state->scored += 1;
+    waitFor(state->scored, workers);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    const long long clean = mapping_kb(table, "Private_Clean");
+    const long long dirty = mapping_kb(table, "Private_Dirty");
+    const WorkerReport report = {ready_seconds, mapping_kb(table, "Pss"), ((clean < 0) or (dirty < 0)) ? -1 : clean + dirty,
+                                 usage.ru_majflt - usage_before.ru_majflt, usage.ru_minflt - usage_before.ru_minflt};
+    state->measured += 1;
+    waitFor(state->measured, workers);
+    return report;
+}
+
+PreforkResult runCase(const std::string& path, const std::string& mode, int workers, const std::vector<double>& rows,
+                      int num_features, const std::vector<double>& expected) {
+    const int n_rows = expected.size();
+    // Counters, reports and predictions of every worker, in memory the workers share with the launcher
+    const size_t shared_bytes = sizeof(SharedState) + workers * (sizeof(WorkerReport) + n_rows * sizeof(double));
+    void* shared = mmap(nullptr, shared_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        throw std::runtime_error( "Cannot map worker results" );
+    }
+    SharedState* state = new (shared) SharedState();
+    WorkerReport* reports = (WorkerReport*)(state + 1);
+    double* predictions = (double*)(reports + workers);
+
+    dropFromPageCache(path);
+    std::unique_ptr<MappedModel> launcher_model;
+    if (mode == "prefork") {
+        launcher_model.reset(new MappedModel(path));
+        launcher_model->warm();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<WorkerExit> exits = prefork_workers(workers, [&] (int w) {
+        struct rusage usage_before;
+        getrusage(RUSAGE_SELF, &usage_before);
+        const auto worker_start = std::chrono::steady_clock::now();
+        double* out = predictions + (size_t)w * n_rows;
+        if (mode == "load") {
+            const TreeModel model = TreeModel::load(path);
+            const double ready = std::chrono::duration<double>(std::chrono::steady_clock::now() - worker_start).count();
+            model.predict_batch(rows.data(), n_rows, num_features, out);
+            reports[w] = finishWorker(model.nodes().data(), ready, usage_before, state, workers);
+        } else if (mode == "map") {
+            const MappedModel model(path);
+            const double ready = std::chrono::duration<double>(std::chrono::steady_clock::now() - worker_start).count();
+            model.predict_batch(rows.data(), n_rows, num_features, out);
+            reports[w] = finishWorker(model.data(), ready, usage_before, state, workers);
+        } else {
+            launcher_model->predict_batch(rows.data(), n_rows, num_features, out);
+            reports[w] = finishWorker(launcher_model->data(), 0.0, usage_before, state, workers);
+        }
+        return 0;
+    });
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    PreforkResult result = {mode, workers, 0, n_rows, seconds, (double)workers * n_rows / seconds, 0.0, 0, 0, 0, 0, true};
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    result.model_bytes = file.tellg();
+    for (int w = 0; w < workers; w++) {
+        result.agrees = result.agrees and (exits[w].status == 0)
+                        and (std::memcmp(predictions + (size_t)w * n_rows, expected.data(), n_rows * sizeof(double)) == 0);
+        result.mean_ready_ms += reports[w].ready_seconds * 1000.0 / workers;
+        result.model_pss_bytes = (reports[w].pss_bytes < 0 or result.model_pss_bytes < 0) ? -1 : result.model_pss_bytes + reports[w].pss_bytes;
+        result.model_private_bytes = (reports[w].private_bytes < 0 or result.model_private_bytes < 0) ? -1 : result.model_private_bytes + reports[w].private_bytes;
+        result.major_faults += reports[w].major_faults;
+        result.minor_faults += reports[w].minor_faults;
+    }
+    munmap(shared, shared_bytes);
+    return result;
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> worker_counts = {1, 2, 4, 8};
+    int depth = 18;
+    int num_features = 16;
+    int n_rows = 200000;
+    try {
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            const bool has_value = (i + 1 < argc);
+            if ((arg == "--workers") and has_value) { worker_counts = parseInts(argv[++i]); }
+            else if ((arg == "--depth") and has_value) { depth = std::stoi(argv[++i]); }
+            else if ((arg == "--features") and has_value) { num_features = std::stoi(argv[++i]); }
+            else if ((arg == "--rows") and has_value) { n_rows = std::stoi(argv[++i]); }
+            else { throw std::invalid_argument( "Unknown or incomplete option: "+arg ); }
+        }
+        if ((depth < 1) or (depth > 24) or (num_features < 1) or (n_rows < 1)) {
+            throw std::invalid_argument( "Need 1 <= depth <= 24, features >= 1 and rows >= 1" );
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // The model file and the rows, built by the launcher before any fork
+    std::mt19937_64 rng(42);
+    std::vector<ModelNode> nodes;
+    addCompleteTree(nodes, depth, num_features, rng);
+    const TreeModel model(num_features, true, nodes);
+    const std::string path = "prefork_model_" + std::to_string(getpid()) + ".bin";
+    model.save(path);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<double> rows((size_t)n_rows * num_features);
+    for (double& value : rows) { value = uniform(rng); }
+    std::vector<double> expected(n_rows);
+    model.predict_batch(rows.data(), n_rows, num_features, expected.data());
+    std::cout << "Model: depth " << depth << ", " << model.size() << " nodes, "
+              << std::fixed << std::setprecision(1) << model.size() * sizeof(ModelNode) / 1048576.0 << " MiB; "
+              << n_rows << " rows of " << num_features << " features per worker" << std::endl;
+
+    std::vector<PreforkResult> results;
+    std::cout << std::left << std::setw(9) << "mode" << std::right << std::setw(8) << "workers" << std::setw(11) << "seconds"
+              << std::setw(13) << "rows/s" << std::setw(11) << "ready_ms" << std::setw(12) << "model_pss" << std::setw(13) << "model_priv"
+              << std::setw(9) << "majflt" << std::setw(10) << "minflt" << std::setw(8) << "agrees" << std::endl;
+    try {
+        for (int workers : worker_counts) {
+            for (const std::string mode : {"load", "map", "prefork"}) {
+                const PreforkResult r = runCase(path, mode, workers, rows, num_features, expected);
+                results.push_back(r);
+                std::cout << std::left << std::setw(9) << r.mode << std::right << std::setw(8) << r.workers
+                          << std::setw(11) << std::setprecision(4) << r.seconds << std::setw(13) << std::setprecision(0) << r.rows_per_sec
+                          << std::setw(11) << std::setprecision(3) << r.mean_ready_ms
+                          << std::setw(10) << std::setprecision(1) << r.model_pss_bytes / 1048576.0 << "Mi"
+                          << std::setw(11) << r.model_private_bytes / 1048576.0 << "Mi"
+                          << std::setw(9) << r.major_faults << std::setw(10) << r.minor_faults
+                          << std::setw(8) << (r.agrees ? "yes" : "NO") << std::endl;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        std::remove(path.c_str());
+        return 1;
+    }
+    std::remove(path.c_str());
+
+    writeResultsToCSV(results, "benchmark_results_prefork.csv");
+
+    bool agrees = true;
+    for (const PreforkResult& r : results) { agrees = agrees and r.agrees; }
+    return agrees ? 0 : 1;
+}
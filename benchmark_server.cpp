@@ -0,0 +1,266 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <unistd.h>
+
+// Serial implementation includes (the server scores with a TreeModel)
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#include "src/model.cpp"
+#include "src/server.cpp"
+
+/*
+ * Load test of the scoring server (src/server.hpp). A PredictionServer runs in a thread of
+ * this process; C client threads each hold one connection and send single-row requests
+ * in a closed loop (a new request as soon as the previous one is answered). Every case is
+ * run unbatched (max_batch 1: one predict call per request), micro-batched, and
+ * micro-batched while another thread hot-reloads the model every --reload-us (alternating
+ * the depth-D tree with a depth-D/2 one), over a Unix domain socket and loopback TCP.
+ * Reports requests per second, latency percentiles and the mean batch the server formed;
+ * every prediction is checked against TreeModel::predict of the model(s) served.
+ *
+ *   ./benchmark_server [--clients 1,4,16,64] [--transports unix,tcp] [--requests 20000]
+ *                      [--max-batch 256] [--budget-us 200] [--reload-us 1000]
+ *                      [--dataset hmeq] [--depth 8]
+ */
+
+struct ServerResult {
+    std::string transport;
+    std::string mode;  // "unbatched", "batched" or "reload".
+    int clients;
+    int max_batch;
+    int budget_us;
+    long long requests;
+    double requests_per_sec;
+    double p50_us;
+    double p99_us;
+    double p999_us;
+    double max_us;
+    ServerStats stats;  // reloads: models swapped in during the case.
+    bool agrees;
+};
+
+void writeResultsToCSV(const std::vector<ServerResult>& results, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,transport,mode,clients,max_batch,budget_us,requests,requests_per_sec,p50_us,p99_us,p999_us,max_us,"
+         << "batches,mean_batch_rows,max_batch_rows,full_flushes,budget_flushes,early_flushes,reloads,agrees\n";
+
+    // Write data
+    for (const ServerResult& r : results) {
+        file << "server,"
+             << r.transport << ","
+             << r.mode << ","
+             << r.clients << ","
+             << r.max_batch << ","
+             << r.budget_us << ","
+             << r.requests << ","
+             << std::fixed << std::setprecision(0) << r.requests_per_sec << ","
+             << std::fixed << std::setprecision(2) << r.p50_us << ","
+             << r.p99_us << ","
+             << r.p999_us << ","
+             << r.max_us << ","
+             << r.stats.batches << ","
+             << (r.stats.batches > 0 ? (double)r.stats.rows / r.stats.batches : 0.0) << ","
+             << r.stats.max_batch_rows << ","
+             << r.stats.full_flushes << ","
+             << r.stats.budget_flushes << ","
+             << r.stats.early_flushes << ","
+             << r.stats.reloads << ","
+             << (r.agrees ? "true" : "false") << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+std::vector<int> parseInts(const std::string& list) {
+    std::vector<int> values;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) { values.push_back(std::stoi(item)); }
+    return values;
+}
+
+std::vector<std::string> parseStrings(const std::string& list) {
+    std::vector<std::string> values;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) { values.push_back(item); }
+    return values;
+}
+
+double percentileUs(const std::vector<long long>& sorted_ns, double p) {
+    /** Nearest-rank percentile of sorted latencies, in microseconds. */
+    if (sorted_ns.empty()) { return 0.0; }
+    const size_t rank = std::max<size_t>(1, (size_t)std::ceil(p / 100.0 * sorted_ns.size()));
+    return sorted_ns[std::min(rank, sorted_ns.size()) - 1] / 1000.0;
+}
+
+ServerResult runCase(const std::vector<TreeModel>& models, const std::vector<double>& rows, const std::vector<std::vector<double>>& expected,
+                     const std::string& transport, const std::string& mode, int clients, int requests, int max_batch, int budget_us, int reload_us) {
+    /** One case; models[0] is served (in "reload" mode, models[1] and models[0] are swapped in by turns). */
+    ServerConfig config = default_server_config();
+    config.socket_path = (transport == "unix") ? "/tmp/pdt_benchmark_" + std::to_string(getpid()) + ".sock" : "";
+    config.port = 0;
+    config.max_batch = (mode == "unbatched") ? 1 : max_batch;
+    config.budget_us = (mode == "unbatched") ? 0 : budget_us;
+    PredictionServer server(models[0], config);
+    std::thread serving([&server] () { server.run(); });
+    std::atomic<bool> clients_done(false);
+    std::thread reloading([&] () {
+        for (int k = 1; (mode == "reload") and !clients_done; k++) {
+            std::this_thread::sleep_for(std::chrono::microseconds(reload_us));
+            server.reload(models[k % 2]);
+        }
+    });
+
+    const int features = models[0].num_features();
+    const int pool = expected[0].size();
+    const int per_client = std::max(1, requests / clients);
+    std::vector<std::vector<long long>> latencies(clients);
+    std::atomic<bool> agrees(true);
+    std::atomic<bool> failed(false);
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; c++) {
+        threads.emplace_back([&, c] () {
+            try {
+                std::unique_ptr<ScoringClient> client(transport == "unix" ? new ScoringClient(config.socket_path) : new ScoringClient(server.port()));
+                latencies[c].reserve(per_client);
+                for (int k = 0; k < per_client; k++) {
+                    const int r = (c * 7919 + k) % pool;
+                    auto sent = std::chrono::high_resolution_clock::now();
+                    const double prediction = client->predict(&rows[(size_t)r * features], features);
+                    auto answered = std::chrono::high_resolution_clock::now();
+                    latencies[c].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(answered - sent).count());
+                    if ((prediction != expected[0][r]) and ((mode != "reload") or (prediction != expected[1][r]))) { agrees = false; }
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Client error: " << e.what() << std::endl;
+                failed = true;
+            }
+        });
+    }
+    for (std::thread& thread : threads) { thread.join(); }
+    auto end = std::chrono::high_resolution_clock::now();
+    clients_done = true;
+    reloading.join();
+    server.stop();
+    serving.join();
+
+    std::vector<long long> all;
+    for (const auto& l : latencies) { all.insert(all.end(), l.begin(), l.end()); }
+    std::sort(all.begin(), all.end());
+    ServerResult result;
+    result.transport = transport;
+    result.mode = mode;
+    result.clients = clients;
+    result.max_batch = config.max_batch;
+    result.budget_us = config.budget_us;
+    result.requests = all.size();
+    result.requests_per_sec = all.size() / std::chrono::duration<double>(end - start).count();
+    result.p50_us = percentileUs(all, 50);
+    result.p99_us = percentileUs(all, 99);
+    result.p999_us = percentileUs(all, 99.9);
+    result.max_us = all.empty() ? 0.0 : all.back() / 1000.0;
+    result.stats = server.stats();
+    result.agrees = agrees and !failed;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> clients = {1, 4, 16, 64};
+    std::vector<std::string> transports = {"unix", "tcp"};
+    std::string dataset = "hmeq";
+    int requests = 20000;
+    int max_batch = 256;
+    int budget_us = 200;
+    int reload_us = 1000;
+    int depth = 8;
+    try {
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            const bool has_value = (i + 1 < argc);
+            if ((arg == "--clients") and has_value) { clients = parseInts(argv[++i]); }
+            else if ((arg == "--transports") and has_value) { transports = parseStrings(argv[++i]); }
+            else if ((arg == "--requests") and has_value) { requests = std::stoi(argv[++i]); }
+            else if ((arg == "--max-batch") and has_value) { max_batch = std::stoi(argv[++i]); }
+            else if ((arg == "--budget-us") and has_value) { budget_us = std::stoi(argv[++i]); }
+            else if ((arg == "--reload-us") and has_value) { reload_us = std::stoi(argv[++i]); }
+            else if ((arg == "--dataset") and has_value) { dataset = argv[++i]; }
+            else if ((arg == "--depth") and has_value) { depth = std::stoi(argv[++i]); }
+            else { throw std::invalid_argument( "Unknown or incomplete option: "+arg ); }
+        }
+        for (const std::string& transport : transports) {
+            if ((transport != "unix") and (transport != "tcp")) { throw std::invalid_argument( "Unknown transport: "+transport ); }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "=== Scoring Server Benchmark ===" << std::endl;
+    DataFrame data = DataLoader("data/" + dataset + "_clean.csv").load();
+    std::vector<DataFrame> split_data = data.train_test_split(0.2, 42);
+    DataFrame train_data = split_data[0];
+    DataFrame test_data = split_data[1];
+    DecisionTree tree(train_data, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+    DecisionTree alternate_tree(train_data, false, "gini_impurity", -1, std::max(1, depth / 2), -1, 1, -1, 42);
+    const std::vector<TreeModel> models = {TreeModel(tree), TreeModel(alternate_tree)};
+    const TreeModel& model = models[0];
+    const int features = model.num_features();
+    std::vector<double> rows;
+    for (int r = 0; r < test_data.length(); r++) {
+        for (int c = 0; c < features; c++) { rows.push_back(test_data.value(r, c)); }
+    }
+    std::vector<std::vector<double>> expected(2, std::vector<double>(test_data.length()));
+    for (int m = 0; m < 2; m++) { models[m].predict_batch(rows.data(), test_data.length(), features, expected[m].data()); }
+    std::cout << "Dataset: " << dataset << ", model: " << model.size() << " nodes, " << requests << " requests per case" << std::endl;
+
+    std::vector<ServerResult> results;
+    try {
+        for (const std::string& transport : transports) {
+            std::cout << "\nTransport: " << transport << std::endl;
+            for (int c : clients) {
+                for (const std::string mode : {"unbatched", "batched", "reload"}) {
+                    ServerResult r = runCase(models, rows, expected, transport, mode, c, requests, max_batch, budget_us, reload_us);
+                    std::cout << "  Clients=" << std::setw(3) << c << ", " << std::left << std::setw(9) << mode << std::right
+                              << " Req/s=" << std::fixed << std::setprecision(0) << r.requests_per_sec
+                              << ", p50=" << std::setprecision(1) << r.p50_us << "us"
+                              << ", p99=" << r.p99_us << "us"
+                              << ", p99.9=" << r.p999_us << "us"
+                              << ", Mean batch=" << std::setprecision(2) << (r.stats.batches > 0 ? (double)r.stats.rows / r.stats.batches : 0.0)
+                              << (r.mode == "reload" ? ", Reloads=" + std::to_string(r.stats.reloads) : "")
+                              << (r.agrees ? "" : "  PREDICTIONS DIFFER") << std::endl;
+                    results.push_back(r);
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // Save combined results
+    std::cout << std::endl;
+    writeResultsToCSV(results, "benchmark_results_server.csv");
+
+    bool agrees = true;
+    for (const ServerResult& r : results) { agrees = agrees and r.agrees; }
+    return agrees ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <iomanip>
+#include <functional>
+#include <random>
+#include <cstdio>
+
+// Serial implementation includes
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#include "src/typed_tree.cpp"
+#include "src/model.cpp"
+#include "src/sparse.cpp"
+#include "src/sparse_tree.cpp"
+
+struct SparseBenchmarkResult {
+    std::string dataset;
+    std::string engine;  // "runtime" or "typed_double" (dense), or "sparse".
+    int num_features;
+    double density;  // Fraction of non-zero feature entries.
+    int max_depth;
+    double train_time_ms;
+    double speedup;  // Dense training time / this engine's training time.
+    double test_accuracy;
+    int tree_size;
+    bool matches_dense;  // Same test predictions as the dense tree.
+};
+
+void writeResultsToCSV(const std::vector<SparseBenchmarkResult>& results, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,dataset,engine,num_features,density,max_depth,train_time_ms,speedup,test_accuracy,tree_size,matches_dense\n";
+
+    // Write data
+    for (const auto& r : results) {
+        file << "sparse,"
+             << r.dataset << ","
+             << r.engine << ","
+             << r.num_features << ","
+             << std::fixed << std::setprecision(4) << r.density << ","
+             << r.max_depth << ","
+             << std::fixed << std::setprecision(4) << r.train_time_ms << ","
+             << std::fixed << std::setprecision(3) << r.speedup << ","
+             << std::fixed << std::setprecision(4) << r.test_accuracy << ","
+             << r.tree_size << ","
+             << (r.matches_dense ? 1 : 0) << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+double medianTime(const std::function<void(int)>& train, int warmup_runs = 1, int measurement_runs = 5) {
+    /** Median training time in ms; train(seed) builds one tree. */
+    for (int i = 0; i < warmup_runs; i++) {
+        train(42 + i);
+    }
+    std::vector<double> times;
+    for (int i = 0; i < measurement_runs; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        train(42 + warmup_runs + i);
+        auto end = std::chrono::high_resolution_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+SparseMatrix widen(const DataFrame& dataframe, int extra_cols, double extra_density, unsigned seed) {
+    /**
+     * Append extra_cols sparse noise columns to a dense frame, each entry non-zero with
+     * probability extra_density (values in [-1, 1], so zeros sit between negatives and
+     * positives). Stands in for the full-width data, which is not shipped with the repo.
+     */
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    const int num_cols = dataframe.width()-1;
+    std::vector<int64_t> row_ptr = {0};
+    std::vector<int32_t> cols;
+    std::vector<double> values;
+    std::vector<double> labels;
+    for (int r = 0; r < dataframe.length(); r++) {
+        const DataVector* row = dataframe.row(r);
+        for (int c = 0; c < num_cols; c++) {
+            cols.push_back(c);
+            values.push_back(row->value(c));
+        }
+        for (int c = 0; c < extra_cols; c++) {
+            if (unit(gen) < extra_density) {
+                cols.push_back(num_cols + c);
+                values.push_back(2.0*unit(gen) - 1.0);
+            }
+        }
+        row_ptr.push_back(cols.size());
+        labels.push_back(row->value(num_cols));
+    }
+    return SparseMatrix(num_cols + extra_cols, row_ptr, cols, values, labels);
+}
+
+double sparseAccuracy(const SparseMatrix& data, const std::vector<double>& predictions) {
+    int correct = 0;
+    for (int r = 0; r < data.length(); r++) {
+        correct += (data.label(r) == predictions[r]) ? 1 : 0;
+    }
+    return (double)correct / data.length();
+}
+
+void printResult(const SparseBenchmarkResult& r) {
+    std::cout << "  " << std::left << std::setw(13) << r.engine << std::right
+              << " Features=" << std::setw(5) << r.num_features
+              << ", Density=" << std::fixed << std::setprecision(3) << r.density
+              << ", Depth=" << std::setw(2) << r.max_depth
+              << ", Time=" << std::fixed << std::setprecision(2) << r.train_time_ms << "ms"
+              << ", Speedup=" << std::fixed << std::setprecision(2) << r.speedup << "x"
+              << ", Size=" << r.tree_size
+              << (r.matches_dense ? "" : "  (predictions differ from dense tree)") << std::endl;
+}
+
+bool checkLoaders(const SparseMatrix& data) {
+    /** Write data as LIBSVM and as CSV, load both back and compare every entry. */
+    const std::string libsvm_path = "sparse_roundtrip.libsvm";
+    const std::string csv_path = "sparse_roundtrip.csv";
+    std::ofstream libsvm(libsvm_path);
+    std::ofstream csv(csv_path);
+    libsvm << std::setprecision(17);
+    csv << std::setprecision(17);
+    for (int r = 0; r < data.length(); r++) {
+        libsvm << data.label(r);
+        for (int64_t k = data.row_begin(r); k < data.row_end(r); k++) {
+            libsvm << " " << data.row_cols()[k]+1 << ":" << data.row_values()[k];
+        }
+        libsvm << "\n";
+        for (int c = 0; c < data.width(); c++) {
+            csv << data.value(r, c) << ",";
+        }
+        csv << data.label(r) << "\n";
+    }
+    libsvm.close();
+    csv.close();
+
+    SparseMatrix from_libsvm = load_libsvm(libsvm_path, data.width());
+    SparseMatrix from_csv = load_sparse_csv(csv_path);
+    std::remove(libsvm_path.c_str());
+    std::remove(csv_path.c_str());
+
+    bool ok = true;
+    for (const SparseMatrix* loaded : {&from_libsvm, &from_csv}) {
+        ok = ok and (loaded->length() == data.length()) and (loaded->width() == data.width()) and (loaded->nnz() == data.nnz());
+        for (int r = 0; ok and (r < data.length()); r++) {
+            ok = (loaded->label(r) == data.label(r));
+            for (int64_t k = data.row_begin(r); ok and (k < data.row_end(r)); k++) {
+                ok = (loaded->value(r, data.row_cols()[k]) == data.row_values()[k]);
+            }
+        }
+    }
+    return ok;
+}
+
+std::vector<SparseBenchmarkResult> testDataset(const std::string& dataset_path, const std::string& dataset_name, int extra_cols) {
+    std::cout << "\n=== Testing " << dataset_name << " Dataset ===" << std::endl;
+
+    // Load dataset and create train/test split (80/20)
+    DataLoader loader(dataset_path);
+    DataFrame df = loader.load();
+    std::vector<DataFrame> split_data = df.train_test_split(0.2, 42);
+    DataFrame train_data = split_data[0];
+    DataFrame test_data = split_data[1];
+    std::cout << "Train set: " << train_data.length() << " rows, Test set: " << test_data.length() << " rows" << std::endl;
+
+    std::vector<int> depths = {4, 8, 12};
+    std::vector<SparseBenchmarkResult> results;
+
+    // Original width: the sparse tree must reproduce the runtime tree.
+    SparseMatrix sparse_train(train_data);
+    SparseMatrix sparse_test(test_data);
+    std::cout << "Original width (" << sparse_train.width() << " features):" << std::endl;
+    for (int depth : depths) {
+        double runtime_ms = medianTime([&] (int seed) {
+            DecisionTree tree(train_data, false, "gini_impurity", -1, depth, -1, 1, -1, seed);
+        });
+        DecisionTree runtime_tree(train_data, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+        DataVector runtime_predictions = runtime_tree.predict(&test_data);
+        results.push_back({dataset_name, "runtime", sparse_train.width(), sparse_train.density(), depth, runtime_ms, 1.0,
+                           accuracy(test_data.col(-1), runtime_predictions), runtime_tree.getSize(), true});
+        printResult(results.back());
+
+        double sparse_ms = medianTime([&] (int seed) {
+            train_sparse_tree(sparse_train, false, "gini_impurity", -1, depth, -1, 1, -1, seed);
+        });
+        TreeModel model = train_sparse_tree(sparse_train, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+        std::vector<double> predictions = predict_sparse(model, sparse_test);
+        results.push_back({dataset_name, "sparse", sparse_train.width(), sparse_train.density(), depth, sparse_ms, runtime_ms / sparse_ms,
+                           sparseAccuracy(sparse_test, predictions), model.size(), predictions == runtime_predictions.vector()});
+        printResult(results.back());
+    }
+
+    // Widened with sparse noise columns: dense (compile-time specialized) vs sparse.
+    SparseMatrix wide_train = widen(train_data, extra_cols, 0.01, 7);
+    SparseMatrix wide_test = widen(test_data, extra_cols, 0.01, 8);
+    DataFrame dense_train = wide_train.dense();
+    DataFrame dense_test = wide_test.dense();
+    std::cout << "Widened (" << wide_train.width() << " features):" << std::endl;
+    for (int depth : depths) {
+        double dense_ms = medianTime([&] (int seed) {
+            typed::make_tree(dense_train, false, "gini_impurity", -1, depth, -1, 1, -1, seed);
+        }, 1, 3);
+        std::unique_ptr<typed::AnyTree> dense_tree = typed::make_tree(dense_train, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+        DataVector dense_predictions = dense_tree->predict(&dense_test);
+        results.push_back({dataset_name + "_wide", "typed_double", wide_train.width(), wide_train.density(), depth, dense_ms, 1.0,
+                           accuracy(dense_test.col(-1), dense_predictions), dense_tree->getSize(), true});
+        printResult(results.back());
+
+        double sparse_ms = medianTime([&] (int seed) {
+            train_sparse_tree(wide_train, false, "gini_impurity", -1, depth, -1, 1, -1, seed);
+        }, 1, 3);
+        TreeModel model = train_sparse_tree(wide_train, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+        std::vector<double> predictions = predict_sparse(model, wide_test);
+        results.push_back({dataset_name + "_wide", "sparse", wide_train.width(), wide_train.density(), depth, sparse_ms, dense_ms / sparse_ms,
+                           sparseAccuracy(wide_test, predictions), model.size(), predictions == dense_predictions.vector()});
+        printResult(results.back());
+    }
+
+    std::cout << "LIBSVM / sparse CSV round trip: " << (checkLoaders(wide_test) ? "ok" : "MISMATCH") << std::endl;
+
+    return results;
+}
+
+int main() {
+    std::cout << "=== Sparse (CSR/CSC) vs Dense Tree Training ===" << std::endl;
+
+    std::vector<SparseBenchmarkResult> all_results;
+
+    // Widen both datasets to the 7219 predictors of the full-width data.
+    std::vector<SparseBenchmarkResult> cancer_results = testDataset("data/cancer_clean.csv", "cancer", 7219 - 30);
+    all_results.insert(all_results.end(), cancer_results.begin(), cancer_results.end());
+
+    std::vector<SparseBenchmarkResult> hmeq_results = testDataset("data/hmeq_clean.csv", "hmeq", 7219 - 11);
+    all_results.insert(all_results.end(), hmeq_results.begin(), hmeq_results.end());
+
+    // Save combined results
+    writeResultsToCSV(all_results, "benchmark_results_sparse.csv");
+
+    std::cout << "\nSparse benchmark completed! Results saved to benchmark_results_sparse.csv" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <iomanip>
+#include <functional>
+
+// Serial implementation includes
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#include "src/model.cpp"
+#include "src/typed_tree.cpp"
+
+struct TypedBenchmarkResult {
+    std::string dataset;
+    std::string loss;
+    std::string engine;  // "runtime", "typed_double" or "typed_float".
+    int max_depth;
+    double train_time_ms;
+    double speedup;  // Runtime training time / this engine's training time.
+    double test_accuracy;  // Accuracy (classification) or mean squared error (regression).
+    int tree_size;
+    bool matches_runtime;  // Same test predictions as the runtime-dispatched tree.
+};
+
+void writeResultsToCSV(const std::vector<TypedBenchmarkResult>& results, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,dataset,loss,engine,max_depth,train_time_ms,speedup,test_metric,tree_size,matches_runtime\n";
+
+    // Write data
+    for (const auto& r : results) {
+        file << "typed,"
+             << r.dataset << ","
+             << r.loss << ","
+             << r.engine << ","
+             << r.max_depth << ","
+             << std::fixed << std::setprecision(4) << r.train_time_ms << ","
+             << std::fixed << std::setprecision(3) << r.speedup << ","
+             << std::fixed << std::setprecision(4) << r.test_accuracy << ","
+             << r.tree_size << ","
+             << (r.matches_runtime ? 1 : 0) << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+double medianTime(const std::function<void(int)>& train, int warmup_runs = 2, int measurement_runs = 5) {
+    /** Median training time in ms; train(seed) builds one tree. */
+    for (int i = 0; i < warmup_runs; i++) {
+        train(42 + i);
+    }
+    std::vector<double> times;
+    for (int i = 0; i < measurement_runs; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        train(42 + warmup_runs + i);
+        auto end = std::chrono::high_resolution_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+double testMetric(bool regression, DataVector labels, DataVector predictions) {
+    /** Accuracy for classification, mean squared error for regression. */
+    if (!regression) {
+        return accuracy(labels, predictions);
+    }
+    double total = 0.0;
+    for (int i = 0; i < labels.size(); i++) {
+        double error = labels.value(i) - predictions.value(i);
+        total += error*error;
+    }
+    return total / labels.size();
+}
+
+std::vector<TypedBenchmarkResult> testDataset(const std::string& dataset_path, const std::string& dataset_name) {
+    std::cout << "\n=== Testing " << dataset_name << " Dataset ===" << std::endl;
+
+    // Load dataset and create train/test split (80/20)
+    DataLoader loader(dataset_path);
+    DataFrame df = loader.load();
+    std::vector<DataFrame> split_data = df.train_test_split(0.2, 42);
+    DataFrame train_data = split_data[0];
+    DataFrame test_data = split_data[1];
+    std::cout << "Train set: " << train_data.length() << " rows, Test set: " << test_data.length() << " rows" << std::endl;
+
+    std::vector<std::string> losses = {"gini_impurity", "cross_entropy", "misclassification_error", "mean_squared_error"};
+    std::vector<int> depths = {4, 8, 12};
+
+    std::vector<TypedBenchmarkResult> results;
+    for (const std::string& loss : losses) {
+        const bool regression = (loss == "mean_squared_error");
+        for (int depth : depths) {
+            // Runtime-dispatched tree (loss as a string, doubles everywhere):
+            double runtime_ms = medianTime([&] (int seed) {
+                DecisionTree tree(train_data, regression, loss, -1, depth, -1, 1, -1, seed);
+            });
+            DecisionTree runtime_tree(train_data, regression, loss, -1, depth, -1, 1, -1, 42);
+            DataVector runtime_predictions = runtime_tree.predict(&test_data);
+            results.push_back({dataset_name, loss, "runtime", depth, runtime_ms, 1.0,
+                               testMetric(regression, test_data.col(-1), runtime_predictions),
+                               runtime_tree.getSize(), true});
+
+            // Compile-time specialized trees:
+            for (bool single_precision : {false, true}) {
+                double typed_ms = medianTime([&] (int seed) {
+                    typed::make_tree(train_data, regression, loss, -1, depth, -1, 1, -1, seed, single_precision);
+                });
+                std::unique_ptr<typed::AnyTree> tree = typed::make_tree(train_data, regression, loss, -1, depth, -1, 1, -1, 42, single_precision);
+                DataVector predictions = tree->predict(&test_data);
+                bool matches = (predictions.vector() == runtime_predictions.vector());
+                results.push_back({dataset_name, loss, single_precision ? "typed_float" : "typed_double", depth,
+                                   typed_ms, runtime_ms / typed_ms,
+                                   testMetric(regression, test_data.col(-1), predictions),
+                                   tree->getSize(), matches});
+            }
+
+            for (size_t i = results.size() - 3; i < results.size(); i++) {
+                const TypedBenchmarkResult& r = results[i];
+                std::cout << "  " << std::left << std::setw(24) << r.loss << std::setw(13) << r.engine << std::right
+                          << " Depth=" << std::setw(2) << r.max_depth
+                          << ", Time=" << std::fixed << std::setprecision(2) << r.train_time_ms << "ms"
+                          << ", Speedup=" << std::fixed << std::setprecision(2) << r.speedup << "x"
+                          << ", Size=" << r.tree_size
+                          << (r.matches_runtime ? "" : "  (predictions differ from runtime tree)") << std::endl;
+            }
+        }
+    }
+
+    return results;
+}
+
+int main() {
+    std::cout << "=== Compile-time Specialized vs Runtime-dispatched Tree Training ===" << std::endl;
+
+    std::vector<TypedBenchmarkResult> all_results;
+
+    // Test Cancer dataset
+    std::vector<TypedBenchmarkResult> cancer_results = testDataset("data/cancer_clean.csv", "cancer");
+    all_results.insert(all_results.end(), cancer_results.begin(), cancer_results.end());
+
+    // Test HMEQ dataset
+    std::vector<TypedBenchmarkResult> hmeq_results = testDataset("data/hmeq_clean.csv", "hmeq");
+    all_results.insert(all_results.end(), hmeq_results.begin(), hmeq_results.end());
+
+    // Save combined results
+    writeResultsToCSV(all_results, "benchmark_results_typed.csv");
+
+    std::cout << "\nTyped benchmark completed! Results saved to benchmark_results_typed.csv" << std::endl;
+    std::cout << "typed_double is expected to reproduce the runtime tree exactly; typed_float may split at rounded thresholds." << std::endl;
+
+    return 0;
+}
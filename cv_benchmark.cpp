@@ -4,9 +4,16 @@
 #include <vector>
 #include <iomanip>
 
+// Memory use of the untimed warmup pass is measured (src/memory.hpp). Allocations are only counted
+// when built with -DPDT_COUNT_ALLOCATIONS (the CSV reads -1 otherwise), which is kept out of
+// this timing binary by default: the counting operator new slows every allocation down.
+
 // Include your existing modules
 #include "src/datasets.cpp"
 #include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
 #include "src/metrics.cpp"
 #include "src/tree_node.cpp"
 #include "src/decision_tree.cpp"
@@ -21,13 +28,14 @@ struct CVBenchmarkResult {
     std::vector<double> fold_scores;
     int warmup_runs;
     int measurement_runs;
+    MemoryUsage memory;  // Training of the 4 fold trees (first warmup run).
 };
 
 void writeCVResultsToCSV(const std::vector<CVBenchmarkResult>& results, const std::string& filename) {
     std::ofstream file(filename);
     
     // Write header - Updated to clarify training time only
-    file << "version,dataset,max_depth,cv_training_time_ms,mean_cv_accuracy,std_cv_accuracy,fold1_acc,fold2_acc,fold3_acc,fold4_acc,warmup_runs,measurement_runs\n";
+    file << "version,dataset,max_depth,cv_training_time_ms,mean_cv_accuracy,std_cv_accuracy,fold1_acc,fold2_acc,fold3_acc,fold4_acc,warmup_runs,measurement_runs,allocations,allocated_bytes,peak_heap_bytes,peak_rss_bytes\n";
     
     // Write data
     for (const auto& r : results) {
@@ -51,6 +59,10 @@ void writeCVResultsToCSV(const std::vector<CVBenchmarkResult>& results, const st
         // Add warmup and measurement run info
         file << "," << r.warmup_runs << "," << r.measurement_runs;
         
+        // Add memory use
+        file << "," << r.memory.allocations << "," << r.memory.allocated_bytes
+             << "," << r.memory.peak_heap_bytes << "," << r.memory.peak_rss_bytes;
+        
         file << "\n";
     }
     
@@ -99,12 +111,17 @@ CVBenchmarkResult measureCVTrainingTime(const DataFrame& data, int depth, const
         folds.push_back(fold_pair);
     }
     
-    // Warmup runs
+    // Warmup runs (the first one also measures memory use)
+    MemoryUsage memory;
     for (int w = 0; w < warmup_runs; w++) {
+        MemoryScope warmup_memory;
         for (int fold = 0; fold < 4; fold++) {
             DataFrame train_data = folds[fold][0];
             DecisionTree warmup_tree(train_data, false, "gini_impurity", -1, depth, -1, 1, -1, 42 + fold + w);
         }
+        if (w == 0) {
+            memory = warmup_memory.close();
+        }
     }
     
     // Measurement runs - time only training
@@ -158,7 +175,7 @@ CVBenchmarkResult measureCVTrainingTime(const DataFrame& data, int depth, const
     }
     double std_dev = std::sqrt(variance_sum / fold_scores.size());
     
-    return {dataset_name, depth, median_time, mean, std_dev, fold_scores, warmup_runs, measurement_runs};
+    return {dataset_name, depth, median_time, mean, std_dev, fold_scores, warmup_runs, measurement_runs, memory};
 }
 
 std::vector<CVBenchmarkResult> testDatasetCV(const std::string& dataset_path, const std::string& dataset_name) {
@@ -203,7 +220,14 @@ std::vector<CVBenchmarkResult> testDatasetCV(const std::string& dataset_path, co
                 std::cout << std::fixed << std::setprecision(3) << result.fold_scores[i];
                 if (i < result.fold_scores.size() - 1) std::cout << ",";
             }
-            std::cout << "]" << std::endl;
+            std::cout << "]";
+            if (MemoryAccounting::enabled()) {
+                std::cout << ", Allocated=" << std::fixed << std::setprecision(1) << result.memory.allocated_bytes / 1024.0 << "KB"
+                          << ", Peak Heap=" << std::fixed << std::setprecision(1) << result.memory.peak_heap_bytes / 1024.0 << "KB";
+            } else {
+                std::cout << ", Peak RSS=" << std::fixed << std::setprecision(1) << result.memory.peak_rss_bytes / 1024.0 << "KB";
+            }
+            std::cout << std::endl;
             
         } catch (const std::exception& e) {
             std::cout << "Error with depth " << depth << ": " << e.what() << std::endl;
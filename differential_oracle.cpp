@@ -0,0 +1,1078 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <iomanip>
+#include <functional>
+#include <random>
+#include <cmath>
+#include <memory>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <cstdio>
+#include <unistd.h>
+
+#ifdef _OPENMP
+// Include the PARALLEL modules (the OpenMP tree is the reference of this build)
+#include <omp.h>
+#include "src-openmp/datasets.cpp"
+#include "src-openmp/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src-openmp/metrics.cpp"
+#include "src-openmp/tree_node.cpp"
+#include "src-openmp/decision_tree.cpp"
+#else
+// Serial implementation includes (the reference)
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#endif
+#include "src/model.cpp"
+#include "src/typed_tree.cpp"
+#include "src/sparse.cpp"
+#include "src/sparse_tree.cpp"
+#include "src/fixed_predictor.hpp"
+
+/*
+ * Differential correctness oracle.
+ *
+ * Trains the runtime ::DecisionTree (the reference) and an optimized engine on thousands of
+ * randomized datasets and hyperparameters, generated deterministically from --seed, and
+ * compares them:
+ *   typed        typed::make_tree (double features)   tree structure, thresholds, leaf values, predictions
+ *   sparse       train_sparse_tree on a SparseMatrix  tree structure, thresholds, leaf values, predictions
+ *   model        TreeModel of the reference tree      predictions
+ *   fixed        FixedPredictor<N> of that model      predictions (row by row and batched)
+ *   split        naive per-threshold search at every  loss and threshold of each split (the scoring
+ *                split of the reference tree           ::DecisionTree did before its split kernels)
+ * The reference rejects missing values and has no categorical splits, so three engines
+ * check the typed tree against itself instead:
+ *   missing      typed tree on data with NaN cells     predictions of its TreeModel, of the model
+ *   categorical  typed tree with category columns      saved and loaded (versions 1 to 4), mapped,
+ *                (and some NaN cells)                  and of FixedPredictor<N>, which must reject
+ *                                                      left defaults and category sets
+ *   dedup        typed tree on distinct rows + counts  tree structure, thresholds, leaf values and
+ *                against one on the expanded rows      predictions (identical for classification)
+ * Datasets mix continuous, small-integer, binary, constant, mostly-zero and duplicated
+ * columns, so ties, constant nodes and degenerate splits come up often. Every mismatch is
+ * shrunk (fewer rows, fewer columns, default hyperparameters, integer values) while it
+ * keeps failing, and the minimal dataset is written to CSV with the command that replays it.
+ * The parallel build (-fopenmp) checks the OpenMP tree the same way: both trees cannot be
+ * linked into one program, and the serial build checks the engines against the serial tree.
+ *
+ *   ./differential_oracle [--cases 2000] [--seed 1] [--engines typed,sparse,model,fixed,split,missing,categorical,dedup]
+ *                         [--max-rows 120] [--max-features 8] [--repro-dir .] [--max-repros 3]
+ *                         [--threads N] [--out oracle_results_<version>.csv]
+ *   ./differential_oracle --replay train.csv [--replay-test test.csv] --engine E
+ *                         [--regression] [--loss L] [--mtry M] [--depth D] [--leaves L]
+ *                         [--min-obs M] [--max-prop P] [--tree-seed S] [--categorical C1,C2]
+ * Regression targets are integers: the reference counts labels (LabelCounter) at every node.
+ * Exit status: 0 every engine agrees, 1 mismatch, 2 usage or input error.
+ */
+
+struct OracleCase {
+    int id;
+    bool regression;
+    std::string loss;
+    int mtry;
+    int max_height;
+    int max_leaves;
+    int min_obs;
+    double max_prop;
+    int seed;
+    std::vector<std::vector<double>> train;  // Rows, label last.
+    std::vector<std::vector<double>> test;  // Held-out rows (also predicted, with the training rows).
+    std::vector<int> categorical;  // Feature columns holding category codes (categorical engine).
+};
+
+struct Mismatch {
+    bool found;
+    std::string kind;  // "structure", "threshold", "leaf_value", "prediction", "split_loss", "rejection" or "exception".
+    std::string detail;
+};
+
+struct EngineSummary {
+    std::string engine;
+    int checked;
+    int skipped;  // The reference (or the typed tree, for the engines checked against it) rejected the case.
+    std::map<std::string, int> mismatches;  // Kind -> count.
+};
+
+const std::vector<std::string> kMismatchKinds = {"structure", "threshold", "leaf_value", "prediction", "split_loss", "rejection", "exception"};
+const std::vector<std::string> kEngines = {"typed", "sparse", "model", "fixed", "split", "missing", "categorical", "dedup"};
+
+std::string buildVersion() {
+#ifdef _OPENMP
+    return "parallel";
+#else
+    return "serial";
+#endif
+}
+
+void writeResultsToCSV(const std::vector<EngineSummary>& results, int cases, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,engine,cases,checked,skipped,mismatches";
+    for (const std::string& kind : kMismatchKinds) { file << "," << kind; }
+    file << "\n";
+
+    // Write data
+    for (const auto& r : results) {
+        int total = 0;
+        for (const auto& m : r.mismatches) { total += m.second; }
+        file << buildVersion() << ","
+             << r.engine << ","
+             << cases << ","
+             << r.checked << ","
+             << r.skipped << ","
+             << total;
+        for (const std::string& kind : kMismatchKinds) {
+            file << "," << (r.mismatches.count(kind) ? r.mismatches.at(kind) : 0);
+        }
+        file << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+/*
+ * CASE GENERATION :
+ */
+
+OracleCase generateCase(int id, unsigned base_seed, int max_rows, int max_features) {
+    /** Case `id` of the sequence of base_seed (the same on every run and platform). */
+    std::mt19937 gen(base_seed * 1000003u + (unsigned)id);
+    auto uniform_int = [&gen] (int low, int high) { return std::uniform_int_distribution<int>(low, high)(gen); };
+    auto uniform = [&gen] (double low, double high) { return std::uniform_real_distribution<double>(low, high)(gen); };
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    OracleCase c;
+    c.id = id;
+    // Rows: mostly small (deep trees, many degenerate nodes), sometimes up to max_rows.
+    const int rows = (uniform_int(0, 3) == 0) ? uniform_int(2, max_rows) : uniform_int(2, std::min(max_rows, 30));
+    const int features = uniform_int(1, max_features);
+    const int test_rows = uniform_int(0, 20);
+
+    // Columns: (kind, parameter) per feature.
+    std::vector<int> kinds(features);
+    std::vector<int> levels(features);
+    for (int f = 0; f < features; f++) {
+        kinds[f] = uniform_int(0, 6);
+        levels[f] = uniform_int(2, 6);
+        if ((kinds[f] == 5) and (f == 0)) { kinds[f] = 0; }  // Nothing to duplicate yet.
+    }
+    const double constant = std::round(uniform(-5.0, 5.0));
+    auto make_row = [&] () {
+        std::vector<double> row(features + 1);
+        for (int f = 0; f < features; f++) {
+            switch (kinds[f]) {
+                case 0: row[f] = normal(gen); break;  // Continuous.
+                case 1: row[f] = uniform_int(0, levels[f] - 1); break;  // Small integers (ties).
+                case 2: row[f] = uniform_int(0, 1); break;  // Binary.
+                case 3: row[f] = constant; break;  // Constant.
+                case 4: row[f] = (uniform_int(0, 9) < 7) ? 0.0 : uniform_int(-3, 9); break;  // Mostly zero.
+                case 5: row[f] = row[uniform_int(0, f - 1)]; break;  // Copy of an earlier column.
+                default: row[f] = std::round(normal(gen) * 1000.0) / 8.0; break;  // Large, negative, dyadic.
+            }
+        }
+        return row;
+    };
+
+    // Target: a threshold rule on one feature plus noise, or pure noise.
+    c.regression = (uniform_int(0, 3) == 0);
+    const int rule_feature = uniform_int(0, features - 1);
+    const bool rule = (uniform_int(0, 2) != 0);
+    const double noise = uniform(0.0, 0.3);
+    std::vector<double> class_values = {0, 1, 2, 3};
+    if (uniform_int(0, 2) == 0) { class_values = {1, 3, 7, 8}; }
+    const int num_classes = std::min(4, std::max(2, uniform_int(1, 5)));
+    auto make_label = [&] (const std::vector<double>& row) {
+        const double x = row[rule_feature];
+        if (c.regression) {
+            double y = rule ? ((x > 0.5) ? 10.0 : -2.0) + 3.0 * x : 0.0;
+            y += normal(gen) * (rule ? noise * 5.0 : 5.0);
+            return std::round(y);  // The reference counts labels (LabelCounter) even for regression, and asserts they are integers.
+        }
+        int k = rule ? ((x > 0.5) ? 1 : 0) + ((x > 2.5) ? 1 : 0) : uniform_int(0, num_classes - 1);
+        if (uniform(0.0, 1.0) < noise) { k = uniform_int(0, num_classes - 1); }
+        return class_values[std::min(k, num_classes - 1)];
+    };
+    for (int r = 0; r < rows + test_rows; r++) {
+        std::vector<double> row = make_row();
+        row[features] = make_label(row);
+        ((r < rows) ? c.train : c.test).push_back(row);
+    }
+
+    // Hyperparameters.
+    if (c.regression) {
+        c.loss = "mean_squared_error";
+    } else {
+        const std::vector<std::string> losses = {"gini_impurity", "cross_entropy", "misclassification_error"};
+        c.loss = losses[uniform_int(0, 2)];
+    }
+    c.mtry = ((features > 1) and (uniform_int(0, 3) == 0)) ? uniform_int(1, features - 1) : -1;
+    c.max_height = (uniform_int(0, 2) == 0) ? -1 : uniform_int(1, 8);
+    c.max_leaves = (uniform_int(0, 2) == 0) ? uniform_int(1, 12) : -1;
+    c.min_obs = (uniform_int(0, 1) == 0) ? uniform_int(1, 5) : -1;
+    c.max_prop = ((!c.regression) and (uniform_int(0, 3) == 0)) ? uniform(0.55, 1.0) : -1;
+    c.seed = uniform_int(0, 100000);
+    return c;
+}
+
+OracleCase engineCase(OracleCase c, const std::string& engine) {
+    /**
+     * Variant of a generated case for the engines that need other data: NaN cells (missing,
+     * and half the categorical cases), category codes (categorical), duplicated rows
+     * (dedup). The split engine searches every column, as its naive reference does.
+     */
+    std::mt19937 gen((unsigned)c.id * 2654435761u + (unsigned)c.seed);
+    auto uniform_int = [&gen] (int low, int high) { return std::uniform_int_distribution<int>(low, high)(gen); };
+    const int features = (int)c.train[0].size() - 1;
+    auto add_missing = [&] () {
+        // Per column: none, a few, many, most or all cells missing.
+        const std::vector<int> percents = {0, 10, 30, 70, 100};
+        for (int f = 0; f < features; f++) {
+            const int percent = percents[uniform_int(0, 4)];
+            for (auto& row : c.train) { if (uniform_int(0, 99) < percent) { row[f] = NAN; } }
+            for (auto& row : c.test) { if (uniform_int(0, 99) < percent) { row[f] = NAN; } }
+        }
+    };
+    if (engine == "split") {
+        c.mtry = -1;
+    } else if (engine == "missing") {
+        add_missing();
+    } else if (engine == "categorical") {
+        // Category codes: dense ranks over training and test rows, so test rows can hold codes unseen in training.
+        for (int f = 0; f < features; f++) {
+            if ((f > 0) and (uniform_int(0, 1) == 0)) { continue; }
+            std::vector<std::vector<double>> all = c.train;
+            all.insert(all.end(), c.test.begin(), c.test.end());
+            std::vector<double> codes(all.size());
+            std::vector<double> sorted;
+            for (const auto& row : all) { sorted.push_back(row[f]); }
+            std::sort(sorted.begin(), sorted.end());
+            sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+            for (size_t i = 0; i < all.size(); i++) {
+                const double code = std::lower_bound(sorted.begin(), sorted.end(), all[i][f]) - sorted.begin();
+                ((i < c.train.size()) ? c.train[i] : c.test[i - c.train.size()])[f] = code;
+            }
+            c.categorical.push_back(f);
+        }
+        if (uniform_int(0, 1) == 0) { add_missing(); }
+    } else if (engine == "dedup") {
+        // Every row once to three times, in shuffled order.
+        std::vector<std::vector<double>> expanded;
+        for (const auto& row : c.train) {
+            for (int k = uniform_int(1, 3); k > 0; k--) { expanded.push_back(row); }
+        }
+        std::shuffle(expanded.begin(), expanded.end(), gen);
+        c.train = expanded;
+    }
+    return c;
+}
+
+/*
+ * ENGINES :
+ */
+
+template<std::size_t N>
+std::vector<double> fixedPredictions(const TreeModel& model, DataFrame* frame, bool batched) {
+    std::unique_ptr<FixedPredictor<N>> predictor(new FixedPredictor<N>(model));  // Large node table: keep it off the stack.
+    std::vector<std::array<double, N>> rows = fixed_rows<N>(frame);
+    std::vector<double> out(rows.size());
+    if (batched) {
+        predictor->predict_batch(rows.data(), rows.size(), out.data());
+    } else {
+        for (size_t r = 0; r < rows.size(); r++) { out[r] = predictor->predict(rows[r]); }
+    }
+    return out;
+}
+
+std::vector<double> fixedPredictionsOfWidth(const TreeModel& model, DataFrame* frame, bool batched) {
+    /** FixedPredictor<N> for the model's width (the oracle generates at most 8 features). */
+    switch (model.num_features()) {
+        case 1: return fixedPredictions<1>(model, frame, batched);
+        case 2: return fixedPredictions<2>(model, frame, batched);
+        case 3: return fixedPredictions<3>(model, frame, batched);
+        case 4: return fixedPredictions<4>(model, frame, batched);
+        case 5: return fixedPredictions<5>(model, frame, batched);
+        case 6: return fixedPredictions<6>(model, frame, batched);
+        case 7: return fixedPredictions<7>(model, frame, batched);
+        case 8: return fixedPredictions<8>(model, frame, batched);
+        default: throw std::invalid_argument( "FixedPredictor check supports 1 to 8 features, got "+std::to_string(model.num_features()) );
+    }
+}
+
+bool sameValue(double expected, double actual, bool regression) {
+    /** Classification values must be identical; regression means may differ by summation order. */
+    if (!regression) {
+        return expected == actual;
+    }
+    return std::fabs(expected - actual) <= 1e-9 * std::max(1.0, std::fabs(expected));
+}
+
+std::string formatValue(double value) {
+    std::ostringstream out;
+    out << std::setprecision(17) << value;
+    return out.str();
+}
+
+Mismatch compareModels(const TreeModel& expected, const TreeModel& actual, bool regression) {
+    /** First difference between two pre-order node tables. */
+    const std::vector<ModelNode>& a = expected.nodes();
+    const std::vector<ModelNode>& b = actual.nodes();
+    if (a.size() != b.size()) {
+        return {true, "structure", std::to_string(a.size()) + " nodes expected, engine has " + std::to_string(b.size())};
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        const std::string at = "node " + std::to_string(i) + ": ";
+        if ((a[i].feature != b[i].feature) or (a[i].left != b[i].left) or (a[i].right != b[i].right) or (a[i].size != b[i].size)) {
+            return {true, "structure", at + "expected feature " + std::to_string(a[i].feature) + " children (" + std::to_string(a[i].left) + ","
+                    + std::to_string(a[i].right) + ") size " + std::to_string(a[i].size) + ", engine has feature " + std::to_string(b[i].feature)
+                    + " children (" + std::to_string(b[i].left) + "," + std::to_string(b[i].right) + ") size " + std::to_string(b[i].size)};
+        }
+        if ((a[i].feature != -1) and (a[i].threshold != b[i].threshold)) {
+            return {true, "threshold", at + "expected " + formatValue(a[i].threshold) + ", engine has " + formatValue(b[i].threshold)};
+        }
+        if ((a[i].feature == -1) and !sameValue(a[i].value, b[i].value, regression)) {
+            return {true, "leaf_value", at + "expected " + formatValue(a[i].value) + ", engine has " + formatValue(b[i].value)};
+        }
+    }
+    return {false, "", ""};
+}
+
+Mismatch comparePredictions(const std::vector<double>& expected, const std::vector<double>& actual, bool regression, const std::string& what) {
+    if (expected.size() != actual.size()) {
+        return {true, "prediction", what + ": " + std::to_string(expected.size()) + " predictions expected, engine has " + std::to_string(actual.size())};
+    }
+    for (size_t r = 0; r < expected.size(); r++) {
+        if (!sameValue(expected[r], actual[r], regression)) {
+            return {true, "prediction", what + " row " + std::to_string(r) + ": expected " + formatValue(expected[r]) + ", engine has " + formatValue(actual[r])};
+        }
+    }
+    return {false, "", ""};
+}
+
+double naiveSplitLoss(const DataFrame& frame, int col, double threshold, const std::string& loss) {
+    /** Weighted loss of a split, scored on the split frames like ::DecisionTree::calculateSplitLoss did before the split kernels. */
+    std::vector<DataFrame> sides = frame.split(col, threshold, true);
+    const int left_size = sides[0].length();
+    const int right_size = sides[1].length();
+    const int total_size = left_size + right_size;
+    LossFunction loss_func = LossFunction(loss);
+    const double left_loss = loss_func.calculate(sides[0].col(-1));
+    const double right_loss = loss_func.calculate(sides[1].col(-1));
+    return (left_loss*left_size/total_size) + (right_loss*right_size/total_size);
+}
+
+bool naiveBestThreshold(const DataFrame& frame, int col, const std::string& loss, double* threshold, double* best_loss) {
+    /** Every unique value but the largest as threshold, first lowest loss kept; false for a constant column. */
+    std::vector<double> values = frame.col(col).vector();
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    bool found = false;
+    for (size_t j = 0; j + 1 < values.size(); j++) {
+        const double split_loss = naiveSplitLoss(frame, col, values[j], loss);
+        if ((!found) or (split_loss < *best_loss)) {
+            found = true;
+            *threshold = values[j];
+            *best_loss = split_loss;
+        }
+    }
+    return found;
+}
+
+bool sameLoss(double expected, double actual) {
+    /** Losses of the kernels and of the naive scoring differ in summation order (and n*log2(n) tables). */
+    return std::fabs(expected - actual) <= 1e-9 * std::max(1.0, std::fabs(expected));
+}
+
+Mismatch checkSplits(const DecisionTree& tree, bool regression, const std::string& loss) {
+    /**
+     * At every split node of the reference tree (grown with every column, so without
+     * shuffles), score each column with the threshold kernels as findBestSplit does
+     * (ThresholdSweep, EntropyTable, and BinarySplitIndex for two-valued columns of two-class
+     * nodes) and naively, one split frame per threshold. Each column's best threshold and
+     * loss must agree, and the node's split must be the naive best over all columns.
+     * Thresholds may differ only at ties (losses equal up to rounding).
+     */
+    const ImpurityMethod impurity = impurity_method(loss);
+    std::vector<TreeNode*> stack = {tree.getRoot()};
+    for (int index = 0; !stack.empty(); index++) {
+        TreeNode* node = stack.back();
+        stack.pop_back();
+        if (node->isLeaf()) {
+            continue;
+        }
+        stack.push_back(node->getRight());
+        stack.push_back(node->getLeft());
+        const std::string at = "node " + std::to_string(index) + ": ";
+        const DataFrame frame = node->getDataFrame();
+        const std::vector<double> labels = frame.col(-1).vector();
+        std::vector<double> class_values = labels;
+        std::sort(class_values.begin(), class_values.end());
+        class_values.erase(std::unique(class_values.begin(), class_values.end()), class_values.end());
+        std::vector<int> classes(labels.size());
+        for (size_t r = 0; r < labels.size(); r++) {
+            classes[r] = std::lower_bound(class_values.begin(), class_values.end(), labels[r]) - class_values.begin();
+        }
+        const EntropyTable table(frame.length());
+        const bool use_bitsets = (!regression) and (class_values.size() == 2);
+        const BinarySplitIndex index_of_node = use_bitsets ? BinarySplitIndex(frame) : BinarySplitIndex();
+        const RowBitset members(frame.length(), true);
+        const int node_positives = use_bitsets ? count_and(members, index_of_node.positives()) : 0;
+        // Each column, kernels against naive scoring:
+        int best_column = -1;
+        double best_threshold = 0.0;
+        double best_loss = 0.0;
+        ThresholdSweep sweep;
+        for (int col = 0; col + 1 < frame.width(); col++) {
+            const std::string column = at + "column " + std::to_string(col) + ": ";
+            if (use_bitsets and index_of_node.is_binary(col)) {
+                int left_size, left_positives;
+                index_of_node.count_split(col, members, frame.length(), node_positives, &left_size, &left_positives);
+                sweep.sweep_binary(index_of_node.threshold(col), frame.length(), left_size, left_positives, node_positives);
+            } else if (regression) {
+                sweep.sweep_targets(frame.col(col).vector(), labels);
+            } else {
+                sweep.sweep_classes(frame.col(col).vector(), classes, class_values.size());
+            }
+            double kernel_loss = 0.0;
+            const int t = sweep.best(impurity, &kernel_loss, &table);
+            double naive_threshold = 0.0;
+            double naive_loss = 0.0;
+            const bool found = naiveBestThreshold(frame, col, loss, &naive_threshold, &naive_loss);
+            if ((t != -1) != found) {
+                return {true, "threshold", column + (found ? "naive best threshold " + formatValue(naive_threshold) + ", the kernels find none"
+                                                           : "constant column, the kernels split at " + formatValue(sweep.threshold(t)))};
+            }
+            if (!found) {
+                continue;
+            }
+            if (!sameLoss(naive_loss, kernel_loss)) {
+                return {true, "split_loss", column + "naive best loss " + formatValue(naive_loss) + " at " + formatValue(naive_threshold)
+                                            + ", the kernels find " + formatValue(kernel_loss) + " at " + formatValue(sweep.threshold(t))};
+            }
+            if ((sweep.threshold(t) != naive_threshold) and !sameLoss(naive_loss, naiveSplitLoss(frame, col, sweep.threshold(t), loss))) {
+                return {true, "threshold", column + "naive best threshold " + formatValue(naive_threshold) + ", the kernels pick "
+                                           + formatValue(sweep.threshold(t))};
+            }
+            if ((best_column == -1) or (naive_loss < best_loss)) {
+                best_column = col;
+                best_threshold = naive_threshold;
+                best_loss = naive_loss;
+            }
+        }
+        // The split of the node:
+        const int feature = node->getSplitFeature();
+        const double threshold = node->getSplitThreshold();
+        if (best_column == -1) {
+            return {true, "structure", at + "every column is constant, the tree splits on feature " + std::to_string(feature)};
+        }
+        if ((feature != best_column) or (threshold != best_threshold)) {
+            const double split_loss = naiveSplitLoss(frame, feature, threshold, loss);
+            if (!sameLoss(best_loss, split_loss)) {
+                return {true, "split_loss", at + "naive best split feature " + std::to_string(best_column) + " <= " + formatValue(best_threshold)
+                                            + " (loss " + formatValue(best_loss) + "), the tree splits on feature " + std::to_string(feature)
+                                            + " <= " + formatValue(threshold) + " (loss " + formatValue(split_loss) + ")"};
+            }
+        }
+    }
+    return {false, "", ""};
+}
+
+std::vector<double> rowMajor(DataFrame* frame, int num_features) {
+    /** Feature values of a frame, row after row (label column dropped). */
+    std::vector<double> values;
+    for (int r = 0; r < frame->length(); r++) {
+        for (int c = 0; c < num_features; c++) { values.push_back(frame->value(r, c)); }
+    }
+    return values;
+}
+
+bool hasLeftDefaults(const TreeModel& model) {
+    for (const ModelNode& node : model.nodes()) {
+        if (node.default_left) { return true; }
+    }
+    return false;
+}
+
+TreeModel withRightDefaults(const TreeModel& model) {
+    /** The model as file versions 1 and 2 (and FixedPredictor) route it: missing values go right. */
+    std::vector<ModelNode> nodes = model.nodes();
+    for (ModelNode& node : nodes) { node.default_left = 0; }
+    return TreeModel(model.num_features(), model.is_regression(), nodes, model.category_words());
+}
+
+void writeLegacyModel(const TreeModel& model, uint32_t version, const std::string& path) {
+    /**
+     * Model file in the layout of version 1, 2 or 3 (see model.hpp): a header without
+     * offsets and the tables right after it. Version 1 has 32-byte nodes and no category
+     * words; version 2 has no default directions, and its writer left the struct padding
+     * where default_left now is uninitialized, so it is filled with garbage here.
+     */
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error( "Cannot open file for writing: "+path );
+    }
+    const uint32_t header[6] = {
+        version, (uint32_t)model.num_features(), (uint32_t)model.is_regression(),
+        (uint32_t)model.size(), (uint32_t)model.height(), (uint32_t)model.category_words().size()
+    };
+    file.write("PDTM", 4);
+    file.write((const char*)header, ((version == 1) ? 5 : 6)*sizeof(uint32_t));
+    for (ModelNode node : model.nodes()) {
+        if (version == 2) { node.default_left = (int32_t)0xA5A5A5A5; }
+        file.write((const char*)&node, (version == 1) ? 32 : sizeof(ModelNode));
+    }
+    if (version > 1) {
+        file.write((const char*)model.category_words().data(), model.category_words().size()*sizeof(uint64_t));
+    }
+}
+
+std::string scratchPath(const std::string& name) {
+    /** Model file of a round trip (removed after use). */
+    return "/tmp/differential_oracle_" + std::to_string(::getpid()) + "_" + name + ".pdtm";
+}
+
+Mismatch checkModels(const typed::AnyTree& tree, const std::vector<std::pair<std::string, DataFrame*>>& frames, bool regression) {
+    /**
+     * The typed tree against its TreeModel, the model saved and loaded again (version 4 as
+     * written by save(), versions 1 to 3 as older writers laid them out), the mapped version
+     * 4 file, and FixedPredictor<N>. Versions 1 and 2 (and FixedPredictor) send missing
+     * values right, so they are compared with the model with right defaults; version 1 and
+     * FixedPredictor hold no category sets, and FixedPredictor must reject left defaults.
+     */
+    const TreeModel model = tree.model();
+    const TreeModel right_defaults = withRightDefaults(model);
+    const bool categorical = model.has_categorical_splits();
+    const int width = model.num_features();
+    std::vector<std::pair<std::string, TreeModel>> loaded;
+    std::vector<std::string> paths;
+    std::unique_ptr<MappedModel> mapped;
+    try {
+        for (uint32_t version = 1; version <= kModelVersion; version++) {
+            if ((version == 1) and categorical) {
+                continue;
+            }
+            paths.push_back(scratchPath("v" + std::to_string(version)));
+            if (version == kModelVersion) {
+                model.save(paths.back());
+            } else {
+                writeLegacyModel(model, version, paths.back());
+            }
+            loaded.push_back({"version " + std::to_string(version) + " file", TreeModel::load(paths.back())});
+        }
+        mapped.reset(new MappedModel(paths.back()));
+    } catch (const std::exception&) {
+        for (const std::string& path : paths) { std::remove(path.c_str()); }
+        throw;
+    }
+    for (const std::string& path : paths) { std::remove(path.c_str()); }
+    for (const auto& file : loaded) {
+        const bool right = (file.first == "version 1 file") or (file.first == "version 2 file");
+        Mismatch m = compareModels(right ? right_defaults : model, file.second, regression);
+        if (m.found) {
+            m.detail = file.first + " " + m.detail;
+            return m;
+        }
+    }
+    bool fixed_rejects = false;
+    try {
+        fixedPredictionsOfWidth(model, frames[0].second, false);
+    } catch (const std::invalid_argument&) {
+        fixed_rejects = true;
+    }
+    if (fixed_rejects != (categorical or hasLeftDefaults(model))) {
+        return {true, "rejection", std::string("FixedPredictor ") + (fixed_rejects ? "rejects" : "accepts") + " a model with"
+                + (categorical ? "" : "out") + " category sets and with" + (hasLeftDefaults(model) ? "" : "out") + " left defaults"};
+    }
+    for (const auto& frame : frames) {
+        const std::vector<double> expected = tree.predict(frame.second).vector();
+        const std::vector<double> expected_right = right_defaults.predict(frame.second).vector();
+        Mismatch m = comparePredictions(expected, model.predict(frame.second).vector(), regression, frame.first + " (model)");
+        if (m.found) { return m; }
+        for (const auto& file : loaded) {
+            const bool right = (file.first == "version 1 file") or (file.first == "version 2 file");
+            m = comparePredictions(right ? expected_right : expected, file.second.predict(frame.second).vector(), regression, frame.first + " (" + file.first + ")");
+            if (m.found) { return m; }
+        }
+        const std::vector<double> rows = rowMajor(frame.second, width);
+        std::vector<double> out(frame.second->length());
+        mapped->predict_batch(rows.data(), out.size(), width, out.data());
+        m = comparePredictions(expected, out, regression, frame.first + " (mapped file)");
+        if (m.found) { return m; }
+        if (!categorical) {
+            // Right defaults always, so FixedPredictor sees missing values either way:
+            m = comparePredictions(expected_right, fixedPredictionsOfWidth(right_defaults, frame.second, false), regression, frame.first + " (FixedPredictor)");
+            if (m.found) { return m; }
+            m = comparePredictions(expected_right, fixedPredictionsOfWidth(right_defaults, frame.second, true), regression, frame.first + " (FixedPredictor, batched)");
+            if (m.found) { return m; }
+        }
+    }
+    return {false, "", ""};
+}
+
+std::vector<std::vector<double>> distinctRows(const std::vector<std::vector<double>>& rows, std::vector<int>* counts) {
+    /** Rows in order of first appearance, with their number of copies (naive, pairwise). */
+    std::vector<std::vector<double>> distinct;
+    counts->clear();
+    for (const auto& row : rows) {
+        const auto found = std::find(distinct.begin(), distinct.end(), row);
+        if (found == distinct.end()) {
+            distinct.push_back(row);
+            counts->push_back(1);
+        } else {
+            (*counts)[found - distinct.begin()] += 1;
+        }
+    }
+    return distinct;
+}
+
+Mismatch checkTypedEngine(const OracleCase& c, const std::string& engine, bool* skipped) {
+    /** The engines checked against the typed tree (the reference rejects NaN and has no categorical splits). */
+    DataFrame train(c.train);
+    DataFrame test = c.test.empty() ? DataFrame() : DataFrame(c.test);
+    std::vector<std::pair<std::string, DataFrame*>> frames = {{"train", &train}};
+    if (!c.test.empty()) { frames.push_back({"test", &test}); }
+    std::unique_ptr<typed::AnyTree> tree;
+    try {
+        tree = typed::make_tree(train, c.regression, c.loss, c.mtry, c.max_height, c.max_leaves, c.min_obs, c.max_prop, c.seed, false, c.categorical);
+    } catch (const std::invalid_argument&) {
+        if (skipped != nullptr) { *skipped = true; }
+        return {false, "", ""};
+    }
+    try {
+        if (engine == "dedup") {
+            std::vector<int> counts;
+            DataFrame distinct(distinctRows(c.train, &counts));
+            std::unique_ptr<typed::AnyTree> weighted = typed::make_tree(distinct, c.regression, c.loss, c.mtry, c.max_height, c.max_leaves, c.min_obs, c.max_prop, c.seed, false, c.categorical, counts);
+            Mismatch m = compareModels(tree->model(), weighted->model(), c.regression);
+            if (m.found) { return m; }
+            for (const auto& frame : frames) {
+                m = comparePredictions(tree->predict(frame.second).vector(), weighted->predict(frame.second).vector(), c.regression, frame.first);
+                if (m.found) { return m; }
+            }
+            return {false, "", ""};
+        }
+        return checkModels(*tree, frames, c.regression);
+    } catch (const std::exception& e) {
+        return {true, "exception", e.what()};
+    }
+}
+
+bool runReference(const OracleCase& c, std::unique_ptr<DecisionTree>& tree) {
+    /** Train the reference; false if it rejects the case (an invalid case, not a mismatch). */
+    try {
+        tree.reset(new DecisionTree(DataFrame(c.train), c.regression, c.loss, c.mtry, c.max_height, c.max_leaves, c.min_obs, c.max_prop, c.seed));
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+Mismatch checkEngine(const OracleCase& c, const std::string& engine, bool* skipped = nullptr) {
+    /** Compare one engine with the reference on one case. */
+    std::unique_ptr<DecisionTree> reference;
+    if (skipped != nullptr) { *skipped = false; }
+    if ((engine == "missing") or (engine == "categorical") or (engine == "dedup")) {
+        return checkTypedEngine(c, engine, skipped);
+    }
+    if (!runReference(c, reference)) {
+        if (skipped != nullptr) { *skipped = true; }
+        return {false, "", ""};
+    }
+    DataFrame train(c.train);
+    DataFrame test = c.test.empty() ? DataFrame() : DataFrame(c.test);
+    std::vector<std::pair<std::string, DataFrame*>> frames = {{"train", &train}};
+    if (!c.test.empty()) { frames.push_back({"test", &test}); }
+    const TreeModel expected(*reference);
+    try {
+        if (engine == "split") {
+            return checkSplits(*reference, c.regression, c.loss);
+        }
+        for (const auto& frame : frames) {
+            const std::vector<double> expected_predictions = reference->predict(frame.second).vector();
+            std::vector<std::vector<double>> actual;
+            if (engine == "typed") {
+                std::unique_ptr<typed::AnyTree> tree = typed::make_tree(train, c.regression, c.loss, c.mtry, c.max_height, c.max_leaves, c.min_obs, c.max_prop, c.seed);
+                if (frame.first == "train") {
+                    Mismatch m = compareModels(expected, tree->model(), c.regression);
+                    if (m.found) { return m; }
+                }
+                actual.push_back(tree->predict(frame.second).vector());
+            } else if (engine == "sparse") {
+                TreeModel model = train_sparse_tree(SparseMatrix(train), c.regression, c.loss, c.mtry, c.max_height, c.max_leaves, c.min_obs, c.max_prop, c.seed);
+                if (frame.first == "train") {
+                    Mismatch m = compareModels(expected, model, c.regression);
+                    if (m.found) { return m; }
+                }
+                actual.push_back(predict_sparse(model, SparseMatrix(*frame.second)));
+            } else if (engine == "model") {
+                actual.push_back(expected.predict(frame.second).vector());
+            } else if (engine == "fixed") {
+                actual.push_back(fixedPredictionsOfWidth(expected, frame.second, false));
+                actual.push_back(fixedPredictionsOfWidth(expected, frame.second, true));
+            } else {
+                throw std::invalid_argument( "Unknown engine: "+engine );
+            }
+            for (size_t k = 0; k < actual.size(); k++) {
+                Mismatch m = comparePredictions(expected_predictions, actual[k], c.regression, frame.first + ((k > 0) ? " (batched)" : ""));
+                if (m.found) { return m; }
+            }
+        }
+    } catch (const std::invalid_argument& e) {
+        if (std::string(e.what()).find("Unknown engine") == 0) { throw; }
+        return {true, "exception", e.what()};
+    } catch (const std::exception& e) {
+        return {true, "exception", e.what()};
+    }
+    return {false, "", ""};
+}
+
+/*
+ * SHRINKING :
+ */
+
+std::vector<double> ranks(const std::vector<std::vector<double>>& rows, int col) {
+    /** Dense rank (0, 1, 2, ...) of each row's value in a column (missing values stay NaN). */
+    std::vector<double> values;
+    std::vector<double> sorted;
+    for (const auto& row : rows) {
+        values.push_back(row[col]);
+        if (!std::isnan(row[col])) { sorted.push_back(row[col]); }
+    }
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    for (double& v : values) {
+        if (!std::isnan(v)) { v = std::lower_bound(sorted.begin(), sorted.end(), v) - sorted.begin(); }
+    }
+    return values;
+}
+
+OracleCase shrinkCase(OracleCase c, const std::string& engine, const std::string& kind) {
+    /**
+     * Smallest variant of a failing case that still fails the same way (same mismatch kind):
+     * drop chunks of training rows, then test rows, then feature columns, reset
+     * hyperparameters to their defaults, and replace feature values by their ranks.
+     * Repeats until no step makes progress.
+     */
+    auto fails = [&engine, &kind] (const OracleCase& x) {
+        Mismatch m = checkEngine(x, engine);
+        return m.found and (m.kind == kind);
+    };
+    auto shrinkRows = [&fails] (OracleCase& x, bool test_rows, size_t min_rows) {
+        bool progress = false;
+        std::vector<std::vector<double>>& rows = test_rows ? x.test : x.train;
+        for (size_t chunk = std::max<size_t>(1, rows.size() / 2); chunk >= 1; chunk /= 2) {
+            size_t start = 0;
+            while ((start + chunk <= rows.size()) and (rows.size() - chunk >= min_rows)) {
+                OracleCase candidate = x;
+                std::vector<std::vector<double>>& candidate_rows = test_rows ? candidate.test : candidate.train;
+                candidate_rows.erase(candidate_rows.begin() + start, candidate_rows.begin() + start + chunk);
+                if (fails(candidate)) {
+                    x = candidate;
+                    progress = true;
+                } else {
+                    start += chunk;
+                }
+            }
+        }
+        return progress;
+    };
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        progress |= shrinkRows(c, false, 2);
+        progress |= shrinkRows(c, true, 0);
+        // Feature columns (keep one):
+        for (int col = (int)c.train[0].size() - 2; (col >= 0) and (c.train[0].size() > 2); col--) {
+            OracleCase candidate = c;
+            for (auto& row : candidate.train) { row.erase(row.begin() + col); }
+            for (auto& row : candidate.test) { row.erase(row.begin() + col); }
+            std::vector<int> categorical;
+            for (int f : candidate.categorical) {
+                if (f != col) { categorical.push_back((f > col) ? f - 1 : f); }
+            }
+            candidate.categorical = categorical;
+            if (candidate.mtry >= (int)candidate.train[0].size() - 1) { candidate.mtry = -1; }
+            if (fails(candidate)) {
+                c = candidate;
+                progress = true;
+            }
+        }
+        // Hyperparameters back to their defaults:
+        const std::vector<std::function<void(OracleCase&)>> defaults = {
+            [] (OracleCase& x) { x.mtry = -1; },
+            [] (OracleCase& x) { x.max_height = -1; },
+            [] (OracleCase& x) { x.max_leaves = -1; },
+            [] (OracleCase& x) { x.min_obs = -1; },
+            [] (OracleCase& x) { x.max_prop = -1; },
+            [] (OracleCase& x) { x.seed = 0; },
+        };
+        for (const auto& reset : defaults) {
+            OracleCase candidate = c;
+            reset(candidate);
+            if ((candidate.mtry != c.mtry) or (candidate.max_height != c.max_height) or (candidate.max_leaves != c.max_leaves)
+                or (candidate.min_obs != c.min_obs) or (candidate.max_prop != c.max_prop) or (candidate.seed != c.seed)) {
+                if (fails(candidate)) {
+                    c = candidate;
+                    progress = true;
+                }
+            }
+        }
+        // Feature values by their ranks (training and test rows ranked together):
+        for (int col = 0; col + 1 < (int)c.train[0].size(); col++) {
+            OracleCase candidate = c;
+            std::vector<std::vector<double>> all = c.train;
+            all.insert(all.end(), c.test.begin(), c.test.end());
+            std::vector<double> r = ranks(all, col);
+            for (size_t i = 0; i < all.size(); i++) {
+                ((i < c.train.size()) ? candidate.train[i] : candidate.test[i - c.train.size()])[col] = r[i];
+            }
+            if ((candidate.train != c.train) or (candidate.test != c.test)) {
+                if (fails(candidate)) {
+                    c = candidate;
+                    progress = true;
+                }
+            }
+        }
+    }
+    return c;
+}
+
+void writeRows(const std::vector<std::vector<double>>& rows, const std::string& path) {
+    /** CSV without header, label last (as DataLoader reads it), full precision, missing values as NaN. */
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error( "Cannot open file for writing: "+path );
+    }
+    for (const auto& row : rows) {
+        for (size_t i = 0; i < row.size(); i++) {
+            file << ((i > 0) ? "," : "");
+            if (std::isnan(row[i])) {
+                file << "NaN";  // Read back with missing_as_nan.
+            } else {
+                file << std::setprecision(17) << row[i];
+            }
+        }
+        file << "\n";
+    }
+}
+
+std::string replayCommand(const OracleCase& c, const std::string& engine, const std::string& train_path, const std::string& test_path) {
+    std::ostringstream out;
+    out << "./differential_oracle --replay " << train_path;
+    if (!test_path.empty()) { out << " --replay-test " << test_path; }
+    out << " --engine " << engine << (c.regression ? " --regression" : "") << " --loss " << c.loss
+        << " --mtry " << c.mtry << " --depth " << c.max_height << " --leaves " << c.max_leaves
+        << " --min-obs " << c.min_obs << " --max-prop " << formatValue(c.max_prop) << " --tree-seed " << c.seed;
+    for (size_t i = 0; i < c.categorical.size(); i++) {
+        out << ((i == 0) ? " --categorical " : ",") << c.categorical[i];
+    }
+    return out.str();
+}
+
+/*
+ * COMMAND LINE :
+ */
+
+struct OracleOptions {
+    int cases;
+    unsigned seed;
+    std::vector<std::string> engines;
+    int max_rows;
+    int max_features;
+    int max_repros;  // Mismatches shrunk and written per engine.
+    std::string repro_dir;
+    std::string output;
+    int threads;
+    // Replay mode:
+    std::string replay;
+    std::string replay_test;
+    OracleCase replay_case;
+    std::string replay_engine;
+};
+
+std::vector<std::string> parseStrings(const std::string& list) {
+    std::vector<std::string> values;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) { values.push_back(item); }
+    return values;
+}
+
+OracleOptions parseArgs(int argc, char** argv) {
+    OracleOptions options;
+    options.cases = 2000;
+    options.seed = 1;
+    options.engines = kEngines;
+    options.max_rows = 120;
+    options.max_features = 8;
+    options.max_repros = 3;
+    options.repro_dir = ".";
+    options.output = "oracle_results_" + buildVersion() + ".csv";
+    options.threads = -1;
+    OracleCase& r = options.replay_case;
+    r.id = -1;
+    r.regression = false;
+    r.loss = "gini_impurity";
+    r.mtry = -1;
+    r.max_height = -1;
+    r.max_leaves = -1;
+    r.min_obs = -1;
+    r.max_prop = -1;
+    r.seed = 0;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool has_value = (i + 1 < argc);
+        if ((arg == "--cases") and has_value) { options.cases = std::stoi(argv[++i]); }
+        else if ((arg == "--seed") and has_value) { options.seed = (unsigned)std::stoul(argv[++i]); }
+        else if ((arg == "--engines") and has_value) { options.engines = parseStrings(argv[++i]); }
+        else if ((arg == "--max-rows") and has_value) { options.max_rows = std::stoi(argv[++i]); }
+        else if ((arg == "--max-features") and has_value) { options.max_features = std::stoi(argv[++i]); }
+        else if ((arg == "--max-repros") and has_value) { options.max_repros = std::stoi(argv[++i]); }
+        else if ((arg == "--repro-dir") and has_value) { options.repro_dir = argv[++i]; }
+        else if ((arg == "--out") and has_value) { options.output = argv[++i]; }
+        else if ((arg == "--threads") and has_value) { options.threads = std::stoi(argv[++i]); }
+        else if ((arg == "--replay") and has_value) { options.replay = argv[++i]; }
+        else if ((arg == "--replay-test") and has_value) { options.replay_test = argv[++i]; }
+        else if ((arg == "--engine") and has_value) { options.replay_engine = argv[++i]; }
+        else if (arg == "--regression") { r.regression = true; }
+        else if ((arg == "--loss") and has_value) { r.loss = argv[++i]; }
+        else if ((arg == "--mtry") and has_value) { r.mtry = std::stoi(argv[++i]); }
+        else if ((arg == "--depth") and has_value) { r.max_height = std::stoi(argv[++i]); }
+        else if ((arg == "--leaves") and has_value) { r.max_leaves = std::stoi(argv[++i]); }
+        else if ((arg == "--min-obs") and has_value) { r.min_obs = std::stoi(argv[++i]); }
+        else if ((arg == "--max-prop") and has_value) { r.max_prop = std::stod(argv[++i]); }
+        else if ((arg == "--tree-seed") and has_value) { r.seed = std::stoi(argv[++i]); }
+        else if ((arg == "--categorical") and has_value) {
+            for (const std::string& col : parseStrings(argv[++i])) { r.categorical.push_back(std::stoi(col)); }
+        }
+        else { throw std::invalid_argument( "Unknown or incomplete option: "+arg ); }
+    }
+    for (const std::string& engine : options.engines) {
+        if (std::find(kEngines.begin(), kEngines.end(), engine) == kEngines.end()) {
+            throw std::invalid_argument( "Unknown engine: "+engine );
+        }
+    }
+    if ((options.max_rows < 2) or (options.max_features < 1) or (options.max_features > 8)) {
+        throw std::invalid_argument( "Need --max-rows >= 2 and 1 <= --max-features <= 8" );
+    }
+    if (!options.replay.empty() and (std::find(kEngines.begin(), kEngines.end(), options.replay_engine) == kEngines.end())) {
+        throw std::invalid_argument( "--replay needs --engine typed|sparse|model|fixed|split|missing|categorical|dedup" );
+    }
+    return options;
+}
+
+std::vector<std::vector<double>> loadRows(const std::string& path) {
+    DataFrame frame = DataLoader(path, true).load();
+    std::vector<std::vector<double>> rows;
+    for (int r = 0; r < frame.length(); r++) { rows.push_back(frame.row(r)->vector()); }
+    return rows;
+}
+
+int replay(const OracleOptions& options) {
+    OracleCase c = options.replay_case;
+    c.train = loadRows(options.replay);
+    if (!options.replay_test.empty()) { c.test = loadRows(options.replay_test); }
+    bool skipped = false;
+    Mismatch m = checkEngine(c, options.replay_engine, &skipped);
+    if (skipped) {
+        std::cout << "The reference rejects this case." << std::endl;
+        return 2;
+    }
+    std::cout << options.replay_engine << ": " << (m.found ? "MISMATCH (" + m.kind + ") " + m.detail : "agrees with the reference") << std::endl;
+    return m.found ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    OracleOptions options;
+    try {
+        options = parseArgs(argc, argv);
+#ifdef _OPENMP
+        if (options.threads > 0) { omp_set_num_threads(options.threads); }
+#endif
+        if (!options.replay.empty()) {
+            return replay(options);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+
+    std::cout << "=== Differential Correctness Oracle (" << buildVersion() << " reference) ===" << std::endl;
+    std::cout << "Cases: " << options.cases << ", seed: " << options.seed << ", rows <= " << options.max_rows
+              << ", features <= " << options.max_features << std::endl;
+
+    std::vector<EngineSummary> summaries;
+    bool any_mismatch = false;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const std::string& engine : options.engines) {
+        EngineSummary summary = {engine, 0, 0, {}};
+        int repros = 0;
+        for (int id = 0; id < options.cases; id++) {
+            const OracleCase c = engineCase(generateCase(id, options.seed, options.max_rows, options.max_features), engine);
+            bool skipped = false;
+            Mismatch m = checkEngine(c, engine, &skipped);
+            if (skipped) {
+                summary.skipped += 1;
+                continue;
+            }
+            summary.checked += 1;
+            if (!m.found) {
+                continue;
+            }
+            summary.mismatches[m.kind] += 1;
+            if (repros >= options.max_repros) {
+                continue;
+            }
+            repros += 1;
+            // Shrink and write the minimal reproduction:
+            const OracleCase minimal = shrinkCase(c, engine, m.kind);
+            const Mismatch minimal_mismatch = checkEngine(minimal, engine);
+            const std::string stem = options.repro_dir + "/oracle_repro_" + engine + "_" + std::to_string(id);
+            const std::string test_path = minimal.test.empty() ? "" : stem + "_test.csv";
+            try {
+                writeRows(minimal.train, stem + "_train.csv");
+                if (!test_path.empty()) { writeRows(minimal.test, test_path); }
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                return 2;
+            }
+            std::cout << "  MISMATCH " << engine << " case " << id << " (" << m.kind << "): " << m.detail << std::endl;
+            std::cout << "    shrunk from " << c.train.size() << "x" << c.train[0].size() - 1 << " to " << minimal.train.size()
+                      << "x" << minimal.train[0].size() - 1 << ": " << minimal_mismatch.detail << std::endl;
+            std::cout << "    replay: " << replayCommand(minimal, engine, stem + "_train.csv", test_path) << std::endl;
+        }
+        int total = 0;
+        for (const auto& kind : summary.mismatches) { total += kind.second; }
+        any_mismatch |= (total > 0);
+        std::cout << "  " << std::left << std::setw(11) << engine << std::right
+                  << " Checked=" << summary.checked << ", Skipped=" << summary.skipped << ", Mismatches=" << total;
+        for (const auto& kind : summary.mismatches) { std::cout << " " << kind.first << "=" << kind.second; }
+        std::cout << (total == 0 ? "  ok" : "  FAILED") << std::endl;
+        summaries.push_back(summary);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // Save combined results
+    writeResultsToCSV(summaries, options.cases, options.output);
+
+    std::cout << "\nOracle completed in " << std::fixed << std::setprecision(1)
+              << std::chrono::duration<double>(end - start).count() << "s: "
+              << (any_mismatch ? "engines DISAGREE with the reference" : "every engine agrees with the reference") << std::endl;
+
+    return any_mismatch ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <iomanip>
+#include <string>
+#include <cmath>
+#include <memory>
+
+// Serial implementation includes
+#include "src/datasets.cpp"
+#include "src/synthetic.cpp"
+
+/*
+ * Writes benchmark workloads of any size, as binary frames (load_binary_frame) or,
+ * for names ending in .csv, as CSV files that DataLoader reads (missing cells empty, read
+ * back as NaN with DataLoader(path, true)).
+ *
+ *   ./generate_data hmeq <rows> <output> [jitter=0.05] [seed=42]
+ *   ./generate_data cancer <rows> <output> [jitter=0.05] [seed=42]
+ *   ./generate_data synthetic <rows> <features> <output> [classes=2] [cardinality=0] [balance=1]
+ *                   [noise=0.1] [informative=0.5] [categorical=0] [missing=0] [seed=42]
+ */
+
+void usage() {
+    std::cout << "Usage:\n"
+              << "  generate_data hmeq|cancer <rows> <output> [jitter=0.05] [seed=42]\n"
+              << "  generate_data synthetic <rows> <features> <output> [classes=2] [cardinality=0] [balance=1]\n"
+              << "                [noise=0.1] [informative=0.5] [categorical=0] [missing=0] [seed=42]\n"
+              << "Output ending in .csv is written as CSV, anything else as a binary frame." << std::endl;
+}
+
+void writeCSV(const SyntheticGenerator& generator, const std::string& path) {
+    /** Stream every row to a CSV file (NaN written as an empty cell). */
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error( "Cannot open data file for writing: "+path );
+    }
+    file << std::setprecision(17);
+    std::vector<double> row(generator.width());
+    for (int64_t r = 0; r < generator.length(); r++) {
+        generator.fill_row(r, &row[0]);
+        for (int c = 0; c < generator.width(); c++) {
+            if (c > 0) { file << ","; }
+            if (!std::isnan(row[c])) { file << row[c]; }
+        }
+        file << "\n";
+    }
+    if (!file) {
+        throw std::runtime_error( "Failed to write data file: "+path );
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    const bool scaled = (args.size() >= 3) and ((args[0] == "hmeq") or (args[0] == "cancer"));
+    const bool synthetic = (args.size() >= 4) and (args[0] == "synthetic");
+    if (!scaled and !synthetic) {
+        usage();
+        return 1;
+    }
+    auto arg = [&] (size_t i, double fallback) { return (i < args.size()) ? std::stod(args[i]) : fallback; };
+
+    try {
+        const int64_t rows = std::stoll(args[1]);
+        std::string output;
+        std::unique_ptr<SyntheticGenerator> generator;
+        if (scaled) {
+            output = args[2];
+            DataFrame source = DataLoader("data/" + args[0] + "_clean.csv").load();
+            generator.reset(new SyntheticGenerator(source, rows, arg(3, 0.05), (uint64_t)arg(4, 42)));
+            std::cout << "Scaling " << args[0] << " (" << source.length() << " rows) to " << rows << " rows" << std::endl;
+        } else {
+            output = args[3];
+            generator.reset(new SyntheticGenerator(rows, std::stoi(args[2]), (int)arg(4, 2), (int)arg(5, 0), arg(6, 1.0),
+                                                   arg(7, 0.1), arg(8, 0.5), arg(9, 0.0), 16, arg(10, 0.0), (uint64_t)arg(11, 42)));
+            std::cout << "Generating " << rows << " x " << args[2] << " synthetic rows" << std::endl;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        const bool csv = (output.size() >= 4) and (output.compare(output.size()-4, 4, ".csv") == 0);
+        if (csv) {
+            writeCSV(*generator, output);
+        } else {
+            generator->save(output);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Wrote " << output << " (" << generator->width() << " columns) in "
+                  << std::fixed << std::setprecision(2) << std::chrono::duration<double>(end - start).count() << "s" << std::endl;
+        std::vector<int> categorical = generator->categorical_columns();
+        if (!categorical.empty()) {
+            std::cout << "Categorical columns:";
+            for (int c : categorical) { std::cout << " " << c; }
+            std::cout << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,20 @@
+// Serial implementation includes (the library wraps a TreeModel loaded from a model file)
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#include "src/model.cpp"
+#include "src/pdt.cpp"
+
+/*
+ * Shared library with the C interface of src/pdt.h. Everything but the pdt_* functions
+ * is compiled with hidden visibility and the version script src/pdt.map keeps the
+ * standard library template instantiations local too, so the library exports the C ABI only:
+ *
+ *   g++ -std=c++14 -O2 -fPIC -shared -fvisibility=hidden -fvisibility-inlines-hidden \
+ *       -Wl,--version-script=src/pdt.map libpdt.cpp -o libpdt.so
+ */
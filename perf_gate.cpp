@@ -0,0 +1,485 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <iomanip>
+#include <random>
+#include <cmath>
+#include <memory>
+#include <algorithm>
+
+#ifdef _OPENMP
+// Include the PARALLEL modules (checks the parallel baselines)
+#include <omp.h>
+#include "src-openmp/datasets.cpp"
+#include "src-openmp/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src-openmp/metrics.cpp"
+#include "src-openmp/tree_node.cpp"
+#include "src-openmp/decision_tree.cpp"
+#else
+// Serial implementation includes (checks the serial baselines)
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#endif
+
+/*
+ * Performance regression gate.
+ *
+ *   ./perf_gate run <baseline.csv> [options]
+ *       Rerun every configuration of a stored result file (benchmark_results_*.csv,
+ *       cv_results_*.csv, or a samples file written by --samples) and compare.
+ *   ./perf_gate compare <baseline_samples.csv> <candidate_samples.csv> [options]
+ *       Compare two samples files without running anything.
+ *
+ * Options:
+ *   --runs N                 Timed repetitions per configuration (default 15).
+ *   --time-threshold X       Tolerated slowdown, as a fraction of the baseline time (default 0.10).
+ *   --accuracy-threshold X   Tolerated absolute change of any accuracy (default 0.005).
+ *   --alpha X                Significance level of the tests (default 0.05).
+ *   --min-time-ms X          Skip the time check below this baseline time (default 0.5).
+ *   --threads N              OpenMP threads (parallel build only).
+ *   --samples FILE           Write the candidate's per-run times (usable as a later baseline).
+ *
+ * A time regression needs both statistical evidence and a slowdown beyond the threshold:
+ * against a samples file, a one-sided Mann-Whitney U test (candidate slower, p < alpha) with
+ * median ratio above 1 + threshold; against a result file, which only holds the baseline
+ * median, the lower end of the 95% bootstrap interval of the candidate median must exceed
+ * baseline * (1 + threshold). Exit status: 0 pass, 1 regression, 2 usage or input error.
+ */
+
+struct GateOptions {
+    int runs;
+    double time_threshold;
+    double accuracy_threshold;
+    double alpha;
+    double min_time_ms;
+    int threads;
+    std::string samples;
+};
+
+struct GateCheck {
+    std::string kind;  // "tree" (train/test split) or "cv" (4 folds).
+    std::string dataset;
+    int max_depth;
+    std::vector<double> baseline_times;  // One value (result file median) or every run (samples file).
+    std::vector<double> candidate_times;
+    std::map<std::string, double> baseline_accuracy;  // Accuracy name -> value.
+    std::map<std::string, double> candidate_accuracy;
+    double ratio;  // median(candidate) / median(baseline).
+    double ratio_low;  // 95% interval of the ratio (bootstrap, point baselines only).
+    double ratio_high;
+    double p_value;  // Mann-Whitney, samples baselines only (-1 otherwise).
+    std::string verdict;  // "ok", "faster", "skip", "SLOWER" or "ACCURACY".
+};
+
+/*
+ * CSV FILES :
+ */
+
+std::vector<std::map<std::string, std::string>> readCSV(const std::string& path) {
+    /** Rows of a CSV file with a header line, as column name -> cell (throws std::runtime_error). */
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error( "Cannot open "+path );
+    }
+    auto split = [] (const std::string& line) {
+        std::vector<std::string> cells;
+        std::stringstream stream(line);
+        std::string cell;
+        while (std::getline(stream, cell, ',')) { cells.push_back(cell); }
+        if (!line.empty() and (line.back() == ',')) { cells.push_back(""); }
+        return cells;
+    };
+    std::string line;
+    std::getline(file, line);
+    const std::vector<std::string> header = split(line);
+    std::vector<std::map<std::string, std::string>> rows;
+    while (std::getline(file, line)) {
+        if (!line.empty() and (line.back() == '\r')) { line.pop_back(); }
+        if (line.empty()) { continue; }
+        std::vector<std::string> cells = split(line);
+        std::map<std::string, std::string> row;
+        for (size_t c = 0; c < header.size() and c < cells.size(); c++) { row[header[c]] = cells[c]; }
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+std::vector<GateCheck> loadBaseline(const std::string& path, std::string& version) {
+    /**
+     * Configurations of a result file (one median per row) or of a samples file (one row per
+     * run). version is the engine that produced them ("serial", "parallel", ...).
+     */
+    std::vector<std::map<std::string, std::string>> rows = readCSV(path);
+    if (rows.empty()) {
+        throw std::runtime_error( "No rows in "+path );
+    }
+    const std::map<std::string, std::string>& first = rows[0];
+    const bool samples = first.count("run") and first.count("time_ms");
+    const bool cv = first.count("cv_training_time_ms") > 0;
+    if (!samples and !cv and !first.count("train_time_ms")) {
+        throw std::runtime_error( "Not a benchmark result or samples file: "+path );
+    }
+    version = first.at("version");
+    if ((version.size() > 3) and (version.compare(version.size()-3, 3, "_cv") == 0)) {
+        version = version.substr(0, version.size()-3);
+    }
+    std::vector<GateCheck> checks;
+    std::map<std::string, size_t> index;
+    for (const std::map<std::string, std::string>& row : rows) {
+        GateCheck check;
+        check.kind = samples ? row.at("kind") : (cv ? "cv" : "tree");
+        check.dataset = row.at("dataset");
+        check.max_depth = std::stoi(row.at("max_depth"));
+        const std::string key = check.kind + "/" + check.dataset + "/" + row.at("max_depth");
+        if (samples) {
+            if (!index.count(key)) {
+                index[key] = checks.size();
+                checks.push_back(check);
+            }
+            GateCheck& existing = checks[index[key]];
+            existing.baseline_times.push_back(std::stod(row.at("time_ms")));
+            for (const char* name : {"train_accuracy", "test_accuracy", "mean_cv_accuracy"}) {
+                if (row.count(name) and !row.at(name).empty()) { existing.baseline_accuracy[name] = std::stod(row.at(name)); }
+            }
+        } else {
+            check.baseline_times.push_back(std::stod(row.at(cv ? "cv_training_time_ms" : "train_time_ms")));
+            if (cv) {
+                check.baseline_accuracy["mean_cv_accuracy"] = std::stod(row.at("mean_cv_accuracy"));
+            } else {
+                check.baseline_accuracy["train_accuracy"] = std::stod(row.at("train_accuracy"));
+                check.baseline_accuracy["test_accuracy"] = std::stod(row.at("test_accuracy"));
+            }
+            checks.push_back(check);
+        }
+    }
+    return checks;
+}
+
+void writeSamples(const std::vector<GateCheck>& checks, const std::string& version, const std::string& filename) {
+    /** Candidate runs as a samples file: one row per configuration and run. */
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,kind,dataset,max_depth,run,time_ms,train_accuracy,test_accuracy,mean_cv_accuracy\n";
+
+    // Write data
+    for (const GateCheck& c : checks) {
+        for (size_t run = 0; run < c.candidate_times.size(); run++) {
+            file << version << ","
+                 << c.kind << ","
+                 << c.dataset << ","
+                 << c.max_depth << ","
+                 << run << ","
+                 << std::fixed << std::setprecision(4) << c.candidate_times[run];
+            for (const char* name : {"train_accuracy", "test_accuracy", "mean_cv_accuracy"}) {
+                file << ",";
+                if (c.candidate_accuracy.count(name)) { file << std::fixed << std::setprecision(4) << c.candidate_accuracy.at(name); }
+            }
+            file << "\n";
+        }
+    }
+
+    file.close();
+    std::cout << "Samples saved to " << filename << std::endl;
+}
+
+/*
+ * STATISTICS :
+ */
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const size_t n = values.size();
+    return (n % 2 == 1) ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+double mannWhitneyGreater(const std::vector<double>& candidate, const std::vector<double>& baseline) {
+    /**
+     * One-sided p-value of the Mann-Whitney U test for "candidate tends to be larger",
+     * from the normal approximation with tie and continuity corrections.
+     */
+    const double n1 = candidate.size();
+    const double n2 = baseline.size();
+    std::vector<std::pair<double, int>> pooled;
+    for (double v : candidate) { pooled.push_back(std::make_pair(v, 0)); }
+    for (double v : baseline) { pooled.push_back(std::make_pair(v, 1)); }
+    std::sort(pooled.begin(), pooled.end());
+    // Mid-ranks of tied groups, and the tie term of the variance:
+    double rank_sum = 0.0;
+    double ties = 0.0;
+    for (size_t i = 0; i < pooled.size(); ) {
+        size_t j = i;
+        while ((j < pooled.size()) and (pooled[j].first == pooled[i].first)) { j++; }
+        const double rank = 0.5 * (i + 1 + j);
+        for (size_t k = i; k < j; k++) {
+            if (pooled[k].second == 0) { rank_sum += rank; }
+        }
+        const double t = j - i;
+        ties += t*t*t - t;
+        i = j;
+    }
+    const double u = rank_sum - n1*(n1 + 1)/2;
+    const double n = n1 + n2;
+    const double variance = n1*n2/12.0 * ((n + 1) - ties/(n*(n - 1)));
+    if (variance <= 0.0) {
+        return 1.0;  // Every value equal.
+    }
+    const double z = (u - n1*n2/2 - 0.5) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+void bootstrapRatio(const std::vector<double>& candidate, double baseline, double* low, double* high) {
+    /** 95% percentile bootstrap interval of median(candidate) / baseline. */
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> pick(0, candidate.size() - 1);
+    std::vector<double> ratios(2000);
+    std::vector<double> resample(candidate.size());
+    for (double& ratio : ratios) {
+        for (double& v : resample) { v = candidate[pick(gen)]; }
+        ratio = median(resample) / baseline;
+    }
+    std::sort(ratios.begin(), ratios.end());
+    *low = ratios[(size_t)(0.025 * ratios.size())];
+    *high = ratios[std::min(ratios.size() - 1, (size_t)(0.975 * ratios.size()))];
+}
+
+void judge(GateCheck& c, const GateOptions& options) {
+    /** Fill in the ratio, test and verdict of one configuration. */
+    const double base = median(c.baseline_times);
+    const double candidate = median(c.candidate_times);
+    c.ratio = candidate / base;
+    c.ratio_low = c.ratio;
+    c.ratio_high = c.ratio;
+    c.p_value = -1.0;
+    bool slower, faster;
+    if (c.baseline_times.size() > 1) {
+        c.p_value = mannWhitneyGreater(c.candidate_times, c.baseline_times);
+        slower = (c.p_value < options.alpha) and (c.ratio > 1.0 + options.time_threshold);
+        faster = (mannWhitneyGreater(c.baseline_times, c.candidate_times) < options.alpha) and (c.ratio < 1.0 - options.time_threshold);
+    } else {
+        bootstrapRatio(c.candidate_times, base, &c.ratio_low, &c.ratio_high);
+        slower = (c.ratio_low > 1.0 + options.time_threshold);
+        faster = (c.ratio_high < 1.0 - options.time_threshold);
+    }
+    c.verdict = (base < options.min_time_ms) ? "skip" : (slower ? "SLOWER" : (faster ? "faster" : "ok"));
+    for (const auto& entry : c.baseline_accuracy) {
+        if (c.candidate_accuracy.count(entry.first)
+                and (std::abs(c.candidate_accuracy.at(entry.first) - entry.second) > options.accuracy_threshold + 1e-9)) {
+            c.verdict = "ACCURACY";
+        }
+    }
+}
+
+/*
+ * RERUNS :
+ */
+
+DataFrame loadDataset(const std::string& name) {
+    static std::map<std::string, DataFrame> cache;
+    if (!cache.count(name)) {
+        cache[name] = DataLoader("data/" + name + "_clean.csv").load();
+    }
+    return cache[name];
+}
+
+void rerunTree(GateCheck& c, int runs) {
+    /** As benchmark_serial / benchmark_parallel: 80/20 split, 2 warmups, seed 42 for accuracy. */
+    std::vector<DataFrame> split_data = loadDataset(c.dataset).train_test_split(0.2, 42);
+    DataFrame train_data = split_data[0];
+    DataFrame test_data = split_data[1];
+    const int warmup_runs = 2;
+    for (int i = 0; i < warmup_runs; i++) {
+        DecisionTree warmup_tree(train_data, false, "gini_impurity", -1, c.max_depth, -1, 1, -1, 42 + i);
+    }
+    for (int i = 0; i < runs; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        DecisionTree tree(train_data, false, "gini_impurity", -1, c.max_depth, -1, 1, -1, 42 + warmup_runs + i);
+        auto end = std::chrono::high_resolution_clock::now();
+        c.candidate_times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    DecisionTree tree(train_data, false, "gini_impurity", -1, c.max_depth, -1, 1, -1, 42);
+    c.candidate_accuracy["train_accuracy"] = accuracy(train_data.col(-1), tree.predict(&train_data));
+    c.candidate_accuracy["test_accuracy"] = accuracy(test_data.col(-1), tree.predict(&test_data));
+}
+
+void rerunCV(GateCheck& c, int runs) {
+    /**
+     * As cv_benchmark / cv_parallel: 4 folds of the data shuffled with seed 42, time of
+     * training the 4 fold trees (in parallel when built with OpenMP), accuracy of the first run.
+     */
+    DataFrame shuffled_data = loadDataset(c.dataset).sample(-1, 42, false);
+    const int k = 4;
+    const int fold_size = shuffled_data.length() / k;
+    const int remainder = shuffled_data.length() % k;
+    std::vector<DataFrame> train_folds(k), val_folds(k);
+    int start_idx = 0;
+    for (int fold = 0; fold < k; fold++) {
+        const int end_idx = start_idx + fold_size + (fold < remainder ? 1 : 0);
+        for (int i = 0; i < shuffled_data.length(); i++) {
+            if ((i >= start_idx) and (i < end_idx)) {
+                val_folds[fold].addRow(shuffled_data.row(i));
+            } else {
+                train_folds[fold].addRow(shuffled_data.row(i));
+            }
+        }
+        start_idx = end_idx;
+    }
+    const int warmup_runs = 1;
+    for (int m = -warmup_runs; m < runs; m++) {
+        std::vector<std::unique_ptr<DecisionTree>> trees(k);
+        auto start = std::chrono::high_resolution_clock::now();
+        #pragma omp parallel for
+        for (int fold = 0; fold < k; fold++) {
+            trees[fold].reset(new DecisionTree(train_folds[fold], false, "gini_impurity", -1, c.max_depth, -1, 1, -1,
+                                               42 + fold + warmup_runs + std::max(m, 0)));
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        if (m < 0) {
+            continue;
+        }
+        c.candidate_times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        if (m == 0) {
+            double sum = 0.0;
+            for (int fold = 0; fold < k; fold++) { sum += accuracy(val_folds[fold].col(-1), trees[fold]->predict(&val_folds[fold])); }
+            c.candidate_accuracy["mean_cv_accuracy"] = sum / k;
+        }
+    }
+}
+
+/*
+ * REPORT :
+ */
+
+int report(std::vector<GateCheck>& checks, const GateOptions& options) {
+    /** Judge and print every configuration; returns the number of failed checks. */
+    int failures = 0;
+    for (GateCheck& c : checks) {
+        judge(c, options);
+        std::cout << "  " << std::left << std::setw(5) << c.kind << std::setw(8) << c.dataset << std::right
+                  << " Depth=" << std::setw(2) << c.max_depth
+                  << ", Baseline=" << std::fixed << std::setprecision(3) << median(c.baseline_times) << "ms"
+                  << ", Candidate=" << median(c.candidate_times) << "ms"
+                  << ", Ratio=" << std::setprecision(3) << c.ratio;
+        if (c.p_value >= 0.0) {
+            std::cout << " (p=" << std::setprecision(4) << c.p_value << ")";
+        } else {
+            std::cout << " [" << c.ratio_low << ", " << c.ratio_high << "]";
+        }
+        for (const auto& entry : c.baseline_accuracy) {
+            if (c.candidate_accuracy.count(entry.first)) {
+                std::cout << ", " << entry.first << "=" << std::setprecision(4) << c.candidate_accuracy.at(entry.first)
+                          << " (was " << entry.second << ")";
+            }
+        }
+        std::cout << "  " << c.verdict << std::endl;
+        failures += ((c.verdict == "SLOWER") or (c.verdict == "ACCURACY")) ? 1 : 0;
+    }
+    std::cout << "\n" << failures << " of " << checks.size() << " configurations regressed"
+              << " (time threshold " << std::setprecision(0) << 100*options.time_threshold << "%"
+              << ", accuracy threshold " << std::setprecision(4) << options.accuracy_threshold << ")" << std::endl;
+    return failures;
+}
+
+void usage() {
+    std::cout << "Usage:\n"
+              << "  perf_gate run <baseline.csv> [options]\n"
+              << "  perf_gate compare <baseline_samples.csv> <candidate_samples.csv> [options]\n"
+              << "Options: --runs N --time-threshold X --accuracy-threshold X --alpha X --min-time-ms X\n"
+              << "         --threads N --samples FILE" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    GateOptions options = {15, 0.10, 0.005, 0.05, 0.5, -1, ""};
+    std::vector<std::string> positional;
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const bool has_value = (i + 1 < args.size());
+            if ((args[i] == "--runs") and has_value) { options.runs = std::stoi(args[++i]); }
+            else if ((args[i] == "--time-threshold") and has_value) { options.time_threshold = std::stod(args[++i]); }
+            else if ((args[i] == "--accuracy-threshold") and has_value) { options.accuracy_threshold = std::stod(args[++i]); }
+            else if ((args[i] == "--alpha") and has_value) { options.alpha = std::stod(args[++i]); }
+            else if ((args[i] == "--min-time-ms") and has_value) { options.min_time_ms = std::stod(args[++i]); }
+            else if ((args[i] == "--threads") and has_value) { options.threads = std::stoi(args[++i]); }
+            else if ((args[i] == "--samples") and has_value) { options.samples = args[++i]; }
+            else if (args[i].compare(0, 2, "--") == 0) { throw std::invalid_argument( "Unknown or incomplete option: "+args[i] ); }
+            else { positional.push_back(args[i]); }
+        }
+        if (options.runs < 2) {
+            throw std::invalid_argument( "Need --runs >= 2" );
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+    const bool run = (positional.size() == 2) and (positional[0] == "run");
+    const bool compare = (positional.size() == 3) and (positional[0] == "compare");
+    if (!run and !compare) {
+        usage();
+        return 2;
+    }
+
+    std::vector<GateCheck> checks;
+    try {
+        std::string version;
+        checks = loadBaseline(positional[1], version);
+        std::cout << "=== Performance Regression Gate ===" << std::endl;
+        std::cout << "Baseline: " << positional[1] << " (" << version << ", " << checks.size() << " configurations)" << std::endl;
+        if (compare) {
+            std::string candidate_version;
+            std::vector<GateCheck> candidates = loadBaseline(positional[2], candidate_version);
+            std::map<std::string, const GateCheck*> by_key;
+            for (const GateCheck& c : candidates) { by_key[c.kind + "/" + c.dataset + "/" + std::to_string(c.max_depth)] = &c; }
+            std::vector<GateCheck> matched;
+            for (GateCheck& c : checks) {
+                const std::string key = c.kind + "/" + c.dataset + "/" + std::to_string(c.max_depth);
+                if (!by_key.count(key)) {
+                    std::cout << "  Missing from candidate: " << key << std::endl;
+                    continue;
+                }
+                c.candidate_times = by_key[key]->baseline_times;
+                c.candidate_accuracy = by_key[key]->baseline_accuracy;
+                matched.push_back(c);
+            }
+            checks = matched;
+            std::cout << "Candidate: " << positional[2] << " (" << candidate_version << ")" << std::endl;
+        } else {
+#ifdef _OPENMP
+            const std::string engine = "parallel";
+            if (options.threads > 0) { omp_set_num_threads(options.threads); }
+            std::cout << "Engine: parallel, " << omp_get_max_threads() << " threads, " << options.runs << " runs" << std::endl;
+#else
+            const std::string engine = "serial";
+            std::cout << "Engine: serial, " << options.runs << " runs" << std::endl;
+#endif
+            if (version != engine) {
+                throw std::runtime_error( "Baseline was produced by the "+version+" engine; this gate was built for the "+engine
+                                          +" engine (build with"+(engine == "serial" ? "" : "out")+" -fopenmp)" );
+            }
+            for (GateCheck& c : checks) {
+                if (c.kind == "cv") { rerunCV(c, options.runs); } else { rerunTree(c, options.runs); }
+            }
+            if (!options.samples.empty()) {
+                writeSamples(checks, engine, options.samples);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+
+    std::cout << std::endl;
+    return (report(checks, options) > 0) ? 1 : 0;
+}
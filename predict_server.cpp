@@ -0,0 +1,169 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <iomanip>
+#include <csignal>
+#include <atomic>
+#include <thread>
+#include <sys/stat.h>
+
+// Serial implementation includes (the server scores with a TreeModel)
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#include "src/model.cpp"
+#include "src/server.cpp"
+
+/*
+ * Scoring daemon: serves one serialized model over a Unix domain socket or loopback TCP
+ * with the binary protocol of src/server.hpp, predicting concurrent requests in
+ * micro-batches. The model comes from a file written by TreeModel::save, or is trained
+ * on a CSV at startup (and optionally saved). SIGINT/SIGTERM stop it and print counters.
+ * SIGHUP, or with --watch-ms a change of the file's modification time, reloads the model
+ * file and swaps it in while requests are served (see PredictionServer::reload); a file
+ * that fails to load, or has another number of features, leaves the current model live.
+ *
+ *   ./predict_server --model tree.bin [--socket pdt.sock | --port 7070] [--watch-ms 500]
+ *                    [--max-batch 256] [--budget-us 200] [--max-request-rows 65536]
+ *   ./predict_server --train data/hmeq_clean.csv [--depth 8] [--regression] [--save tree.bin] ...
+ */
+
+PredictionServer* running_server = nullptr;
+std::atomic<bool> reload_requested(false);
+
+void stopServer(int) {
+    if (running_server != nullptr) { running_server->stop(); }
+}
+
+void requestReload(int) {
+    reload_requested = true;
+}
+
+bool fileChanged(const std::string& path, struct stat& last) {
+    /** Whether the file's modification time or size differs from last (which is updated). */
+    struct stat now;
+    if (stat(path.c_str(), &now) != 0) { return false; }
+    const bool changed = (now.st_mtim.tv_sec != last.st_mtim.tv_sec) or (now.st_mtim.tv_nsec != last.st_mtim.tv_nsec)
+                         or (now.st_size != last.st_size);
+    last = now;
+    return changed;
+}
+
+void reloadLoop(PredictionServer& server, const std::string& path, int watch_ms, const std::atomic<bool>& done) {
+    /** Reload thread: swap in the model file on SIGHUP or, when watching, when it changes. */
+    struct stat last;
+    if (stat(path.c_str(), &last) != 0) { std::memset(&last, 0, sizeof(last)); }
+    auto checked = std::chrono::steady_clock::now();
+    while (!done) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        bool reload = reload_requested.exchange(false);
+        if ((watch_ms > 0) and (std::chrono::steady_clock::now() - checked >= std::chrono::milliseconds(watch_ms))) {
+            checked = std::chrono::steady_clock::now();
+            reload = fileChanged(path, last) or reload;
+        }
+        if (!reload) {
+            continue;
+        }
+        try {
+            const TreeModel model = TreeModel::load(path);
+            auto start = std::chrono::high_resolution_clock::now();
+            server.reload(model);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::cout << "Reloaded " << path << ": " << model.size() << "-node model live, previous one freed after "
+                      << std::fixed << std::setprecision(1) << std::chrono::duration<double, std::micro>(end - start).count()
+                      << "us" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Reload failed, keeping the current model: " << e.what() << std::endl;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    ServerConfig config = default_server_config();
+    std::string model_path;
+    std::string train_path;
+    std::string save_path;
+    bool regression = false;
+    int depth = 8;
+    int watch_ms = 0;
+    try {
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            const bool has_value = (i + 1 < argc);
+            if ((arg == "--model") and has_value) { model_path = argv[++i]; }
+            else if ((arg == "--train") and has_value) { train_path = argv[++i]; }
+            else if ((arg == "--save") and has_value) { save_path = argv[++i]; }
+            else if ((arg == "--depth") and has_value) { depth = std::stoi(argv[++i]); }
+            else if (arg == "--regression") { regression = true; }
+            else if ((arg == "--socket") and has_value) { config.socket_path = argv[++i]; }
+            else if ((arg == "--port") and has_value) { config.socket_path = ""; config.port = std::stoi(argv[++i]); }
+            else if ((arg == "--watch-ms") and has_value) { watch_ms = std::stoi(argv[++i]); }
+            else if ((arg == "--max-batch") and has_value) { config.max_batch = std::stoi(argv[++i]); }
+            else if ((arg == "--budget-us") and has_value) { config.budget_us = std::stoi(argv[++i]); }
+            else if ((arg == "--max-request-rows") and has_value) { config.max_request_rows = std::stoi(argv[++i]); }
+            else { throw std::invalid_argument( "Unknown or incomplete option: "+arg ); }
+        }
+        if (model_path.empty() == train_path.empty()) {
+            throw std::invalid_argument( "Give exactly one of --model and --train" );
+        }
+
+        TreeModel model;
+        if (!model_path.empty()) {
+            model = TreeModel::load(model_path);
+        } else {
+            DataFrame data = DataLoader(train_path).load();
+            DecisionTree tree(data, regression, regression ? "mean_squared_error" : "gini_impurity", -1, depth, -1, 1, -1, 42);
+            model = TreeModel(tree);
+            if (!save_path.empty()) { model.save(save_path); }
+        }
+
+        PredictionServer server(model, config);
+        running_server = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+        std::signal(SIGHUP, requestReload);
+        const std::string reload_path = model_path.empty() ? save_path : model_path;
+        std::atomic<bool> done(false);
+        std::thread reloader;
+        if (!reload_path.empty()) {
+            reloader = std::thread(reloadLoop, std::ref(server), reload_path, watch_ms, std::cref(done));
+        }
+        std::cout << "Serving " << model.size() << "-node model (" << model.num_features() << " features) on "
+                  << (config.socket_path.empty() ? "127.0.0.1:" + std::to_string(server.port()) : config.socket_path)
+                  << ", max batch " << config.max_batch << " rows, budget " << config.budget_us << "us" << std::endl;
+        auto start = std::chrono::high_resolution_clock::now();
+        try {
+            server.run();
+        } catch (...) {
+            done = true;
+            if (reloader.joinable()) { reloader.join(); }
+            throw;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        running_server = nullptr;
+        done = true;
+        if (reloader.joinable()) { reloader.join(); }
+
+        const ServerStats stats = server.stats();
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << "Stopped after " << std::fixed << std::setprecision(1) << seconds << "s: "
+                  << stats.connections << " connections, " << stats.requests << " requests (" << stats.errors << " errors), "
+                  << stats.rows << " rows in " << stats.batches << " batches (mean "
+                  << std::setprecision(2) << (stats.batches > 0 ? (double)stats.rows / stats.batches : 0.0)
+                  << " rows, max " << stats.max_batch_rows << "; cut full/budget/early "
+                  << stats.full_flushes << "/" << stats.budget_flushes << "/" << stats.early_flushes << "), "
+                  << stats.reloads << " reloads" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,465 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <iomanip>
+#include <functional>
+#include <random>
+#include <cmath>
+#include <memory>
+#include <sched.h>
+#include <omp.h>
+
+// Load balance of the parallel regions is profiled in one extra untimed run (src/region_profile.hpp):
+#ifndef PDT_REGION_PROFILE
+#define PDT_REGION_PROFILE
+#endif
+
+// Include the PARALLEL modules (decision tree + CV) and the workload generator
+#include "src-openmp/datasets.cpp"
+#include "src-openmp/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src-openmp/metrics.cpp"
+#include "src-openmp/tree_node.cpp"
+#include "src-openmp/decision_tree.cpp"
+#include "src-openmp/cv.cpp"
+#include "src/synthetic.cpp"
+
+/*
+ * Strong and weak scaling of the OpenMP engines in one run:
+ *   fit      DecisionTree training (features of each node searched in parallel)
+ *   predict  DecisionTree::predict on held-out rows (rows in parallel)
+ *   cv       CrossValidator::validateDepth, 4 folds (folds in parallel)
+ * Workloads are hmeq scaled with SyntheticGenerator. Strong scaling keeps the rows fixed
+ * while threads grow; weak scaling gives every thread weak_rows rows.
+ *
+ * After the timed runs, one more run records every parallel region it executes (split_search
+ * of findBestSplit, predict, cv_folds): per thread the busy time, the wait at the implicit
+ * barrier and the tasks (loop iterations). The imbalance factor is the busiest thread's busy
+ * time over the average thread's (1 = balanced); efficiency is the busy share of the thread
+ * time the regions held, the rest being barrier wait and fork/join/scheduling overhead.
+ *
+ *   ./scaling_harness [--threads 1,2,4,8] [--rows 3445,20000,80000] [--weak-rows 10000]
+ *                     [--engines fit,predict,cv] [--runs 7] [--depth 8] [--no-pin] [--out FILE]
+ *                     [--regions-out FILE]
+ */
+
+struct ScalingConfig {
+    std::vector<int> threads;
+    std::vector<int> rows;  // Strong scaling problem sizes.
+    int weak_rows;  // Weak scaling rows per thread (0 to skip).
+    std::vector<std::string> engines;
+    int runs;  // Timed repetitions per configuration.
+    int depth;
+    bool pin;  // Pin OpenMP thread i to the i-th allowed CPU.
+    std::string output;
+    std::string regions_output;  // Region profile CSV.
+};
+
+struct ScalingResult {
+    std::string mode;  // "strong" or "weak".
+    std::string engine;
+    std::string dataset;
+    int rows;  // Training rows (predict: rows predicted).
+    int features;
+    int threads;
+    bool pinned;
+    std::vector<double> times_ms;  // One per repetition.
+    double median_ms;
+    double mean_ms;
+    double std_ms;
+    double ci_low_ms;  // 95% bootstrap interval of the median.
+    double ci_high_ms;
+    double speedup;  // Strong: T1/Tp. Weak: p*T1/Tp (scaled speedup).
+    double speedup_ci_low;
+    double speedup_ci_high;
+    double efficiency;  // speedup / threads.
+    double karp_flatt;  // Experimentally determined serial fraction (threads > 1).
+    RegionTotals regions[kNumRegions];  // Profiled run.
+};
+
+void writeResultsToCSV(const std::vector<ScalingResult>& results, const std::string& filename) {
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,mode,engine,dataset,rows,features,threads,pinned,runs,median_ms,mean_ms,std_ms,ci_low_ms,ci_high_ms,"
+         << "speedup,speedup_ci_low,speedup_ci_high,efficiency,karp_flatt\n";
+
+    // Write data
+    for (const auto& r : results) {
+        file << "scaling,"
+             << r.mode << ","
+             << r.engine << ","
+             << r.dataset << ","
+             << r.rows << ","
+             << r.features << ","
+             << r.threads << ","
+             << (r.pinned ? 1 : 0) << ","
+             << r.times_ms.size() << ","
+             << std::fixed << std::setprecision(4) << r.median_ms << ","
+             << std::fixed << std::setprecision(4) << r.mean_ms << ","
+             << std::fixed << std::setprecision(4) << r.std_ms << ","
+             << std::fixed << std::setprecision(4) << r.ci_low_ms << ","
+             << std::fixed << std::setprecision(4) << r.ci_high_ms << ","
+             << std::fixed << std::setprecision(4) << r.speedup << ","
+             << std::fixed << std::setprecision(4) << r.speedup_ci_low << ","
+             << std::fixed << std::setprecision(4) << r.speedup_ci_high << ","
+             << std::fixed << std::setprecision(4) << r.efficiency << ",";
+        if (r.threads > 1) { file << std::fixed << std::setprecision(4) << r.karp_flatt; }
+        file << "\n";
+    }
+
+    file.close();
+    std::cout << "Results saved to " << filename << std::endl;
+}
+
+void writeRegionsToCSV(const std::vector<ScalingResult>& results, const std::string& filename) {
+    /** One "all" row per region executed by a configuration, then one row per thread number. */
+    std::ofstream file(filename);
+
+    // Write header
+    file << "version,mode,engine,rows,threads,region,thread,executions,tasks,busy_ms,wait_ms,overhead_ms,imbalance,efficiency\n";
+
+    // Write data
+    for (const auto& r : results) {
+        for (int g = 0; g < kNumRegions; g++) {
+            const RegionTotals& t = r.regions[g];
+            if (t.executions == 0) {
+                continue;
+            }
+            const std::string prefix = "scaling," + r.mode + "," + r.engine + "," + std::to_string(r.rows) + ","
+                                       + std::to_string(r.threads) + "," + region_name((Region)g) + ",";
+            file << prefix << "all,"
+                 << t.executions << ","
+                 << t.tasks << ","
+                 << std::fixed << std::setprecision(4) << t.busy_ns / 1e6 << ","
+                 << std::fixed << std::setprecision(4) << t.wait_ns / 1e6 << ","
+                 << std::fixed << std::setprecision(4) << t.overhead_ns() / 1e6 << ","
+                 << std::fixed << std::setprecision(4) << t.imbalance() << ","
+                 << std::fixed << std::setprecision(4) << t.efficiency() << "\n";
+            for (size_t i = 0; i < t.threads.size(); i++) {
+                file << prefix << i << ",,"
+                     << t.threads[i].tasks << ","
+                     << std::fixed << std::setprecision(4) << t.threads[i].busy_ns / 1e6 << ","
+                     << std::fixed << std::setprecision(4) << t.threads[i].wait_ns / 1e6 << ",,,\n";
+            }
+        }
+    }
+
+    file.close();
+    std::cout << "Region profile saved to " << filename << std::endl;
+}
+
+/*
+ * STATISTICS :
+ */
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const size_t n = values.size();
+    return (n % 2 == 1) ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+std::vector<double> bootstrapMedians(const std::vector<double>& values, int resamples, std::mt19937& gen) {
+    /** Medians of `resamples` resamples (with replacement) of values. */
+    std::uniform_int_distribution<int> pick(0, values.size() - 1);
+    std::vector<double> medians(resamples);
+    std::vector<double> resample(values.size());
+    for (int b = 0; b < resamples; b++) {
+        for (double& v : resample) { v = values[pick(gen)]; }
+        medians[b] = median(resample);
+    }
+    return medians;
+}
+
+double percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+void summarize(ScalingResult& r) {
+    /** Median, mean, standard deviation and 95% bootstrap interval of the median of r.times_ms. */
+    const std::vector<double>& t = r.times_ms;
+    r.median_ms = median(t);
+    r.mean_ms = 0.0;
+    for (double v : t) { r.mean_ms += v; }
+    r.mean_ms /= t.size();
+    r.std_ms = 0.0;
+    for (double v : t) { r.std_ms += (v - r.mean_ms) * (v - r.mean_ms); }
+    r.std_ms = (t.size() > 1) ? std::sqrt(r.std_ms / (t.size() - 1)) : 0.0;
+    std::mt19937 gen(42);
+    std::vector<double> medians = bootstrapMedians(t, 2000, gen);
+    r.ci_low_ms = percentile(medians, 0.025);
+    r.ci_high_ms = percentile(medians, 0.975);
+}
+
+void computeSpeedup(ScalingResult& r, const ScalingResult& base) {
+    /**
+     * Speedup over the single-thread run of the same mode, engine and size (weak: same
+     * rows per thread), with a 95% bootstrap interval from resampling both runs.
+     */
+    const double p = r.threads;
+    const double scale = (r.mode == "weak") ? p : 1.0;
+    r.speedup = scale * base.median_ms / r.median_ms;
+    std::mt19937 gen(7);
+    std::vector<double> base_medians = bootstrapMedians(base.times_ms, 2000, gen);
+    std::vector<double> medians = bootstrapMedians(r.times_ms, 2000, gen);
+    std::vector<double> ratios(medians.size());
+    for (size_t b = 0; b < medians.size(); b++) { ratios[b] = scale * base_medians[b] / medians[b]; }
+    r.speedup_ci_low = percentile(ratios, 0.025);
+    r.speedup_ci_high = percentile(ratios, 0.975);
+    r.efficiency = r.speedup / p;
+    r.karp_flatt = (p > 1) ? (1.0 / r.speedup - 1.0 / p) / (1.0 - 1.0 / p) : 0.0;
+}
+
+/*
+ * THREADS :
+ */
+
+std::vector<int> allowedCPUs() {
+    /** CPUs this process may run on, in increasing order. */
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &set)) { cpus.push_back(c); }
+        }
+    }
+    return cpus;
+}
+
+void setThreads(int threads, bool pin, const std::vector<int>& cpus) {
+    /**
+     * Use `threads` OpenMP threads from now on; with pin, bind thread i to cpus[i % cpus.size()].
+     * The OpenMP runtime keeps its pool between parallel regions, so the binding holds for
+     * every later region with the same number of threads.
+     */
+    omp_set_dynamic(0);
+    omp_set_num_threads(threads);
+    #pragma omp parallel
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (pin and !cpus.empty()) {
+            CPU_SET(cpus[omp_get_thread_num() % cpus.size()], &set);
+        } else {
+            for (int c : cpus) { CPU_SET(c, &set); }
+        }
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+}
+
+/*
+ * ENGINES :
+ */
+
+std::function<void()> makeEngine(const std::string& engine, const DataFrame& train, DataFrame& test, int depth,
+                                 std::unique_ptr<DecisionTree>& fitted) {
+    /** A callable that runs the engine once (predict uses `fitted`, trained here). */
+    if (engine == "fit") {
+        return [&train, depth] () {
+            DecisionTree tree(train, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+        };
+    }
+    if (engine == "predict") {
+        fitted.reset(new DecisionTree(train, false, "gini_impurity", -1, depth, -1, 1, -1, 42));
+        DecisionTree* tree = fitted.get();
+        return [tree, &test] () {
+            tree->predict(&test);
+        };
+    }
+    if (engine == "cv") {
+        return [&train, depth] () {
+            // validateDepth reports progress on std::cout; keep it out of the harness output.
+            std::ostringstream discard;
+            std::streambuf* saved = std::cout.rdbuf(discard.rdbuf());
+            CrossValidator(train, 4, 42).validateDepth(depth);
+            std::cout.rdbuf(saved);
+        };
+    }
+    throw std::invalid_argument( "Unknown engine: "+engine );
+}
+
+ScalingResult measure(const std::string& mode, const std::string& engine, const SyntheticGenerator& generator,
+                      int rows, int threads, const ScalingConfig& config, const std::vector<int>& cpus) {
+    /** Generate the workload, set the threads, then time one warmup and config.runs repetitions. */
+    DataFrame train = generator.generate(0, rows);
+    // Held-out rows for predict (capped, as each runtime-tree prediction scans its leaf's rows):
+    const int test_rows = std::min(rows / 5, 2000 * ((mode == "weak") ? threads : 1));
+    DataFrame test = generator.generate(rows, rows + test_rows);
+    std::unique_ptr<DecisionTree> fitted;
+    setThreads(threads, config.pin, cpus);
+    std::function<void()> run = makeEngine(engine, train, test, config.depth, fitted);
+
+    ScalingResult r;
+    r.mode = mode;
+    r.engine = engine;
+    r.dataset = "hmeq_scaled";
+    r.rows = (engine == "predict") ? test.length() : train.length();
+    r.features = train.width() - 1;
+    r.threads = threads;
+    r.pinned = config.pin;
+    run();  // Warmup.
+    for (int i = 0; i < config.runs; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        run();
+        auto end = std::chrono::high_resolution_clock::now();
+        r.times_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    summarize(r);
+
+    // One more run with the region profile on (its time is not used):
+    RegionProfile::reset();
+    RegionProfile::set_active(true);
+    run();
+    RegionProfile::set_active(false);
+    for (int g = 0; g < kNumRegions; g++) { r.regions[g] = RegionProfile::get((Region)g); }
+    return r;
+}
+
+void printResult(const ScalingResult& r) {
+    std::cout << "  " << std::left << std::setw(7) << r.mode << std::setw(8) << r.engine << std::right
+              << " Rows=" << std::setw(7) << r.rows
+              << ", Threads=" << std::setw(2) << r.threads
+              << ", Median=" << std::fixed << std::setprecision(2) << r.median_ms << "ms"
+              << " [" << r.ci_low_ms << ", " << r.ci_high_ms << "]"
+              << ", Speedup=" << std::setprecision(2) << r.speedup
+              << " [" << r.speedup_ci_low << ", " << r.speedup_ci_high << "]"
+              << ", Efficiency=" << std::setprecision(2) << r.efficiency;
+    if (r.threads > 1) { std::cout << ", Karp-Flatt=" << std::setprecision(3) << r.karp_flatt; }
+    std::cout << std::endl;
+    for (int g = 0; g < kNumRegions; g++) {
+        const RegionTotals& t = r.regions[g];
+        if (t.executions == 0) {
+            continue;
+        }
+        const double capacity = std::max(t.capacity_ns, 1.0);
+        std::cout << "    " << std::left << std::setw(13) << region_name((Region)g) << std::right
+                  << " Imbalance=" << std::fixed << std::setprecision(2) << t.imbalance()
+                  << ", Efficiency=" << t.efficiency()
+                  << ", Wait=" << std::setprecision(1) << 100.0 * t.wait_ns / capacity << "%"
+                  << ", Overhead=" << 100.0 * t.overhead_ns() / capacity << "%"
+                  << ", Tasks/execution=" << (double)t.tasks / t.executions << std::endl;
+    }
+}
+
+/*
+ * COMMAND LINE :
+ */
+
+std::vector<int> parseInts(const std::string& list) {
+    std::vector<int> values;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) { values.push_back(std::stoi(item)); }
+    return values;
+}
+
+std::vector<std::string> parseStrings(const std::string& list) {
+    std::vector<std::string> values;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) { values.push_back(item); }
+    return values;
+}
+
+ScalingConfig parseArgs(int argc, char** argv) {
+    /** Defaults: threads 1,2,4,... up to the number of processors (or OMP_NUM_THREADS). */
+    ScalingConfig config;
+    for (int t = 1; t < omp_get_max_threads(); t *= 2) { config.threads.push_back(t); }
+    config.threads.push_back(omp_get_max_threads());
+    config.rows = {3445, 20000, 80000};
+    config.weak_rows = 10000;
+    config.engines = {"fit", "predict", "cv"};
+    config.runs = 7;
+    config.depth = 8;
+    config.pin = true;
+    config.output = "scaling_results.csv";
+    config.regions_output = "scaling_regions.csv";
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool has_value = (i + 1 < argc);
+        if ((arg == "--threads") and has_value) { config.threads = parseInts(argv[++i]); }
+        else if ((arg == "--rows") and has_value) { config.rows = parseInts(argv[++i]); }
+        else if ((arg == "--weak-rows") and has_value) { config.weak_rows = std::stoi(argv[++i]); }
+        else if ((arg == "--engines") and has_value) { config.engines = parseStrings(argv[++i]); }
+        else if ((arg == "--runs") and has_value) { config.runs = std::stoi(argv[++i]); }
+        else if ((arg == "--depth") and has_value) { config.depth = std::stoi(argv[++i]); }
+        else if ((arg == "--out") and has_value) { config.output = argv[++i]; }
+        else if ((arg == "--regions-out") and has_value) { config.regions_output = argv[++i]; }
+        else if (arg == "--no-pin") { config.pin = false; }
+        else { throw std::invalid_argument( "Unknown or incomplete option: "+arg ); }
+    }
+    if (config.threads.empty() or (config.threads[0] != 1)) {
+        config.threads.insert(config.threads.begin(), 1);  // Every speedup is relative to one thread.
+    }
+    if (config.runs < 2) {
+        throw std::invalid_argument( "Need --runs >= 2 for confidence intervals" );
+    }
+    return config;
+}
+
+int main(int argc, char** argv) {
+    ScalingConfig config;
+    try {
+        config = parseArgs(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    const std::vector<int> cpus = allowedCPUs();
+    std::cout << "=== Strong / Weak Scaling Harness ===" << std::endl;
+    std::cout << "CPUs available: " << cpus.size() << ", threads:";
+    for (int t : config.threads) { std::cout << " " << t; }
+    std::cout << ", runs: " << config.runs << ", pinned: " << (config.pin ? "yes" : "no") << std::endl;
+    if ((int)cpus.size() < config.threads.back()) {
+        std::cout << "Note: more threads than CPUs, so high thread counts are oversubscribed." << std::endl;
+    }
+
+    // Workload: hmeq resampled and jittered to any number of rows.
+    DataFrame hmeq = DataLoader("data/hmeq_clean.csv").load();
+    int max_rows = config.weak_rows * config.threads.back();
+    for (int n : config.rows) { max_rows = std::max(max_rows, n); }
+    SyntheticGenerator generator(hmeq, (int64_t)max_rows + max_rows / 5 + 2000 * config.threads.back());
+
+    std::vector<ScalingResult> all_results;
+    for (const std::string& engine : config.engines) {
+        std::cout << "\n=== Engine: " << engine << " ===" << std::endl;
+        // Strong scaling: fixed rows.
+        for (int rows : config.rows) {
+            ScalingResult base;
+            for (int threads : config.threads) {
+                ScalingResult r = measure("strong", engine, generator, rows, threads, config, cpus);
+                if (threads == 1) { base = r; }
+                computeSpeedup(r, base);
+                printResult(r);
+                all_results.push_back(r);
+            }
+        }
+        // Weak scaling: weak_rows per thread.
+        if (config.weak_rows > 0) {
+            ScalingResult base;
+            for (int threads : config.threads) {
+                ScalingResult r = measure("weak", engine, generator, config.weak_rows * threads, threads, config, cpus);
+                if (threads == 1) { base = r; }
+                computeSpeedup(r, base);
+                printResult(r);
+                all_results.push_back(r);
+            }
+        }
+    }
+
+    // Save combined results
+    writeResultsToCSV(all_results, config.output);
+    writeRegionsToCSV(all_results, config.regions_output);
+
+    std::cout << "\nScaling harness completed! Results saved to " << config.output << std::endl;
+    std::cout << "Intervals are 95% bootstrap intervals of the median time and of the speedup." << std::endl;
+    std::cout << "Imbalance is the busiest thread's busy time over the average thread's, per region (1 = balanced)." << std::endl;
+
+    return 0;
+}
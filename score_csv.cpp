@@ -0,0 +1,115 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <iomanip>
+#include <cstdio>
+
+// Serial implementation includes (scoring uses a TreeModel; the pipeline has its own threads)
+#include "src/datasets.cpp"
+#include "src/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src/metrics.cpp"
+#include "src/tree_node.cpp"
+#include "src/decision_tree.cpp"
+#include "src/model.cpp"
+#include "src/stream_scorer.cpp"
+
+/*
+ * Streaming batch scorer: CSV rows in, one prediction per line out, in input order
+ * (see src/stream_scorer.hpp for the pipeline and the accepted rows). Reads stdin unless
+ * --input is given and writes stdout unless --out is given; --stats prints throughput and
+ * the time each stage spent held back by the next one to stderr. The model is a file
+ * written by TreeModel::save, or is trained on a CSV first (and optionally saved).
+ * Missing cells (empty, "NA", "?", ...) are an error unless --missing-as-nan is given, which
+ * scores them as NaN and, with --train, loads the training CSV the same way.
+ *
+ *   ./score_csv --model tree.bin [--input rows.csv] [--out predictions.txt] [--header]
+ *               [--missing-as-nan] [--threads N] [--chunk-kb 1024] [--queue-chunks 4N] [--stats]
+ *   ./score_csv --train data/hmeq_clean.csv [--depth 8] [--regression] [--save tree.bin] ...
+ * Exit status: 0 every row scored, 1 usage error, 2 malformed input or I/O error.
+ */
+
+int main(int argc, char** argv) {
+    ScorerConfig config = default_scorer_config();
+    std::string model_path;
+    std::string train_path;
+    std::string save_path;
+    std::string input_path;
+    std::string output_path;
+    bool regression = false;
+    bool print_stats = false;
+    bool queue_given = false;
+    int depth = 8;
+    TreeModel model;
+    try {
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            const bool has_value = (i + 1 < argc);
+            if ((arg == "--model") and has_value) { model_path = argv[++i]; }
+            else if ((arg == "--train") and has_value) { train_path = argv[++i]; }
+            else if ((arg == "--save") and has_value) { save_path = argv[++i]; }
+            else if ((arg == "--depth") and has_value) { depth = std::stoi(argv[++i]); }
+            else if (arg == "--regression") { regression = true; }
+            else if ((arg == "--input") and has_value) { input_path = argv[++i]; }
+            else if ((arg == "--out") and has_value) { output_path = argv[++i]; }
+            else if (arg == "--header") { config.header = true; }
+            else if (arg == "--missing-as-nan") { config.missing_as_nan = true; }
+            else if ((arg == "--threads") and has_value) { config.threads = std::stoi(argv[++i]); }
+            else if ((arg == "--chunk-kb") and has_value) { config.chunk_bytes = (size_t)std::stoi(argv[++i]) * 1024; }
+            else if ((arg == "--queue-chunks") and has_value) { config.queue_chunks = std::stoi(argv[++i]); queue_given = true; }
+            else if (arg == "--stats") { print_stats = true; }
+            else { throw std::invalid_argument( "Unknown or incomplete option: "+arg ); }
+        }
+        if (model_path.empty() == train_path.empty()) {
+            throw std::invalid_argument( "Give exactly one of --model and --train" );
+        }
+        if (!queue_given) { config.queue_chunks = 4 * config.threads; }
+
+        if (!model_path.empty()) {
+            model = TreeModel::load(model_path);
+        } else {
+            DataFrame data = DataLoader(train_path, config.missing_as_nan).load();
+            DecisionTree tree(data, regression, regression ? "mean_squared_error" : "gini_impurity", -1, depth, -1, 1, -1, 42);
+            model = TreeModel(tree);
+            if (!save_path.empty()) { model.save(save_path); }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::FILE* input = input_path.empty() ? stdin : std::fopen(input_path.c_str(), "rb");
+    std::FILE* output = output_path.empty() ? stdout : std::fopen(output_path.c_str(), "wb");
+    if ((input == nullptr) or (output == nullptr)) {
+        std::cerr << "Error: Cannot open " << ((input == nullptr) ? input_path : output_path) << std::endl;
+        return 2;
+    }
+    int status = 0;
+    try {
+        const StreamScorer scorer(model, config);
+        const ScorerStats stats = scorer.score(input, output);
+        if (print_stats) {
+            std::cerr << "Scored " << stats.rows << " rows (" << std::fixed << std::setprecision(1) << stats.bytes / 1048576.0
+                      << " MiB, " << stats.chunks << " chunks) in " << std::setprecision(3) << stats.seconds << "s: "
+                      << std::setprecision(0) << stats.rows / std::max(stats.seconds, 1e-9) << " rows/s, "
+                      << std::setprecision(1) << stats.bytes / 1048576.0 / std::max(stats.seconds, 1e-9) << " MiB/s with "
+                      << config.threads << " parse threads" << std::endl;
+            std::cerr << "Held back by the next stage: read " << std::setprecision(3) << stats.read_wait_seconds
+                      << "s, parse " << stats.parse_wait_seconds << "s (all threads), predict " << stats.predict_wait_seconds << "s" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        status = 2;
+    }
+    if (input != stdin) { std::fclose(input); }
+    if ((output != stdout) and (std::fclose(output) != 0) and (status == 0)) {
+        std::cerr << "Error: Cannot write " << output_path << std::endl;
+        status = 2;
+    }
+
+    return status;
+}
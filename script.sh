@@ -8,13 +8,47 @@ echo ""
 # Create results and logs directories
 mkdir -p results logs
 
+# Part 0: Regression Gate (runs first: the parts below overwrite the stored baselines)
+echo "PART 0: REGRESSION GATE"
+echo "======================="
+
+# Compile the gate for both engines
+echo "Compiling regression gate..."
+g++ -std=c++14 -O2 perf_gate.cpp -o perf_gate 2>logs/compile.log
+g++ -std=c++14 -O2 -fopenmp perf_gate.cpp -o perf_gate_parallel 2>>logs/compile.log
+
+if [ ! -f perf_gate ] || [ ! -f perf_gate_parallel ]; then
+    echo "ERROR: Regression gate compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+# Rerun the stored configurations; a regression is reported here and in the exit status of the suite
+echo "Checking against stored baselines..."
+gate_status=0
+./perf_gate run results/benchmark_results_serial.csv | tee logs/gate.log
+[ ${PIPESTATUS[0]} -eq 0 ] || gate_status=1
+./perf_gate run results/cv_results_serial.csv | tee -a logs/gate.log
+[ ${PIPESTATUS[0]} -eq 0 ] || gate_status=1
+./perf_gate_parallel run results/benchmark_results_parallel_4threads.csv --threads 4 | tee -a logs/gate.log
+[ ${PIPESTATUS[0]} -eq 0 ] || gate_status=1
+./perf_gate_parallel run results/cv_results_parallel_4threads.csv --threads 4 | tee -a logs/gate.log
+[ ${PIPESTATUS[0]} -eq 0 ] || gate_status=1
+
+if [ $gate_status -eq 0 ]; then
+    echo "✓ Regression gate passed"
+else
+    echo "✗ Regression gate FAILED (see logs/gate.log)"
+fi
+echo ""
+
 # Part 1: Tree Training Benchmarks
 echo "PART 1: TREE TRAINING BENCHMARKS"
 echo "================================="
 
 # Compile tree benchmarks
 echo "Compiling tree benchmarks..."
-g++ -std=c++14 -O2 benchmark_serial.cpp -o benchmark_serial 2>logs/compile.log
+g++ -std=c++14 -O2 benchmark_serial.cpp -o benchmark_serial 2>>logs/compile.log
 g++ -std=c++14 -O2 -fopenmp benchmark_parallel.cpp -o benchmark_parallel 2>>logs/compile.log
 
 if [ ! -f benchmark_serial ] || [ ! -f benchmark_parallel ]; then
@@ -80,8 +114,364 @@ done
 echo "✓ Cross-validation benchmarks complete"
 echo ""
 
+# Part 3: Kernel Microbenchmarks
+echo "PART 3: KERNEL MICROBENCHMARKS"
+echo "=============================="
+
+# Compile histogram microbenchmark (single thread, so rows/s/core is per physical core)
+echo "Compiling histogram microbenchmark..."
+g++ -std=c++14 -O2 benchmark_histogram.cpp -o benchmark_histogram 2>>logs/compile.log
+
+if [ ! -f benchmark_histogram ]; then
+    echo "ERROR: Histogram benchmark compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Running histogram microbenchmark..."
+./benchmark_histogram | tee logs/histogram.log
+mv benchmark_results_histogram.csv results/ 2>/dev/null
+
+echo "✓ Kernel microbenchmarks complete"
+echo ""
+
+# Part 4: Compile-time Specialized Trainer
+echo "PART 4: SPECIALIZED TRAINER BENCHMARK"
+echo "====================================="
+
+# Compile typed-vs-runtime benchmark
+echo "Compiling specialized trainer benchmark..."
+g++ -std=c++14 -O2 benchmark_typed.cpp -o benchmark_typed 2>>logs/compile.log
+
+if [ ! -f benchmark_typed ]; then
+    echo "ERROR: Specialized trainer benchmark compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Running specialized trainer benchmark..."
+./benchmark_typed | tee logs/typed.log
+mv benchmark_results_typed.csv results/ 2>/dev/null
+
+echo "✓ Specialized trainer benchmark complete"
+echo ""
+
+# Part 5: Sparse (CSR/CSC) Training
+echo "PART 5: SPARSE TRAINING BENCHMARK"
+echo "================================="
+
+# Compile sparse-vs-dense benchmark
+echo "Compiling sparse training benchmark..."
+g++ -std=c++14 -O2 benchmark_sparse.cpp -o benchmark_sparse 2>>logs/compile.log
+
+if [ ! -f benchmark_sparse ]; then
+    echo "ERROR: Sparse training benchmark compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Running sparse training benchmark..."
+./benchmark_sparse | tee logs/sparse.log
+mv benchmark_results_sparse.csv results/ 2>/dev/null
+
+echo "✓ Sparse training benchmark complete"
+echo ""
+
+# Part 6: Categorical Subset Splits
+echo "PART 6: CATEGORICAL SPLIT BENCHMARK"
+echo "==================================="
+
+# Compile categorical-vs-ordinal benchmark
+echo "Compiling categorical split benchmark..."
+g++ -std=c++14 -O2 benchmark_categorical.cpp -o benchmark_categorical 2>>logs/compile.log
+
+if [ ! -f benchmark_categorical ]; then
+    echo "ERROR: Categorical split benchmark compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Running categorical split benchmark..."
+./benchmark_categorical | tee logs/categorical.log
+mv benchmark_results_categorical.csv results/ 2>/dev/null
+
+echo "✓ Categorical split benchmark complete"
+echo ""
+
+# Part 7: Missing-value Routing
+echo "PART 7: MISSING-VALUE BENCHMARK"
+echo "==============================="
+
+# Compile native-vs-drop/impute benchmark
+echo "Compiling missing-value benchmark..."
+g++ -std=c++14 -O2 benchmark_missing.cpp -o benchmark_missing 2>>logs/compile.log
+
+if [ ! -f benchmark_missing ]; then
+    echo "ERROR: Missing-value benchmark compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Running missing-value benchmark..."
+./benchmark_missing | tee logs/missing.log
+mv benchmark_results_missing.csv results/ 2>/dev/null
+
+echo "✓ Missing-value benchmark complete"
+echo ""
+
+# Part 8: Duplicate-row Compression
+echo "PART 8: DEDUP BENCHMARK"
+echo "======================="
+
+# Compile distinct-rows-with-counts benchmark
+echo "Compiling dedup benchmark..."
+g++ -std=c++14 -O2 benchmark_dedup.cpp -o benchmark_dedup 2>>logs/compile.log
+
+if [ ! -f benchmark_dedup ]; then
+    echo "ERROR: Dedup benchmark compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Running dedup benchmark..."
+./benchmark_dedup | tee logs/dedup.log
+mv benchmark_results_dedup.csv results/ 2>/dev/null
+
+echo "✓ Dedup benchmark complete"
+echo ""
+
+# Part 9: Tree Kernel Microbenchmarks
+echo "PART 9: TREE KERNEL MICROBENCHMARKS"
+echo "==================================="
+
+# Compile split/loss/partition/predict kernel benchmark
+echo "Compiling tree kernel microbenchmarks..."
+g++ -std=c++14 -O2 benchmark_kernels.cpp -o benchmark_kernels 2>>logs/compile.log
+
+if [ ! -f benchmark_kernels ]; then
+    echo "ERROR: Tree kernel microbenchmark compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Running tree kernel microbenchmarks..."
+./benchmark_kernels | tee logs/kernels.log
+mv benchmark_results_kernels.csv results/ 2>/dev/null
+
+echo "✓ Tree kernel microbenchmarks complete"
+echo ""
+
+# Part 10: Strong / Weak Scaling Harness
+echo "PART 10: SCALING HARNESS"
+echo "========================"
+
+# Compile the harness (sweeps threads, sizes and engines in one run)
+echo "Compiling scaling harness..."
+g++ -std=c++14 -O2 -fopenmp scaling_harness.cpp -o scaling_harness 2>>logs/compile.log
+
+if [ ! -f scaling_harness ]; then
+    echo "ERROR: Scaling harness compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Running scaling harness..."
+unset OMP_NUM_THREADS
+./scaling_harness --threads 1,2,4,6,8 --out results/scaling_results.csv --regions-out results/scaling_regions.csv | tee logs/scaling.log
+
+echo "✓ Scaling harness complete"
+echo ""
+
+# Part 11: Inference Latency Benchmark
+echo "PART 11: INFERENCE LATENCY BENCHMARK"
+echo "===================================="
+
+# Compile the inference benchmark (OpenMP only for the thread sweep)
+echo "Compiling inference benchmark..."
+g++ -std=c++14 -O2 -fopenmp benchmark_inference.cpp -o benchmark_inference 2>>logs/compile.log
+
+if [ ! -f benchmark_inference ]; then
+    echo "ERROR: Inference benchmark compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Running inference benchmark..."
+./benchmark_inference --threads 1,2,4,8 | tee logs/inference.log
+mv benchmark_results_inference.csv benchmark_results_inference_latency.csv results/ 2>/dev/null
+
+echo "✓ Inference benchmark complete"
+echo ""
+
+# Part 12: Hardware Counters per Training Phase
+echo "PART 12: HARDWARE COUNTERS PER PHASE"
+echo "===================================="
+
+# Compile the counter benchmark (enables the perf_event_open phase instrumentation itself)
+echo "Compiling counter benchmark..."
+g++ -std=c++14 -O2 benchmark_counters.cpp -o benchmark_counters 2>>logs/compile.log
+
+if [ ! -f benchmark_counters ]; then
+    echo "ERROR: Counter benchmark compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Running counter benchmark..."
+./benchmark_counters | tee logs/counters.log
+mv benchmark_results_counters.csv results/ 2>/dev/null
+
+echo "✓ Counter benchmark complete"
+echo ""
+
+# Part 13: Timeline Trace
+echo "PART 13: TIMELINE TRACE"
+echo "======================="
+
+# Compile the traced fit (enables the per-thread trace buffers itself)
+echo "Compiling trace export..."
+g++ -std=c++14 -O2 -fopenmp trace_fit.cpp -o trace_fit 2>>logs/compile.log
+
+if [ ! -f trace_fit ]; then
+    echo "ERROR: Trace export compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Tracing parallel fit, predict and CV (open in chrome://tracing or ui.perfetto.dev)..."
+./trace_fit --threads 4 --out results/trace_fit.json | tee logs/trace.log
+
+echo "✓ Timeline trace complete"
+echo ""
+
+# Part 14: Differential Correctness Oracle
+echo "PART 14: DIFFERENTIAL CORRECTNESS ORACLE"
+echo "========================================"
+
+# Compile the oracle against the serial and the OpenMP reference tree
+echo "Compiling differential oracle..."
+g++ -std=c++14 -O2 differential_oracle.cpp -o differential_oracle 2>>logs/compile.log
+g++ -std=c++14 -O2 -fopenmp differential_oracle.cpp -o differential_oracle_parallel 2>>logs/compile.log
+
+if [ ! -f differential_oracle ] || [ ! -f differential_oracle_parallel ]; then
+    echo "ERROR: Differential oracle compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+# Minimal reproductions of any mismatch are written to results/; a mismatch fails the suite like the gate
+echo "Comparing the engines with the reference trees on randomized datasets..."
+./differential_oracle --cases 2000 --repro-dir results | tee logs/oracle.log
+[ ${PIPESTATUS[0]} -eq 0 ] || gate_status=1
+./differential_oracle_parallel --cases 2000 --threads 4 --repro-dir results | tee -a logs/oracle.log
+[ ${PIPESTATUS[0]} -eq 0 ] || gate_status=1
+mv oracle_results_*.csv results/ 2>/dev/null
+
+echo "✓ Differential oracle complete"
+echo ""
+
+# Part 15: Scoring Server
+echo "PART 15: SCORING SERVER"
+echo "======================="
+
+# Compile the daemon and its load test (the server runs in a thread of the load test)
+echo "Compiling scoring server..."
+g++ -std=c++14 -O2 -pthread predict_server.cpp -o predict_server 2>>logs/compile.log
+g++ -std=c++14 -O2 -pthread benchmark_server.cpp -o benchmark_server 2>>logs/compile.log
+
+if [ ! -f predict_server ] || [ ! -f benchmark_server ]; then
+    echo "ERROR: Scoring server compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Load-testing unbatched, micro-batched and hot-reloading scoring over Unix and TCP sockets..."
+./benchmark_server --clients 1,4,16,64 | tee logs/server.log
+mv benchmark_results_server.csv results/ 2>/dev/null
+
+echo "✓ Scoring server benchmark complete"
+echo ""
+
+# Part 16: Streaming CSV Scorer
+echo "PART 16: STREAMING CSV SCORER"
+echo "============================="
+
+# Compile the scorer and the workload generator
+echo "Compiling streaming scorer..."
+g++ -std=c++14 -O2 -pthread score_csv.cpp -o score_csv 2>>logs/compile.log
+g++ -std=c++14 -O2 generate_data.cpp -o generate_data 2>>logs/compile.log
+
+if [ ! -f score_csv ] || [ ! -f generate_data ]; then
+    echo "ERROR: Streaming scorer compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+# Train and save once, then score a 1M-row file with 1 and 4 parse threads (outputs must be identical)
+echo "Scoring 1M rows with a saved model..."
+./generate_data hmeq 1000000 scoring_rows.csv > /dev/null
+./score_csv --train data/hmeq_clean.csv --depth 8 --save results/hmeq_model.bin --input scoring_rows.csv --out scoring_1.txt --threads 1 --stats 2>&1 | tee logs/scorer.log
+./score_csv --model results/hmeq_model.bin --out scoring_4.txt --threads 4 --stats < scoring_rows.csv 2>&1 | tee -a logs/scorer.log
+if cmp -s scoring_1.txt scoring_4.txt; then
+    echo "Predictions identical across thread counts" | tee -a logs/scorer.log
+else
+    echo "✗ Predictions differ across thread counts" | tee -a logs/scorer.log
+    gate_status=1
+fi
+rm -f scoring_rows.csv scoring_1.txt scoring_4.txt
+
+echo "✓ Streaming scorer complete"
+echo ""
+
+# Part 17: C API
+echo "PART 17: C API"
+echo "=============="
+
+# Build the shared library (C ABI only) and a plain C consumer linked against it
+echo "Compiling libpdt.so and its C consumer..."
+g++ -std=c++14 -O2 -fPIC -shared -fvisibility=hidden -fvisibility-inlines-hidden -Wl,--version-script=src/pdt.map libpdt.cpp -o libpdt.so 2>>logs/compile.log
+gcc -std=c99 -O2 benchmark_c_api.c -o benchmark_c_api -L. -lpdt -Wl,-rpath,'$ORIGIN' -lm 2>>logs/compile.log
+
+if [ ! -f libpdt.so ] || [ ! -f benchmark_c_api ]; then
+    echo "ERROR: C API compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+# Score the saved model through the C API in row-major, strided and column-major layouts
+echo "Scoring caller-owned buffers through the C API..."
+nm -D --defined-only libpdt.so | awk '$2 == "T" { print "exported: " $3 }' | tee logs/c_api.log
+./benchmark_c_api --model results/hmeq_model.bin --rows 1000000 | tee -a logs/c_api.log
+[ ${PIPESTATUS[0]} -eq 0 ] || gate_status=1
+mv benchmark_results_c_api.csv results/ 2>/dev/null
+
+echo "✓ C API benchmark complete"
+echo ""
+
+# Part 18: Pre-forked Scoring Workers
+echo "PART 18: PRE-FORKED SCORING WORKERS"
+echo "==================================="
+
+# Compile the multi-process benchmark (heap copy per worker vs one shared mapping)
+echo "Compiling pre-fork scoring benchmark..."
+g++ -std=c++14 -O2 benchmark_prefork.cpp -o benchmark_prefork 2>>logs/compile.log
+
+if [ ! -f benchmark_prefork ]; then
+    echo "ERROR: Pre-fork benchmark compilation failed!"
+    cat logs/compile.log
+    exit 1
+fi
+
+echo "Scoring with 1-8 worker processes: loaded, mapped per worker, mapped and warmed before fork..."
+./benchmark_prefork --workers 1,2,4,8 --depth 18 | tee logs/prefork.log
+[ ${PIPESTATUS[0]} -eq 0 ] || gate_status=1
+mv benchmark_results_prefork.csv results/ 2>/dev/null
+
+echo "✓ Pre-fork scoring benchmark complete"
+echo ""
+
 # Cleanup
-rm -f benchmark_serial benchmark_parallel cv_benchmark_serial cv_benchmark_parallel
+rm -f benchmark_serial benchmark_parallel cv_benchmark_serial cv_benchmark_parallel benchmark_histogram benchmark_typed benchmark_sparse benchmark_categorical benchmark_missing benchmark_dedup benchmark_kernels scaling_harness perf_gate perf_gate_parallel benchmark_inference benchmark_counters trace_fit differential_oracle differential_oracle_parallel predict_server benchmark_server score_csv generate_data libpdt.so benchmark_c_api benchmark_prefork
 
 # Display results summary
 echo "========================================="
@@ -98,11 +488,30 @@ done
 echo ""
 echo "Detailed logs saved in ./logs/:"
 echo "  compile.log              - Compilation output"
+echo "  gate.log                 - Regression gate against the stored baselines"
 echo "  tree_serial.log          - Serial tree training output"
 echo "  tree_parallel_*t.log     - Parallel tree training output"
 echo "  cv_serial.log            - Serial CV output"
 echo "  cv_parallel_*t.log       - Parallel CV output"
+echo "  histogram.log            - Histogram kernel microbenchmark output"
+echo "  typed.log                - Specialized vs runtime-dispatched training output"
+echo "  sparse.log               - Sparse vs dense training output (widened data)"
+echo "  categorical.log          - Categorical subset splits vs ordinal codes output"
+echo "  missing.log              - Native missing-value routing vs dropping/imputing output"
+echo "  dedup.log                - Distinct rows with counts vs full-data training output"
+echo "  kernels.log              - Split/loss/partition/predict kernel microbenchmark output"
+echo "  scaling.log              - Strong/weak scaling harness output (region load balance in results/scaling_regions.csv)"
+echo "  inference.log            - Scoring latency percentiles and throughput per engine output"
+echo "  counters.log             - Cycles/instructions/cache/branch/TLB misses per training phase output"
+echo "  trace.log                - Timeline trace export output (trace in results/trace_fit.json)"
+echo "  oracle.log               - Differential correctness oracle output"
+echo "  server.log               - Scoring server load test (unbatched, micro-batched, hot reload) output"
+echo "  scorer.log               - Streaming CSV scorer throughput and stage backpressure output"
+echo "  c_api.log                - C API exports and zero-copy row/column-major scoring output"
+echo "  prefork.log              - Worker processes sharing one mapped model vs a heap copy each output"
 echo ""
 echo "Next steps:"
 echo "  • Analyze results: python analyze_results.py"
-echo "  • View specific logs: cat logs/[filename]"
\ No newline at end of file
+echo "  • View specific logs: cat logs/[filename]"
+
+exit $gate_status
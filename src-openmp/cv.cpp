@@ -1,4 +1,6 @@
 #include "cv.hpp"
+#include "../src/trace.hpp"
+#include "../src/region_profile.hpp"
 #include <iostream>
 #include <iomanip>
 #include <cmath>
@@ -7,7 +9,7 @@
 #include <omp.h>
 
 CrossValidator::CrossValidator(DataFrame data, int k_folds, int seed, bool regression) 
-    : data_(data), k_folds_(k_folds), random_seed_(seed), regression_(regression) {
+    : data_(data), k_folds_(k_folds), random_seed_(seed), regression_(regression), memory_budget_bytes_(-1), account_memory_(false) {
     
     assert(k_folds > 1);
     assert(data.length() >= k_folds);
@@ -87,20 +89,27 @@ CVResult CrossValidator::validateSingleHyperparameter(const HyperparameterSet& p
     /**
      * Perform k-fold cross-validation for a single set of hyperparameters.
      * PARALLEL VERSION: Each fold runs on a separate thread
+     * (fold memory counts the allocations of its thread; only the whole CV has peaks).
      */
+    MemoryScope cv_memory(false, tracksMemory());
     
     // Create k-fold splits
     std::vector<std::vector<DataFrame>> folds = createKFolds(data_, k_folds_, random_seed_);
     
     // Pre-allocate fold scores vector for thread safety
     std::vector<double> fold_scores(k_folds_, 0.0);
+    std::vector<MemoryUsage> fold_memory(k_folds_);
     
     // Print parallel info before the parallel region
     std::cout << " [Parallel CV: Starting parallel fold processing]" << std::flush;
     
     // PARALLEL FOLDS: Each fold trains on a separate thread
+    RegionScope region(Region::cv_folds);
     #pragma omp parallel for
     for (int fold = 0; fold < k_folds_; fold++) {
+        RegionTask task(region);
+        TraceScope trace("cv_fold", "cv", fold);
+        MemoryScope memory(true, tracksMemory());
         DataFrame train_data = folds[fold][0];
         DataFrame val_data = folds[fold][1];
         
@@ -122,12 +131,18 @@ CVResult CrossValidator::validateSingleHyperparameter(const HyperparameterSet& p
         // Calculate accuracy for this fold
         double fold_accuracy = accuracy(true_labels, predictions);
         fold_scores[fold] = fold_accuracy;
+        fold_memory[fold] = memory.close();
     }
+    region.stop();
     
     // Calculate mean and standard deviation
     auto mean_std = calculateMeanStd(fold_scores);
     
-    return CVResult(dataset_name, params.max_depth, 0.0, mean_std.first, mean_std.second, fold_scores);
+    CVResult result(dataset_name, params.max_depth, 0.0, mean_std.first, mean_std.second, fold_scores);
+    result.fold_memory = fold_memory;
+    result.memory = cv_memory.close();
+    check_memory_budget(result.memory, memory_budget_bytes_, "Cross-validation at depth " + std::to_string(params.max_depth));
+    return result;
 }
 
 CVResult CrossValidator::validateDepth(int max_depth, const std::string& dataset_name) const {
@@ -139,11 +154,13 @@ CVResult CrossValidator::validateDepth(int max_depth, const std::string& dataset
     return validateSingleHyperparameter(params, dataset_name);
 }
 
-std::vector<CVResult> CrossValidator::gridSearchCV(const std::vector<HyperparameterSet>& param_grid, const std::string& dataset_name) const {
+std::vector<CVResult> CrossValidator::gridSearchCV(const std::vector<HyperparameterSet>& param_grid, const std::string& dataset_name,
+                                                   MemoryUsage* grid_memory) const {
     /**
      * Perform cross-validation for multiple hyperparameter combinations.
      * Each parameter set uses parallel folds.
      */
+    MemoryScope memory(false, grid_memory != nullptr);
     std::vector<CVResult> results;
     
     for (const auto& params : param_grid) {
@@ -151,6 +168,9 @@ std::vector<CVResult> CrossValidator::gridSearchCV(const std::vector<Hyperparame
         results.push_back(result);
     }
     
+    if (grid_memory != nullptr) {
+        *grid_memory = memory.close();
+    }
     return results;
 }
 
@@ -1,4 +1,5 @@
 #include "datasets.hpp"
+#include "../src/perf_counters.hpp"
 #include <assert.h>
 #include <math.h>
 #include <cmath>
@@ -9,6 +10,8 @@
 #include <vector>
 #include <random>
 #include <algorithm>
+#include <limits>
+#include <cctype>
 
 
 /*
@@ -154,6 +157,7 @@ std::vector<DataVector> DataVector::split(double split_threshold, bool equal_goe
     /**
      * Returns a pair of vectors (value above and below split_threshold).
      * Values equal to the threshold go left if equal_goes_left==true and right otherwise.
+     * Missing values (NaN) go right, as in DecisionTree prediction.
      */
     DataVector left = DataVector(this->is_row());
     DataVector right = DataVector(this->is_row());
@@ -161,7 +165,7 @@ std::vector<DataVector> DataVector::split(double split_threshold, bool equal_goe
         double split_val = this->value(i);
         if (split_val<split_threshold) {
             left.addValue(split_val);
-        } else if (split_val>split_threshold) {
+        } else if ((split_val>split_threshold) or std::isnan(split_val)) {
             right.addValue(split_val);
         } else if (equal_goes_left) {
             left.addValue(split_val);
@@ -571,6 +575,7 @@ std::vector<DataFrame> DataFrame::split(int split_column, double split_threshold
     /**
      * Returns a pair of tables (value above and below split_threshold in specified column).
      * Values equal to the threshold go left if equal_goes_left==true and right otherwise.
+     * Missing values (NaN) go right, as in DecisionTree prediction.
      */
     DataFrame left = DataFrame();
     DataFrame right = DataFrame();
@@ -580,7 +585,7 @@ std::vector<DataFrame> DataFrame::split(int split_column, double split_threshold
         double split_val = row->value(split_column);
         if (split_val<split_threshold) {
             left.addRow(row);
-        } else if (split_val>split_threshold) {
+        } else if ((split_val>split_threshold) or std::isnan(split_val)) {
             right.addRow(row);
         } else if (equal_goes_left) {
             left.addRow(row);
@@ -703,6 +708,35 @@ DataFrame::DataFrame(std::vector<std::vector<double>> matrix)
  */
 
 
+std::vector<int> DataLoader::categorical_columns() const
+{
+    /**
+     * Feature columns in which at least one cell was a string, and which were therefore
+     * dictionary-encoded to codes 0,1,2,... in order of first appearance.
+     * Such codes have no meaningful order (see typed::make_tree's categorical argument).
+     */
+    std::vector<int> columns;
+    for (int c = 0; c+1 < (int)this->categories_.size(); c++)
+    {
+        if (this->categories_[c].size()>0) { columns.push_back(c); }
+    }
+    return columns;
+}
+
+const std::vector<std::string>& DataLoader::categories(int c) const
+{
+    /** Dictionary of column c (empty for numeric columns). */
+    assert ((c>=0) and (c<(int)this->categories_.size()));
+    return this->categories_[c];
+}
+
+int DataLoader::dropped_rows() const
+{
+    /** Rows skipped because their label cell was missing (only when loading with missing_as_nan). */
+    return this->dropped_rows_;
+}
+
+
 /*
  * DATA LOADER - UTILITES :
  */
@@ -719,6 +753,18 @@ DataFrame DataLoader::load()
  */
 
 
+static bool isMissingCell(const std::string& cell)
+{
+    /** Whether a CSV cell marks a missing value: empty, "NA", "N/A", "NaN", "null" or "?" (any case, blanks ignored). */
+    std::string value;
+    for (char ch : cell)
+    {
+        if (!std::isspace((unsigned char)ch)) { value += std::tolower((unsigned char)ch); }
+    }
+    return (value=="") or (value=="na") or (value=="n/a") or (value=="nan") or (value=="null") or (value=="?");
+}
+
+
 DataLoader::DataLoader()
 {
     /** Load hard-coded dummy dataset. */
@@ -736,17 +782,28 @@ DataLoader::DataLoader()
         {7.673756466,3.301233593,1}
     };
     this->dataframe_ = DataFrame(matrix);
+    this->categories_.resize(this->dataframe_.width());
+    this->dropped_rows_ = 0;
 }
 
 DataLoader::DataLoader(std::vector<std::vector<double>> matrix)
 {
     /** Load dataset from vector of vectors. */
     this->dataframe_ = DataFrame(matrix);
+    this->categories_.resize(this->dataframe_.width());
+    this->dropped_rows_ = 0;
 }
 
-DataLoader::DataLoader(std::string filename)
+DataLoader::DataLoader(std::string filename, bool missing_as_nan)
 {
-    /** Load dataset from CSV file at filename */
+    /**
+     * Load dataset from CSV file at filename.
+     * String cells are dictionary-encoded per column (a blank cell is one more string).
+     * With missing_as_nan, empty, "NA", "N/A", "NaN", "null" and "?" feature cells load as
+     * NaN instead, and rows whose label cell is missing are skipped (see dropped_rows()).
+     * Only typed::DecisionTree routes NaN; ::DecisionTree rejects it.
+     */
+    PhaseScope scope(Phase::load);
 
     std::ifstream temp_file(filename); // Open file as a stream
     std::vector<std::vector<std::string>> all_columns_str = {}; // Initialize a vector of vectors for categorical values
@@ -773,6 +830,7 @@ DataLoader::DataLoader(std::string filename)
     }
 
     std::ifstream myfile(filename); // Create stream from given file
+    this->dropped_rows_ = 0;
     std::vector<std::vector<double>> df = {}; // Initialize a matrix
     std::string line; // Initialize a line as a string
 
@@ -800,8 +858,14 @@ DataLoader::DataLoader(std::string filename)
                 double newval;
                 try
                 {   
-                    // Works if the column_str_value is a numerical
-                    newval = std::stod(column_str_value);
+                    if (missing_as_nan and isMissingCell(column_str_value))
+                    {
+                        // Missing value (kept as NaN for the trees to route):
+                        newval = std::numeric_limits<double>::quiet_NaN();
+                    } else {
+                        // Works if the column_str_value is a numerical
+                        newval = std::stod(column_str_value);
+                    }
                 }
                 // In case of invalid_argument error
                 catch(const std::invalid_argument&)
@@ -834,6 +898,13 @@ DataLoader::DataLoader(std::string filename)
                 col_num++;
             }
 
+            // Skip rows without a label (missing_as_nan only):
+            if (missing_as_nan and std::isnan(newrow.back()))
+            {
+                this->dropped_rows_ += 1;
+                continue;
+            }
+
             // Append vector to matrix
             df.push_back(newrow);
 
@@ -841,6 +912,7 @@ DataLoader::DataLoader(std::string filename)
 
         // Save matrix as DataFrame
         this->dataframe_ = df;
+        this->categories_ = all_columns_str;
         myfile.close();
 
     }
@@ -112,12 +112,17 @@ private:
 
     // Attributes:
     DataFrame dataframe_;
+    std::vector<std::vector<std::string>> categories_;  // Dictionary of each column (empty for numeric columns).
+    int dropped_rows_;  // Rows skipped because their label cell was missing.
 
     // Utilities:
 
 public:
 
     // Accessors:
+    std::vector<int> categorical_columns() const;  // Feature columns holding dictionary-encoded strings (label column excluded).
+    const std::vector<std::string>& categories(int c) const;  // Dictionary of column c (code i stands for categories(c)[i]).
+    int dropped_rows() const;  // Rows skipped because their label cell was missing (missing_as_nan only).
 
     // Utilities:
     DataFrame load();  // Return the loaded DataFrame.
@@ -125,7 +130,7 @@ public:
     // Constructors:
     DataLoader();  // Load hard-coded dummy dataset.
     DataLoader(std::vector<std::vector<double>> matrix);
-    DataLoader(std::string filename);
+    DataLoader(std::string filename, bool missing_as_nan=false);  // missing_as_nan: empty, "NA", "NaN" and "?" cells load as NaN.
 
 };
 
@@ -2,12 +2,19 @@
 #include "tree_node.hpp"
 #include "datasets.hpp"
 #include "losses.hpp"
+#include "../src/impurity.hpp"
+#include "../src/bitsets.hpp"
+#include "../src/perf_counters.hpp"
+#include "../src/trace.hpp"
+#include "../src/region_profile.hpp"
 #include <iostream>
+#include <limits>  // std::numeric_limits.
 #include <cmath>  // std::floor.
 #include <math.h>  // std::sqrt.
 #include <algorithm>  // std::sort.
 #include <stack>  // std::stack.
 #include <assert.h>
+#include <stdexcept>  // std::invalid_argument.
 #include <time.h>  // std::time.
 
 // Constructors:
@@ -53,11 +60,25 @@ DecisionTree::DecisionTree(
             throw std::invalid_argument( "Received invalid loss method for classification tree: "+loss );
         }
     }
+    // Missing values are not routed by this tree (typed::DecisionTree learns a direction for them):
+    for (int r = 0; r < dataframe.length(); r++)
+    {
+        for (int c = 0; c < dataframe.width(); c++)
+        {
+            if (std::isnan(dataframe.value(r,c))) {
+                throw std::invalid_argument( "DecisionTree does not accept missing values (NaN in row "+std::to_string(r)+", column "+std::to_string(c)+"); impute them or use typed::make_tree" );
+            }
+        }
+    }
     // Set properties constructor from inputs:
     this->dataframe_ = dataframe;
     this->num_features_ = dataframe.width()-1;  // Number of columns, excluding label column.
     this->regression_ = regression;
     this->loss_ = loss;
+    this->impurity_ = impurity_method(loss);
+    if (this->impurity_==ImpurityMethod::cross_entropy) {
+        this->entropy_table_ = EntropyTable(dataframe.length());
+    }
     this->mtry_ = (mtry==-1) ? this->num_features_ : mtry;
     this->max_height_ = max_height;
     this->max_leaves_ = max_leaves;
@@ -72,8 +93,20 @@ DecisionTree::DecisionTree(
     this->fitted_ = false;
     this->seed_gen = SeedGenerator(this->meta_seed_);
     // Perform training:
-    fit_(this->root_);  // Fit recursively, beginning at root:
+    TraceScope trace("fit_tree", "fit", this->dataframe_.length());
+    PhaseScope presort(Phase::presort);
+    if (!this->regression_) {
+        this->binary_index_ = BinarySplitIndex(this->dataframe_);
+    }
+    presort.stop();
+    if (this->binary_index_.enabled()) {
+        RowBitset members = RowBitset(this->dataframe_.length(), true);  // Root holds every row.
+        fit_(this->root_, &members);  // Fit recursively, beginning at root (bitset fast path):
+    } else {
+        fit_(this->root_);  // Fit recursively, beginning at root:
+    }
     // Update list of leaves:
+    PhaseScope leaves(Phase::leaf);
     this->leaves_ = this->root_->findLeaves();
     this->fitted_ = true;
 }
@@ -241,25 +274,17 @@ double DecisionTree::calculateLoss(DataFrame* dataframe) const
     return loss;
 }
 
-double DecisionTree::calculateSplitLoss(DataFrame* left_dataframe, DataFrame* right_dataframe) const
-{
-    /** Calculate loss on split dataset using weighted average of loss in each split. */
-    int left_size = left_dataframe->length();
-    int right_size = right_dataframe->length();
-    int total_size = left_size + right_size;
-    assert ( (left_size>0) and (right_size>0) );  // Both vectors should be non-empty.
-    // Get loss for each vector:
-    LossFunction loss_func = LossFunction(this->loss_);
-    double left_loss = loss_func.calculate(left_dataframe->col(-1));  // Get class labels from last column.
-    double right_loss = loss_func.calculate(right_dataframe->col(-1));  // Get class labels from last column.
-    // Get weighted average of loss:
-    double loss = (left_loss*left_size/total_size) + (right_loss*right_size/total_size);
-    return loss;
-}
-
-std::pair<int,double> DecisionTree::findBestSplit(TreeNode *node)
+std::pair<int,double> DecisionTree::findBestSplit(TreeNode *node, const RowBitset* members)
 {
-    /** Find best split at this node. */
+    /**
+     * Find best split at this node.
+     * With members (rows of the node as a bitset), two-valued features of a binary
+     * classification tree are scored from popcounts instead of sorting the column.
+     * Split search counters are those of the calling thread outside the parallel loop
+     * plus those of every thread for its own features.
+     */
+    PhaseScope prelude(Phase::split_search);
+    TraceScope trace("find_best_split", "split");
     DataFrame dataframe = node->getDataFrame();
     // Must have enough data to split
     assert (dataframe.length()>1);
@@ -278,39 +303,65 @@ std::pair<int,double> DecisionTree::findBestSplit(TreeNode *node)
         }
     }
     
-    // Initialize best split tracking
+    // Labels at this node (as class indices 0..num_classes-1 for classification trees):
+    std::vector<double> labels = dataframe.col(-1).vector();
+    std::vector<double> class_values = labels;
+    std::vector<int> classes(labels.size());
+    std::sort(class_values.begin(), class_values.end());
+    class_values.erase(std::unique(class_values.begin(), class_values.end()), class_values.end());
+    for (int r = 0; r < (int)labels.size(); r++){
+        classes[r] = std::lower_bound(class_values.begin(), class_values.end(), labels[r]) - class_values.begin();
+    }
+    // Bitset fast path: class 1 counts of the node, shared by every binary feature:
+    const bool use_bitsets = (members != nullptr) and (class_values.size() == 2);
+    const int node_positives = use_bitsets ? count_and(*members, this->binary_index_.positives()) : 0;
+    
+    // Per-feature results, filled in parallel:
+    std::vector<int> feature_best(this->mtry_, -1);
+    std::vector<double> feature_loss(this->mtry_, 0.0);
+    std::vector<double> feature_threshold(this->mtry_, 0.0);
+    
+    prelude.stop();
+    RegionScope region(Region::split_search);
+    // PARALLEL FEATURES: each thread sorts one column and scores all of its thresholds at once
+    #pragma omp parallel for schedule(dynamic) shared(shuf_inds, dataframe, labels, classes, class_values, members, feature_best, feature_loss, feature_threshold)
+    for (int i = 0; i < this->mtry_; i++){
+        RegionTask task(region);
+        PhaseScope scope(Phase::split_search);
+        int col = shuf_inds[i];
+        TraceScope feature_trace("split_feature", "split", col);  // One OpenMP task.
+        ThresholdSweep sweep;
+        if (use_bitsets and this->binary_index_.is_binary(col)) {
+            int left_size, left_positives;
+            this->binary_index_.count_split(col, *members, labels.size(), node_positives, &left_size, &left_positives);
+            sweep.sweep_binary(this->binary_index_.threshold(col), labels.size(), left_size, left_positives, node_positives);
+        } else if (this->regression_) {
+            sweep.sweep_targets(dataframe.col(col).vector(), labels);
+        } else {
+            sweep.sweep_classes(dataframe.col(col).vector(), classes, class_values.size());
+        }
+        int t = sweep.best(this->impurity_, &feature_loss[i], &this->entropy_table_);
+        if (t != -1) {
+            feature_best[i] = t;
+            feature_threshold[i] = sweep.threshold(t);
+        }
+    }
+    region.stop();
+    
+    // Reduce in feature order, so ties resolve exactly as in the serial version
     bool first_pass = true;
     int best_column = -1;
     double best_threshold = -1.0;
     double best_loss = std::numeric_limits<double>::max();  // Start with very high loss
-    
-    // Explore possible splits:
     for (int i = 0; i < this->mtry_; i++){
-        int col = shuf_inds[i];
-        std::vector<double> col_vals = dataframe.col(col).vector();
-        // Remove duplicates:
-        std::sort(col_vals.begin(), col_vals.end());
-        col_vals.erase(std::unique(col_vals.begin(), col_vals.end()), col_vals.end());
-        
-        // FIXED PARALLEL VERSION: Use critical sections for thread-safe updates
-        #pragma omp parallel for schedule(dynamic) shared(col_vals, col, dataframe, best_loss, best_column, best_threshold, first_pass)
-        for (int j = 0; j < (int)col_vals.size()-1; j++){
-            // Don't split on last value (because it will produce empty `right`).
-            double val = col_vals[j];
-            // Split dataset using current column and threshold, score:
-            std::vector<DataFrame> dataset_splits = dataframe.split(col, val, true);
-            double loss = this->calculateSplitLoss(&dataset_splits[0], &dataset_splits[1]);
-            
-            // Thread-safe update of global best
-            #pragma omp critical
-            {
-                if (first_pass || loss < best_loss) {
-                    first_pass = false;
-                    best_column = col;
-                    best_threshold = val;
-                    best_loss = loss;
-                }
-            }
+        if (feature_best[i] == -1) {
+            continue;  // Constant column.
+        }
+        if (first_pass || feature_loss[i] < best_loss) {
+            first_pass = false;
+            best_column = shuf_inds[i];
+            best_threshold = feature_threshold[i];
+            best_loss = feature_loss[i];
         }
     }
     
@@ -318,11 +369,13 @@ std::pair<int,double> DecisionTree::findBestSplit(TreeNode *node)
     return split;
 }
 
-void DecisionTree::fit_(TreeNode* node)
+void DecisionTree::fit_(TreeNode* node, const RowBitset* members)
 {
+    TraceScope trace("expand_node", "fit", node->getDepth());  // Spans the subtree.
+    PhaseScope leaf(Phase::leaf);  // Stopping checks (the node stays a leaf on return).
     DataFrame dataframe = node->getDataFrame();
     LabelCounter label_counter = LabelCounter(dataframe.col(-1));
-    double proportion = label_counter.get_values().max()/label_counter.size();
+    double proportion = label_counter.get_values().max()/label_counter.total_size();  // Share of the node's rows.
     if ( label_counter.size()==1 ) {
         return;  // Prune if there is only one class left.
     } else if ( dataframe.length()<2 ) {
@@ -336,10 +389,13 @@ void DecisionTree::fit_(TreeNode* node)
     } else if ( (this->max_prop_!=-1) and (  proportion>=this->max_prop_) ) {
         return;  // Prune if proportion of majority label is above threshold.
     }
+    leaf.stop();
     // Find best split at this node:
-    std::pair<int,double> split = this->findBestSplit(node);
+    std::pair<int,double> split = this->findBestSplit(node, members);
+    PhaseScope partition(Phase::partition);
     int split_feature = split.first;
     double split_threshold = split.second;
+    TraceScope partition_trace("partition", "partition", split_feature);
     // To handle scenario where all columns within mtry have just 1 unique value
     if (split_feature == -1 && split_threshold == -1.0)
     {
@@ -361,6 +417,18 @@ void DecisionTree::fit_(TreeNode* node)
     node->setLeft(left_child);
     node->setRight(right_child);
     // Recurse to (new) children:
+    if (members != nullptr) {
+        // Node rows of the children, in the same order as left_data / right_data:
+        RowBitset left_members, right_members;
+        this->binary_index_.partition(*members, dataframe, split_feature, split_threshold, left_members, right_members);
+        partition.stop();
+        partition_trace.stop();
+        this->fit_(left_child, &left_members);
+        this->fit_(right_child, &right_members);
+        return;
+    }
+    partition.stop();
+    partition_trace.stop();
     this->fit_(left_child);
     this->fit_(right_child);
 }
@@ -369,7 +437,8 @@ double DecisionTree::predict_(DataVector* observation) const
 {
     /** Helper function to perform prediction on a single observation. */
     TreeNode* node = this->root_;
-    // Starting at root node, traverse tree while going left or right according to trained splitting criteria:
+    // Starting at root node, traverse tree while going left or right according to trained splitting criteria
+    // (a missing value, NaN, goes right):
     while (!node->isLeaf())
     {
         int split_feature = node->getSplitFeature();
@@ -404,18 +473,22 @@ DataVector DecisionTree::predict(DataFrame* testdata) const
     assert ( (testdata->width()==this->num_features_) or (testdata->width()==this->num_features_+1) );
     
     int i;
+    RegionScope region(Region::predict);
     #pragma omp parallel shared(n, preds) private(i)
     {
+        PhaseScope scope(Phase::predict);  // Each thread's share, up to the end of the loop.
+        TraceScope trace("predict", "predict");
         #pragma omp for schedule(dynamic)
         for (i = 0; i < n; i++)
         {
+            RegionTask task(region);
             DataVector* observation = testdata->row(i);
             double prediction = this->predict_(observation);
             preds[i] = prediction;
         }
     }
-    DataVector predictions = DataVector(preds, false);
-    assert(predictions.min() != -1);
+    region.stop();
+    DataVector predictions = DataVector(preds, false);  // Every row is assigned by the loop (-1 is a valid prediction, not a sentinel).
 
     return predictions;
 }
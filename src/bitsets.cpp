@@ -0,0 +1,329 @@
+#include "bitsets.hpp"
+#include "datasets.hpp"
+#include <assert.h>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BITSETS_X86 1
+#endif
+
+
+/*
+ * ROW BITSET - CONSTRUCTORS :
+ */
+
+
+RowBitset::RowBitset(int size, bool value)
+{
+    /** Bitset of `size` rows, all set (value==true) or all clear. */
+    assert (size>=0);
+    this->size_ = size;
+    this->words_.assign((size+63)/64, value ? ~(uint64_t)0 : 0);
+    if (value and (size%64!=0)) {
+        this->words_.back() = ((uint64_t)1 << (size%64)) - 1;  // Keep bits past size() clear.
+    }
+}
+
+
+/*
+ * ROW BITSET - ACCESSORS :
+ */
+
+
+int RowBitset::size() const
+{
+    /** Returns number of rows (bits). */
+    return this->size_;
+}
+
+int RowBitset::num_words() const
+{
+    /** Returns number of 64-bit words. */
+    return this->words_.size();
+}
+
+const uint64_t* RowBitset::words() const
+{
+    /** Pointer to the packed words. */
+    return this->words_.data();
+}
+
+uint64_t* RowBitset::words()
+{
+    /** Pointer to the packed words (for word-wise updates). */
+    return this->words_.data();
+}
+
+bool RowBitset::test(int r) const
+{
+    /** Checks if row r is set. */
+    assert ((r>=0) and (r<this->size_));
+    return (this->words_[r/64] >> (r%64)) & 1;
+}
+
+int RowBitset::count() const
+{
+    /** Number of set rows. */
+    return count_and(*this, *this);
+}
+
+
+/*
+ * ROW BITSET - UTILITIES :
+ */
+
+
+void RowBitset::set(int r)
+{
+    /** Set row r. */
+    assert ((r>=0) and (r<this->size_));
+    this->words_[r/64] |= (uint64_t)1 << (r%64);
+}
+
+
+/*
+ * POPCOUNT KERNELS :
+ *
+ * The generic versions let the compiler pick a popcount sequence for the baseline
+ * target; the x86 versions are built with the POPCNT instruction and chosen at run
+ * time. Four accumulators keep independent popcounts in flight.
+ */
+
+
+static int count_and2_generic(const uint64_t* a, const uint64_t* b, int n_words)
+{
+    int total = 0;
+    for (int w = 0; w < n_words; w++) { total += __builtin_popcountll(a[w] & b[w]); }
+    return total;
+}
+
+static int count_and3_generic(const uint64_t* a, const uint64_t* b, const uint64_t* c, int n_words)
+{
+    int total = 0;
+    for (int w = 0; w < n_words; w++) { total += __builtin_popcountll(a[w] & b[w] & c[w]); }
+    return total;
+}
+
+#ifdef BITSETS_X86
+
+__attribute__((target("popcnt")))
+static int count_and2_popcnt(const uint64_t* a, const uint64_t* b, int n_words)
+{
+    int64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    int w = 0;
+    for (; w+4 <= n_words; w += 4)
+    {
+        c0 += __builtin_popcountll(a[w] & b[w]);
+        c1 += __builtin_popcountll(a[w+1] & b[w+1]);
+        c2 += __builtin_popcountll(a[w+2] & b[w+2]);
+        c3 += __builtin_popcountll(a[w+3] & b[w+3]);
+    }
+    for (; w < n_words; w++) { c0 += __builtin_popcountll(a[w] & b[w]); }
+    return c0 + c1 + c2 + c3;
+}
+
+__attribute__((target("popcnt")))
+static int count_and3_popcnt(const uint64_t* a, const uint64_t* b, const uint64_t* c, int n_words)
+{
+    int64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    int w = 0;
+    for (; w+4 <= n_words; w += 4)
+    {
+        c0 += __builtin_popcountll(a[w] & b[w] & c[w]);
+        c1 += __builtin_popcountll(a[w+1] & b[w+1] & c[w+1]);
+        c2 += __builtin_popcountll(a[w+2] & b[w+2] & c[w+2]);
+        c3 += __builtin_popcountll(a[w+3] & b[w+3] & c[w+3]);
+    }
+    for (; w < n_words; w++) { c0 += __builtin_popcountll(a[w] & b[w] & c[w]); }
+    return c0 + c1 + c2 + c3;
+}
+
+static bool cpu_has_popcnt()
+{
+    static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("popcnt"));
+    return supported;
+}
+
+#endif
+
+int count_and(const RowBitset& a, const RowBitset& b)
+{
+    /** popcount(a & b). */
+    assert (a.size()==b.size());
+#ifdef BITSETS_X86
+    if (cpu_has_popcnt()) {
+        return count_and2_popcnt(a.words(), b.words(), a.num_words());
+    }
+#endif
+    return count_and2_generic(a.words(), b.words(), a.num_words());
+}
+
+int count_and(const RowBitset& a, const RowBitset& b, const RowBitset& c)
+{
+    /** popcount(a & b & c). */
+    assert ((a.size()==b.size()) and (a.size()==c.size()));
+#ifdef BITSETS_X86
+    if (cpu_has_popcnt()) {
+        return count_and3_popcnt(a.words(), b.words(), c.words(), a.num_words());
+    }
+#endif
+    return count_and3_generic(a.words(), b.words(), c.words(), a.num_words());
+}
+
+
+/*
+ * BINARY SPLIT INDEX - CONSTRUCTORS :
+ */
+
+
+BinarySplitIndex::BinarySplitIndex()
+{
+    /** Empty index (fast path disabled). */
+    this->length_ = 0;
+    this->enabled_ = false;
+}
+
+BinarySplitIndex::BinarySplitIndex(const DataFrame& dataframe)
+{
+    /**
+     * Build the label mask and the masks of every two-valued feature column.
+     *    dataframe : Training data (with class labels in right-most column).
+     * The index stays disabled unless the labels take exactly two values.
+     */
+    const int length = dataframe.length();
+    const int num_features = dataframe.width()-1;
+    this->length_ = length;
+    this->enabled_ = false;
+    this->columns_.assign(num_features, RowBitset());
+    this->thresholds_.assign(num_features, 0.0);
+    this->binary_.assign(num_features, false);
+    // Distinct values of column c (stops looking after a third one):
+    auto two_values = [&dataframe, length] (int c, double* low, double* high) {
+        *low = *high = dataframe.value(0, c);
+        for (int r = 1; r < length; r++)
+        {
+            double v = dataframe.value(r, c);
+            if ((v==*low) or (v==*high)) {
+                continue;
+            } else if (*low!=*high) {
+                return false;  // Third value.
+            }
+            *low = std::min(*low, v);
+            *high = std::max(*high, v);
+        }
+        return *low!=*high;
+    };
+    double low, high;
+    if ((length==0) or !two_values(num_features, &low, &high)) {
+        return;
+    }
+    this->positives_ = RowBitset(length);
+    for (int r = 0; r < length; r++)
+    {
+        if (dataframe.value(r, -1)==high) { this->positives_.set(r); }
+    }
+    for (int c = 0; c < num_features; c++)
+    {
+        if (!two_values(c, &low, &high)) {
+            continue;
+        }
+        this->binary_[c] = true;
+        this->thresholds_[c] = low;
+        this->columns_[c] = RowBitset(length);
+        for (int r = 0; r < length; r++)
+        {
+            if (dataframe.value(r, c)==high) { this->columns_[c].set(r); }
+        }
+        this->enabled_ = true;
+    }
+}
+
+
+/*
+ * BINARY SPLIT INDEX - ACCESSORS :
+ */
+
+
+bool BinarySplitIndex::enabled() const
+{
+    /** Checks if the fast path applies to this training set. */
+    return this->enabled_;
+}
+
+bool BinarySplitIndex::is_binary(int c) const
+{
+    /** Checks if column c holds exactly two values. */
+    return this->enabled_ and this->binary_[c];
+}
+
+double BinarySplitIndex::threshold(int c) const
+{
+    /** Split threshold of binary column c (its smaller value). */
+    assert (this->is_binary(c));
+    return this->thresholds_[c];
+}
+
+const RowBitset& BinarySplitIndex::positives() const
+{
+    /** Rows of class 1. */
+    return this->positives_;
+}
+
+
+/*
+ * BINARY SPLIT INDEX - UTILITIES :
+ */
+
+
+void BinarySplitIndex::count_split(int c, const RowBitset& members, int node_size, int node_positives, int* left_size, int* left_positives) const
+{
+    /**
+     * Class counts of the split on binary column c at the node given by members.
+     *    node_size      : popcount(members), known by the caller.
+     *    node_positives : popcount(members & positives), shared by all columns of a node.
+     */
+    assert (this->is_binary(c));
+    const RowBitset& column = this->columns_[c];
+    *left_size = node_size - count_and(members, column);
+    *left_positives = node_positives - count_and(members, column, this->positives_);
+}
+
+void BinarySplitIndex::partition(const RowBitset& members, const DataFrame& node_data, int c, double threshold, RowBitset& left, RowBitset& right) const
+{
+    /**
+     * Membership of the two children of a split (value <= threshold goes left).
+     * Binary columns split with word operations; other columns walk the set bits
+     * of members alongside the rows of node_data (same order).
+     */
+    assert (members.count()==node_data.length());
+    left = RowBitset(members.size());
+    right = RowBitset(members.size());
+    const uint64_t* in = members.words();
+    uint64_t* out_left = left.words();
+    uint64_t* out_right = right.words();
+    if (this->is_binary(c) and (threshold==this->thresholds_[c])) {
+        const uint64_t* column = this->columns_[c].words();
+        for (int w = 0; w < members.num_words(); w++)
+        {
+            out_left[w] = in[w] & ~column[w];
+            out_right[w] = in[w] & column[w];
+        }
+        return;
+    }
+    int i = 0;  // Row of node_data.
+    for (int w = 0; w < members.num_words(); w++)
+    {
+        for (uint64_t bits = in[w]; bits != 0; bits &= bits-1)
+        {
+            uint64_t bit = bits & (~bits+1);  // Lowest set bit.
+            if (node_data.value(i, c)<=threshold) {
+                out_left[w] |= bit;
+            } else {
+                out_right[w] |= bit;
+            }
+            i += 1;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef BITSETS_HPP
+#define BITSETS_HPP
+
+#include "datasets.hpp"
+#include <vector>
+#include <cstdint>
+
+class RowBitset
+{
+    /**
+     * One bit per row of a training set, packed into 64-bit words.
+     * Bits past size() are always zero, so word-wise popcounts need no masking.
+     * */
+
+private:
+
+    // Attributes:
+    int size_;  // Number of rows (bits).
+    std::vector<uint64_t> words_;  // Packed bits, row r in words_[r/64] bit r%64.
+
+public:
+
+    // Accessors:
+    int size() const;  // Returns number of rows (bits).
+    int num_words() const;  // Returns number of 64-bit words.
+    const uint64_t* words() const;  // Pointer to the packed words.
+    uint64_t* words();  // Pointer to the packed words (for word-wise updates).
+    bool test(int r) const;  // Checks if row r is set.
+    int count() const;  // Number of set rows.
+
+    // Utilities:
+    void set(int r);  // Set row r.
+
+    // Constructors:
+    RowBitset(int size=0, bool value=false);
+
+};
+
+int count_and(const RowBitset& a, const RowBitset& b);  // popcount(a & b).
+int count_and(const RowBitset& a, const RowBitset& b, const RowBitset& c);  // popcount(a & b & c).
+
+class BinarySplitIndex
+{
+    /**
+     * Bitsets for the binary-label fast path of the split search.
+     * When the labels take exactly two values, the rows of the larger label (class 1)
+     * form the `positives` mask, and every feature column with exactly two values
+     * gets a mask of the rows holding the larger value (the rows that go right when
+     * splitting at the smaller one). With the node membership as a third mask, the
+     * class counts of such a split are two AND+POPCNT passes over 64 rows per word:
+     *     right_size      = popcount(members & column)
+     *     right_positives = popcount(members & column & positives)
+     * Membership bits follow the row order of the training DataFrame, which
+     * DataFrame::split preserves, so the i-th set bit of a node is its i-th row.
+     * Only DecisionTree builds it, after rejecting NaN, so every value compares.
+     * */
+
+private:
+
+    // Attributes:
+    int length_;  // Number of training rows.
+    RowBitset positives_;  // Rows whose label is the larger of the two labels.
+    std::vector<RowBitset> columns_;  // Per column: rows holding the larger value (empty unless binary).
+    std::vector<double> thresholds_;  // Per column: the smaller value (split threshold of a binary column).
+    std::vector<bool> binary_;  // Per column: whether the column holds exactly two values.
+    bool enabled_;  // Binary labels and at least one binary feature column.
+
+public:
+
+    // Accessors:
+    bool enabled() const;  // Checks if the fast path applies to this training set.
+    bool is_binary(int c) const;  // Checks if column c holds exactly two values.
+    double threshold(int c) const;  // Split threshold of binary column c (its smaller value).
+    const RowBitset& positives() const;  // Rows of class 1.
+
+    // Utilities:
+    void count_split(int c, const RowBitset& members, int node_size, int node_positives, int* left_size, int* left_positives) const;  // Class counts of the split on binary column c.
+    void partition(const RowBitset& members, const DataFrame& node_data, int c, double threshold, RowBitset& left, RowBitset& right) const;  // Membership of the two children of a split.
+
+    // Constructors:
+    BinarySplitIndex(const DataFrame& dataframe);
+    BinarySplitIndex();
+
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+template<typename T>
+class BoundedQueue
+{
+    /**
+     * Blocking queue of at most capacity items between two pipeline stages.
+     * push() waits while the queue is full, which is how a slow stage holds back the
+     * stages before it (backpressure) instead of letting memory grow. close() ends the
+     * stream: pop() then drains what is left and returns false, and push() drops items.
+     * The time producers spent waiting is kept, to show which stage limits the pipeline.
+     * */
+
+private:
+
+    // Attributes:
+    std::deque<T> items_;
+    std::size_t capacity_;
+    bool closed_;
+    double push_wait_seconds_;  // Total time push() waited for room.
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+
+public:
+
+    // Accessors:
+    double push_wait_seconds() const { std::lock_guard<std::mutex> lock(this->mutex_); return this->push_wait_seconds_; }
+
+    // Utilities:
+    bool push(T item)
+    {
+        /** Append an item, waiting for room; false (item dropped) if the queue is closed. */
+        std::unique_lock<std::mutex> lock(this->mutex_);
+        if ((this->items_.size() >= this->capacity_) and !this->closed_) {
+            const auto start = std::chrono::steady_clock::now();
+            this->not_full_.wait(lock, [this] () { return (this->items_.size() < this->capacity_) or this->closed_; });
+            this->push_wait_seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        if (this->closed_) { return false; }
+        this->items_.push_back(std::move(item));
+        lock.unlock();
+        this->not_empty_.notify_one();
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        /** Take the oldest item, waiting for one; false once the queue is closed and empty. */
+        std::unique_lock<std::mutex> lock(this->mutex_);
+        this->not_empty_.wait(lock, [this] () { return !this->items_.empty() or this->closed_; });
+        if (this->items_.empty()) { return false; }
+        item = std::move(this->items_.front());
+        this->items_.pop_front();
+        lock.unlock();
+        this->not_full_.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        /** End the stream (producers are done, or a stage failed): wakes every waiting thread. */
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->closed_ = true;
+        }
+        this->not_full_.notify_all();
+        this->not_empty_.notify_all();
+    }
+
+    // Constructors:
+    explicit BoundedQueue(std::size_t capacity) : capacity_(capacity), closed_(false), push_wait_seconds_(0.0) {}
+
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "cv.hpp"
+#include "trace.hpp"
 #include <iostream>
 #include <iomanip>
 #include <cmath>
@@ -6,7 +7,7 @@
 #include <algorithm>
 
 CrossValidator::CrossValidator(DataFrame data, int k_folds, int seed, bool regression) 
-    : data_(data), k_folds_(k_folds), random_seed_(seed), regression_(regression) {
+    : data_(data), k_folds_(k_folds), random_seed_(seed), regression_(regression), memory_budget_bytes_(-1), account_memory_(false) {
     
     assert(k_folds > 1);
     assert(data.length() >= k_folds);
@@ -86,14 +87,18 @@ CVResult CrossValidator::validateSingleHyperparameter(const HyperparameterSet& p
     /**
      * Perform k-fold cross-validation for a single set of hyperparameters.
      */
+    MemoryScope cv_memory(false, tracksMemory());
     
     // Create k-fold splits
     std::vector<std::vector<DataFrame>> folds = createKFolds(data_, k_folds_, random_seed_);
     
     std::vector<double> fold_scores;
+    std::vector<MemoryUsage> fold_memory;
     
     // Train and evaluate on each fold (SERIAL)
     for (int fold = 0; fold < k_folds_; fold++) {
+        TraceScope trace("cv_fold", "cv", fold);
+        MemoryScope memory(false, tracksMemory());
         DataFrame train_data = folds[fold][0];
         DataFrame val_data = folds[fold][1];
         
@@ -115,12 +120,18 @@ CVResult CrossValidator::validateSingleHyperparameter(const HyperparameterSet& p
         // Calculate accuracy for this fold
         double fold_accuracy = accuracy(true_labels, predictions);
         fold_scores.push_back(fold_accuracy);
+        fold_memory.push_back(memory.close());
+        check_memory_budget(fold_memory.back(), memory_budget_bytes_, "CV fold " + std::to_string(fold));
     }
     
     // Calculate mean and standard deviation
     auto mean_std = calculateMeanStd(fold_scores);
     
-    return CVResult(dataset_name, params.max_depth, 0.0, mean_std.first, mean_std.second, fold_scores);
+    CVResult result(dataset_name, params.max_depth, 0.0, mean_std.first, mean_std.second, fold_scores);
+    result.fold_memory = fold_memory;
+    result.memory = cv_memory.close();
+    check_memory_budget(result.memory, memory_budget_bytes_, "Cross-validation at depth " + std::to_string(params.max_depth));
+    return result;
 }
 
 CVResult CrossValidator::validateDepth(int max_depth, const std::string& dataset_name) const {
@@ -131,10 +142,12 @@ CVResult CrossValidator::validateDepth(int max_depth, const std::string& dataset
     return validateSingleHyperparameter(params, dataset_name);
 }
 
-std::vector<CVResult> CrossValidator::gridSearchCV(const std::vector<HyperparameterSet>& param_grid, const std::string& dataset_name) const {
+std::vector<CVResult> CrossValidator::gridSearchCV(const std::vector<HyperparameterSet>& param_grid, const std::string& dataset_name,
+                                                   MemoryUsage* grid_memory) const {
     /**
      * Perform cross-validation for multiple hyperparameter combinations.
      */
+    MemoryScope memory(false, grid_memory != nullptr);
     std::vector<CVResult> results;
     
     for (const auto& params : param_grid) {
@@ -142,6 +155,9 @@ std::vector<CVResult> CrossValidator::gridSearchCV(const std::vector<Hyperparame
         results.push_back(result);
     }
     
+    if (grid_memory != nullptr) {
+        *grid_memory = memory.close();
+    }
     return results;
 }
 
@@ -4,6 +4,7 @@
 #include "decision_tree.hpp"
 #include "datasets.hpp"
 #include "metrics.hpp"
+#include "memory.hpp"
 #include <vector>
 #include <string>
 #include <utility>
@@ -15,6 +16,8 @@ struct CVResult {
     double mean_cv_accuracy;
     double std_cv_accuracy;
     std::vector<double> fold_scores;
+    MemoryUsage memory;  // Whole cross-validation (folds and their trees), when accounted.
+    std::vector<MemoryUsage> fold_memory;  // Training and prediction of each fold, when accounted.
     
     // Constructor for easy creation
     CVResult(const std::string& dataset_name, int depth, double time_ms, 
@@ -43,6 +46,11 @@ private:
     int k_folds_;
     int random_seed_;
     bool regression_;
+    long long memory_budget_bytes_;  // Peak allowed per cross-validation (-1: none).
+    bool account_memory_;  // Whether CVResult::memory and fold_memory are measured.
+    
+    // Whether cross-validations open memory scopes (accounting or a budget was requested)
+    bool tracksMemory() const { return account_memory_ || memory_budget_bytes_ >= 0; }
     
     // Helper function to create k-fold splits
     std::vector<std::vector<DataFrame>> createKFolds(const DataFrame& data, int k, int seed) const;
@@ -61,7 +69,9 @@ public:
     CVResult validateDepth(int max_depth, const std::string& dataset_name = "") const;
     
     // Multiple hyperparameter grid search with cross-validation
-    std::vector<CVResult> gridSearchCV(const std::vector<HyperparameterSet>& param_grid, const std::string& dataset_name = "") const;
+    // (grid_memory, if given, receives the memory use of the whole search)
+    std::vector<CVResult> gridSearchCV(const std::vector<HyperparameterSet>& param_grid, const std::string& dataset_name = "",
+                                       MemoryUsage* grid_memory = nullptr) const;
     
     // Convenience method to validate multiple depths
     std::vector<CVResult> validateDepths(const std::vector<int>& depths, const std::string& dataset_name = "") const;
@@ -73,6 +83,14 @@ public:
     int getKFolds() const { return k_folds_; }
     int getSeed() const { return random_seed_; }
     bool isRegression() const { return regression_; }
+    long long getMemoryBudget() const { return memory_budget_bytes_; }
+    bool accountsMemory() const { return account_memory_; }
+    
+    // Make a cross-validation throw std::runtime_error when its memory peak exceeds bytes (-1: no budget)
+    void setMemoryBudget(long long bytes) { memory_budget_bytes_ = bytes; }
+    
+    // Measure the memory use of each cross-validation into CVResult (off by default: it costs time)
+    void setMemoryAccounting(bool enabled) { account_memory_ = enabled; }
 };
 
 #endif
\ No newline at end of file
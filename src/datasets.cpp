@@ -1,4 +1,5 @@
 #include "datasets.hpp"
+#include "perf_counters.hpp"
 #include <assert.h>
 #include <math.h>
 #include <cmath>
@@ -9,6 +10,11 @@
 #include <vector>
 #include <random>
 #include <algorithm>
+#include <limits>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
 
 
 /*
@@ -177,6 +183,7 @@ std::vector<DataVector> DataVector::split(double split_threshold, bool equal_goe
     /**
      * Returns a pair of vectors (value above and below split_threshold).
      * Values equal to the threshold go left if equal_goes_left==true and right otherwise.
+     * Missing values (NaN) go right, as in DecisionTree prediction.
      */
     DataVector left = DataVector(this->is_row());
     DataVector right = DataVector(this->is_row());
@@ -184,7 +191,7 @@ std::vector<DataVector> DataVector::split(double split_threshold, bool equal_goe
         double split_val = this->value(i);
         if (split_val<split_threshold) {
             left.addValue(split_val);
-        } else if (split_val>split_threshold) {
+        } else if ((split_val>split_threshold) or std::isnan(split_val)) {
             right.addValue(split_val);
         } else if (equal_goes_left) {
             left.addValue(split_val);
@@ -613,6 +620,7 @@ std::vector<DataFrame> DataFrame::split(int split_column, double split_threshold
     /**
      * Returns a pair of tables (value above and below split_threshold in specified column).
      * Values equal to the threshold go left if equal_goes_left==true and right otherwise.
+     * Missing values (NaN) go right, as in DecisionTree prediction.
      */
     DataFrame left = DataFrame();
     DataFrame right = DataFrame();
@@ -622,7 +630,7 @@ std::vector<DataFrame> DataFrame::split(int split_column, double split_threshold
         double split_val = row->value(split_column);
         if (split_val<split_threshold) {
             left.addRow(row);
-        } else if (split_val>split_threshold) {
+        } else if ((split_val>split_threshold) or std::isnan(split_val)) {
             right.addRow(row);
         } else if (equal_goes_left) {
             left.addRow(row);
@@ -666,6 +674,56 @@ std::vector<DataFrame> DataFrame::train_test_split(double test_pct, int seed) co
     return std::vector<DataFrame> {train, test};
 }
 
+DataFrame DataFrame::deduplicate(std::vector<int>& counts) const
+{
+    /**
+     * Collapse identical rows (features and label, compared bit for bit) into their first
+     * occurrence. Returns the distinct rows in order of first appearance (sharing row
+     * pointers with this frame) and sets counts[i] to the number of copies of row i.
+     * Rows are bucketed by a hash of their bits, so the cost is linear in the frame size.
+     */
+    DataFrame distinct = DataFrame();
+    counts.clear();
+    std::unordered_map<uint64_t, std::vector<int>> buckets;  // Row hash -> indices of distinct rows.
+    for (int r = 0; r < this->length(); r++)
+    {
+        const DataVector* row = this->row(r);
+        // FNV-1a over the 64-bit patterns of the values:
+        uint64_t hash = 14695981039346656037ull;
+        for (int c = 0; c < this->width(); c++)
+        {
+            const double value = row->value(c);
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            hash = (hash ^ bits) * 1099511628211ull;
+        }
+        std::vector<int>& candidates = buckets[hash];
+        bool found = false;
+        for (int i : candidates)
+        {
+            const DataVector* other = distinct.row(i);
+            bool same = true;
+            for (int c = 0; same and (c < this->width()); c++)
+            {
+                const double a = row->value(c);
+                const double b = other->value(c);
+                same = (std::memcmp(&a, &b, sizeof(double)) == 0);
+            }
+            if (same) {
+                counts[i] += 1;
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            candidates.push_back(distinct.length());
+            distinct.addRow(this->row(r));
+            counts.push_back(1);
+        }
+    }
+    return distinct;
+}
+
 std::string DataFrame::to_string(bool new_line, int col_width) const
 {
     /**
@@ -745,6 +803,35 @@ DataFrame::DataFrame(std::vector<std::vector<double>> matrix)
  */
 
 
+std::vector<int> DataLoader::categorical_columns() const
+{
+    /**
+     * Feature columns in which at least one cell was a string, and which were therefore
+     * dictionary-encoded to codes 0,1,2,... in order of first appearance.
+     * Such codes have no meaningful order (see typed::make_tree's categorical argument).
+     */
+    std::vector<int> columns;
+    for (int c = 0; c+1 < (int)this->categories_.size(); c++)
+    {
+        if (this->categories_[c].size()>0) { columns.push_back(c); }
+    }
+    return columns;
+}
+
+const std::vector<std::string>& DataLoader::categories(int c) const
+{
+    /** Dictionary of column c (empty for numeric columns). */
+    assert ((c>=0) and (c<(int)this->categories_.size()));
+    return this->categories_[c];
+}
+
+int DataLoader::dropped_rows() const
+{
+    /** Rows skipped because their label cell was missing (only when loading with missing_as_nan). */
+    return this->dropped_rows_;
+}
+
+
 /*
  * DATA LOADER - UTILITES :
  */
@@ -761,6 +848,18 @@ DataFrame DataLoader::load()
  */
 
 
+static bool isMissingCell(const std::string& cell)
+{
+    /** Whether a CSV cell marks a missing value: empty, "NA", "N/A", "NaN", "null" or "?" (any case, blanks ignored). */
+    std::string value;
+    for (char ch : cell)
+    {
+        if (!std::isspace((unsigned char)ch)) { value += std::tolower((unsigned char)ch); }
+    }
+    return (value=="") or (value=="na") or (value=="n/a") or (value=="nan") or (value=="null") or (value=="?");
+}
+
+
 DataLoader::DataLoader()
 {
     /** Load hard-coded dummy dataset. */
@@ -778,17 +877,28 @@ DataLoader::DataLoader()
         {7.673756466,3.301233593,1}
     };
     this->dataframe_ = DataFrame(matrix);
+    this->categories_.resize(this->dataframe_.width());
+    this->dropped_rows_ = 0;
 }
 
 DataLoader::DataLoader(std::vector<std::vector<double>> matrix)
 {
     /** Load dataset from vector of vectors. */
     this->dataframe_ = DataFrame(matrix);
+    this->categories_.resize(this->dataframe_.width());
+    this->dropped_rows_ = 0;
 }
 
-DataLoader::DataLoader(std::string filename)
+DataLoader::DataLoader(std::string filename, bool missing_as_nan)
 {
-    /** Load dataset from CSV file at filename */
+    /**
+     * Load dataset from CSV file at filename.
+     * String cells are dictionary-encoded per column (a blank cell is one more string).
+     * With missing_as_nan, empty, "NA", "N/A", "NaN", "null" and "?" feature cells load as
+     * NaN instead, and rows whose label cell is missing are skipped (see dropped_rows()).
+     * Only typed::DecisionTree routes NaN; ::DecisionTree rejects it.
+     */
+    PhaseScope scope(Phase::load);
 
     std::ifstream temp_file(filename); // Open file as a stream
     std::vector<std::vector<std::string>> all_columns_str = {}; // Initialize a vector of vectors for categorical values
@@ -815,6 +925,7 @@ DataLoader::DataLoader(std::string filename)
     }
 
     std::ifstream myfile(filename); // Create stream from given file
+    this->dropped_rows_ = 0;
     std::vector<std::vector<double>> df = {}; // Initialize a matrix
     std::string line; // Initialize a line as a string
 
@@ -842,8 +953,14 @@ DataLoader::DataLoader(std::string filename)
                 double newval;
                 try
                 {   
-                    // Works if the column_str_value is a numerical
-                    newval = std::stod(column_str_value);
+                    if (missing_as_nan and isMissingCell(column_str_value))
+                    {
+                        // Missing value (kept as NaN for the trees to route):
+                        newval = std::numeric_limits<double>::quiet_NaN();
+                    } else {
+                        // Works if the column_str_value is a numerical
+                        newval = std::stod(column_str_value);
+                    }
                 }
                 // In case of invalid_argument error
                 catch(const std::invalid_argument&)
@@ -876,6 +993,13 @@ DataLoader::DataLoader(std::string filename)
                 col_num++;
             }
 
+            // Skip rows without a label (missing_as_nan only):
+            if (missing_as_nan and std::isnan(newrow.back()))
+            {
+                this->dropped_rows_ += 1;
+                continue;
+            }
+
             // Append vector to matrix
             df.push_back(newrow);
 
@@ -883,6 +1007,7 @@ DataLoader::DataLoader(std::string filename)
 
         // Save matrix as DataFrame
         this->dataframe_ = df;
+        this->categories_ = all_columns_str;
         myfile.close();
 
     }
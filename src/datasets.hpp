@@ -98,6 +98,7 @@ public:
     DataFrame transpose() const;  // Returns a transposed copy of the DataFrame.
     std::vector<DataFrame> split(int split_column, double split_threshold, bool equal_goes_left=true) const;  // Returns a pair of frames (value above and below threshold in specified column).
     std::vector<DataFrame> train_test_split(double split_pct, int seed = -1) const; // Returns a pair of train/test tables (sized using split_pct).
+    DataFrame deduplicate(std::vector<int>& counts) const;  // Returns the distinct rows, with the number of copies of each in counts.
     std::string to_string(bool new_line=true, int col_width=9) const;  // Return the DataFrame as a string.
     void print(bool new_line=true, int col_width=9) const;  // Print the data frame.
 
@@ -120,12 +121,17 @@ private:
 
     // Attributes:
     DataFrame dataframe_;
+    std::vector<std::vector<std::string>> categories_;  // Dictionary of each column (empty for numeric columns).
+    int dropped_rows_;  // Rows skipped because their label cell was missing.
 
     // Utilities:
 
 public:
 
     // Accessors:
+    std::vector<int> categorical_columns() const;  // Feature columns holding dictionary-encoded strings (label column excluded).
+    const std::vector<std::string>& categories(int c) const;  // Dictionary of column c (code i stands for categories(c)[i]).
+    int dropped_rows() const;  // Rows skipped because their label cell was missing (missing_as_nan only).
 
     // Utilities:
     DataFrame load();  // Return the loaded DataFrame.
@@ -133,7 +139,7 @@ public:
     // Constructors:
     DataLoader();  // Load hard-coded dummy dataset.
     DataLoader(std::vector<std::vector<double>> matrix);
-    DataLoader(std::string filename);
+    DataLoader(std::string filename, bool missing_as_nan=false);  // missing_as_nan: empty, "NA", "NaN" and "?" cells load as NaN.
 
 };
 
@@ -4,6 +4,8 @@
 #include "tree_node.hpp"
 #include "datasets.hpp"
 #include "losses.hpp"
+#include "impurity.hpp"
+#include "bitsets.hpp"
 #include <utility>  // std::pair, std::make_pair
 
 class DecisionTree
@@ -15,11 +17,14 @@ private:
     DataFrame dataframe_;  // Training data.
     bool regression_;  // Use regression==false for a classification tree.
     std::string loss_;  // String indicating loss function method.
+    ImpurityMethod impurity_;  // Parsed loss_, used by the threshold kernels.
+    EntropyTable entropy_table_;  // n*log2(n) for counts up to the training size (cross_entropy only).
+    BinarySplitIndex binary_index_;  // Label and feature bitsets for binary classification (popcount split counting).
     int mtry_;  // Hyperparameter: Number of features to use at each split (or -1 for all in deterministic order; or 0 for sqrt(n_columns) ).
     int max_height_;  // Stopping condition: max height of tree.
     int max_leaves_;  // Stopping condition: max number of leaves.
     int min_obs_;  // Stopping condition: minimum number of observations in a leaf.
-    int max_prop_;  // Stopping condition: minimum proportion of majority class in a leaf.
+    double max_prop_;  // Stopping condition: maximum proportion of majority class in a leaf.
     int num_leaves_;  // State variable: Number of leaves currently in tree.
     int num_features_;  // State variable: Number of features in dataset.
     std::vector<TreeNode*> leaves_;  // State variables: List of leaves.
@@ -28,15 +33,15 @@ private:
     SeedGenerator seed_gen;  // Random seed generator.
 
     // Utilities:
-    void fit_(TreeNode* node);  // Helper function to perform fitting recursively.
+    void fit_(TreeNode* node, const RowBitset* members=nullptr);  // Helper function to perform fitting recursively (members: node rows, for the bitset fast path).
     double predict_(DataVector* observation) const;  // Helper function to perform prediction on a single observation.
-    std::pair<int,double> findBestSplit(TreeNode *node);  // Find best split at this node.
+    std::pair<int,double> findBestSplit(TreeNode *node, const RowBitset* members=nullptr);  // Find best split at this node.
     double calculateLoss(DataFrame* dataframe) const;  // Calculate loss before split.
-    double calculateSplitLoss(DataFrame* left_dataframe, DataFrame* right_dataframe) const;  // Calculate loss on split dataset.
 
 public:
 
     // Constructors:
+    // Throws std::invalid_argument for a missing value (NaN) in dataframe.
     DecisionTree(
         DataFrame dataframe, bool regression=false, std::string loss="gini_impurity",
         int mtry=-1, int max_height=-1, int max_leaves=-1, int min_obs=-1,
@@ -0,0 +1,199 @@
+#ifndef FIXED_PREDICTOR_HPP
+#define FIXED_PREDICTOR_HPP
+
+#include "model.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Inference for a fixed schema of N features, known at compile time.
+ *
+ * make_fixed_predictor<N>(model) copies a TreeModel into a FixedPredictor<N>, whose
+ * node table is a std::array of MaxNodes entries inside the object and whose rows are
+ * std::array<double, N>. Because N is a constant, feature indices are checked once at
+ * load time, a row can live in registers, and no per-row bounds or width checks remain.
+ * Leaves point to themselves, so predict_batch() advances four rows together for
+ * exactly height()-1 steps without testing for leaves. Only threshold splits that send
+ * missing values right are supported (as trained on data without NaN).
+ */
+
+struct FixedNode
+{
+    /** Node of a FixedPredictor (16 bytes). Leaves have children==own index and right_offset==0. */
+    double threshold;  // Rows with value <= threshold go left.
+    int32_t children;  // Left child index.
+    uint16_t right_offset;  // right = children + right_offset (pre-order: right follows the left subtree).
+    uint16_t feature;  // Splitting column (< N); 0 for leaves.
+};
+
+template<std::size_t N, std::size_t MaxNodes = 2047>
+class FixedPredictor
+{
+    /**
+     * A TreeModel specialized for rows of exactly N features and at most MaxNodes nodes.
+     * Predictions are identical to TreeModel::predict / DecisionTree::predict.
+     * */
+
+    static_assert(N>0, "FixedPredictor needs at least one feature");
+    static_assert(N<=std::numeric_limits<uint16_t>::max(), "Feature index must fit in uint16_t");
+
+public:
+
+    typedef std::array<double, N> Row;
+
+private:
+
+    // Attributes:
+    std::array<double, MaxNodes> values_;  // Prediction of each node.
+    std::array<FixedNode, MaxNodes> nodes_;  // Node table (first size_ entries used).
+    int size_;  // Number of nodes.
+    int steps_;  // Traversal steps (height of tree - 1).
+
+public:
+
+    // Accessors:
+    static constexpr std::size_t num_features() { return N; }  // Schema width.
+    static constexpr std::size_t max_nodes() { return MaxNodes; }  // Capacity of the node table.
+    int size() const { return this->size_; }  // Number of nodes.
+    int height() const { return this->steps_+1; }  // Height of tree.
+
+    // Utilities:
+    double predict(const Row& row) const;  // Prediction for one row.
+    void predict_batch(const Row* rows, std::size_t n_rows, double* out) const;  // Predictions for n_rows rows.
+    std::vector<double> predict(const std::vector<Row>& rows) const;  // Predictions for many rows.
+
+    // Constructors:
+    explicit FixedPredictor(const TreeModel& model);
+
+};
+
+template<std::size_t N, std::size_t MaxNodes>
+FixedPredictor<N,MaxNodes>::FixedPredictor(const TreeModel& model)
+{
+    /** Copy a model into the fixed node table (throws std::invalid_argument if it does not fit). */
+    if (model.num_features() != (int)N) {
+        throw std::invalid_argument( "Model expects "+std::to_string(model.num_features())+" features, predictor has "+std::to_string(N) );
+    }
+    if (model.has_categorical_splits()) {
+        throw std::invalid_argument( "FixedPredictor only supports threshold splits (model has categorical splits)" );
+    }
+    if (model.size() > (int)MaxNodes) {
+        throw std::invalid_argument( "Model has "+std::to_string(model.size())+" nodes, predictor holds at most "+std::to_string(MaxNodes) );
+    }
+    const std::vector<ModelNode>& nodes = model.nodes();
+    this->size_ = nodes.size();
+    this->steps_ = model.height()-1;
+    for (int i = 0; i < this->size_; i++)
+    {
+        FixedNode& node = this->nodes_[i];
+        this->values_[i] = nodes[i].value;
+        if (nodes[i].feature == -1) {
+            node.threshold = 0.0;
+            node.children = i;  // Self-loop: extra steps stay on the leaf.
+            node.right_offset = 0;
+            node.feature = 0;
+            continue;
+        }
+        if (nodes[i].default_left) {
+            throw std::invalid_argument( "FixedPredictor sends missing values right, but node "+std::to_string(i)+" defaults left" );
+        }
+        if (nodes[i].right <= nodes[i].left) {
+            throw std::invalid_argument( "Right child before left child at node "+std::to_string(i) );
+        }
+        if (nodes[i].right - nodes[i].left > (int)std::numeric_limits<uint16_t>::max()) {
+            throw std::invalid_argument( "Subtree too large for FixedPredictor at node "+std::to_string(i) );
+        }
+        node.threshold = nodes[i].threshold;
+        node.children = nodes[i].left;
+        node.right_offset = nodes[i].right - nodes[i].left;
+        node.feature = nodes[i].feature;
+    }
+}
+
+template<std::size_t N, std::size_t MaxNodes>
+double FixedPredictor<N,MaxNodes>::predict(const Row& row) const
+{
+    /** Prediction for one row (stops at the leaf, which suits unbalanced trees). */
+    const FixedNode* nodes = this->nodes_.data();
+    int i = 0;
+    while (nodes[i].children != i)
+    {
+        const FixedNode& node = nodes[i];
+        i = node.children + ((row[node.feature] <= node.threshold) ? 0 : node.right_offset);
+    }
+    return this->values_[i];
+}
+
+template<std::size_t N, std::size_t MaxNodes>
+void FixedPredictor<N,MaxNodes>::predict_batch(const Row* rows, std::size_t n_rows, double* out) const
+{
+    /**
+     * Predictions for n_rows rows. Four rows advance through the tree together, so the
+     * node loads of one row overlap with the comparisons of the others.
+     */
+    const FixedNode* nodes = this->nodes_.data();
+    std::size_t r = 0;
+    for (; r+4 <= n_rows; r += 4)
+    {
+        int i0 = 0, i1 = 0, i2 = 0, i3 = 0;
+        for (int step = 0; step < this->steps_; step++)
+        {
+            const FixedNode& n0 = nodes[i0];
+            const FixedNode& n1 = nodes[i1];
+            const FixedNode& n2 = nodes[i2];
+            const FixedNode& n3 = nodes[i3];
+            i0 = n0.children + ((rows[r][n0.feature] <= n0.threshold) ? 0 : n0.right_offset);
+            i1 = n1.children + ((rows[r+1][n1.feature] <= n1.threshold) ? 0 : n1.right_offset);
+            i2 = n2.children + ((rows[r+2][n2.feature] <= n2.threshold) ? 0 : n2.right_offset);
+            i3 = n3.children + ((rows[r+3][n3.feature] <= n3.threshold) ? 0 : n3.right_offset);
+        }
+        out[r] = this->values_[i0];
+        out[r+1] = this->values_[i1];
+        out[r+2] = this->values_[i2];
+        out[r+3] = this->values_[i3];
+    }
+    for (; r < n_rows; r++) { out[r] = this->predict(rows[r]); }
+}
+
+template<std::size_t N, std::size_t MaxNodes>
+std::vector<double> FixedPredictor<N,MaxNodes>::predict(const std::vector<Row>& rows) const
+{
+    /** Predictions for many rows. */
+    std::vector<double> out(rows.size());
+    this->predict_batch(rows.data(), rows.size(), out.data());
+    return out;
+}
+
+template<std::size_t N, std::size_t MaxNodes = 2047>
+FixedPredictor<N,MaxNodes> make_fixed_predictor(const TreeModel& model)
+{
+    /**
+     * Inference path for a fixed schema of N features, e.g. make_fixed_predictor<11>(model)
+     * for HMEQ or make_fixed_predictor<30>(model) for cancer. Throws std::invalid_argument
+     * if the model has a different width or more than MaxNodes nodes.
+     */
+    return FixedPredictor<N,MaxNodes>(model);
+}
+
+template<std::size_t N>
+std::vector<std::array<double, N>> fixed_rows(DataFrame* dataframe)
+{
+    /** Copy the first N columns of every row into std::array rows (for FixedPredictor<N>). */
+    if ((dataframe->width() != (int)N) and (dataframe->width() != (int)N+1)) {
+        throw std::invalid_argument( "Expected "+std::to_string(N)+" feature columns, got "+std::to_string(dataframe->width()) );
+    }
+    std::vector<std::array<double, N>> rows(dataframe->length());
+    for (int r = 0; r < dataframe->length(); r++)
+    {
+        const DataVector* row = dataframe->row(r);
+        for (std::size_t c = 0; c < N; c++) { rows[r][c] = row->value(c); }
+    }
+    return rows;
+}
+
+#endif
@@ -0,0 +1,620 @@
+#include "histogram.hpp"
+#include "datasets.hpp"
+#include "simd.hpp"
+#include "perf_counters.hpp"
+#include <assert.h>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HISTOGRAM_X86 1
+#include <immintrin.h>
+#endif
+
+
+/*
+ * BINNED FRAME - ACCESSORS :
+ */
+
+
+int BinnedFrame::length() const
+{
+    /** Returns the number of rows. */
+    return this->length_;
+}
+
+int BinnedFrame::width() const
+{
+    /** Returns the number of feature columns (label column excluded). */
+    return this->width_;
+}
+
+int BinnedFrame::num_classes() const
+{
+    /** Returns the number of distinct labels. */
+    return this->classes_.size();
+}
+
+int BinnedFrame::num_bins(int c) const
+{
+    /** Returns the number of bins used by column c. */
+    assert ((c>=0) and (c<this->width()));
+    return this->edges_[c].size();
+}
+
+const uint8_t* BinnedFrame::codes(int c) const
+{
+    /** Pointer to the (contiguous) bin codes of column c. */
+    assert ((c>=0) and (c<this->width()));
+    return &this->codes_[(size_t)c*this->length_];
+}
+
+const int32_t* BinnedFrame::labels() const
+{
+    /** Pointer to the class index of each row. */
+    return &this->labels_[0];
+}
+
+double BinnedFrame::class_label(int k) const
+{
+    /** Original label value of class index k. */
+    assert ((k>=0) and (k<this->num_classes()));
+    return this->classes_[k];
+}
+
+double BinnedFrame::threshold(int c, int b) const
+{
+    /**
+     * Split threshold equivalent to "code <= b" in column c,
+     * i.e. rows in bins 0..b satisfy value <= threshold(c,b).
+     */
+    assert ((b>=0) and (b<this->num_bins(c)));
+    return this->edges_[c][b];
+}
+
+
+/*
+ * BINNED FRAME - CONSTRUCTORS :
+ */
+
+
+BinnedFrame::BinnedFrame(const DataFrame& dataframe, int max_bins)
+{
+    /**
+     * Quantize every feature column of dataframe (labels in right-most column).
+     * Columns with at most max_bins unique values get one bin per value, so splits
+     * on them are exact; wider columns use quantile edges.
+     */
+    PhaseScope scope(Phase::presort);
+    assert ((max_bins>=2) and (max_bins<=kMaxBins));
+    assert ((dataframe.length()>0) and (dataframe.width()>1));
+    this->length_ = dataframe.length();
+    this->width_ = dataframe.width()-1;
+    this->codes_.assign((size_t)this->length_*this->width_ + kCodePadding, 0);
+    // Map labels to class indices:
+    std::vector<double> label_col = dataframe.col(-1).vector();
+    this->classes_ = label_col;
+    std::sort(this->classes_.begin(), this->classes_.end());
+    this->classes_.erase(std::unique(this->classes_.begin(), this->classes_.end()), this->classes_.end());
+    this->labels_.resize(this->length_ + kCodePadding/sizeof(int32_t));
+    for (int i = 0; i < this->length_; i++)
+    {
+        this->labels_[i] = std::lower_bound(this->classes_.begin(), this->classes_.end(), label_col[i]) - this->classes_.begin();
+    }
+    // Quantize each column:
+    for (int c = 0; c < this->width_; c++)
+    {
+        std::vector<double> values = dataframe.col(c).vector();
+        std::vector<double> sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<double> edges = sorted;
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        if ((int)edges.size() > max_bins) {
+            // Too many unique values: use (deduplicated) quantiles as bin edges.
+            edges.clear();
+            for (int b = 1; b <= max_bins; b++)
+            {
+                edges.push_back(sorted[(size_t)b*this->length_/max_bins - 1]);
+            }
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        }
+        uint8_t* out = &this->codes_[(size_t)c*this->length_];
+        for (int i = 0; i < this->length_; i++)
+        {
+            out[i] = std::lower_bound(edges.begin(), edges.end(), values[i]) - edges.begin();
+        }
+        this->edges_.push_back(edges);
+    }
+}
+
+
+/*
+ * HISTOGRAM SCRATCH :
+ */
+
+
+uint32_t* HistogramScratch::counts(size_t n)
+{
+    /** At least n zeroed counters (grown, never shrunk). */
+    if (this->counts_.size() < n) {
+        this->counts_.assign(n, 0);
+    }
+    return &this->counts_[0];
+}
+
+double* HistogramScratch::sums(size_t n)
+{
+    /** At least n zeroed sums (grown, never shrunk). */
+    if (this->sums_.size() < n) {
+        this->sums_.assign(n, 0.0);
+    }
+    return &this->sums_[0];
+}
+
+
+/*
+ * HISTOGRAM KERNELS - LABEL COUNTS :
+ *
+ * Every kernel adds into `hist` (the caller zeroes it) and accepts rows==nullptr
+ * to mean the contiguous rows 0..n_rows-1. The sub-histogram variants trade a
+ * final reduction for independent increments: consecutive rows landing in the
+ * same bin no longer wait on each other's store-to-load forwarding. Their
+ * sub-histograms live in a HistogramScratch and cover only the num_bins bins
+ * of the column, which the reduction clears again as it reads them.
+ */
+
+
+template <bool kIndexed>
+static void histogram_scalar(const uint8_t* codes, const int32_t* labels, const int32_t* rows, int n_rows, int num_classes, uint32_t* hist)
+{
+    for (int i = 0; i < n_rows; i++)
+    {
+        int r = kIndexed ? rows[i] : i;
+        hist[codes[r]*num_classes + labels[r]] += 1;
+    }
+}
+
+template <bool kIndexed>
+static void histogram_unrolled(const uint8_t* codes, const int32_t* labels, const int32_t* rows, int n_rows, int num_classes,
+                               int num_bins, HistogramScratch& scratch, uint32_t* hist)
+{
+    const int size = num_bins*num_classes;
+    uint32_t* h0 = scratch.counts(4*size);
+    uint32_t* h1 = h0 + size;
+    uint32_t* h2 = h1 + size;
+    uint32_t* h3 = h2 + size;
+    int i = 0;
+    for (; i+4 <= n_rows; i += 4)
+    {
+        int r0 = kIndexed ? rows[i] : i;
+        int r1 = kIndexed ? rows[i+1] : i+1;
+        int r2 = kIndexed ? rows[i+2] : i+2;
+        int r3 = kIndexed ? rows[i+3] : i+3;
+        h0[codes[r0]*num_classes + labels[r0]] += 1;
+        h1[codes[r1]*num_classes + labels[r1]] += 1;
+        h2[codes[r2]*num_classes + labels[r2]] += 1;
+        h3[codes[r3]*num_classes + labels[r3]] += 1;
+    }
+    for (; i < n_rows; i++)
+    {
+        int r = kIndexed ? rows[i] : i;
+        h0[codes[r]*num_classes + labels[r]] += 1;
+    }
+    for (int b = 0; b < size; b++)
+    {
+        hist[b] += h0[b] + h1[b] + h2[b] + h3[b];
+        h0[b] = h1[b] = h2[b] = h3[b] = 0;
+    }
+}
+
+#ifdef HISTOGRAM_X86
+
+template <bool kIndexed>
+__attribute__((target("avx2")))
+static void histogram_avx2(const uint8_t* codes, const int32_t* labels, const int32_t* rows, int n_rows, int num_classes,
+                           int num_bins, HistogramScratch& scratch, uint32_t* hist)
+{
+    // Bin indices for eight rows are formed in one register (gathers for codes and labels),
+    // then each lane increments its own sub-histogram: AVX2 has no scatter.
+    const int size = num_bins*num_classes;
+    uint32_t* h = scratch.counts(8*size);
+    alignas(32) int32_t bins[8];
+    const __m256i iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256i classes = _mm256_set1_epi32(num_classes);
+    const __m256i lane_offsets = _mm256_mullo_epi32(iota, _mm256_set1_epi32(size));
+    int i = 0;
+    for (; i+8 <= n_rows; i += 8)
+    {
+        __m256i code, label;
+        if (kIndexed) {
+            __m256i idx = _mm256_loadu_si256((const __m256i*)(rows+i));
+            code = _mm256_and_si256(_mm256_i32gather_epi32((const int*)codes, idx, 1), byte_mask);
+            label = _mm256_i32gather_epi32((const int*)labels, idx, 4);
+        } else {
+            code = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(codes+i)));
+            label = _mm256_loadu_si256((const __m256i*)(labels+i));
+        }
+        __m256i bin = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(code, classes), label), lane_offsets);
+        _mm256_store_si256((__m256i*)bins, bin);
+        h[bins[0]] += 1; h[bins[1]] += 1; h[bins[2]] += 1; h[bins[3]] += 1;
+        h[bins[4]] += 1; h[bins[5]] += 1; h[bins[6]] += 1; h[bins[7]] += 1;
+    }
+    for (; i < n_rows; i++)
+    {
+        int r = kIndexed ? rows[i] : i;
+        h[codes[r]*num_classes + labels[r]] += 1;
+    }
+    for (int b = 0; b < size; b++)
+    {
+        uint32_t total = 0;
+        for (int k = 0; k < 8; k++) { total += h[k*size + b]; h[k*size + b] = 0; }
+        hist[b] += total;
+    }
+}
+
+template <bool kIndexed>
+__attribute__((target("avx512f,avx512vl")))
+static void histogram_avx512(const uint8_t* codes, const int32_t* labels, const int32_t* rows, int n_rows, int num_classes,
+                             int num_bins, HistogramScratch& scratch, uint32_t* hist)
+{
+    // Sixteen lanes gather, increment and scatter at once. Each lane owns a sub-histogram,
+    // so two lanes can never hit the same address and no conflict detection is needed.
+    const int size = num_bins*num_classes;
+    uint32_t* h = scratch.counts(16*size);
+    const __m512i iota = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i byte_mask = _mm512_set1_epi32(0xFF);
+    const __m512i classes = _mm512_set1_epi32(num_classes);
+    const __m512i lane_offsets = _mm512_mullo_epi32(iota, _mm512_set1_epi32(size));
+    const __m512i one = _mm512_set1_epi32(1);
+    int i = 0;
+    for (; i+16 <= n_rows; i += 16)
+    {
+        __m512i code, label;
+        if (kIndexed) {
+            __m512i idx = _mm512_loadu_si512((const void*)(rows+i));
+            code = _mm512_and_si512(_mm512_i32gather_epi32(idx, (const void*)codes, 1), byte_mask);
+            label = _mm512_i32gather_epi32(idx, (const void*)labels, 4);
+        } else {
+            code = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(codes+i)));
+            label = _mm512_loadu_si512((const void*)(labels+i));
+        }
+        __m512i bin = _mm512_add_epi32(_mm512_add_epi32(_mm512_mullo_epi32(code, classes), label), lane_offsets);
+        __m512i current = _mm512_i32gather_epi32(bin, (const void*)h, 4);
+        _mm512_i32scatter_epi32((void*)h, bin, _mm512_add_epi32(current, one), 4);
+    }
+    for (; i < n_rows; i++)
+    {
+        int r = kIndexed ? rows[i] : i;
+        h[codes[r]*num_classes + labels[r]] += 1;
+    }
+    for (int b = 0; b < size; b++)
+    {
+        uint32_t total = 0;
+        for (int k = 0; k < 16; k++) { total += h[k*size + b]; h[k*size + b] = 0; }
+        hist[b] += total;
+    }
+}
+
+#endif
+
+
+/*
+ * HISTOGRAM KERNELS - GRADIENT SUMS :
+ *
+ * Same layout as above with num_bins entries per sub-histogram. Partial sums are
+ * combined in a different order by each kernel, so floating point results can
+ * differ in the last bits between kernels (counts are always identical).
+ */
+
+
+template <bool kIndexed>
+static void gradient_histogram_scalar(const uint8_t* codes, const double* gradients, const int32_t* rows, int n_rows, double* sums, uint32_t* counts)
+{
+    for (int i = 0; i < n_rows; i++)
+    {
+        int r = kIndexed ? rows[i] : i;
+        sums[codes[r]] += gradients[r];
+        counts[codes[r]] += 1;
+    }
+}
+
+template <bool kIndexed>
+static void gradient_histogram_unrolled(const uint8_t* codes, const double* gradients, const int32_t* rows, int n_rows,
+                                        int num_bins, HistogramScratch& scratch, double* sums, uint32_t* counts)
+{
+    double* s = scratch.sums(4*num_bins);
+    uint32_t* n = scratch.counts(4*num_bins);
+    int i = 0;
+    for (; i+4 <= n_rows; i += 4)
+    {
+        int r0 = kIndexed ? rows[i] : i;
+        int r1 = kIndexed ? rows[i+1] : i+1;
+        int r2 = kIndexed ? rows[i+2] : i+2;
+        int r3 = kIndexed ? rows[i+3] : i+3;
+        int b0 = codes[r0];
+        int b1 = num_bins + codes[r1];
+        int b2 = 2*num_bins + codes[r2];
+        int b3 = 3*num_bins + codes[r3];
+        s[b0] += gradients[r0]; n[b0] += 1;
+        s[b1] += gradients[r1]; n[b1] += 1;
+        s[b2] += gradients[r2]; n[b2] += 1;
+        s[b3] += gradients[r3]; n[b3] += 1;
+    }
+    for (; i < n_rows; i++)
+    {
+        int r = kIndexed ? rows[i] : i;
+        s[codes[r]] += gradients[r];
+        n[codes[r]] += 1;
+    }
+    for (int b = 0; b < num_bins; b++)
+    {
+        sums[b] += (s[b] + s[num_bins+b]) + (s[2*num_bins+b] + s[3*num_bins+b]);
+        counts[b] += n[b] + n[num_bins+b] + n[2*num_bins+b] + n[3*num_bins+b];
+    }
+    std::fill(s, s + 4*num_bins, 0.0);
+    std::fill(n, n + 4*num_bins, 0);
+}
+
+#ifdef HISTOGRAM_X86
+
+template <bool kIndexed>
+__attribute__((target("avx2")))
+static void gradient_histogram_avx2(const uint8_t* codes, const double* gradients, const int32_t* rows, int n_rows,
+                                    int num_bins, HistogramScratch& scratch, double* sums, uint32_t* counts)
+{
+    double* s = scratch.sums(8*num_bins);
+    uint32_t* n = scratch.counts(8*num_bins);
+    alignas(32) int32_t bins[8];
+    alignas(32) double grads[8];
+    const __m256i iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256i lane_offsets = _mm256_mullo_epi32(iota, _mm256_set1_epi32(num_bins));
+    int i = 0;
+    for (; i+8 <= n_rows; i += 8)
+    {
+        __m256i code;
+        if (kIndexed) {
+            __m256i idx = _mm256_loadu_si256((const __m256i*)(rows+i));
+            code = _mm256_and_si256(_mm256_i32gather_epi32((const int*)codes, idx, 1), byte_mask);
+            _mm256_store_pd(grads, _mm256_i32gather_pd(gradients, _mm256_castsi256_si128(idx), 8));
+            _mm256_store_pd(grads+4, _mm256_i32gather_pd(gradients, _mm256_extracti128_si256(idx, 1), 8));
+        } else {
+            code = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(codes+i)));
+            _mm256_store_pd(grads, _mm256_loadu_pd(gradients+i));
+            _mm256_store_pd(grads+4, _mm256_loadu_pd(gradients+i+4));
+        }
+        _mm256_store_si256((__m256i*)bins, _mm256_add_epi32(code, lane_offsets));
+        for (int k = 0; k < 8; k++)
+        {
+            s[bins[k]] += grads[k];
+            n[bins[k]] += 1;
+        }
+    }
+    for (; i < n_rows; i++)
+    {
+        int r = kIndexed ? rows[i] : i;
+        s[codes[r]] += gradients[r];
+        n[codes[r]] += 1;
+    }
+    for (int b = 0; b < num_bins; b++)
+    {
+        double total = 0.0;
+        uint32_t count = 0;
+        for (int k = 0; k < 8; k++)
+        {
+            total += s[k*num_bins + b];
+            count += n[k*num_bins + b];
+        }
+        sums[b] += total;
+        counts[b] += count;
+    }
+    std::fill(s, s + 8*num_bins, 0.0);
+    std::fill(n, n + 8*num_bins, 0);
+}
+
+template <bool kIndexed>
+__attribute__((target("avx512f,avx512vl")))
+static void gradient_histogram_avx512(const uint8_t* codes, const double* gradients, const int32_t* rows, int n_rows,
+                                      int num_bins, HistogramScratch& scratch, double* sums, uint32_t* counts)
+{
+    // Eight double lanes per iteration, one private sub-histogram per lane (see histogram_avx512).
+    double* s = scratch.sums(8*num_bins);
+    uint32_t* n = scratch.counts(8*num_bins);
+    const __m256i iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256i lane_offsets = _mm256_mullo_epi32(iota, _mm256_set1_epi32(num_bins));
+    const __m256i one = _mm256_set1_epi32(1);
+    int i = 0;
+    for (; i+8 <= n_rows; i += 8)
+    {
+        __m256i code;
+        __m512d grad;
+        if (kIndexed) {
+            __m256i idx = _mm256_loadu_si256((const __m256i*)(rows+i));
+            code = _mm256_and_si256(_mm256_i32gather_epi32((const int*)codes, idx, 1), byte_mask);
+            grad = _mm512_i32gather_pd(idx, (const void*)gradients, 8);
+        } else {
+            code = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(codes+i)));
+            grad = _mm512_loadu_pd(gradients+i);
+        }
+        __m256i bin = _mm256_add_epi32(code, lane_offsets);
+        __m512d current = _mm512_i32gather_pd(bin, (const void*)s, 8);
+        _mm512_i32scatter_pd((void*)s, bin, _mm512_add_pd(current, grad), 8);
+        __m256i count = _mm256_i32gather_epi32((const int*)n, bin, 4);
+        _mm256_i32scatter_epi32((void*)n, bin, _mm256_add_epi32(count, one), 4);
+    }
+    for (; i < n_rows; i++)
+    {
+        int r = kIndexed ? rows[i] : i;
+        s[codes[r]] += gradients[r];
+        n[codes[r]] += 1;
+    }
+    for (int b = 0; b < num_bins; b++)
+    {
+        double total = 0.0;
+        uint32_t count = 0;
+        for (int k = 0; k < 8; k++)
+        {
+            total += s[k*num_bins + b];
+            count += n[k*num_bins + b];
+        }
+        sums[b] += total;
+        counts[b] += count;
+    }
+    std::fill(s, s + 8*num_bins, 0.0);
+    std::fill(n, n + 8*num_bins, 0);
+}
+
+#endif
+
+
+/*
+ * HISTOGRAM KERNELS - DISPATCH :
+ */
+
+
+bool histogram_kernel_supported(HistogramKernel kernel)
+{
+    /** Checks if the running CPU can execute a kernel. */
+#ifdef HISTOGRAM_X86
+    if (kernel==HistogramKernel::avx512) {
+        return simd_level_supported(SimdLevel::avx512);
+    } else if (kernel==HistogramKernel::avx2) {
+        return simd_level_supported(SimdLevel::avx2);
+    }
+#else
+    if ((kernel==HistogramKernel::avx512) or (kernel==HistogramKernel::avx2)) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+HistogramKernel resolve_histogram_kernel(HistogramKernel kernel, int n_rows, bool indexed, int num_bins, int num_classes)
+{
+    /**
+     * Replace `automatic` with the kernel that was fastest for a node of this shape
+     * (benchmark_histogram and per-node timings, 200 bins, 2 and 8 classes, AVX-512 CPU):
+     *  - Every sub-histogram kernel pays lanes*num_bins*num_classes cells of reduction,
+     *    which dominates until a node holds ~16 rows per cell: the scalar kernel wins below.
+     *  - Gathered rows (a node's row list) were fastest unrolled at every size: the vector
+     *    gathers cost more than the independent increments save.
+     *  - Contiguous rows went faster with AVX-512 (then AVX2) only for nodes of >= 64 rows
+     *    per cell whose lane sub-histograms fit in L1 (2 classes: 1.00 vs 1.26 ns/row at
+     *    262144 rows); with 8 classes they spilled and the unrolled kernel won.
+     */
+    if (kernel!=HistogramKernel::automatic) {
+        return kernel;
+    }
+    const long long cells = (long long)num_bins*num_classes;
+    if (n_rows < 16*cells) {
+        return HistogramKernel::scalar;
+    }
+    if ((!indexed) and (n_rows >= 64*cells)) {
+        const long long l1_bytes = 32*1024;
+        if (histogram_kernel_supported(HistogramKernel::avx512) and (16*cells*(long long)sizeof(uint32_t) <= l1_bytes)) {
+            return HistogramKernel::avx512;
+        } else if (histogram_kernel_supported(HistogramKernel::avx2) and (8*cells*(long long)sizeof(uint32_t) <= l1_bytes)) {
+            return HistogramKernel::avx2;
+        }
+    }
+    return HistogramKernel::unrolled;
+}
+
+std::string histogram_kernel_name(HistogramKernel kernel)
+{
+    /** Printable name of a kernel. */
+    switch (kernel)
+    {
+        case HistogramKernel::automatic: return "automatic";
+        case HistogramKernel::scalar: return "scalar";
+        case HistogramKernel::unrolled: return "unrolled";
+        case HistogramKernel::avx2: return "avx2";
+        case HistogramKernel::avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+void build_histogram(
+    const uint8_t* codes, const int32_t* labels, const int32_t* rows, int n_rows,
+    int num_classes, uint32_t* hist, HistogramKernel kernel, int num_bins, HistogramScratch* scratch
+)
+{
+    /**
+     * Add the label counts of the given rows to hist[bin*num_classes+label].
+     *    codes       : Bin code of every row (readable kCodePadding bytes past the end).
+     *    labels      : Class index of every row.
+     *    rows        : Row indices to count (e.g. the rows in a node), or nullptr for rows 0..n_rows-1.
+     *    hist        : kMaxBins*num_classes counters, accumulated into (not reset); only
+     *                  the first num_bins*num_classes are touched.
+     *    kernel      : Implementation to use (automatic selects the best supported one).
+     *    num_bins    : Bins used by the column (every code < num_bins, e.g. BinnedFrame::num_bins).
+     *    scratch     : Sub-histograms reused across calls (one per thread), or nullptr to allocate them.
+     */
+    assert ((n_rows>=0) and (num_classes>=1) and (num_bins>=1) and (num_bins<=kMaxBins));
+    bool indexed = (rows!=nullptr);
+    kernel = resolve_histogram_kernel(kernel, n_rows, indexed, num_bins, num_classes);
+    assert (histogram_kernel_supported(kernel));
+    HistogramScratch local;
+    HistogramScratch& sub = (scratch!=nullptr) ? *scratch : local;
+#ifdef HISTOGRAM_X86
+    if (kernel==HistogramKernel::avx512) {
+        if (indexed) { histogram_avx512<true>(codes, labels, rows, n_rows, num_classes, num_bins, sub, hist); }
+        else { histogram_avx512<false>(codes, labels, rows, n_rows, num_classes, num_bins, sub, hist); }
+        return;
+    } else if (kernel==HistogramKernel::avx2) {
+        if (indexed) { histogram_avx2<true>(codes, labels, rows, n_rows, num_classes, num_bins, sub, hist); }
+        else { histogram_avx2<false>(codes, labels, rows, n_rows, num_classes, num_bins, sub, hist); }
+        return;
+    }
+#endif
+    if (kernel==HistogramKernel::unrolled) {
+        if (indexed) { histogram_unrolled<true>(codes, labels, rows, n_rows, num_classes, num_bins, sub, hist); }
+        else { histogram_unrolled<false>(codes, labels, rows, n_rows, num_classes, num_bins, sub, hist); }
+    } else {
+        if (indexed) { histogram_scalar<true>(codes, labels, rows, n_rows, num_classes, hist); }
+        else { histogram_scalar<false>(codes, labels, rows, n_rows, num_classes, hist); }
+    }
+}
+
+void build_gradient_histogram(
+    const uint8_t* codes, const double* gradients, const int32_t* rows, int n_rows,
+    double* sums, uint32_t* counts, HistogramKernel kernel, int num_bins, HistogramScratch* scratch
+)
+{
+    /**
+     * Add the gradients (and counts) of the given rows to sums[bin] (and counts[bin]).
+     * Arguments as in build_histogram; sums and counts hold kMaxBins entries each.
+     */
+    assert ((n_rows>=0) and (num_bins>=1) and (num_bins<=kMaxBins));
+    if (kernel==HistogramKernel::automatic) {
+        // The SIMD gradient kernels never beat the unrolled one in benchmark_histogram
+        // (AVX-512 tied on contiguous rows and lost on node rows; AVX2 lost everywhere).
+        kernel = (n_rows < 16*num_bins) ? HistogramKernel::scalar : HistogramKernel::unrolled;
+    }
+    assert (histogram_kernel_supported(kernel));
+    bool indexed = (rows!=nullptr);
+    HistogramScratch local;
+    HistogramScratch& sub = (scratch!=nullptr) ? *scratch : local;
+#ifdef HISTOGRAM_X86
+    if (kernel==HistogramKernel::avx512) {
+        if (indexed) { gradient_histogram_avx512<true>(codes, gradients, rows, n_rows, num_bins, sub, sums, counts); }
+        else { gradient_histogram_avx512<false>(codes, gradients, rows, n_rows, num_bins, sub, sums, counts); }
+        return;
+    } else if (kernel==HistogramKernel::avx2) {
+        if (indexed) { gradient_histogram_avx2<true>(codes, gradients, rows, n_rows, num_bins, sub, sums, counts); }
+        else { gradient_histogram_avx2<false>(codes, gradients, rows, n_rows, num_bins, sub, sums, counts); }
+        return;
+    }
+#endif
+    if (kernel==HistogramKernel::unrolled) {
+        if (indexed) { gradient_histogram_unrolled<true>(codes, gradients, rows, n_rows, num_bins, sub, sums, counts); }
+        else { gradient_histogram_unrolled<false>(codes, gradients, rows, n_rows, num_bins, sub, sums, counts); }
+    } else {
+        if (indexed) { gradient_histogram_scalar<true>(codes, gradients, rows, n_rows, sums, counts); }
+        else { gradient_histogram_scalar<false>(codes, gradients, rows, n_rows, sums, counts); }
+    }
+}
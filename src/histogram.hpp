@@ -0,0 +1,100 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include "datasets.hpp"
+#include "simd.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+const int kMaxBins = 256;  // Bin codes are stored as uint8_t.
+const int kCodePadding = 64;  // Code buffers must be readable this many bytes past the last row (vector gathers read 4 bytes).
+
+enum class HistogramKernel
+{
+    /** Implementations of the histogram scatter-add. */
+    automatic,  // Fastest supported kernel for the node's shape (see resolve_histogram_kernel).
+    scalar,  // One histogram, one row at a time.
+    unrolled,  // Four sub-histograms, rows unrolled by four.
+    avx2,  // AVX2 gathers for codes/labels, eight sub-histograms.
+    avx512  // AVX-512 gather/add/scatter into sixteen lane-private sub-histograms.
+};
+
+class BinnedFrame
+{
+    /**
+     * Features of a DataFrame quantized into at most kMaxBins bins per column.
+     * Codes are stored column-major so a per-node histogram reads one contiguous array.
+     * Labels (right-most column) are mapped to class indices 0..num_classes()-1.
+     * */
+
+private:
+
+    // Attributes:
+    int length_;  // Number of rows.
+    int width_;  // Number of feature columns (label column excluded).
+    std::vector<uint8_t> codes_;  // Column-major bin codes (padded by kCodePadding).
+    std::vector<int32_t> labels_;  // Class index of each row.
+    std::vector<double> classes_;  // Original label value of each class index (ascending).
+    std::vector<std::vector<double>> edges_;  // Upper edge (inclusive) of each bin, per column.
+
+public:
+
+    // Accessors:
+    int length() const;  // Returns number of rows.
+    int width() const;  // Returns number of feature columns.
+    int num_classes() const;  // Returns number of distinct labels.
+    int num_bins(int c) const;  // Returns number of bins used by column c.
+    const uint8_t* codes(int c) const;  // Pointer to the bin codes of column c.
+    const int32_t* labels() const;  // Pointer to the class index of each row.
+    double class_label(int k) const;  // Original label value of class index k.
+    double threshold(int c, int b) const;  // Split threshold equivalent to "code <= b" in column c.
+
+    // Constructors:
+    BinnedFrame(const DataFrame& dataframe, int max_bins=kMaxBins);
+
+};
+
+class HistogramScratch
+{
+    /**
+     * Sub-histograms of the unrolled and SIMD kernels, kept between calls so building
+     * the histogram of a small node neither allocates nor zeroes kMaxBins bins per lane.
+     * Kernels clear what they used while reducing it, so the buffers are all zero
+     * between calls. Not thread-safe: use one per thread.
+     * */
+
+private:
+
+    // Attributes:
+    std::vector<uint32_t> counts_;
+    std::vector<double> sums_;
+
+public:
+
+    // Accessors:
+    uint32_t* counts(size_t n);  // At least n zeroed counters.
+    double* sums(size_t n);  // At least n zeroed sums.
+
+};
+
+// Label-count histograms: hist[bin*num_classes+label] += 1 for each row (hist holds kMaxBins*num_classes entries).
+// Passing the column's num_bins and a reused scratch keeps the per-call cost proportional to the bins in use.
+void build_histogram(
+    const uint8_t* codes, const int32_t* labels, const int32_t* rows, int n_rows,
+    int num_classes, uint32_t* hist, HistogramKernel kernel=HistogramKernel::automatic,
+    int num_bins=kMaxBins, HistogramScratch* scratch=nullptr
+);
+
+// Gradient histograms: sums[bin] += gradients[row] and counts[bin] += 1 (both hold kMaxBins entries).
+void build_gradient_histogram(
+    const uint8_t* codes, const double* gradients, const int32_t* rows, int n_rows,
+    double* sums, uint32_t* counts, HistogramKernel kernel=HistogramKernel::automatic,
+    int num_bins=kMaxBins, HistogramScratch* scratch=nullptr
+);
+
+HistogramKernel resolve_histogram_kernel(HistogramKernel kernel, int n_rows, bool indexed, int num_bins, int num_classes);  // Replace `automatic` with the fastest kernel for a node of this shape.
+bool histogram_kernel_supported(HistogramKernel kernel);  // Checks if the running CPU can execute a kernel.
+std::string histogram_kernel_name(HistogramKernel kernel);  // Printable name of a kernel.
+
+#endif
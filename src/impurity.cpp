@@ -0,0 +1,669 @@
+#include "impurity.hpp"
+#include "simd.hpp"
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define IMPURITY_X86 1
+#include <immintrin.h>
+#endif
+
+
+ImpurityMethod impurity_method(const std::string& method)
+{
+    /** Parse a loss name (same names as LossFunction). */
+    if (method=="misclassification_error") {
+        return ImpurityMethod::misclassification_error;
+    } else if (method=="cross_entropy") {
+        return ImpurityMethod::cross_entropy;
+    } else if (method=="gini_impurity") {
+        return ImpurityMethod::gini_impurity;
+    } else if (method=="mean_squared_error") {
+        return ImpurityMethod::mean_squared_error;
+    }
+    throw std::invalid_argument( "Received invalid loss method: "+method );
+}
+
+
+/*
+ * ENTROPY TABLE :
+ */
+
+
+double nlog2n_approx(double n)
+{
+    /**
+     * n*log2(n) without calling log2: split n = m*2^e with m in [sqrt(1/2), sqrt(2)),
+     * then ln(m) = 2*atanh(s) with s = (m-1)/(m+1), |s| < 0.172, summed as an odd
+     * polynomial in s. Relative error is below 1e-11 for any positive n.
+     */
+    if (n<=0) {
+        return 0.0;
+    }
+    uint64_t bits;
+    std::memcpy(&bits, &n, sizeof(bits));
+    int exponent = (int)((bits >> 52) & 0x7FF) - 1023;
+    bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;  // Mantissa in [1,2).
+    double mantissa;
+    std::memcpy(&mantissa, &bits, sizeof(mantissa));
+    if (mantissa > 1.4142135623730951) {
+        mantissa *= 0.5;
+        exponent += 1;
+    }
+    const double s = (mantissa-1)/(mantissa+1);
+    const double s2 = s*s;
+    const double ln_mantissa = 2*s*(1 + s2*(1.0/3 + s2*(1.0/5 + s2*(1.0/7 + s2*(1.0/9 + s2*(1.0/11 + s2*(1.0/13)))))));
+    return n*(exponent + ln_mantissa*1.4426950408889634);  // 1/ln(2).
+}
+
+int EntropyTable::max_count() const
+{
+    /** Largest count held in the table. */
+    return this->values_.size()-1;
+}
+
+const double* EntropyTable::data() const
+{
+    /** Pointer to the table (for gathers). */
+    return &this->values_[0];
+}
+
+double EntropyTable::nlog2n(int n) const
+{
+    /** n*log2(n): table lookup, or polynomial approximation past max_count(). */
+    assert (n>=0);
+    if (n<(int)this->values_.size()) {
+        return this->values_[n];
+    }
+    return nlog2n_approx(n);
+}
+
+EntropyTable::EntropyTable(int max_count)
+{
+    /** Precompute n*log2(n) for n = 0..max_count (e.g. the number of training rows). */
+    assert (max_count>=0);
+    this->values_.resize(max_count+1);
+    this->values_[0] = 0.0;
+    for (int n = 1; n <= max_count; n++)
+    {
+        this->values_[n] = n*std::log2((double)n);
+    }
+}
+
+
+/*
+ * THRESHOLD KERNELS - CLASSIFICATION :
+ *
+ * Each kernel writes the weighted child loss
+ *     (left_loss*left_size/total_size) + (right_loss*right_size/total_size)
+ * of every candidate into `out`, using the same operations in the same order as
+ * LossFunction on the two child label vectors. The vector kernels only process
+ * several thresholds side by side, so every lane rounds exactly like the scalar
+ * code and split selection is unchanged. Classes missing from a child add 0.0.
+ */
+
+
+static void class_losses_scalar(
+    ImpurityMethod method, int num_thresholds, int num_classes, int total_size,
+    const int32_t* left_sizes, const int32_t* left_counts, const int32_t* class_totals, double* out
+)
+{
+    // Gini impurity and misclassification error (entropy has its own kernels below).
+    const double total = total_size;
+    for (int t = 0; t < num_thresholds; t++)
+    {
+        const double n_left = left_sizes[t];
+        const double n_right = total - n_left;
+        double left_loss = 0;
+        double right_loss = 0;
+        if (method==ImpurityMethod::misclassification_error) {
+            int32_t max_left = 0;
+            int32_t max_right = 0;
+            for (int k = 0; k < num_classes; k++)
+            {
+                int32_t c_left = left_counts[k*num_thresholds + t];
+                max_left = std::max(max_left, c_left);
+                max_right = std::max(max_right, class_totals[k] - c_left);
+            }
+            left_loss = (n_left - max_left) / n_left;
+            right_loss = (n_right - max_right) / n_right;
+        } else {
+            for (int k = 0; k < num_classes; k++)
+            {
+                int32_t c_left = left_counts[k*num_thresholds + t];
+                int32_t c_right = class_totals[k] - c_left;
+                double p_left = c_left / n_left;
+                double p_right = c_right / n_right;
+                left_loss += p_left*(1-p_left);
+                right_loss += p_right*(1-p_right);
+            }
+        }
+        out[t] = (left_loss*n_left/total) + (right_loss*n_right/total);
+    }
+}
+
+#ifdef IMPURITY_X86
+
+__attribute__((target("avx2")))
+static void class_losses_avx2(
+    ImpurityMethod method, int num_thresholds, int num_classes, int total_size,
+    const int32_t* left_sizes, const int32_t* left_counts, const int32_t* class_totals, double* out
+)
+{
+    // Four thresholds per iteration. Binary labels are specialized: the class-0 counts
+    // follow from the left size, so only one prefix array is read.
+    const __m256d total = _mm256_set1_pd(total_size);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const bool binary = (num_classes==2);
+    const int32_t* ones = left_counts + num_thresholds;  // Class 1 prefix counts (binary case).
+    int t = 0;
+    for (; t+4 <= num_thresholds; t += 4)
+    {
+        const __m256d n_left = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(left_sizes+t)));
+        const __m256d n_right = _mm256_sub_pd(total, n_left);
+        __m256d left_loss = zero;
+        __m256d right_loss = zero;
+        if (binary) {
+            const __m256d c1_left = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(ones+t)));
+            const __m256d c1_right = _mm256_sub_pd(_mm256_set1_pd(class_totals[1]), c1_left);
+            const __m256d c0_left = _mm256_sub_pd(n_left, c1_left);
+            const __m256d c0_right = _mm256_sub_pd(n_right, c1_right);
+            if (method==ImpurityMethod::misclassification_error) {
+                left_loss = _mm256_div_pd(_mm256_sub_pd(n_left, _mm256_max_pd(c0_left, c1_left)), n_left);
+                right_loss = _mm256_div_pd(_mm256_sub_pd(n_right, _mm256_max_pd(c0_right, c1_right)), n_right);
+            } else {
+                __m256d p;
+                p = _mm256_div_pd(c0_left, n_left);
+                left_loss = _mm256_add_pd(left_loss, _mm256_mul_pd(p, _mm256_sub_pd(one, p)));
+                p = _mm256_div_pd(c1_left, n_left);
+                left_loss = _mm256_add_pd(left_loss, _mm256_mul_pd(p, _mm256_sub_pd(one, p)));
+                p = _mm256_div_pd(c0_right, n_right);
+                right_loss = _mm256_add_pd(right_loss, _mm256_mul_pd(p, _mm256_sub_pd(one, p)));
+                p = _mm256_div_pd(c1_right, n_right);
+                right_loss = _mm256_add_pd(right_loss, _mm256_mul_pd(p, _mm256_sub_pd(one, p)));
+            }
+        } else {
+            __m256d max_left = zero;
+            __m256d max_right = zero;
+            for (int k = 0; k < num_classes; k++)
+            {
+                const __m256d c_left = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(left_counts + k*num_thresholds + t)));
+                const __m256d c_right = _mm256_sub_pd(_mm256_set1_pd(class_totals[k]), c_left);
+                if (method==ImpurityMethod::misclassification_error) {
+                    max_left = _mm256_max_pd(max_left, c_left);
+                    max_right = _mm256_max_pd(max_right, c_right);
+                } else {
+                    __m256d p;
+                    p = _mm256_div_pd(c_left, n_left);
+                    left_loss = _mm256_add_pd(left_loss, _mm256_mul_pd(p, _mm256_sub_pd(one, p)));
+                    p = _mm256_div_pd(c_right, n_right);
+                    right_loss = _mm256_add_pd(right_loss, _mm256_mul_pd(p, _mm256_sub_pd(one, p)));
+                }
+            }
+            if (method==ImpurityMethod::misclassification_error) {
+                left_loss = _mm256_div_pd(_mm256_sub_pd(n_left, max_left), n_left);
+                right_loss = _mm256_div_pd(_mm256_sub_pd(n_right, max_right), n_right);
+            }
+        }
+        const __m256d weighted_left = _mm256_div_pd(_mm256_mul_pd(left_loss, n_left), total);
+        const __m256d weighted_right = _mm256_div_pd(_mm256_mul_pd(right_loss, n_right), total);
+        _mm256_storeu_pd(out+t, _mm256_add_pd(weighted_left, weighted_right));
+    }
+    // Remaining thresholds:
+    if (t < num_thresholds) {
+        std::vector<int32_t> tail_counts;
+        for (int k = 0; k < num_classes; k++)
+        {
+            tail_counts.insert(tail_counts.end(), left_counts + k*num_thresholds + t, left_counts + (k+1)*num_thresholds);
+        }
+        class_losses_scalar(method, num_thresholds-t, num_classes, total_size, left_sizes+t, &tail_counts[0], class_totals, out+t);
+    }
+}
+
+#endif
+
+
+/*
+ * THRESHOLD KERNELS - ENTROPY :
+ *
+ * Weighted child entropy from n*log2(n) lookups:
+ *     (left_size*H_left + right_size*H_right) / total_size
+ *         = ( [T(left_size) - sum_k T(c_left_k)] + [T(right_size) - sum_k T(c_right_k)] ) / total_size
+ * T(0) = 0, so classes missing from a child need no special case.
+ */
+
+
+static void entropy_losses_scalar(
+    int num_thresholds, int num_classes, int total_size, const int32_t* left_sizes,
+    const int32_t* left_counts, const int32_t* class_totals, const EntropyTable& table, double* out
+)
+{
+    const double total = total_size;
+    for (int t = 0; t < num_thresholds; t++)
+    {
+        const int32_t n_left = left_sizes[t];
+        const int32_t n_right = total_size - n_left;
+        double left_loss = table.nlog2n(n_left);
+        double right_loss = table.nlog2n(n_right);
+        for (int k = 0; k < num_classes; k++)
+        {
+            int32_t c_left = left_counts[k*num_thresholds + t];
+            left_loss -= table.nlog2n(c_left);
+            right_loss -= table.nlog2n(class_totals[k] - c_left);
+        }
+        out[t] = (left_loss + right_loss) / total;
+    }
+}
+
+#ifdef IMPURITY_X86
+
+__attribute__((target("avx2")))
+static void entropy_losses_avx2(
+    int num_thresholds, int num_classes, int total_size, const int32_t* left_sizes,
+    const int32_t* left_counts, const int32_t* class_totals, const EntropyTable& table, double* out
+)
+{
+    // Four thresholds per iteration, one gather per count. Requires total_size <= table.max_count().
+    const double* nlogn = table.data();
+    const __m128i total_count = _mm_set1_epi32(total_size);
+    const __m256d total = _mm256_set1_pd(total_size);
+    const bool binary = (num_classes==2);
+    const int32_t* ones = left_counts + num_thresholds;  // Class 1 prefix counts (binary case).
+    int t = 0;
+    for (; t+4 <= num_thresholds; t += 4)
+    {
+        const __m128i n_left = _mm_loadu_si128((const __m128i*)(left_sizes+t));
+        const __m128i n_right = _mm_sub_epi32(total_count, n_left);
+        __m256d left_loss = _mm256_i32gather_pd(nlogn, n_left, 8);
+        __m256d right_loss = _mm256_i32gather_pd(nlogn, n_right, 8);
+        if (binary) {
+            const __m128i c1_left = _mm_loadu_si128((const __m128i*)(ones+t));
+            const __m128i c1_right = _mm_sub_epi32(_mm_set1_epi32(class_totals[1]), c1_left);
+            const __m128i c0_left = _mm_sub_epi32(n_left, c1_left);
+            const __m128i c0_right = _mm_sub_epi32(n_right, c1_right);
+            left_loss = _mm256_sub_pd(left_loss, _mm256_i32gather_pd(nlogn, c0_left, 8));
+            right_loss = _mm256_sub_pd(right_loss, _mm256_i32gather_pd(nlogn, c0_right, 8));
+            left_loss = _mm256_sub_pd(left_loss, _mm256_i32gather_pd(nlogn, c1_left, 8));
+            right_loss = _mm256_sub_pd(right_loss, _mm256_i32gather_pd(nlogn, c1_right, 8));
+        } else {
+            for (int k = 0; k < num_classes; k++)
+            {
+                const __m128i c_left = _mm_loadu_si128((const __m128i*)(left_counts + k*num_thresholds + t));
+                const __m128i c_right = _mm_sub_epi32(_mm_set1_epi32(class_totals[k]), c_left);
+                left_loss = _mm256_sub_pd(left_loss, _mm256_i32gather_pd(nlogn, c_left, 8));
+                right_loss = _mm256_sub_pd(right_loss, _mm256_i32gather_pd(nlogn, c_right, 8));
+            }
+        }
+        _mm256_storeu_pd(out+t, _mm256_div_pd(_mm256_add_pd(left_loss, right_loss), total));
+    }
+    // Remaining thresholds:
+    if (t < num_thresholds) {
+        std::vector<int32_t> tail_counts;
+        for (int k = 0; k < num_classes; k++)
+        {
+            tail_counts.insert(tail_counts.end(), left_counts + k*num_thresholds + t, left_counts + (k+1)*num_thresholds);
+        }
+        entropy_losses_scalar(num_thresholds-t, num_classes, total_size, left_sizes+t, &tail_counts[0], class_totals, table, out+t);
+    }
+}
+
+#endif
+
+
+/*
+ * THRESHOLD KERNELS - REGRESSION :
+ */
+
+
+static void regression_losses_scalar(
+    int num_thresholds, int total_size, double total_sum, double total_square,
+    const int32_t* left_sizes, const double* left_sums, const double* left_squares, double* out
+)
+{
+    const double total = total_size;
+    for (int t = 0; t < num_thresholds; t++)
+    {
+        const double n_left = left_sizes[t];
+        const double n_right = total - n_left;
+        const double s_right = total_sum - left_sums[t];
+        const double q_right = total_square - left_squares[t];
+        double left_loss = std::max(0.0, (left_squares[t] - left_sums[t]*left_sums[t]/n_left)/n_left);
+        double right_loss = std::max(0.0, (q_right - s_right*s_right/n_right)/n_right);
+        out[t] = (left_loss*n_left/total) + (right_loss*n_right/total);
+    }
+}
+
+#ifdef IMPURITY_X86
+
+__attribute__((target("avx2")))
+static void regression_losses_avx2(
+    int num_thresholds, int total_size, double total_sum, double total_square,
+    const int32_t* left_sizes, const double* left_sums, const double* left_squares, double* out
+)
+{
+    const __m256d total = _mm256_set1_pd(total_size);
+    const __m256d sum = _mm256_set1_pd(total_sum);
+    const __m256d square = _mm256_set1_pd(total_square);
+    const __m256d zero = _mm256_setzero_pd();
+    int t = 0;
+    for (; t+4 <= num_thresholds; t += 4)
+    {
+        const __m256d n_left = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(left_sizes+t)));
+        const __m256d n_right = _mm256_sub_pd(total, n_left);
+        const __m256d s_left = _mm256_loadu_pd(left_sums+t);
+        const __m256d q_left = _mm256_loadu_pd(left_squares+t);
+        const __m256d s_right = _mm256_sub_pd(sum, s_left);
+        const __m256d q_right = _mm256_sub_pd(square, q_left);
+        __m256d left_loss = _mm256_div_pd(_mm256_sub_pd(q_left, _mm256_div_pd(_mm256_mul_pd(s_left, s_left), n_left)), n_left);
+        __m256d right_loss = _mm256_div_pd(_mm256_sub_pd(q_right, _mm256_div_pd(_mm256_mul_pd(s_right, s_right), n_right)), n_right);
+        left_loss = _mm256_max_pd(zero, left_loss);
+        right_loss = _mm256_max_pd(zero, right_loss);
+        const __m256d weighted_left = _mm256_div_pd(_mm256_mul_pd(left_loss, n_left), total);
+        const __m256d weighted_right = _mm256_div_pd(_mm256_mul_pd(right_loss, n_right), total);
+        _mm256_storeu_pd(out+t, _mm256_add_pd(weighted_left, weighted_right));
+    }
+    regression_losses_scalar(num_thresholds-t, total_size, total_sum, total_square, left_sizes+t, left_sums+t, left_squares+t, out+t);
+}
+
+#endif
+
+
+/*
+ * ARGMIN :
+ */
+
+
+static int argmin_scalar(const double* values, int n)
+{
+    int best = 0;
+    for (int i = 1; i < n; i++)
+    {
+        if (values[i]<values[best]) { best = i; }
+    }
+    return best;
+}
+
+#ifdef IMPURITY_X86
+
+__attribute__((target("avx2")))
+static int argmin_avx2(const double* values, int n)
+{
+    // Pass 1: vector minimum. Pass 2: first position holding it (compare + movemask).
+    if (n < 8) {
+        return argmin_scalar(values, n);
+    }
+    __m256d lowest = _mm256_loadu_pd(values);
+    int i = 4;
+    for (; i+4 <= n; i += 4)
+    {
+        lowest = _mm256_min_pd(lowest, _mm256_loadu_pd(values+i));
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, lowest);
+    double minimum = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    for (; i < n; i++) { minimum = std::min(minimum, values[i]); }
+    const __m256d target = _mm256_set1_pd(minimum);
+    for (i = 0; i+4 <= n; i += 4)
+    {
+        int mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values+i), target, _CMP_EQ_OQ));
+        if (mask) { return i + __builtin_ctz(mask); }
+    }
+    for (; i < n; i++)
+    {
+        if (values[i]==minimum) { return i; }
+    }
+    return argmin_scalar(values, n);  // Only reached if values contain NaN.
+}
+
+#endif
+
+int argmin(const double* values, int n)
+{
+    /** Index of the first minimum of values[0..n-1], or -1 if n==0. */
+    if (n<=0) {
+        return -1;
+    }
+#ifdef IMPURITY_X86
+    if (simd_level_supported(SimdLevel::avx2)) {
+        return argmin_avx2(values, n);
+    }
+#endif
+    return argmin_scalar(values, n);
+}
+
+
+/*
+ * THRESHOLD SWEEP - ACCESSORS :
+ */
+
+
+int ThresholdSweep::num_thresholds() const
+{
+    /** Number of candidate thresholds. */
+    return this->thresholds_.size();
+}
+
+int ThresholdSweep::num_classes() const
+{
+    /** Number of classes (0 for regression sweeps). */
+    return this->num_classes_;
+}
+
+int ThresholdSweep::total_size() const
+{
+    /** Number of rows at the node. */
+    return this->total_size_;
+}
+
+double ThresholdSweep::threshold(int t) const
+{
+    /** Threshold value of candidate t. */
+    assert ((t>=0) and (t<this->num_thresholds()));
+    return this->thresholds_[t];
+}
+
+int ThresholdSweep::left_size(int t) const
+{
+    /** Rows going left (value <= threshold) at candidate t. */
+    assert ((t>=0) and (t<this->num_thresholds()));
+    return this->left_sizes_[t];
+}
+
+
+/*
+ * THRESHOLD SWEEP - UTILITIES :
+ */
+
+
+void ThresholdSweep::sweep_classes(const std::vector<double>& values, const std::vector<int>& classes, int num_classes)
+{
+    /**
+     * Sort the (value, class) pairs of one feature and record the class counts
+     * to the left of every boundary between two distinct values.
+     *    values      : Feature value of each row at the node.
+     *    classes     : Class index (0..num_classes-1) of each row, in the same order.
+     */
+    assert (values.size()==classes.size());
+    assert (num_classes>=1);
+    const int n = values.size();
+    std::vector<std::pair<double,int>> pairs(n);
+    for (int i = 0; i < n; i++) { pairs[i] = std::make_pair(values[i], classes[i]); }
+    std::sort(pairs.begin(), pairs.end());
+    int num_thresholds = 0;
+    for (int i = 0; i+1 < n; i++)
+    {
+        if (pairs[i+1].first != pairs[i].first) { num_thresholds += 1; }
+    }
+    this->num_classes_ = num_classes;
+    this->total_size_ = n;
+    this->thresholds_.resize(num_thresholds);
+    this->left_sizes_.resize(num_thresholds);
+    this->left_counts_.assign((size_t)num_classes*num_thresholds, 0);
+    this->class_totals_.assign(num_classes, 0);
+    int t = 0;
+    for (int i = 0; i < n; i++)
+    {
+        this->class_totals_[pairs[i].second] += 1;
+        if ((i+1 < n) and (pairs[i+1].first != pairs[i].first)) {
+            this->thresholds_[t] = pairs[i].first;
+            this->left_sizes_[t] = i+1;
+            for (int k = 0; k < num_classes; k++)
+            {
+                this->left_counts_[(size_t)k*num_thresholds + t] = this->class_totals_[k];
+            }
+            t += 1;
+        }
+    }
+}
+
+void ThresholdSweep::sweep_binary(double threshold, int total_size, int left_size, int left_positives, int total_positives)
+{
+    /**
+     * Single-candidate sweep for a two-valued feature and two classes, from counts
+     * obtained elsewhere (e.g. bitset popcounts) instead of sorting the column.
+     * Produces the same statistics sweep_classes would for that column; a split that
+     * leaves one side empty has no candidate.
+     *    threshold       : Smaller of the two feature values (rows <= threshold go left).
+     *    left_positives  : Rows of class 1 going left.
+     *    total_positives : Rows of class 1 at the node.
+     */
+    assert ((0<=left_size) and (left_size<=total_size));
+    assert ((0<=left_positives) and (left_positives<=left_size) and (left_positives<=total_positives));
+    this->num_classes_ = 2;
+    this->total_size_ = total_size;
+    this->class_totals_ = {total_size-total_positives, total_positives};
+    if ((left_size==0) or (left_size==total_size)) {
+        this->thresholds_.clear();
+        this->left_sizes_.clear();
+        this->left_counts_.clear();
+        return;
+    }
+    this->thresholds_.assign(1, threshold);
+    this->left_sizes_.assign(1, left_size);
+    this->left_counts_ = {left_size-left_positives, left_positives};
+}
+
+void ThresholdSweep::sweep_targets(const std::vector<double>& values, const std::vector<double>& targets)
+{
+    /** Regression counterpart of sweep_classes: prefix sums of targets and squared targets. */
+    assert (values.size()==targets.size());
+    const int n = values.size();
+    std::vector<std::pair<double,double>> pairs(n);
+    for (int i = 0; i < n; i++) { pairs[i] = std::make_pair(values[i], targets[i]); }
+    std::sort(pairs.begin(), pairs.end());
+    this->num_classes_ = 0;
+    this->total_size_ = n;
+    this->thresholds_.clear();
+    this->left_sizes_.clear();
+    this->left_sums_.clear();
+    this->left_squares_.clear();
+    double sum = 0.0;
+    double square = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += pairs[i].second;
+        square += pairs[i].second*pairs[i].second;
+        if ((i+1 < n) and (pairs[i+1].first != pairs[i].first)) {
+            this->thresholds_.push_back(pairs[i].first);
+            this->left_sizes_.push_back(i+1);
+            this->left_sums_.push_back(sum);
+            this->left_squares_.push_back(square);
+        }
+    }
+    this->total_sum_ = sum;
+    this->total_square_ = square;
+}
+
+std::vector<double> ThresholdSweep::losses(ImpurityMethod method, const EntropyTable* table) const
+{
+    /**
+     * Weighted child loss of every candidate threshold, evaluated in one vectorized pass.
+     * table is only used for cross_entropy; it must hold counts up to total_size()
+     * (a temporary one is built otherwise).
+     */
+    const int num_thresholds = this->num_thresholds();
+    std::vector<double> out(num_thresholds);
+    if (num_thresholds==0) {
+        return out;
+    }
+    bool avx2 = simd_level_supported(SimdLevel::avx2);
+    if (method==ImpurityMethod::mean_squared_error) {
+        assert (this->num_classes_==0);  // Built with sweep_targets.
+#ifdef IMPURITY_X86
+        if (avx2) {
+            regression_losses_avx2(num_thresholds, this->total_size_, this->total_sum_, this->total_square_,
+                                   &this->left_sizes_[0], &this->left_sums_[0], &this->left_squares_[0], &out[0]);
+            return out;
+        }
+#endif
+        regression_losses_scalar(num_thresholds, this->total_size_, this->total_sum_, this->total_square_,
+                                 &this->left_sizes_[0], &this->left_sums_[0], &this->left_squares_[0], &out[0]);
+        return out;
+    }
+    assert (this->num_classes_>0);  // Built with sweep_classes.
+    if (method==ImpurityMethod::cross_entropy) {
+        EntropyTable local_table;
+        if ((table==nullptr) or (table->max_count()<this->total_size_)) {
+            // Callers scoring many nodes should pass a table sized for the root.
+            local_table = EntropyTable(this->total_size_);
+            table = &local_table;
+        }
+#ifdef IMPURITY_X86
+        if (avx2) {
+            entropy_losses_avx2(num_thresholds, this->num_classes_, this->total_size_, &this->left_sizes_[0],
+                                &this->left_counts_[0], &this->class_totals_[0], *table, &out[0]);
+            return out;
+        }
+#endif
+        entropy_losses_scalar(num_thresholds, this->num_classes_, this->total_size_, &this->left_sizes_[0],
+                              &this->left_counts_[0], &this->class_totals_[0], *table, &out[0]);
+        return out;
+    }
+#ifdef IMPURITY_X86
+    if (avx2) {
+        class_losses_avx2(method, num_thresholds, this->num_classes_, this->total_size_,
+                          &this->left_sizes_[0], &this->left_counts_[0], &this->class_totals_[0], &out[0]);
+        return out;
+    }
+#endif
+    class_losses_scalar(method, num_thresholds, this->num_classes_, this->total_size_,
+                        &this->left_sizes_[0], &this->left_counts_[0], &this->class_totals_[0], &out[0]);
+    return out;
+}
+
+int ThresholdSweep::best(ImpurityMethod method, double* best_loss, const EntropyTable* table) const
+{
+    /**
+     * Index of the lowest-loss candidate threshold (the first one on ties, like
+     * scanning thresholds in increasing order), or -1 if the feature is constant.
+     * The loss of that candidate is written to best_loss.
+     */
+    std::vector<double> out = this->losses(method, table);
+    int t = argmin(out.data(), out.size());
+    if (t>=0) {
+        *best_loss = out[t];
+    }
+    return t;
+}
+
+
+/*
+ * THRESHOLD SWEEP - CONSTRUCTORS :
+ */
+
+
+ThresholdSweep::ThresholdSweep()
+{
+    this->num_classes_ = 0;
+    this->total_size_ = 0;
+    this->total_sum_ = 0.0;
+    this->total_square_ = 0.0;
+}
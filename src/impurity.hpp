@@ -0,0 +1,96 @@
+#ifndef IMPURITY_HPP
+#define IMPURITY_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+enum class ImpurityMethod
+{
+    /** Split criteria understood by the threshold kernels (same names as LossFunction). */
+    misclassification_error,
+    cross_entropy,
+    gini_impurity,
+    mean_squared_error
+};
+
+ImpurityMethod impurity_method(const std::string& method);  // Parse a loss name (throws std::invalid_argument).
+
+double nlog2n_approx(double n);  // n*log2(n) from a polynomial in the mantissa (relative error below 1e-11).
+
+class EntropyTable
+{
+    /**
+     * Precomputed n*log2(n) for integer counts 0..max_count.
+     * With it, the entropy of a child with class counts c_k and size n is
+     *     n*H = n*log2(n) - sum_k c_k*log2(c_k)
+     * so scoring a threshold takes table lookups instead of one log2 per class.
+     * Entries are computed with std::log2, so equal counts always give equal
+     * losses and ties between thresholds resolve as with the exact formula.
+     * */
+
+private:
+
+    // Attributes:
+    std::vector<double> values_;  // values_[n] = n*log2(n), values_[0] = 0.
+
+public:
+
+    // Accessors:
+    int max_count() const;  // Largest count held in the table.
+    const double* data() const;  // Pointer to the table (for gathers).
+    double nlog2n(int n) const;  // n*log2(n): table lookup, or polynomial approximation past max_count.
+
+    // Constructors:
+    EntropyTable(int max_count=0);
+
+};
+
+class ThresholdSweep
+{
+    /**
+     * Prefix statistics of one feature at one node, for every candidate threshold.
+     * Candidate t splits at thresholds[t] (value <= threshold goes left); the largest
+     * unique value is not a candidate because it would leave the right side empty.
+     * Class counts are stored class-major (counts[k*num_thresholds()+t]) so that the
+     * kernels read consecutive thresholds with one vector load.
+     * */
+
+private:
+
+    // Attributes:
+    int num_classes_;  // Number of classes (0 for regression sweeps).
+    int total_size_;  // Number of rows at the node.
+    std::vector<double> thresholds_;  // Candidate thresholds in increasing order.
+    std::vector<int32_t> left_sizes_;  // Rows with value <= thresholds[t].
+    std::vector<int32_t> left_counts_;  // Class-major prefix class counts.
+    std::vector<int32_t> class_totals_;  // Class counts of the whole node.
+    std::vector<double> left_sums_;  // Regression: prefix sum of labels.
+    std::vector<double> left_squares_;  // Regression: prefix sum of squared labels.
+    double total_sum_;  // Regression: sum of labels at the node.
+    double total_square_;  // Regression: sum of squared labels at the node.
+
+public:
+
+    // Accessors:
+    int num_thresholds() const;  // Number of candidate thresholds.
+    int num_classes() const;  // Number of classes (0 for regression sweeps).
+    int total_size() const;  // Number of rows at the node.
+    double threshold(int t) const;  // Threshold value of candidate t.
+    int left_size(int t) const;  // Rows going left at candidate t.
+
+    // Utilities:
+    void sweep_classes(const std::vector<double>& values, const std::vector<int>& classes, int num_classes);  // Build prefix class counts.
+    void sweep_targets(const std::vector<double>& values, const std::vector<double>& targets);  // Build prefix sums for regression.
+    void sweep_binary(double threshold, int total_size, int left_size, int left_positives, int total_positives);  // Single candidate from precomputed binary counts.
+    int best(ImpurityMethod method, double* best_loss, const EntropyTable* table=nullptr) const;  // Index of the lowest-loss candidate (first on ties), or -1 if none.
+    std::vector<double> losses(ImpurityMethod method, const EntropyTable* table=nullptr) const;  // Weighted child loss of every candidate.
+
+    // Constructors:
+    ThresholdSweep();
+
+};
+
+int argmin(const double* values, int n);  // Index of the first minimum (vectorized), or -1 if n==0.
+
+#endif
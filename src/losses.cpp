@@ -36,17 +36,14 @@ double LossFunction::misclassification_error(DataVector labels)
 double LossFunction::cross_entropy(DataVector labels)
 {
     /** Returns the loss calculated with cross_entropy. */
-    double loss;
+    double loss = 0;
     LabelCounter label_counter = LabelCounter(labels);
     int sum_of_counts = label_counter.get_values().sum();  // Get total number of labels.
     assert (sum_of_counts==labels.size());
-    int predicted_label = label_counter.get_most_frequent();
-    DataVector labels_ = label_counter.get_labels();  // Get labels.
     DataVector counts_ = label_counter.get_values();  // Get count for each label.
     double prop;  // Temporary variable to store proportion of current class.
     for (int i = 0; i < counts_.size(); i++)
     {
-        int label = labels_.value(i);
         int count = counts_.value(i);
         prop = 1.0*count/sum_of_counts;
         loss += prop * std::log2(prop);
@@ -0,0 +1,351 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/*
+ * Allocation and peak-memory accounting.
+ *
+ * A MemoryScope reports what the code it encloses allocated: operator new calls and bytes
+ * requested, the peak growth of the live heap, and the peak resident set size (VmHWM, reset
+ * at the start of the scope through /proc/self/clear_refs where the kernel allows it).
+ *
+ * Allocations are only counted when compiled with -DPDT_COUNT_ALLOCATIONS, which replaces
+ * the global operator new / delete of the program; even then they are only counted while a
+ * scope is open, so timed code outside scopes pays one relaxed atomic load per allocation.
+ * Without the flag the allocation fields read -1 and only the RSS is reported.
+ */
+
+struct MemoryUsage
+{
+    /** Memory use of one region. Fields that could not be measured are -1. */
+    long long allocations = -1;  // operator new calls.
+    long long allocated_bytes = -1;  // Bytes requested from operator new.
+    long long peak_heap_bytes = -1;  // Peak of the live heap above its level at the start.
+    long long peak_rss_bytes = -1;  // Peak resident set size of the process.
+};
+
+inline void check_memory_budget(const MemoryUsage& usage, long long budget_bytes, const std::string& what)
+{
+    /**
+     * Throw std::runtime_error if the peak of a region exceeds budget_bytes (no budget if < 0).
+     * The heap peak is used when allocations are counted, the resident set otherwise.
+     */
+    if (budget_bytes < 0) {
+        return;
+    }
+    const long long peak = (usage.peak_heap_bytes >= 0) ? usage.peak_heap_bytes : usage.peak_rss_bytes;
+    if (peak > budget_bytes) {
+        throw std::runtime_error( what+" exceeded its memory budget: "+std::to_string(peak)+" bytes > "+std::to_string(budget_bytes) );
+    }
+}
+
+
+/*
+ * RESIDENT SET SIZE :
+ */
+
+inline long long read_proc_kb(const char* path, const char* key)
+{
+    /** A "<key>: <n> kB" line of a /proc file, in bytes (-1 if unavailable). */
+    // stdio rather than streams: no operator new, so reading does not count as an allocation.
+    std::FILE* file = std::fopen(path, "r");
+    if (file == nullptr) {
+        return -1;
+    }
+    const size_t key_length = std::strlen(key);
+    char line[256];
+    long long value = -1;
+    while (std::fgets(line, sizeof(line), file) != nullptr)
+    {
+        if ((std::strncmp(line, key, key_length) == 0) and (line[key_length] == ':')) {
+            value = std::atoll(line + key_length + 1) * 1024;
+            break;
+        }
+    }
+    std::fclose(file);
+    return value;
+}
+
+inline long long read_proc_status_kb(const char* key) { return read_proc_kb("/proc/self/status", key); }
+inline long long current_rss_bytes() { return read_proc_status_kb("VmRSS"); }
+inline long long peak_rss_bytes() { return read_proc_status_kb("VmHWM"); }
+
+inline long long mapping_kb(const void* address, const char* key)
+{
+    /**
+     * A "<key>: <n> kB" line of the /proc/self/smaps entry of the mapping holding address,
+     * in bytes (-1 if unavailable), e.g. the Pss or Private_Clean of a mapped file, or of
+     * the anonymous mapping malloc put a large block in.
+     */
+    std::FILE* file = std::fopen("/proc/self/smaps", "r");
+    if (file == nullptr) {
+        return -1;
+    }
+    const unsigned long target = (unsigned long)address;
+    const size_t key_length = std::strlen(key);
+    char line[512];
+    bool inside = false;
+    long long value = -1;
+    while (std::fgets(line, sizeof(line), file) != nullptr)
+    {
+        unsigned long begin, end;
+        char separator;
+        if ((std::sscanf(line, "%lx-%lx%c", &begin, &end, &separator) == 3) and (separator == ' ')) {
+            if (inside) { break; }
+            inside = (begin <= target) and (target < end);
+        } else if (inside and (std::strncmp(line, key, key_length) == 0) and (line[key_length] == ':')) {
+            value = std::atoll(line + key_length + 1) * 1024;
+            break;
+        }
+    }
+    std::fclose(file);
+    return value;
+}
+
+inline bool reset_peak_rss()
+{
+    /** Reset VmHWM to the current RSS (Linux >= 4.0); false when not permitted. */
+    std::FILE* file = std::fopen("/proc/self/clear_refs", "w");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool written = (std::fputs("5", file) >= 0);
+    return (std::fclose(file) == 0) and written;
+}
+
+
+/*
+ * ALLOCATION COUNTERS :
+ */
+
+struct AllocationCounters
+{
+    /** Process-wide counts (updated while any scope is open). */
+    std::atomic<int> tracking{0};  // Open scopes.
+    std::atomic<long long> allocations{0};
+    std::atomic<long long> allocated_bytes{0};
+    std::atomic<long long> live_bytes{0};  // Usable size of the blocks allocated minus freed.
+    std::atomic<long long> peak_live_bytes{0};
+};
+
+struct ThreadAllocationCounters
+{
+    /** Counts of one thread (updated while any scope is open). */
+    long long allocations;
+    long long allocated_bytes;
+};
+
+class MemoryAccounting
+{
+    /** The counters behind the replaced operator new / delete. */
+
+public:
+
+    static bool enabled()
+    {
+        /** Whether allocation counting was compiled in (-DPDT_COUNT_ALLOCATIONS). */
+#ifdef PDT_COUNT_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+    static AllocationCounters& counters()
+    {
+        static AllocationCounters c;
+        return c;
+    }
+    static ThreadAllocationCounters& thread_counters()
+    {
+        thread_local ThreadAllocationCounters c = {0, 0};
+        return c;
+    }
+    static size_t block_size(void* ptr, size_t requested)
+    {
+        /** Heap bytes held by a block (what the allocator handed out when known). */
+#ifdef __GLIBC__
+        (void)requested;
+        return malloc_usable_size(ptr);
+#else
+        (void)ptr;
+        return requested;
+#endif
+    }
+    static void on_allocate(void* ptr, size_t size)
+    {
+        AllocationCounters& c = counters();
+        if (c.tracking.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        ThreadAllocationCounters& t = thread_counters();
+        t.allocations += 1;
+        t.allocated_bytes += size;
+        c.allocations.fetch_add(1, std::memory_order_relaxed);
+        c.allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+        const long long block = (long long)block_size(ptr, size);
+        const long long live = c.live_bytes.fetch_add(block, std::memory_order_relaxed) + block;
+        long long peak = c.peak_live_bytes.load(std::memory_order_relaxed);
+        while ((live > peak) and !c.peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    }
+    static void on_free(void* ptr)
+    {
+        AllocationCounters& c = counters();
+        if ((ptr == nullptr) or (c.tracking.load(std::memory_order_relaxed) == 0)) {
+            return;
+        }
+        c.live_bytes.fetch_sub(block_size(ptr, 0), std::memory_order_relaxed);
+    }
+
+};
+
+#ifdef PDT_COUNT_ALLOCATIONS
+
+// Every operator new / new[] / delete / delete[] of the program (library containers included)
+// goes through these; the array and nothrow forms forward to them in libstdc++.
+#if defined(__GNUC__) and !defined(__clang__) and (__GNUC__ >= 11)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"  // free() of what our operator new malloc()ed.
+#endif
+void* operator new(std::size_t size)
+{
+    void* ptr = std::malloc(size ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    MemoryAccounting::on_allocate(ptr, size);
+    return ptr;
+}
+void operator delete(void* ptr) noexcept { MemoryAccounting::on_free(ptr); std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { MemoryAccounting::on_free(ptr); std::free(ptr); }
+#if defined(__GNUC__) and !defined(__clang__) and (__GNUC__ >= 11)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+
+/*
+ * SCOPES :
+ */
+
+class MemoryScope
+{
+    /**
+     * Accounts the enclosing region. A process scope counts the allocations of every thread
+     * and tracks the heap and RSS peaks; process scopes may nest (an inner scope does not hide
+     * its peaks from the outer one), but not overlap across threads. A thread scope counts the
+     * allocations of its own thread only and reports no peaks (-1), so concurrent regions,
+     * such as the folds of a parallel CV, can be accounted separately. An inactive scope does
+     * nothing and reports -1 everywhere, so callers that only sometimes account a region, such
+     * as the cross-validator, leave their timed paths untouched.
+     */
+
+private:
+
+    static long long& carried_rss_peak() { static long long peak = -1; return peak; }  // Of scopes nested in the innermost open one.
+
+    // Attributes:
+    bool active_;
+    bool thread_only_;
+    bool rss_reset_;  // Whether VmHWM was reset at the start.
+    long long start_allocations_;
+    long long start_bytes_;
+    long long start_live_;
+    long long outer_heap_peak_;  // Heap peak of the enclosing scope, restored on close.
+    long long outer_rss_peak_;  // RSS peak of the enclosing scope before VmHWM was reset.
+    bool open_;
+
+public:
+
+    // Utilities:
+    MemoryUsage usage() const
+    {
+        /** Use so far (or up to close()). */
+        AllocationCounters& c = MemoryAccounting::counters();
+        MemoryUsage u;
+        if (!this->active_) {
+            return u;
+        }
+        if (MemoryAccounting::enabled())
+        {
+            if (this->thread_only_) {
+                const ThreadAllocationCounters& t = MemoryAccounting::thread_counters();
+                u.allocations = t.allocations - this->start_allocations_;
+                u.allocated_bytes = t.allocated_bytes - this->start_bytes_;
+            } else {
+                u.allocations = c.allocations.load() - this->start_allocations_;
+                u.allocated_bytes = c.allocated_bytes.load() - this->start_bytes_;
+                u.peak_heap_bytes = c.peak_live_bytes.load() - this->start_live_;
+            }
+        }
+        if (!this->thread_only_)
+        {
+            // Nested scopes reset VmHWM again, and carried their peaks over when they closed:
+            const long long rss = peak_rss_bytes();
+            u.peak_rss_bytes = (this->rss_reset_ and (rss >= 0)) ? std::max(rss, carried_rss_peak()) : rss;  // Else: peak of the process lifetime.
+        }
+        return u;
+    }
+    MemoryUsage close()
+    {
+        /** Stop accounting and return the use (the destructor then does nothing). */
+        const MemoryUsage u = this->usage();
+        if (!this->open_) {
+            return u;
+        }
+        this->open_ = false;
+        AllocationCounters& c = MemoryAccounting::counters();
+        if (!this->thread_only_)
+        {
+            // Let the enclosing scope see this scope's peak:
+            long long peak = c.peak_live_bytes.load();
+            c.peak_live_bytes.store(std::max(peak, this->outer_heap_peak_));
+            carried_rss_peak() = std::max(this->outer_rss_peak_, u.peak_rss_bytes);
+        }
+        c.tracking.fetch_sub(1);
+        return u;
+    }
+
+    // Constructors:
+    explicit MemoryScope(bool thread_only=false, bool active=true)
+        : active_(active), thread_only_(thread_only), rss_reset_(false), start_allocations_(0), start_bytes_(0), start_live_(0),
+          outer_heap_peak_(0), outer_rss_peak_(-1), open_(active)
+    {
+        if (!this->active_) {
+            return;
+        }
+        AllocationCounters& c = MemoryAccounting::counters();
+        c.tracking.fetch_add(1);
+        if (this->thread_only_) {
+            const ThreadAllocationCounters& t = MemoryAccounting::thread_counters();
+            this->start_allocations_ = t.allocations;
+            this->start_bytes_ = t.allocated_bytes;
+            return;
+        }
+        this->outer_rss_peak_ = std::max(carried_rss_peak(), peak_rss_bytes());
+        carried_rss_peak() = -1;
+        this->rss_reset_ = reset_peak_rss();
+        this->start_allocations_ = c.allocations.load();
+        this->start_bytes_ = c.allocated_bytes.load();
+        this->start_live_ = c.live_bytes.load();
+        this->outer_heap_peak_ = c.peak_live_bytes.exchange(this->start_live_);
+    }
+    ~MemoryScope() { this->close(); }
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+};
+
+#endif
@@ -0,0 +1,509 @@
+#include "model.hpp"
+#include "datasets.hpp"
+#include "decision_tree.hpp"
+#include "tree_node.hpp"
+#include "losses.hpp"
+#include <assert.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/*
+ * TREE MODEL - CONSTRUCTORS :
+ */
+
+
+static int addNodes(const TreeNode* node, bool regression, std::vector<ModelNode>& nodes)
+{
+    /** Append the subtree rooted at node in pre-order and return its index. */
+    DataFrame dataframe = node->getDataFrame();
+    ModelNode out;
+    out.feature = -1;
+    out.left = -1;
+    out.right = -1;
+    out.size = dataframe.length();
+    out.threshold = 0.0;
+    out.categories = -1;
+    out.default_left = 0;  // DataFrame::split sends NaN right.
+    if (regression) {
+        out.value = dataframe.col(-1).mean();
+    } else {
+        out.value = LabelCounter(dataframe.col(-1)).get_most_frequent();
+    }
+    const int index = nodes.size();
+    nodes.push_back(out);
+    if (!node->isLeaf()) {
+        nodes[index].feature = node->getSplitFeature();
+        nodes[index].threshold = node->getSplitThreshold();
+        const int left = addNodes(node->getLeft(), regression, nodes);
+        const int right = addNodes(node->getRight(), regression, nodes);
+        nodes[index].left = left;
+        nodes[index].right = right;
+    }
+    return index;
+}
+
+static int validateNodes(int num_features, const ModelNode* nodes, std::size_t num_nodes,
+                         const uint64_t* category_words, std::size_t num_category_words)
+{
+    /**
+     * Check that the node table is a tree in pre-order (left child right after its parent,
+     * right child after the left one, every node but the root reached exactly once,
+     * features within the schema, category sets inside category_words) and return its height.
+     */
+    if (num_nodes == 0) {
+        throw std::invalid_argument( "Model has no nodes" );
+    }
+    std::vector<int> depth(num_nodes, -1);  // -1 until a parent reaches the node.
+    depth[0] = 0;
+    int height = 0;
+    for (int i = 0; i < (int)num_nodes; i++)
+    {
+        const ModelNode& node = nodes[i];
+        if (depth[i] < 0) {
+            throw std::invalid_argument( "Node "+std::to_string(i)+" is not reached from the root" );
+        }
+        height = std::max(height, depth[i]+1);
+        if (node.feature == -1) {
+            if ((node.left != -1) or (node.right != -1)) {
+                throw std::invalid_argument( "Leaf node "+std::to_string(i)+" has children" );
+            }
+            continue;
+        }
+        if ((node.feature < 0) or (node.feature >= num_features)) {
+            throw std::invalid_argument( "Node "+std::to_string(i)+" splits on invalid column "+std::to_string(node.feature) );
+        }
+        if ((node.default_left != 0) and (node.default_left != 1)) {
+            throw std::invalid_argument( "Node "+std::to_string(i)+" has invalid default direction "+std::to_string(node.default_left) );
+        }
+        if (node.categories != -1) {
+            const int64_t offset = node.categories;
+            if ((offset < 0) or (offset >= (int64_t)num_category_words)
+                or ((uint64_t)(num_category_words-offset-1) < (category_words[offset]>>6) + ((category_words[offset]&63) != 0))) {
+                throw std::invalid_argument( "Node "+std::to_string(i)+" has invalid category set "+std::to_string(node.categories) );
+            }
+        }
+        if ((node.left != i+1) or (node.right <= node.left) or (node.right >= (int)num_nodes)) {
+            throw std::invalid_argument( "Node "+std::to_string(i)+" has invalid children "+std::to_string(node.left)+", "+std::to_string(node.right) );
+        }
+        for (int child : {node.left, node.right})
+        {
+            if (depth[child] >= 0) {
+                throw std::invalid_argument( "Node "+std::to_string(child)+" has more than one parent" );
+            }
+            depth[child] = depth[i]+1;
+        }
+    }
+    return height;
+}
+
+TreeModel::TreeModel(const DecisionTree& tree)
+{
+    /** Flatten a fitted DecisionTree. */
+    assert (tree.isFitted());
+    this->num_features_ = tree.getDataFrame().width()-1;
+    this->regression_ = tree.isRegressionTree();
+    addNodes(tree.getRoot(), this->regression_, this->nodes_);
+    this->height_ = validateNodes(this->num_features_, this->nodes_.data(), this->nodes_.size(),
+                                  this->category_words_.data(), this->category_words_.size());
+}
+
+TreeModel::TreeModel(int num_features, bool regression, const std::vector<ModelNode>& nodes,
+                     const std::vector<uint64_t>& category_words)
+{
+    /** Build a model from a pre-order node table and its category sets (throws std::invalid_argument if malformed). */
+    this->num_features_ = num_features;
+    this->regression_ = regression;
+    this->nodes_ = nodes;
+    this->category_words_ = category_words;
+    this->height_ = validateNodes(num_features, nodes.data(), nodes.size(), category_words.data(), category_words.size());
+}
+
+TreeModel::TreeModel()
+{
+    /** Empty model (a single leaf predicting 0). */
+    this->num_features_ = 0;
+    this->regression_ = false;
+    this->nodes_ = { ModelNode{-1, -1, -1, 0, 0.0, 0.0, -1, 0} };
+    this->height_ = 1;
+}
+
+
+/*
+ * TREE MODEL - ACCESSORS :
+ */
+
+
+int TreeModel::num_features() const
+{
+    /** Number of feature columns. */
+    return this->num_features_;
+}
+
+bool TreeModel::is_regression() const
+{
+    /** Type of tree (classification or regression). */
+    return this->regression_;
+}
+
+int TreeModel::size() const
+{
+    /** Number of nodes. */
+    return this->nodes_.size();
+}
+
+int TreeModel::height() const
+{
+    /** Height of tree (a single leaf has height 1). */
+    return this->height_;
+}
+
+const std::vector<ModelNode>& TreeModel::nodes() const
+{
+    /** Pre-order node table (root at index 0). */
+    return this->nodes_;
+}
+
+const std::vector<uint64_t>& TreeModel::category_words() const
+{
+    /** Category sets of categorical splits ({num_categories, bit words...} each, at ModelNode::categories). */
+    return this->category_words_;
+}
+
+bool TreeModel::has_categorical_splits() const
+{
+    /** Whether any node splits on a category set. */
+    for (const ModelNode& node : this->nodes_)
+    {
+        if (node.categories != -1) { return true; }
+    }
+    return false;
+}
+
+
+/*
+ * TREE MODEL - UTILITIES :
+ */
+
+
+double TreeModel::predict(const double* observation) const
+{
+    /**
+     * Prediction for one row of feature values (same traversal as DecisionTree::predict;
+     * categorical splits send the row left if its code is in the node's category set and
+     * missing values follow the node's default direction).
+     */
+    return predict_row(&this->nodes_[0], this->category_words_.data(), observation);
+}
+
+DataVector TreeModel::predict(DataFrame* testdata) const
+{
+    /** Perform prediction sequentially on each observation and collect a vector of predictions. */
+    assert ( (testdata->width()==this->num_features_) or (testdata->width()==this->num_features_+1) );
+    DataVector predictions = DataVector(false);  // is_row=false.
+    std::vector<double> observation(std::max(this->num_features_, 1));
+    for (int r = 0; r < testdata->length(); r++)
+    {
+        const DataVector* row = testdata->row(r);
+        for (int c = 0; c < this->num_features_; c++) { observation[c] = row->value(c); }
+        predictions.addValue(this->predict(&observation[0]));
+    }
+    return predictions;
+}
+
+void TreeModel::predict_batch(const double* rows, std::size_t n_rows, std::size_t row_stride, double* out) const
+{
+    /**
+     * Predictions for n_rows row-major rows of feature values, the first at rows and each
+     * next one row_stride doubles further (row_stride >= num_features), written to out.
+     * No copy of the rows is made, so callers can score their own buffers as they are.
+     */
+    for (std::size_t r = 0; r < n_rows; r++)
+    {
+        out[r] = this->predict(rows + r*row_stride);
+    }
+}
+
+void TreeModel::predict_strided(const double* values, std::size_t n_rows, std::size_t row_stride, std::size_t col_stride, double* out) const
+{
+    /**
+     * Predictions for n_rows rows of any layout, read in place: feature c of row r is
+     * values[r*row_stride + c*col_stride]. Row-major data has col_stride 1, column-major
+     * data row_stride 1 (and col_stride the distance between columns).
+     */
+    const ModelNode* nodes = &this->nodes_[0];
+    const uint64_t* words = this->category_words_.data();
+    for (std::size_t r = 0; r < n_rows; r++)
+    {
+        out[r] = predict_row(nodes, words, values + r*row_stride, col_stride);
+    }
+}
+
+void TreeModel::save(const std::string& path) const
+{
+    /**
+     * Write the binary model file (layout documented in model.hpp). The file is written
+     * next to path and renamed over it, so a server reloading path never reads it half-written.
+     */
+    const uint64_t nodes_offset = kModelHeaderBytes;
+    const uint64_t words_offset = nodes_offset + this->nodes_.size()*sizeof(ModelNode);
+    const uint64_t file_size = words_offset + this->category_words_.size()*sizeof(uint64_t);
+    if (file_size > UINT32_MAX) {
+        throw std::runtime_error( "Model too large for the file format ("+std::to_string(file_size)+" bytes)" );
+    }
+    const std::string temporary = path+".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error( "Cannot open model file for writing: "+temporary );
+        }
+        const uint32_t header[9] = {
+            kModelVersion, (uint32_t)this->num_features_, (uint32_t)this->regression_,
+            (uint32_t)this->nodes_.size(), (uint32_t)this->height_, (uint32_t)this->category_words_.size(),
+            (uint32_t)nodes_offset, (uint32_t)words_offset, (uint32_t)file_size
+        };
+        file.write("PDTM", 4);
+        file.write((const char*)header, sizeof(header));
+        file.write((const char*)&this->nodes_[0], this->nodes_.size()*sizeof(ModelNode));
+        file.write((const char*)this->category_words_.data(), this->category_words_.size()*sizeof(uint64_t));
+        file.close();
+        if (!file) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error( "Failed to write model file: "+temporary );
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error( "Cannot replace model file: "+path );
+    }
+}
+
+static void checkLayout(const uint32_t* header, const std::string& path)
+{
+    /** Check the table offsets of a version 4 header (throws std::runtime_error). */
+    const uint64_t nodes_end = (uint64_t)header[6] + (uint64_t)header[3]*sizeof(ModelNode);
+    const uint64_t words_end = (uint64_t)header[7] + (uint64_t)header[5]*sizeof(uint64_t);
+    if ((header[6] < kModelHeaderBytes) or (header[6]%8 != 0) or (header[7]%8 != 0)
+        or (header[7] < nodes_end) or (header[8] < words_end)) {
+        throw std::runtime_error( "Corrupt model file "+path+": invalid table offsets" );
+    }
+}
+
+TreeModel TreeModel::load(const std::string& path)
+{
+    /**
+     * Read a binary model file written by save() (throws std::runtime_error). The table
+     * sizes in the header are checked against the length of the file before anything is
+     * allocated, so a corrupt header cannot ask for more memory than the file holds.
+     */
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error( "Cannot open model file: "+path );
+    }
+    const uint64_t file_bytes = (uint64_t)file.tellg();
+    file.seekg(0);
+    char magic[4];
+    uint32_t header[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    file.read(magic, 4);
+    file.read((char*)header, 5*sizeof(uint32_t));
+    if (!file or (std::memcmp(magic, "PDTM", 4) != 0)) {
+        throw std::runtime_error( "Not a model file: "+path );
+    }
+    if ((header[0] == 0) or (header[0] > kModelVersion)) {
+        throw std::runtime_error( "Unsupported model version "+std::to_string(header[0])+" in "+path );
+    }
+    if (header[0] >= 2) {
+        file.read((char*)&header[5], ((header[0] >= 4) ? 4 : 1)*sizeof(uint32_t));
+        if (!file) {
+            throw std::runtime_error( "Truncated model file: "+path );
+        }
+    }
+    uint64_t file_end;  // Bytes the header says the file holds.
+    if (header[0] >= 4) {
+        checkLayout(header, path);
+        file_end = header[8];
+    } else {
+        const uint64_t node_bytes = (header[0] == 1) ? 32 : sizeof(ModelNode);
+        file_end = (uint64_t)file.tellg() + (uint64_t)header[3]*node_bytes + (uint64_t)header[5]*sizeof(uint64_t);
+    }
+    if (file_end > file_bytes) {
+        throw std::runtime_error( "Truncated model file: "+path );
+    }
+    std::vector<ModelNode> nodes(header[3]);
+    std::vector<uint64_t> category_words(header[5]);
+    if (header[0] == 1) {
+        // Version 1: {feature, left, right, size, threshold, value} nodes, threshold splits only.
+        for (ModelNode& node : nodes)
+        {
+            file.read((char*)&node, 32);
+            node.categories = -1;
+            node.default_left = 0;
+        }
+    } else {
+        if (header[0] >= 4) { file.seekg(header[6]); }
+        file.read((char*)nodes.data(), nodes.size()*sizeof(ModelNode));
+        if (header[0] >= 4) { file.seekg(header[7]); }
+        file.read((char*)category_words.data(), category_words.size()*sizeof(uint64_t));
+        if (header[0] == 2) {
+            // Version 2 wrote the struct padding where default_left is now: missing values go right.
+            for (ModelNode& node : nodes) { node.default_left = 0; }
+        }
+    }
+    if (!file) {
+        throw std::runtime_error( "Truncated model file: "+path );
+    }
+    try {
+        return TreeModel(header[1], header[2] != 0, nodes, category_words);
+    } catch (const std::invalid_argument& e) {
+        throw std::runtime_error( "Corrupt model file "+path+": "+e.what() );
+    }
+}
+
+
+/*
+ * MAPPED MODEL :
+ */
+
+
+MappedModel::MappedModel(const std::string& path)
+{
+    /**
+     * Map a version 4 model file read-only and check it like TreeModel::load does
+     * (throws std::runtime_error). The file descriptor is closed once the file is mapped.
+     */
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error( "Cannot open model file: "+path );
+    }
+    struct stat status;
+    if ((::fstat(fd, &status) != 0) or (status.st_size < (off_t)kModelHeaderBytes)) {
+        ::close(fd);
+        throw std::runtime_error( "Not a model file: "+path );
+    }
+    void* mapping = ::mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error( "Cannot map model file: "+path );
+    }
+    this->mapping_ = mapping;
+    this->mapped_bytes_ = status.st_size;
+    try {
+        const char* base = (const char*)mapping;
+        uint32_t header[9];
+        std::memcpy(header, base+4, sizeof(header));
+        if (std::memcmp(base, "PDTM", 4) != 0) {
+            throw std::runtime_error( "Not a model file: "+path );
+        }
+        if (header[0] != kModelVersion) {
+            throw std::runtime_error( "Cannot map model version "+std::to_string(header[0])+" in "+path+" (load and save it again)" );
+        }
+        checkLayout(header, path);
+        if (header[8] > this->mapped_bytes_) {
+            throw std::runtime_error( "Truncated model file: "+path );
+        }
+        this->num_features_ = header[1];
+        this->regression_ = (header[2] != 0);
+        this->num_nodes_ = header[3];
+        this->nodes_ = (const ModelNode*)(base + header[6]);
+        this->category_words_ = (const uint64_t*)(base + header[7]);
+        this->height_ = validateNodes(this->num_features_, this->nodes_, header[3], this->category_words_, header[5]);
+    } catch (const std::invalid_argument& e) {
+        ::munmap(this->mapping_, this->mapped_bytes_);
+        throw std::runtime_error( "Corrupt model file "+path+": "+e.what() );
+    } catch (...) {
+        ::munmap(this->mapping_, this->mapped_bytes_);
+        throw;
+    }
+}
+
+MappedModel::MappedModel(MappedModel&& other)
+    : mapping_(other.mapping_), mapped_bytes_(other.mapped_bytes_), num_features_(other.num_features_),
+      regression_(other.regression_), height_(other.height_), num_nodes_(other.num_nodes_),
+      nodes_(other.nodes_), category_words_(other.category_words_)
+{
+    other.mapping_ = nullptr;
+}
+
+MappedModel::~MappedModel()
+{
+    if (this->mapping_ != nullptr) { ::munmap(this->mapping_, this->mapped_bytes_); }
+}
+
+int MappedModel::num_features() const
+{
+    /** Number of feature columns. */
+    return this->num_features_;
+}
+
+bool MappedModel::is_regression() const
+{
+    /** Type of tree (classification or regression). */
+    return this->regression_;
+}
+
+int MappedModel::size() const
+{
+    /** Number of nodes. */
+    return this->num_nodes_;
+}
+
+int MappedModel::height() const
+{
+    /** Height of tree (a single leaf has height 1). */
+    return this->height_;
+}
+
+std::size_t MappedModel::mapped_bytes() const
+{
+    /** Length of the mapping (the file size). */
+    return this->mapped_bytes_;
+}
+
+const void* MappedModel::data() const
+{
+    /** Start of the mapping (the file header). */
+    return this->mapping_;
+}
+
+double MappedModel::predict(const double* observation) const
+{
+    /** Prediction for one row of feature values (the traversal of TreeModel::predict). */
+    return predict_row(this->nodes_, this->category_words_, observation);
+}
+
+void MappedModel::predict_batch(const double* rows, std::size_t n_rows, std::size_t row_stride, double* out) const
+{
+    /** Predictions for n_rows row-major rows, row_stride doubles apart, written to out. */
+    for (std::size_t r = 0; r < n_rows; r++)
+    {
+        out[r] = predict_row(this->nodes_, this->category_words_, rows + r*row_stride);
+    }
+}
+
+std::size_t MappedModel::warm() const
+{
+    /**
+     * Fault every page of the mapping in: the file is read into the page cache once (not
+     * by each worker on its first requests) and this process's page table is filled.
+     * Children forked afterwards share the cached pages; returns the pages touched.
+     */
+    const std::size_t page = ::sysconf(_SC_PAGESIZE);
+    ::madvise(this->mapping_, this->mapped_bytes_, MADV_WILLNEED);
+    const volatile char* base = (const volatile char*)this->mapping_;
+    std::size_t pages = 0;
+    for (std::size_t offset = 0; offset < this->mapped_bytes_; offset += page)
+    {
+        (void)base[offset];
+        pages += 1;
+    }
+    return pages;
+}
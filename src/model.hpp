@@ -0,0 +1,163 @@
+#ifndef MODEL_HPP
+#define MODEL_HPP
+
+#include "datasets.hpp"
+#include "decision_tree.hpp"
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+struct ModelNode
+{
+    /**
+     * One node of a serialized tree (40 bytes, no pointers).
+     * Children are node indices and category sets are offsets, so the node table can be
+     * copied, written to disk or mapped from a file as is. Leaves have feature==-1 and
+     * left==right==-1. Rows whose value is missing (NaN) follow default_left.
+     * */
+    int32_t feature;  // Splitting column, or -1 for a leaf.
+    int32_t left;  // Index of the left child (rows with value <= threshold, or in the category set).
+    int32_t right;  // Index of the right child.
+    int32_t size;  // Number of training rows that reached this node.
+    double threshold;  // Numerical splitting threshold.
+    double value;  // Prediction at this node (majority label or mean target).
+    int32_t categories;  // Offset of the left-going category set in TreeModel::category_words(), or -1 for a threshold split.
+    int32_t default_left;  // 1 if rows missing the feature (NaN) go left, 0 if they go right.
+};
+
+inline bool in_category_set(const uint64_t* set, double value)
+{
+    /**
+     * Membership test for a category code in a set stored as {num_categories, bit words...}.
+     * Codes outside [0, num_categories) (e.g. categories unseen in training) are not members.
+     */
+    if (!((value >= 0) and (value < (double)set[0]))) { return false; }
+    const uint64_t code = (uint64_t)value;
+    return (set[1 + (code>>6)] >> (code&63)) & 1;
+}
+
+inline bool goes_left(const ModelNode& node, const uint64_t* category_words, double value)
+{
+    /** Direction of a row with the given value of node.feature at a split node. */
+    if (std::isnan(value)) { return node.default_left != 0; }
+    return (node.categories == -1) ? (value <= node.threshold) : in_category_set(category_words + node.categories, value);
+}
+
+inline double predict_row(const ModelNode* nodes, const uint64_t* category_words, const double* row, std::size_t col_stride=1)
+{
+    /** Walk a pre-order node table from the root (feature c of the row at row[c*col_stride]). */
+    int i = 0;
+    while (nodes[i].feature != -1)
+    {
+        const ModelNode& node = nodes[i];
+        i = goes_left(node, category_words, row[node.feature*col_stride]) ? node.left : node.right;
+    }
+    return nodes[i].value;
+}
+
+class TreeModel
+{
+    /**
+     * A trained tree reduced to what inference needs: a flat pre-order node table
+     * (root at index 0), the category sets of categorical splits, and the number of
+     * feature columns it expects.
+     * Binary file layout (little-endian, see save()):
+     *     char[4] "PDTM", uint32 version, uint32 num_features, uint32 regression,
+     *     uint32 num_nodes, uint32 height, uint32 num_category_words,
+     *     uint32 nodes_offset, uint32 category_words_offset, uint32 file_size,
+     *     ModelNode[num_nodes] at nodes_offset, uint64 category_words[num_category_words] at category_words_offset
+     * Offsets are from the start of the file and 8-byte aligned, and the tables hold no
+     * pointers, so the file can be mapped at any address and used in place (MappedModel).
+     * Version 1 files (32-byte nodes, no category sets), version 2 files (no default
+     * directions, i.e. missing values go right) and version 3 files (tables right after
+     * a 28-byte header, no offsets) are still read.
+     * */
+
+private:
+
+    // Attributes:
+    int num_features_;  // Number of feature columns.
+    bool regression_;  // Type of tree (classification or regression).
+    int height_;  // Height of tree (a single leaf has height 1).
+    std::vector<ModelNode> nodes_;  // Pre-order node table.
+    std::vector<uint64_t> category_words_;  // Category sets of categorical splits, back to back.
+
+public:
+
+    // Accessors:
+    int num_features() const;  // Number of feature columns.
+    bool is_regression() const;  // Type of tree (classification or regression).
+    int size() const;  // Number of nodes.
+    int height() const;  // Height of tree.
+    const std::vector<ModelNode>& nodes() const;  // Pre-order node table.
+    const std::vector<uint64_t>& category_words() const;  // Category sets ({num_categories, bit words...} each).
+    bool has_categorical_splits() const;  // Whether any node splits on a category set.
+
+    // Utilities:
+    double predict(const double* observation) const;  // Prediction for one row of feature values.
+    DataVector predict(DataFrame* testdata) const;  // Perform prediction sequentially on each observation.
+    void predict_batch(const double* rows, std::size_t n_rows, std::size_t row_stride, double* out) const;  // Row-major rows, row_stride doubles apart.
+    void predict_strided(const double* values, std::size_t n_rows, std::size_t row_stride, std::size_t col_stride, double* out) const;  // Value (r,c) at values[r*row_stride+c*col_stride].
+    void save(const std::string& path) const;  // Write the binary model file (to a temporary file renamed over path).
+    static TreeModel load(const std::string& path);  // Read a binary model file (throws std::runtime_error).
+
+    // Constructors:
+    TreeModel(const DecisionTree& tree);
+    TreeModel(int num_features, bool regression, const std::vector<ModelNode>& nodes,
+              const std::vector<uint64_t>& category_words=std::vector<uint64_t>());
+    TreeModel();
+
+};
+
+class MappedModel
+{
+    /**
+     * A model file mapped read-only (MAP_SHARED) and scored in place, with no copy of its
+     * tables: every process that maps the same file shares one copy of it in the page
+     * cache, and a mapping made before fork() is shared by the children as well.
+     * Needs a version 4 file (aligned tables); older files must be loaded with
+     * TreeModel::load and saved again. Predictions are those of TreeModel.
+     * */
+
+private:
+
+    // Attributes:
+    void* mapping_;  // Start of the mapping (the file header).
+    std::size_t mapped_bytes_;  // Length of the mapping (the file size).
+    int num_features_;  // Number of feature columns.
+    bool regression_;  // Type of tree (classification or regression).
+    int height_;  // Height of tree.
+    int num_nodes_;  // Number of nodes.
+    const ModelNode* nodes_;  // Pre-order node table, inside the mapping.
+    const uint64_t* category_words_;  // Category sets, inside the mapping.
+
+public:
+
+    // Accessors:
+    int num_features() const;  // Number of feature columns.
+    bool is_regression() const;  // Type of tree (classification or regression).
+    int size() const;  // Number of nodes.
+    int height() const;  // Height of tree.
+    std::size_t mapped_bytes() const;  // Length of the mapping.
+    const void* data() const;  // Start of the mapping.
+
+    // Utilities:
+    double predict(const double* observation) const;  // Prediction for one row of feature values.
+    void predict_batch(const double* rows, std::size_t n_rows, std::size_t row_stride, double* out) const;  // Row-major rows, row_stride doubles apart.
+    std::size_t warm() const;  // Fault every page of the mapping in (e.g. before fork); returns the pages touched.
+
+    // Constructors:
+    MappedModel(const std::string& path);  // Map and validate a version 4 model file (throws std::runtime_error).
+    MappedModel(MappedModel&& other);
+    MappedModel(const MappedModel&) = delete;
+    MappedModel& operator=(const MappedModel&) = delete;
+    ~MappedModel();
+
+};
+
+const uint32_t kModelVersion = 4;  // Version written by TreeModel::save.
+const uint32_t kModelHeaderBytes = 40;  // Header size of version 4 files (the node table starts 8-byte aligned after it).
+
+#endif
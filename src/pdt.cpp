@@ -0,0 +1,116 @@
+#include "pdt.h"
+#include "model.hpp"
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+
+struct pdt_model
+{
+    TreeModel model;
+};
+
+static thread_local std::string last_error;
+
+static pdt_status fail(pdt_status status, const std::string& message)
+{
+    last_error = message;
+    return status;
+}
+
+static pdt_status checkShape(const pdt_model* model, const double* X, size_t rows, size_t cols, size_t stride,
+                             size_t min_stride, const double* out)
+{
+    /** Arguments shared by both layouts (stride is the row stride, or the column stride). */
+    if (model == nullptr) {
+        return fail(PDT_ERROR_INVALID_ARGUMENT, "model is null");
+    }
+    if ((rows > 0) and ((X == nullptr) or (out == nullptr))) {
+        return fail(PDT_ERROR_INVALID_ARGUMENT, "X or out is null");
+    }
+    if (cols < (size_t)model->model.num_features()) {
+        return fail(PDT_ERROR_SHAPE, "model reads "+std::to_string(model->model.num_features())+" columns, input has "+std::to_string(cols));
+    }
+    if ((rows > 0) and (stride < min_stride)) {
+        return fail(PDT_ERROR_INVALID_ARGUMENT, "stride "+std::to_string(stride)+" is smaller than "+std::to_string(min_stride));
+    }
+    return PDT_OK;
+}
+
+
+/*
+ * C API :
+ */
+
+
+extern "C" {
+
+unsigned pdt_abi_version(void)
+{
+    return PDT_ABI_VERSION;
+}
+
+pdt_status pdt_model_load(const char* path, pdt_model** model)
+{
+    last_error.clear();
+    if ((path == nullptr) or (model == nullptr)) {
+        return fail(PDT_ERROR_INVALID_ARGUMENT, "path or model is null");
+    }
+    *model = nullptr;
+    try {
+        *model = new pdt_model{TreeModel::load(path)};
+        return PDT_OK;
+    } catch (const std::runtime_error& e) {
+        return fail(PDT_ERROR_IO, e.what());
+    } catch (const std::exception& e) {
+        return fail(PDT_ERROR_INTERNAL, e.what());
+    } catch (...) {
+        return fail(PDT_ERROR_INTERNAL, "unknown error");
+    }
+}
+
+void pdt_model_free(pdt_model* model)
+{
+    delete model;
+}
+
+size_t pdt_model_num_features(const pdt_model* model)
+{
+    return (model == nullptr) ? 0 : model->model.num_features();
+}
+
+int pdt_model_is_regression(const pdt_model* model)
+{
+    return (model != nullptr) and model->model.is_regression();
+}
+
+size_t pdt_model_num_nodes(const pdt_model* model)
+{
+    return (model == nullptr) ? 0 : model->model.size();
+}
+
+pdt_status pdt_predict(const pdt_model* model, const double* X, size_t rows, size_t cols, size_t row_stride, double* out)
+{
+    last_error.clear();
+    const pdt_status status = checkShape(model, X, rows, cols, row_stride, cols, out);
+    if (status != PDT_OK) { return status; }
+    model->model.predict_batch(X, rows, row_stride, out);  // Reads X in place.
+    return PDT_OK;
+}
+
+pdt_status pdt_predict_colmajor(const pdt_model* model, const double* X, size_t rows, size_t cols, size_t col_stride, double* out)
+{
+    last_error.clear();
+    const pdt_status status = checkShape(model, X, rows, cols, col_stride, rows, out);
+    if (status != PDT_OK) { return status; }
+    model->model.predict_strided(X, rows, 1, col_stride, out);  // Reads X in place.
+    return PDT_OK;
+}
+
+const char* pdt_last_error(void)
+{
+    return last_error.c_str();
+}
+
+}
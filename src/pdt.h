@@ -0,0 +1,75 @@
+#ifndef PDT_H
+#define PDT_H
+
+/*
+ * C interface to the tree models (libpdt.so).
+ *
+ * Callers in any language with a C FFI load a model written by TreeModel::save and score
+ * their own buffers: pdt_predict and pdt_predict_colmajor read the feature values where
+ * they are, with no copy into DataFrame rows, and write one prediction per row into out.
+ * A model is immutable once loaded, so one handle may be used by many threads at once.
+ *
+ * Stability: the library exports only the pdt_* functions below (everything else is
+ * hidden), handles are opaque, and functions are only ever added, never changed, within
+ * an ABI version. pdt_abi_version() returns PDT_ABI_VERSION of the library actually
+ * loaded, which callers should compare with the header they were built against.
+ *
+ * Errors: functions return PDT_OK or an error code and never throw or abort; the message
+ * of the last error on the calling thread is available from pdt_last_error().
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define PDT_API __attribute__((visibility("default")))
+#else
+#define PDT_API
+#endif
+
+#define PDT_ABI_VERSION 1
+
+typedef struct pdt_model pdt_model;  /* Opaque handle of a loaded model. */
+
+typedef enum pdt_status
+{
+    PDT_OK = 0,
+    PDT_ERROR_INVALID_ARGUMENT = 1,  /* Null pointer, or a stride too small for the shape. */
+    PDT_ERROR_SHAPE = 2,  /* Fewer columns than the model has features. */
+    PDT_ERROR_IO = 3,  /* Model file missing, unreadable or corrupt. */
+    PDT_ERROR_INTERNAL = 4  /* Anything else (e.g. out of memory). */
+} pdt_status;
+
+PDT_API unsigned pdt_abi_version(void);
+
+/* Load a model file written by TreeModel::save; *model is set on success (free with pdt_model_free). */
+PDT_API pdt_status pdt_model_load(const char* path, pdt_model** model);
+PDT_API void pdt_model_free(pdt_model* model);  /* Null is ignored. */
+
+PDT_API size_t pdt_model_num_features(const pdt_model* model);  /* Columns the model reads (0 for null). */
+PDT_API int pdt_model_is_regression(const pdt_model* model);  /* 1 for a regression tree, 0 otherwise. */
+PDT_API size_t pdt_model_num_nodes(const pdt_model* model);
+
+/*
+ * Row-major input: feature c of row r is X[r*row_stride + c], with row_stride >= cols.
+ * cols may exceed the model's features (e.g. a trailing label column); the extra columns
+ * are not read. Missing values are NaN. out receives rows predictions.
+ */
+PDT_API pdt_status pdt_predict(const pdt_model* model, const double* X, size_t rows, size_t cols,
+                               size_t row_stride, double* out);
+
+/* Column-major input: feature c of row r is X[c*col_stride + r], with col_stride >= rows. */
+PDT_API pdt_status pdt_predict_colmajor(const pdt_model* model, const double* X, size_t rows, size_t cols,
+                                        size_t col_stride, double* out);
+
+/* Message of the last error on this thread ("" if none); valid until the next pdt_* call on it. */
+PDT_API const char* pdt_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
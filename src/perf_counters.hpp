@@ -0,0 +1,278 @@
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Hardware performance counters per training phase.
+ *
+ * Code regions are tagged with a PhaseScope; every scope reads the counters of its thread
+ * (cycles, instructions, cache misses, branch mispredicts, dTLB load misses, through
+ * perf_event_open) on entry and exit and adds the difference, with the wall time, to the
+ * process-wide totals of its phase (PhaseProfile). Scopes of one thread must not nest.
+ *
+ * The layer only exists when compiled with -DPDT_PERF_COUNTERS; otherwise PhaseScope is
+ * empty and the totals stay at zero. Where counters cannot be opened (no perf support,
+ * perf_event_paranoid, containers) or only some of them can, the missing counters read
+ * as -1 and only wall time and call counts are recorded.
+ */
+
+enum class Phase { load, presort, split_search, partition, leaf, predict };
+
+const int kNumPhases = 6;
+const int kNumCounters = 5;
+
+inline const char* phase_name(Phase phase)
+{
+    static const char* names[kNumPhases] = {"load", "presort", "split_search", "partition", "leaf", "predict"};
+    return names[(int)phase];
+}
+
+inline const char* counter_name(int counter)
+{
+    static const char* names[kNumCounters] = {"cycles", "instructions", "cache_misses", "branch_misses", "dtlb_misses"};
+    return names[counter];
+}
+
+struct PhaseCounts
+{
+    /** Totals of one phase. Counters that could not be opened are -1. */
+    long long calls;  // Scopes closed.
+    double wall_ns;  // Wall time inside the scopes (summed over threads).
+    double counters[kNumCounters];  // Event counts, scaled up when the kernel multiplexed them.
+};
+
+
+/*
+ * COUNTER GROUP OF ONE THREAD :
+ */
+
+class PerfCounters
+{
+    /** The kNumCounters events of the calling thread, opened as one group (user space only). */
+
+private:
+
+    // Attributes:
+    int leader_;  // Group leader file descriptor (-1 when no counter could be opened).
+    int fds_[kNumCounters];  // File descriptor of each counter (-1 if unavailable).
+    int slots_[kNumCounters];  // Position of each counter in a group read (-1 if unavailable).
+    int num_open_;  // Counters in the group.
+
+public:
+
+    // Accessors:
+    bool available() const { return this->num_open_ > 0; }
+    bool has(int counter) const { return this->slots_[counter] != -1; }
+
+    // Utilities:
+    bool read(double* values) const
+    {
+        /** Current value of every counter (-1 if unavailable); false when nothing can be read. */
+        for (int c = 0; c < kNumCounters; c++) { values[c] = -1.0; }
+#ifdef __linux__
+        if (this->leader_ == -1) {
+            return false;
+        }
+        // PERF_FORMAT_GROUP | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING: nr, enabled, running, values[nr].
+        uint64_t buffer[3 + kNumCounters];
+        if (::read(this->leader_, buffer, sizeof(buffer)) < (ssize_t)(3 * sizeof(uint64_t))) {
+            return false;
+        }
+        const double scale = (buffer[2] > 0) ? (double)buffer[1] / buffer[2] : 1.0;
+        for (int c = 0; c < kNumCounters; c++) {
+            if (this->slots_[c] != -1) { values[c] = buffer[3 + this->slots_[c]] * scale; }
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Constructors:
+    PerfCounters() : leader_(-1), num_open_(0)
+    {
+        for (int c = 0; c < kNumCounters; c++) { this->fds_[c] = -1; this->slots_[c] = -1; }
+#ifdef __linux__
+        const uint32_t types[kNumCounters] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE};
+        const uint64_t configs[kNumCounters] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+            PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+        };
+        for (int c = 0; c < kNumCounters; c++)
+        {
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = types[c];
+            attr.config = configs[c];
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.disabled = (this->leader_ == -1) ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            const int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, this->leader_, 0);
+            if (fd == -1) {
+                continue;  // Event not supported or not permitted: leave it out of the group.
+            }
+            if (this->leader_ == -1) { this->leader_ = fd; }
+            this->fds_[c] = fd;
+            this->slots_[c] = this->num_open_++;
+        }
+        if (this->leader_ != -1) {
+            ioctl(this->leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+    ~PerfCounters()
+    {
+#ifdef __linux__
+        for (int c = 0; c < kNumCounters; c++) {
+            if ((this->fds_[c] != -1) and (this->fds_[c] != this->leader_)) { close(this->fds_[c]); }
+        }
+        if (this->leader_ != -1) { close(this->leader_); }
+#endif
+    }
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+};
+
+
+/*
+ * PROCESS-WIDE TOTALS :
+ */
+
+class PhaseProfile
+{
+    /** Totals of every phase since the last reset() (call it before measuring), over all threads. */
+
+private:
+
+    static std::mutex& mutex() { static std::mutex m; return m; }
+    static PhaseCounts* totals() { static PhaseCounts t[kNumPhases]; return t; }
+
+public:
+
+    static bool enabled()
+    {
+        /** Whether the layer was compiled in (-DPDT_PERF_COUNTERS). */
+#ifdef PDT_PERF_COUNTERS
+        return true;
+#else
+        return false;
+#endif
+    }
+    static PerfCounters& thread_counters()
+    {
+        /** Counter group of the calling thread, opened on first use. */
+        thread_local PerfCounters counters;
+        return counters;
+    }
+    static bool counters_available()
+    {
+        /** Whether the calling thread could open at least one hardware counter. */
+        return enabled() and thread_counters().available();
+    }
+    static void reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        for (int p = 0; p < kNumPhases; p++)
+        {
+            totals()[p].calls = 0;
+            totals()[p].wall_ns = 0.0;
+            for (int c = 0; c < kNumCounters; c++) { totals()[p].counters[c] = (enabled() and thread_counters().has(c)) ? 0.0 : -1.0; }
+        }
+    }
+    static PhaseCounts get(Phase phase)
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        return totals()[(int)phase];
+    }
+    static void add(Phase phase, double wall_ns, const double* deltas)
+    {
+        /** Add one closed scope (deltas: -1 for counters that are unavailable). */
+        std::lock_guard<std::mutex> lock(mutex());
+        PhaseCounts& t = totals()[(int)phase];
+        t.calls += 1;
+        t.wall_ns += wall_ns;
+        for (int c = 0; c < kNumCounters; c++) {
+            if (deltas[c] >= 0.0) { t.counters[c] = std::max(t.counters[c], 0.0) + deltas[c]; }
+        }
+    }
+
+};
+
+
+/*
+ * SCOPES :
+ */
+
+#ifdef PDT_PERF_COUNTERS
+
+class PhaseScope
+{
+    /** Attributes the counters of the enclosing region (or up to stop()) to a phase. */
+
+private:
+
+    // Attributes:
+    Phase phase_;
+    bool running_;
+    std::chrono::steady_clock::time_point start_;
+    double start_counts_[kNumCounters];
+
+public:
+
+    void stop()
+    {
+        /** Close the scope early (the destructor then does nothing). */
+        if (!this->running_) {
+            return;
+        }
+        this->running_ = false;
+        double end_counts[kNumCounters];
+        PhaseProfile::thread_counters().read(end_counts);
+        const double wall_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - this->start_).count();
+        double deltas[kNumCounters];
+        for (int c = 0; c < kNumCounters; c++) {
+            deltas[c] = ((end_counts[c] >= 0.0) and (this->start_counts_[c] >= 0.0)) ? end_counts[c] - this->start_counts_[c] : -1.0;
+        }
+        PhaseProfile::add(this->phase_, wall_ns, deltas);
+    }
+
+    explicit PhaseScope(Phase phase) : phase_(phase), running_(true)
+    {
+        PhaseProfile::thread_counters().read(this->start_counts_);
+        this->start_ = std::chrono::steady_clock::now();
+    }
+    ~PhaseScope() { this->stop(); }
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+};
+
+#else
+
+class PhaseScope
+{
+    /** Compiled out: no state, no work. */
+public:
+    void stop() {}
+    explicit PhaseScope(Phase) {}
+};
+
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+#include "prefork.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+static int waitWorker(pid_t pid)
+{
+    /** Exit code of a child, or 128+signal if a signal ended it. */
+    int status = 0;
+    while (::waitpid(pid, &status, 0) < 0)
+    {
+        if (errno != EINTR) { return -1; }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+std::vector<WorkerExit> prefork_workers(int workers, const std::function<int(int)>& work)
+{
+    /**
+     * Fork `workers` processes, each running work(index) with index in [0, workers) and
+     * exiting with its return value (1 if it throws), and wait for all of them. Output
+     * buffered before the call is flushed first, so no child writes it again; children
+     * leave with _exit, skipping the launcher's static destructors and atexit handlers.
+     * Throws std::runtime_error if a worker cannot be forked (the ones started are killed).
+     */
+    if (workers < 1) {
+        throw std::invalid_argument( "Need at least one worker, got "+std::to_string(workers) );
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    std::vector<WorkerExit> exits;
+    for (int w = 0; w < workers; w++)
+    {
+        const pid_t pid = ::fork();
+        if (pid == 0) {
+            int code = 1;
+            try {
+                code = work(w);
+            } catch (const std::exception& e) {
+                std::cerr << "Worker " << w << ": " << e.what() << std::endl;
+            }
+            std::cout.flush();
+            std::fflush(nullptr);
+            ::_exit(code);
+        }
+        if (pid < 0) {
+            const std::string error = std::strerror(errno);
+            for (WorkerExit& started : exits)
+            {
+                ::kill(started.pid, SIGKILL);
+                waitWorker(started.pid);
+            }
+            throw std::runtime_error( "Cannot fork worker "+std::to_string(w)+": "+error );
+        }
+        exits.push_back(WorkerExit{w, pid, 0});
+    }
+    for (WorkerExit& exit : exits)
+    {
+        exit.status = waitWorker(exit.pid);
+    }
+    return exits;
+}
@@ -0,0 +1,27 @@
+#ifndef PREFORK_HPP
+#define PREFORK_HPP
+
+#include <functional>
+#include <sys/types.h>
+#include <vector>
+
+/*
+ * Pre-fork worker processes.
+ *
+ * The launcher does the expensive, shareable setup once (e.g. mapping and warming a
+ * MappedModel) and then forks the workers, which inherit it: a MAP_SHARED file mapping
+ * made before fork() refers to the same page-cache pages in every child, so N workers
+ * hold one copy of the model instead of N. Anything else the launcher built before
+ * forking (e.g. an input buffer it no longer writes to) is shared copy-on-write.
+ */
+
+struct WorkerExit
+{
+    int worker;  // Index passed to the worker function.
+    pid_t pid;
+    int status;  // Exit code of the worker, or 128+signal if it was killed.
+};
+
+std::vector<WorkerExit> prefork_workers(int workers, const std::function<int(int)>& work);  // Fork workers running work(index), wait for all.
+
+#endif
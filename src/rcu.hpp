@@ -0,0 +1,205 @@
+#ifndef RCU_HPP
+#define RCU_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+ * Read-copy-update pointer with epoch-based reclamation.
+ *
+ * RcuPointer<T> holds the current version of a read-mostly object (e.g. the TreeModel a
+ * server scores with). Readers never lock: a reader thread claims a slot once
+ * (register_reader), then brackets each use with read_lock / read_unlock (or an
+ * RcuReadGuard), which store the global epoch in its slot and clear it again, a few
+ * uncontended atomic stores. replace() publishes a new version with one atomic exchange
+ * and retires the old one, tagged with the epoch that follows the exchange. A retired
+ * version is deleted once no slot announces an epoch older than its tag, i.e. after the
+ * last reader that could have loaded it has finished. Writers are serialized by a mutex
+ * that readers never touch.
+ */
+
+template<typename T, std::size_t MaxReaders = 64>
+class RcuPointer
+{
+    /**
+     * The current version of a T, swappable while readers use it.
+     * */
+
+private:
+
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<uint64_t> epoch;  // Epoch the reader entered at, or 0 when outside a read section.
+        std::atomic<bool> claimed;
+    };
+
+    // Attributes:
+    std::atomic<const T*> current_;
+    std::atomic<uint64_t> epoch_;  // Global epoch (starts at 1; 0 marks an idle slot).
+    ReaderSlot slots_[MaxReaders];
+    std::mutex writer_mutex_;  // Serializes replace() and reclaim().
+    std::vector<std::pair<uint64_t, const T*>> retired_;  // Versions replaced but maybe still read, with their tags.
+    std::atomic<std::size_t> num_retired_;
+
+public:
+
+    // Accessors:
+    std::size_t retired() const { return this->num_retired_.load(); }  // Versions waiting for their readers.
+
+    // Readers:
+    int register_reader();  // Claim a slot for the calling thread (throws std::runtime_error if all are taken).
+    void unregister_reader(int slot);  // Release a slot (outside a read section).
+    const T* read_lock(int slot);  // Enter a read section; the returned version stays valid until read_unlock.
+    void read_unlock(int slot);  // Leave the read section.
+
+    // Writers:
+    void replace(std::unique_ptr<T> version);  // Publish a new version and retire the current one.
+    bool reclaim();  // Delete the retired versions no reader can hold; true if none remain.
+    void synchronize();  // Wait until every retired version is deleted.
+
+    // Constructors:
+    explicit RcuPointer(std::unique_ptr<T> version);
+    RcuPointer(const RcuPointer&) = delete;
+    RcuPointer& operator=(const RcuPointer&) = delete;
+    ~RcuPointer();  // Deletes every version (no reader may be inside a read section).
+
+};
+
+template<typename T, std::size_t MaxReaders>
+RcuPointer<T,MaxReaders>::RcuPointer(std::unique_ptr<T> version)
+    : current_(version.release()), epoch_(1), num_retired_(0)
+{
+    for (ReaderSlot& slot : this->slots_)
+    {
+        slot.epoch.store(0);
+        slot.claimed.store(false);
+    }
+}
+
+template<typename T, std::size_t MaxReaders>
+RcuPointer<T,MaxReaders>::~RcuPointer()
+{
+    delete this->current_.load();
+    for (const auto& version : this->retired_) { delete version.second; }
+}
+
+template<typename T, std::size_t MaxReaders>
+int RcuPointer<T,MaxReaders>::register_reader()
+{
+    /** Claim a slot for the calling thread (once per thread, not per read). */
+    for (std::size_t i = 0; i < MaxReaders; i++)
+    {
+        bool expected = false;
+        if (this->slots_[i].claimed.compare_exchange_strong(expected, true)) { return i; }
+    }
+    throw std::runtime_error( "All "+std::to_string(MaxReaders)+" RCU reader slots are taken" );
+}
+
+template<typename T, std::size_t MaxReaders>
+void RcuPointer<T,MaxReaders>::unregister_reader(int slot)
+{
+    this->slots_[slot].epoch.store(0);
+    this->slots_[slot].claimed.store(false);
+}
+
+template<typename T, std::size_t MaxReaders>
+const T* RcuPointer<T,MaxReaders>::read_lock(int slot)
+{
+    /**
+     * Announce the current epoch, then load the version. Both are sequentially consistent,
+     * so a writer that misses the announcement has already published its new version.
+     */
+    this->slots_[slot].epoch.store(this->epoch_.load());
+    return this->current_.load();
+}
+
+template<typename T, std::size_t MaxReaders>
+void RcuPointer<T,MaxReaders>::read_unlock(int slot)
+{
+    this->slots_[slot].epoch.store(0, std::memory_order_release);
+}
+
+template<typename T, std::size_t MaxReaders>
+void RcuPointer<T,MaxReaders>::replace(std::unique_ptr<T> version)
+{
+    /** Publish a new version (readers entering from now on see it) and retire the current one. */
+    std::lock_guard<std::mutex> lock(this->writer_mutex_);
+    const T* old = this->current_.exchange(version.release());
+    const uint64_t tag = this->epoch_.fetch_add(1)+1;  // Readers at an epoch below tag may hold old.
+    this->retired_.push_back(std::make_pair(tag, old));
+    this->num_retired_.store(this->retired_.size());
+}
+
+template<typename T, std::size_t MaxReaders>
+bool RcuPointer<T,MaxReaders>::reclaim()
+{
+    /** Delete every retired version whose readers have all left; true if none remain retired. */
+    std::lock_guard<std::mutex> lock(this->writer_mutex_);
+    uint64_t oldest = UINT64_MAX;  // Oldest epoch a reader is still in.
+    for (const ReaderSlot& slot : this->slots_)
+    {
+        const uint64_t epoch = slot.epoch.load();
+        if (epoch != 0) { oldest = std::min(oldest, epoch); }
+    }
+    std::size_t kept = 0;
+    for (const auto& version : this->retired_)
+    {
+        if (oldest >= version.first) {
+            delete version.second;
+        } else {
+            this->retired_[kept++] = version;
+        }
+    }
+    this->retired_.resize(kept);
+    this->num_retired_.store(kept);
+    return kept == 0;
+}
+
+template<typename T, std::size_t MaxReaders>
+void RcuPointer<T,MaxReaders>::synchronize()
+{
+    /** Wait (on the calling writer thread only) until every retired version is deleted. */
+    while (!this->reclaim())
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+template<typename T, std::size_t MaxReaders = 64>
+class RcuReadGuard
+{
+    /**
+     * A read section of a registered reader: the version it holds stays alive until
+     * the guard goes out of scope.
+     * */
+
+private:
+
+    RcuPointer<T,MaxReaders>& pointer_;
+    int slot_;
+    const T* version_;
+
+public:
+
+    const T& operator*() const { return *this->version_; }
+    const T* operator->() const { return this->version_; }
+
+    RcuReadGuard(RcuPointer<T,MaxReaders>& pointer, int slot)
+        : pointer_(pointer), slot_(slot), version_(pointer.read_lock(slot)) {}
+    RcuReadGuard(const RcuReadGuard&) = delete;
+    RcuReadGuard& operator=(const RcuReadGuard&) = delete;
+    ~RcuReadGuard() { this->pointer_.read_unlock(this->slot_); }
+
+};
+
+#endif
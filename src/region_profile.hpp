@@ -0,0 +1,277 @@
+#ifndef REGION_PROFILE_HPP
+#define REGION_PROFILE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/*
+ * Load balance of the OpenMP parallel regions.
+ *
+ * A RegionScope wraps one execution of a parallel construct (opened by the encountering thread
+ * before it, stopped after it) and a RegionTask wraps each unit of work inside it (a loop
+ * iteration). Per thread of the team the scope collects the busy time (inside tasks), the
+ * number of tasks, and the wait at the implicit barrier (from the thread's last task to the end
+ * of the construct); on stop() it adds them to the process-wide totals of its region.
+ *
+ * The layer only exists when compiled with -DPDT_REGION_PROFILE, and then only records while
+ * RegionProfile::set_active(true) is in effect, so timed runs can leave it off. Otherwise
+ * RegionScope and RegionTask are empty classes.
+ */
+
+enum class Region { split_search, predict, cv_folds };
+
+const int kNumRegions = 3;
+
+inline const char* region_name(Region region)
+{
+    static const char* names[kNumRegions] = {"split_search", "predict", "cv_folds"};
+    return names[(int)region];
+}
+
+struct RegionThreadTotals
+{
+    /** Totals of one thread number of the team (summed over executions). */
+    double busy_ns = 0.0;
+    double wait_ns = 0.0;
+    long long tasks = 0;
+};
+
+struct RegionTotals
+{
+    /** Totals of one region since the last reset. */
+    long long executions = 0;
+    long long team_threads = 0;  // Team sizes, summed over executions.
+    double wall_ns = 0.0;  // Duration of the constructs.
+    double capacity_ns = 0.0;  // Duration x team size: the thread time the constructs held.
+    double busy_ns = 0.0;
+    double wait_ns = 0.0;  // At the implicit barrier.
+    double max_busy_ns = 0.0;  // Busy time of the busiest thread of each execution.
+    double mean_busy_ns = 0.0;  // Mean busy time per thread of each execution.
+    long long tasks = 0;
+    std::vector<RegionThreadTotals> threads;  // By thread number.
+
+    double imbalance() const
+    {
+        /** Busiest thread over the average one (1 = balanced; the team size = one thread did all). */
+        return (this->mean_busy_ns > 0.0) ? this->max_busy_ns / this->mean_busy_ns : 0.0;
+    }
+    double efficiency() const
+    {
+        /** Share of the held thread time spent in tasks. */
+        return (this->capacity_ns > 0.0) ? this->busy_ns / this->capacity_ns : 0.0;
+    }
+    double overhead_ns() const
+    {
+        /** Held thread time neither busy nor at the barrier: fork, join, scheduling. */
+        return std::max(0.0, this->capacity_ns - this->busy_ns - this->wait_ns);
+    }
+};
+
+class RegionProfile
+{
+    /** Totals of every region since the last reset(), over all threads. */
+
+private:
+
+    static std::mutex& mutex() { static std::mutex m; return m; }
+    static RegionTotals* totals() { static RegionTotals t[kNumRegions]; return t; }
+    static std::atomic<bool>& active_flag() { static std::atomic<bool> a(false); return a; }
+
+public:
+
+    static bool enabled()
+    {
+        /** Whether the layer was compiled in (-DPDT_REGION_PROFILE). */
+#ifdef PDT_REGION_PROFILE
+        return true;
+#else
+        return false;
+#endif
+    }
+    static bool active() { return active_flag().load(std::memory_order_relaxed); }
+    static void set_active(bool active) { active_flag().store(active); }
+    static int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    static void reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        for (int r = 0; r < kNumRegions; r++) { totals()[r] = RegionTotals(); }
+    }
+    static RegionTotals get(Region region)
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        return totals()[(int)region];
+    }
+    static void add(Region region, double wall_ns, const std::vector<RegionThreadTotals>& team)
+    {
+        /** Add one execution of a region (one entry per thread of the team). */
+        double busy = 0.0, max_busy = 0.0;
+        for (const RegionThreadTotals& t : team) {
+            busy += t.busy_ns;
+            max_busy = std::max(max_busy, t.busy_ns);
+        }
+        std::lock_guard<std::mutex> lock(mutex());
+        RegionTotals& r = totals()[(int)region];
+        r.executions += 1;
+        r.team_threads += team.size();
+        r.wall_ns += wall_ns;
+        r.capacity_ns += wall_ns * team.size();
+        r.busy_ns += busy;
+        r.max_busy_ns += max_busy;
+        r.mean_busy_ns += busy / team.size();
+        if (r.threads.size() < team.size()) { r.threads.resize(team.size()); }
+        for (size_t i = 0; i < team.size(); i++)
+        {
+            r.wait_ns += team[i].wait_ns;
+            r.tasks += team[i].tasks;
+            r.threads[i].busy_ns += team[i].busy_ns;
+            r.threads[i].wait_ns += team[i].wait_ns;
+            r.threads[i].tasks += team[i].tasks;
+        }
+    }
+
+};
+
+
+/*
+ * SCOPES :
+ */
+
+#ifdef PDT_REGION_PROFILE
+
+class RegionScope
+{
+    /** One execution of a parallel construct (see RegionTask). */
+
+private:
+
+    struct Slot
+    {
+        double busy_ns;
+        int64_t last_end_ns;  // End of the thread's last task.
+        long long tasks;
+        char padding[40];  // One cache line per thread.
+    };
+
+    // Attributes:
+    Region region_;
+    bool active_;
+    int64_t start_ns_;
+    std::vector<Slot> slots_;  // By thread number.
+    std::atomic<int> team_size_;
+
+public:
+
+    // Accessors:
+    bool active() const { return this->active_; }
+
+    // Utilities:
+    void record(int64_t start_ns, int64_t end_ns)
+    {
+        /** A task of the calling thread (a member of the construct's team). */
+#ifdef _OPENMP
+        const int thread = omp_get_thread_num();
+        this->team_size_.store(omp_get_num_threads(), std::memory_order_relaxed);
+#else
+        const int thread = 0;
+        this->team_size_.store(1, std::memory_order_relaxed);
+#endif
+        Slot& slot = this->slots_[thread];
+        slot.busy_ns += (double)(end_ns - start_ns);
+        slot.last_end_ns = end_ns;
+        slot.tasks += 1;
+    }
+    void stop()
+    {
+        /** Close the execution after the construct (the destructor then does nothing). */
+        if (!this->active_) {
+            return;
+        }
+        this->active_ = false;
+        const int64_t end_ns = RegionProfile::now_ns();
+        const int team_size = std::max(1, std::min(this->team_size_.load(), (int)this->slots_.size()));
+        std::vector<RegionThreadTotals> team(team_size);
+        for (int t = 0; t < team_size; t++)
+        {
+            const Slot& slot = this->slots_[t];
+            team[t].busy_ns = slot.busy_ns;
+            team[t].tasks = slot.tasks;
+            // A thread that got no task waited for the whole construct:
+            team[t].wait_ns = (double)(end_ns - ((slot.tasks > 0) ? slot.last_end_ns : this->start_ns_));
+        }
+        RegionProfile::add(this->region_, (double)(end_ns - this->start_ns_), team);
+    }
+
+    // Constructors:
+    explicit RegionScope(Region region) : region_(region), active_(RegionProfile::active()), start_ns_(0), team_size_(0)
+    {
+        if (!this->active_) {
+            return;
+        }
+#ifdef _OPENMP
+        this->slots_.assign(omp_get_max_threads(), Slot());
+#else
+        this->slots_.assign(1, Slot());
+#endif
+        this->start_ns_ = RegionProfile::now_ns();
+    }
+    ~RegionScope() { this->stop(); }
+    RegionScope(const RegionScope&) = delete;
+    RegionScope& operator=(const RegionScope&) = delete;
+
+};
+
+class RegionTask
+{
+    /** Times one unit of work of a RegionScope on the calling thread. */
+
+private:
+
+    // Attributes:
+    RegionScope& scope_;
+    int64_t start_ns_;
+
+public:
+
+    explicit RegionTask(RegionScope& scope) : scope_(scope), start_ns_(scope.active() ? RegionProfile::now_ns() : 0) {}
+    ~RegionTask()
+    {
+        if (this->scope_.active()) {
+            this->scope_.record(this->start_ns_, RegionProfile::now_ns());
+        }
+    }
+    RegionTask(const RegionTask&) = delete;
+    RegionTask& operator=(const RegionTask&) = delete;
+
+};
+
+#else
+
+class RegionScope
+{
+    /** Compiled out: no state, no work. */
+public:
+    void stop() {}
+    explicit RegionScope(Region) {}
+};
+
+class RegionTask
+{
+    /** Compiled out: no state, no work. */
+public:
+    explicit RegionTask(RegionScope&) {}
+};
+
+#endif
+
+#endif
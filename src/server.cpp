@@ -0,0 +1,578 @@
+#include "server.hpp"
+#include "model.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+const uint64_t kListenEvent = 0;  // epoll ids below kFirstConnection are the server's own descriptors.
+const uint64_t kWakeEvent = 1;
+const uint64_t kTimerEvent = 2;
+const uint64_t kFirstConnection = 3;
+const std::size_t kReadChunk = 65536;  // Bytes asked of recv() at a time.
+
+static long long monotonicNs()
+{
+    /** CLOCK_MONOTONIC in nanoseconds (the clock of the batch timerfd). */
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec*1000000000LL + now.tv_nsec;
+}
+
+static std::runtime_error systemError(const std::string& what)
+{
+    return std::runtime_error( what+": "+std::strerror(errno) );
+}
+
+ServerConfig default_server_config()
+{
+    /** Unix socket "pdt.sock", batches of up to 256 rows, 200us budget, requests of up to 65536 rows. */
+    ServerConfig config;
+    config.socket_path = "pdt.sock";
+    config.port = 0;
+    config.max_batch = 256;
+    config.budget_us = 200;
+    config.max_request_rows = 65536;
+    return config;
+}
+
+
+/*
+ * PREDICTION SERVER - CONSTRUCTORS :
+ */
+
+
+PredictionServer::PredictionServer(const TreeModel& model, const ServerConfig& config)
+    : model_(std::unique_ptr<TreeModel>(new TreeModel(model))), num_features_(model.num_features()), reloads_(0), reader_slot_(-1), config_(config), listen_fd_(-1), epoll_fd_(-1), wake_fd_(-1), timer_fd_(-1), port_(-1),
+      stopping_(false), next_connection_(kFirstConnection), waiting_connections_(0), batch_num_rows_(0),
+      batch_deadline_ns_(0), last_arrival_ns_(0), arrival_gap_ns_(1e18), stats_()
+{
+    /** Bind the socket and set up the event loop (throws std::runtime_error). */
+    if ((config.max_batch < 1) or (config.budget_us < 0) or (config.max_request_rows < 1)) {
+        throw std::invalid_argument( "Need max_batch >= 1, budget_us >= 0 and max_request_rows >= 1" );
+    }
+    try {
+        if (!config.socket_path.empty()) {
+            sockaddr_un address;
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            if (config.socket_path.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error( "Socket path too long: "+config.socket_path );
+            }
+            std::strcpy(address.sun_path, config.socket_path.c_str());
+            this->listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (this->listen_fd_ < 0) { throw systemError("socket"); }
+            unlink(config.socket_path.c_str());  // A stale socket of a previous run.
+            if (bind(this->listen_fd_, (const sockaddr*)&address, sizeof(address)) < 0) {
+                throw systemError("Cannot bind "+config.socket_path);
+            }
+        } else {
+            sockaddr_in address;
+            std::memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = htons(config.port);
+            this->listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (this->listen_fd_ < 0) { throw systemError("socket"); }
+            const int one = 1;
+            setsockopt(this->listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            if (bind(this->listen_fd_, (const sockaddr*)&address, sizeof(address)) < 0) {
+                throw systemError("Cannot bind 127.0.0.1:"+std::to_string(config.port));
+            }
+            socklen_t length = sizeof(address);
+            getsockname(this->listen_fd_, (sockaddr*)&address, &length);
+            this->port_ = ntohs(address.sin_port);
+        }
+        if (listen(this->listen_fd_, SOMAXCONN) < 0) { throw systemError("listen"); }
+        this->epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        this->wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        this->timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if ((this->epoll_fd_ < 0) or (this->wake_fd_ < 0) or (this->timer_fd_ < 0)) { throw systemError("epoll/eventfd/timerfd"); }
+        const std::pair<int, uint64_t> watched[3] = {{this->listen_fd_, kListenEvent}, {this->wake_fd_, kWakeEvent}, {this->timer_fd_, kTimerEvent}};
+        for (const auto& fd : watched)
+        {
+            epoll_event event;
+            event.events = EPOLLIN;
+            event.data.u64 = fd.second;
+            if (epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, fd.first, &event) < 0) { throw systemError("epoll_ctl"); }
+        }
+    } catch (...) {
+        this->closeAll();
+        throw;
+    }
+    this->batch_rows_.reserve((std::size_t)config.max_batch*std::max(model.num_features(), 1));
+    this->batch_out_.reserve(config.max_batch);
+}
+
+PredictionServer::~PredictionServer()
+{
+    this->closeAll();
+}
+
+void PredictionServer::closeAll()
+{
+    /** Close every descriptor (and remove the Unix socket file). */
+    for (auto& connection : this->connections_) { close(connection.second.fd); }
+    this->connections_.clear();
+    for (int fd : {this->listen_fd_, this->epoll_fd_, this->wake_fd_, this->timer_fd_})
+    {
+        if (fd >= 0) { close(fd); }
+    }
+    if ((this->listen_fd_ >= 0) and !this->config_.socket_path.empty()) {
+        unlink(this->config_.socket_path.c_str());
+    }
+    this->listen_fd_ = this->epoll_fd_ = this->wake_fd_ = this->timer_fd_ = -1;
+}
+
+
+/*
+ * PREDICTION SERVER - ACCESSORS :
+ */
+
+
+int PredictionServer::port() const
+{
+    /** Bound TCP port (-1 when listening on a Unix socket). */
+    return this->port_;
+}
+
+const ServerConfig& PredictionServer::config() const
+{
+    return this->config_;
+}
+
+ServerStats PredictionServer::stats() const
+{
+    /** Counters so far (read after run() returns, or from the serving thread). */
+    ServerStats stats = this->stats_;
+    stats.reloads = this->reloads_.load();
+    return stats;
+}
+
+
+/*
+ * PREDICTION SERVER - UTILITIES :
+ */
+
+
+void PredictionServer::run()
+{
+    /**
+     * Serve until stop(). Each iteration handles every ready descriptor (so requests that
+     * arrived together join one batch), then decides whether to predict the batch now or
+     * to wait, on the timerfd, for its deadline.
+     */
+    epoll_event events[64];
+    this->reader_slot_ = this->model_.register_reader();
+    while (!this->stopping_.load())
+    {
+        const int n = epoll_wait(this->epoll_fd_, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            throw systemError("epoll_wait");
+        }
+        for (int i = 0; i < n; i++)
+        {
+            const uint64_t id = events[i].data.u64;
+            uint64_t counter;
+            if (id == kListenEvent) {
+                this->acceptAll();
+            } else if ((id == kWakeEvent) or (id == kTimerEvent)) {
+                if (read((id == kWakeEvent) ? this->wake_fd_ : this->timer_fd_, &counter, sizeof(counter)) < 0) {}  // Only clears readiness.
+            } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                this->closeConnection(id);  // The peer is gone: its responses cannot be delivered.
+            } else {
+                if (events[i].events & EPOLLOUT) { this->sendTo(id); }
+                if (events[i].events & EPOLLIN) { this->readFrom(id); }
+            }
+        }
+        if (!this->queue_.empty()) {
+            const long long now = monotonicNs();
+            if (this->batch_num_rows_ >= this->config_.max_batch) {
+                this->flush(this->stats_.full_flushes);
+            } else if (now >= this->batch_deadline_ns_) {
+                this->flush(this->stats_.budget_flushes);
+            } else if ((this->waiting_connections_ >= (int)this->connections_.size())
+                       or (this->batch_deadline_ns_-now < this->arrival_gap_ns_)) {
+                // Every client is waiting on this batch, or the next request is not expected in time.
+                this->flush(this->stats_.early_flushes);
+            } else {
+                this->armTimer(this->batch_deadline_ns_);
+            }
+        }
+        for (uint64_t id : this->replied_) { this->sendTo(id); }
+        this->replied_.clear();
+    }
+    this->model_.unregister_reader(this->reader_slot_);
+}
+
+void PredictionServer::stop()
+{
+    /** Make run() return (async-signal-safe: an atomic store and a write()). */
+    this->stopping_.store(true);
+    const uint64_t one = 1;
+    if (write(this->wake_fd_, &one, sizeof(one)) < 0) {}
+}
+
+void PredictionServer::reload(const TreeModel& model)
+{
+    /**
+     * Serve a new model from the next batch on, without pausing the event loop. Callable
+     * from any thread; returns once the previous model is deleted, i.e. once the batch
+     * that may have been using it is done. Throws std::invalid_argument if the new model
+     * expects a different number of features (queued rows have the old width).
+     */
+    if (model.num_features() != this->num_features_) {
+        throw std::invalid_argument( "Reloaded model expects "+std::to_string(model.num_features())+" features, the server "+std::to_string(this->num_features_) );
+    }
+    this->model_.replace(std::unique_ptr<TreeModel>(new TreeModel(model)));
+    this->reloads_ += 1;
+    this->model_.synchronize();
+}
+
+void PredictionServer::acceptAll()
+{
+    /** Accept every pending connection. */
+    while (true)
+    {
+        const int fd = accept4(this->listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) { continue; }
+            return;  // EAGAIN, or out of descriptors: the rest stay in the backlog.
+        }
+        if (this->config_.socket_path.empty()) {
+            const int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // Responses are small and latency-bound.
+        }
+        const uint64_t id = this->next_connection_++;
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = id;
+        if (epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+        Connection& connection = this->connections_[id];
+        connection.fd = fd;
+        connection.in_begin = 0;
+        connection.in_end = 0;
+        connection.out_begin = 0;
+        connection.queued = 0;
+        connection.closing = false;
+        connection.writable_armed = false;
+        this->stats_.connections += 1;
+    }
+}
+
+void PredictionServer::readFrom(uint64_t id)
+{
+    /** Read what is available and queue the complete requests. */
+    auto it = this->connections_.find(id);
+    if ((it == this->connections_.end()) or it->second.closing) { return; }
+    Connection& connection = it->second;
+    bool eof = false;
+    while (true)
+    {
+        if (connection.in.size()-connection.in_end < kReadChunk) {
+            connection.in.resize(connection.in_end+kReadChunk);  // Grows only: the buffer is reused.
+        }
+        const ssize_t n = recv(connection.fd, &connection.in[connection.in_end], kReadChunk, 0);
+        if (n > 0) {
+            connection.in_end += n;
+            if ((std::size_t)n < kReadChunk) { break; }  // Drained (saves the recv that would return EAGAIN).
+            continue;
+        }
+        if ((n < 0) and (errno == EINTR)) { continue; }
+        if ((n < 0) and (errno != EAGAIN) and (errno != EWOULDBLOCK)) {
+            this->closeConnection(id);
+            return;
+        }
+        eof = (n == 0);
+        break;
+    }
+    this->parseRequests(id, connection);
+    if (eof and !connection.closing) {
+        // The client sent its last request: answer what is queued, then close.
+        connection.closing = true;
+        this->watch(id, connection, connection.writable_armed);
+        this->replied_.push_back(id);
+    }
+}
+
+void PredictionServer::parseRequests(uint64_t id, Connection& connection)
+{
+    /** Queue the complete requests in the input buffer (a request's rows are copied into the batch). */
+    const uint32_t width = this->num_features_;
+    while (!connection.closing)
+    {
+        const std::size_t available = connection.in_end-connection.in_begin;
+        if (available < 2*sizeof(uint32_t)) { break; }
+        uint32_t header[2];
+        std::memcpy(header, &connection.in[connection.in_begin], sizeof(header));
+        if (header[0] > (uint32_t)this->config_.max_request_rows) {
+            this->enqueue(id, connection, 0, kStatusTooLarge, "Too many rows in request");
+            connection.closing = true;
+            break;
+        }
+        if ((header[0] > 0) and (header[1] != width)) {
+            this->enqueue(id, connection, 0, kStatusBadWidth, "Number of features differs from the model's");
+            connection.closing = true;
+            break;
+        }
+        const std::size_t values = (std::size_t)header[0]*header[1];
+        const std::size_t frame = sizeof(header)+values*sizeof(double);
+        if (available < frame) { break; }
+        const std::size_t offset = this->batch_rows_.size();
+        this->batch_rows_.resize(offset+values);
+        std::memcpy(&this->batch_rows_[offset], &connection.in[connection.in_begin+sizeof(header)], values*sizeof(double));
+        connection.in_begin += frame;
+        this->enqueue(id, connection, header[0], kStatusOk, nullptr);
+        if (this->batch_num_rows_ >= this->config_.max_batch) {
+            this->flush(this->stats_.full_flushes);  // A pipelining client fills batches by itself.
+        }
+    }
+    if (connection.closing) {
+        connection.in_begin = connection.in_end = 0;
+        this->watch(id, connection, connection.writable_armed);
+    } else if (connection.in_begin == connection.in_end) {
+        connection.in_begin = connection.in_end = 0;
+    } else if (connection.in_begin > 0) {
+        // Keep the partial request, at the front:
+        std::memmove(&connection.in[0], &connection.in[connection.in_begin], connection.in_end-connection.in_begin);
+        connection.in_end -= connection.in_begin;
+        connection.in_begin = 0;
+    }
+}
+
+void PredictionServer::enqueue(uint64_t id, Connection& connection, int rows, uint32_t status, const char* message)
+{
+    /** Add a request to the batch (its rows are already at the end of batch_rows_). */
+    const long long now = monotonicNs();
+    if (this->queue_.empty()) {
+        this->batch_deadline_ns_ = now + 1000LL*this->config_.budget_us;
+    }
+    if (this->last_arrival_ns_ > 0) {
+        const double gap = now-this->last_arrival_ns_;
+        this->arrival_gap_ns_ = (this->arrival_gap_ns_ >= 1e18) ? gap : 0.875*this->arrival_gap_ns_ + 0.125*gap;
+    }
+    this->last_arrival_ns_ = now;
+    this->queue_.push_back(QueuedRequest{id, rows, status, message});
+    this->batch_num_rows_ += rows;
+    if (connection.queued++ == 0) { this->waiting_connections_ += 1; }
+}
+
+void PredictionServer::flush(long long& reason_counter)
+{
+    /** Predict the batch in one call and append every request's response to its connection. */
+    if (this->queue_.empty()) { return; }
+    this->batch_out_.resize(this->batch_num_rows_);
+    {
+        RcuReadGuard<TreeModel> model(this->model_, this->reader_slot_);  // The whole batch sees one model.
+        model->predict_batch(this->batch_rows_.data(), this->batch_num_rows_, this->num_features_, this->batch_out_.data());
+    }
+    reason_counter += 1;
+    this->stats_.batches += 1;
+    this->stats_.rows += this->batch_num_rows_;
+    this->stats_.max_batch_rows = std::max(this->stats_.max_batch_rows, this->batch_num_rows_);
+    std::size_t row = 0;
+    for (const QueuedRequest& request : this->queue_)
+    {
+        this->stats_.requests += 1;
+        this->stats_.errors += (request.status != kStatusOk);
+        auto it = this->connections_.find(request.connection);
+        if (it != this->connections_.end()) {
+            Connection& connection = it->second;
+            const uint32_t count = (request.status == kStatusOk) ? request.rows : std::strlen(request.message);
+            const uint32_t header[2] = {request.status, count};
+            const char* payload = (request.status == kStatusOk) ? (const char*)&this->batch_out_[row] : request.message;
+            const std::size_t bytes = (request.status == kStatusOk) ? count*sizeof(double) : count;
+            connection.out.insert(connection.out.end(), (const char*)header, (const char*)header+sizeof(header));
+            connection.out.insert(connection.out.end(), payload, payload+bytes);
+            if (--connection.queued == 0) { this->waiting_connections_ -= 1; }
+            this->replied_.push_back(request.connection);
+        }
+        row += request.rows;
+    }
+    this->queue_.clear();
+    this->batch_rows_.clear();
+    this->batch_num_rows_ = 0;
+}
+
+void PredictionServer::sendTo(uint64_t id)
+{
+    /** Write queued response bytes; close the connection once it is done, or if it broke. */
+    auto it = this->connections_.find(id);
+    if (it == this->connections_.end()) { return; }
+    Connection& connection = it->second;
+    while (connection.out_begin < connection.out.size())
+    {
+        const ssize_t n = send(connection.fd, &connection.out[connection.out_begin], connection.out.size()-connection.out_begin, MSG_NOSIGNAL);
+        if (n > 0) {
+            connection.out_begin += n;
+        } else if ((n < 0) and (errno == EINTR)) {
+            continue;
+        } else if ((n < 0) and ((errno == EAGAIN) or (errno == EWOULDBLOCK))) {
+            if (!connection.writable_armed) { this->watch(id, connection, true); }
+            return;
+        } else {
+            this->closeConnection(id);
+            return;
+        }
+    }
+    connection.out.clear();
+    connection.out_begin = 0;
+    if (connection.writable_armed) { this->watch(id, connection, false); }
+    if (connection.closing and (connection.queued == 0)) { this->closeConnection(id); }
+}
+
+void PredictionServer::closeConnection(uint64_t id)
+{
+    /** Forget a connection (its queued requests are still predicted, their responses dropped). */
+    auto it = this->connections_.find(id);
+    if (it == this->connections_.end()) { return; }
+    epoll_ctl(this->epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    close(it->second.fd);
+    if (it->second.queued > 0) { this->waiting_connections_ -= 1; }
+    this->connections_.erase(it);
+}
+
+void PredictionServer::armTimer(long long deadline_ns)
+{
+    /** Wake the event loop at deadline_ns (CLOCK_MONOTONIC). */
+    itimerspec timer;
+    std::memset(&timer, 0, sizeof(timer));
+    timer.it_value.tv_sec = deadline_ns/1000000000LL;
+    timer.it_value.tv_nsec = deadline_ns%1000000000LL;
+    timerfd_settime(this->timer_fd_, TFD_TIMER_ABSTIME, &timer, nullptr);
+}
+
+void PredictionServer::watch(uint64_t id, Connection& connection, bool writable)
+{
+    /** Events epoll waits for: input unless closing, output while responses are pending. */
+    epoll_event event;
+    event.events = (connection.closing ? 0u : (uint32_t)EPOLLIN) | (writable ? (uint32_t)EPOLLOUT : 0u);
+    event.data.u64 = id;
+    epoll_ctl(this->epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+    connection.writable_armed = writable;
+}
+
+
+/*
+ * SCORING CLIENT :
+ */
+
+
+ScoringClient::ScoringClient(const std::string& socket_path)
+{
+    /** Connect to a server's Unix domain socket (throws std::runtime_error). */
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error( "Socket path too long: "+socket_path );
+    }
+    std::strcpy(address.sun_path, socket_path.c_str());
+    this->fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if ((this->fd_ < 0) or (connect(this->fd_, (const sockaddr*)&address, sizeof(address)) < 0)) {
+        const std::runtime_error error = systemError("Cannot connect to "+socket_path);
+        if (this->fd_ >= 0) { close(this->fd_); }
+        throw error;
+    }
+}
+
+ScoringClient::ScoringClient(int port)
+{
+    /** Connect to a server on 127.0.0.1:port (throws std::runtime_error). */
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    this->fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if ((this->fd_ < 0) or (connect(this->fd_, (const sockaddr*)&address, sizeof(address)) < 0)) {
+        const std::runtime_error error = systemError("Cannot connect to 127.0.0.1:"+std::to_string(port));
+        if (this->fd_ >= 0) { close(this->fd_); }
+        throw error;
+    }
+    const int one = 1;
+    setsockopt(this->fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+ScoringClient::~ScoringClient()
+{
+    close(this->fd_);
+}
+
+void ScoringClient::sendAll(const char* data, std::size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t n = send(this->fd_, data, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            throw systemError("send");
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+void ScoringClient::receiveAll(char* data, std::size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t n = recv(this->fd_, data, size, 0);
+        if (n == 0) {
+            throw std::runtime_error( "Connection closed by the server" );
+        }
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            throw systemError("recv");
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+void ScoringClient::predict(const double* rows, int num_rows, int num_features, double* out)
+{
+    /** Predictions for num_rows row-major rows, written to out (throws std::runtime_error on an error response). */
+    const uint32_t header[2] = {(uint32_t)num_rows, (uint32_t)num_features};
+    const std::size_t values = (std::size_t)num_rows*num_features*sizeof(double);
+    this->buffer_.resize(sizeof(header)+values);
+    std::memcpy(&this->buffer_[0], header, sizeof(header));
+    if (values > 0) { std::memcpy(&this->buffer_[sizeof(header)], rows, values); }
+    this->sendAll(this->buffer_.data(), this->buffer_.size());
+    uint32_t response[2];
+    this->receiveAll((char*)response, sizeof(response));
+    if (response[0] != kStatusOk) {
+        std::string message(response[1], '\0');
+        this->receiveAll(&message[0], message.size());
+        throw std::runtime_error( "Server error "+std::to_string(response[0])+": "+message );
+    }
+    if (response[1] != (uint32_t)num_rows) {
+        throw std::runtime_error( "Server returned "+std::to_string(response[1])+" predictions for "+std::to_string(num_rows)+" rows" );
+    }
+    this->receiveAll((char*)out, (std::size_t)num_rows*sizeof(double));
+}
+
+double ScoringClient::predict(const double* row, int num_features)
+{
+    /** Prediction for one row. */
+    double out;
+    this->predict(row, 1, num_features, &out);
+    return out;
+}
@@ -0,0 +1,189 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "model.hpp"
+#include "rcu.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Local scoring over a Unix domain socket or loopback TCP.
+ *
+ * Wire format (native byte order, i.e. little-endian on the hosts we serve from):
+ *     request   uint32 num_rows, uint32 num_features, double values[num_rows*num_features]
+ *     response  uint32 status, uint32 count, then double[count] predictions (status 0)
+ *               or char[count] error message (any other status)
+ * Rows are row-major. A connection may pipeline requests; responses come back in request
+ * order. A request of 0 rows is answered with 0 predictions (a ping). After an error
+ * response the server closes the connection, since it does not read the payload.
+ *
+ * PredictionServer runs one event loop (epoll) that reads every ready connection, queues
+ * the rows of complete requests into one contiguous buffer and predicts them together
+ * with TreeModel::predict_batch, then writes each request's share of the results back.
+ * A queued batch is cut when it reaches max_batch rows, when its oldest request has
+ * waited budget_us, or earlier when waiting cannot help: every open connection already
+ * has a request in the batch, or the recent arrival rate makes another request within
+ * the remaining budget unlikely. Buffers are reused across requests, so serving a
+ * request costs no thread and no allocation.
+ *
+ * The model sits behind an RcuPointer (src/rcu.hpp): reload() swaps in a new one from any
+ * thread while requests are being served. The event loop reads the model without a lock;
+ * each batch is predicted entirely by one model, and the replaced model is deleted once
+ * the batch that may be using it is done.
+ */
+
+enum ServerStatus : uint32_t
+{
+    kStatusOk = 0,
+    kStatusBadWidth = 1,  // num_features differs from the model's.
+    kStatusTooLarge = 2,  // num_rows above the server's max_request_rows.
+};
+
+struct ServerConfig
+{
+    std::string socket_path;  // Unix domain socket to listen on; empty for loopback TCP.
+    int port;  // TCP port on 127.0.0.1 when socket_path is empty (0 picks a free port).
+    int max_batch;  // A batch is predicted as soon as it holds this many rows.
+    int budget_us;  // Longest a request waits for others to join its batch (0: no waiting).
+    int max_request_rows;  // Larger requests are refused.
+};
+
+ServerConfig default_server_config();  // Unix socket "pdt.sock", max_batch 256, budget 200us, 65536 rows.
+
+struct ServerStats
+{
+    long long connections;  // Connections accepted.
+    long long requests;  // Requests answered (errors included).
+    long long rows;  // Rows predicted.
+    long long batches;  // predict_batch calls.
+    long long full_flushes;  // Batches cut at max_batch rows.
+    long long budget_flushes;  // Batches cut when the oldest request's budget ran out.
+    long long early_flushes;  // Batches cut before the budget because waiting could not help.
+    long long errors;  // Error responses.
+    long long reloads;  // Models swapped in by reload().
+    int max_batch_rows;  // Largest batch predicted.
+};
+
+class PredictionServer
+{
+    /**
+     * A scoring daemon for one TreeModel (see the protocol above). run() serves until
+     * stop() is called, which is safe from another thread or a signal handler.
+     * */
+
+private:
+
+    struct Connection
+    {
+        int fd;
+        std::vector<char> in;  // Input buffer: bytes [in_begin, in_end) are received but not yet parsed.
+        std::size_t in_begin;
+        std::size_t in_end;
+        std::vector<char> out;  // Response bytes not yet sent, from out_begin.
+        std::size_t out_begin;
+        int queued;  // Requests of this connection in the current batch.
+        bool closing;  // Close once out is sent (nothing more is read).
+        bool writable_armed;  // Whether epoll also waits for EPOLLOUT.
+    };
+
+    struct QueuedRequest
+    {
+        uint64_t connection;  // Connection id.
+        int rows;  // Rows in the batch buffer (consecutive, in queue order).
+        uint32_t status;  // kStatusOk, or the error to answer with.
+        const char* message;  // Error message (status != kStatusOk).
+    };
+
+    // Attributes:
+    RcuPointer<TreeModel> model_;  // Model served (swapped by reload()).
+    int num_features_;  // Request width (every model served has it).
+    std::atomic<long long> reloads_;
+    int reader_slot_;  // RCU reader slot of the event loop (claimed by run()).
+    ServerConfig config_;
+    int listen_fd_;
+    int epoll_fd_;
+    int wake_fd_;  // eventfd written by stop().
+    int timer_fd_;  // timerfd armed at the batch deadline.
+    int port_;  // Bound TCP port (-1 for a Unix socket).
+    std::atomic<bool> stopping_;
+    uint64_t next_connection_;  // Id of the next accepted connection (ids are never reused).
+    std::unordered_map<uint64_t, Connection> connections_;
+    int waiting_connections_;  // Connections with queued > 0.
+    std::vector<QueuedRequest> queue_;  // Requests of the current batch.
+    std::vector<double> batch_rows_;  // Their rows, back to back.
+    std::vector<double> batch_out_;  // Predictions of the batch.
+    std::vector<uint64_t> replied_;  // Connections with new responses to send (after each loop iteration).
+    int batch_num_rows_;
+    long long batch_deadline_ns_;  // Monotonic time the oldest queued request must be answered by.
+    long long last_arrival_ns_;  // Arrival of the previous request.
+    double arrival_gap_ns_;  // Moving average of the gap between requests.
+    ServerStats stats_;
+
+    // Utilities:
+    void acceptAll();  // Accept every pending connection.
+    void readFrom(uint64_t id);  // Read what is available and queue complete requests.
+    void parseRequests(uint64_t id, Connection& connection);  // Queue the complete requests in the input buffer.
+    void enqueue(uint64_t id, Connection& connection, int rows, uint32_t status, const char* message);  // Add a request (rows already in batch_rows_).
+    void flush(long long& reason_counter);  // Predict the batch and queue every response.
+    void sendTo(uint64_t id);  // Write queued response bytes; close the connection if done or broken.
+    void closeConnection(uint64_t id);
+    void armTimer(long long deadline_ns);
+    void watch(uint64_t id, Connection& connection, bool writable);  // Events epoll waits for on a connection.
+    void closeAll();  // Close every descriptor (and remove the Unix socket file).
+
+public:
+
+    // Accessors:
+    int port() const;  // Bound TCP port (-1 when listening on a Unix socket).
+    const ServerConfig& config() const;
+    ServerStats stats() const;  // Counters so far (read after run() returns, or from the serving thread).
+
+    // Utilities:
+    void run();  // Serve until stop().
+    void stop();  // Make run() return (async-signal-safe).
+    void reload(const TreeModel& model);  // Serve a new model from now on (any thread; blocks until the old one is freed).
+
+    // Constructors:
+    PredictionServer(const TreeModel& model, const ServerConfig& config);  // Binds and listens (throws std::runtime_error).
+    PredictionServer(const PredictionServer&) = delete;
+    PredictionServer& operator=(const PredictionServer&) = delete;
+    ~PredictionServer();
+
+};
+
+class ScoringClient
+{
+    /**
+     * Blocking client of a PredictionServer: one connection, one request at a time.
+     * */
+
+private:
+
+    // Attributes:
+    int fd_;
+    std::vector<char> buffer_;  // Request frame, reused across calls.
+
+    // Utilities:
+    void sendAll(const char* data, std::size_t size);
+    void receiveAll(char* data, std::size_t size);
+
+public:
+
+    // Utilities:
+    void predict(const double* rows, int num_rows, int num_features, double* out);  // Throws std::runtime_error on an error response.
+    double predict(const double* row, int num_features);  // Prediction for one row.
+
+    // Constructors:
+    explicit ScoringClient(const std::string& socket_path);  // Unix domain socket.
+    explicit ScoringClient(int port);  // Loopback TCP.
+    ScoringClient(const ScoringClient&) = delete;
+    ScoringClient& operator=(const ScoringClient&) = delete;
+    ~ScoringClient();
+
+};
+
+#endif
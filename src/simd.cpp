@@ -0,0 +1,50 @@
+#include "simd.hpp"
+#include <string>
+
+
+/*
+ * SIMD - RUNTIME DISPATCH :
+ */
+
+
+bool simd_level_supported(SimdLevel level)
+{
+    /**
+     * Checks if the running CPU can execute kernels built for the given level.
+     * Kernels are compiled with per-function target attributes, so the binary
+     * itself does not need -mavx2 / -mavx512f and still runs on older machines.
+     */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (level==SimdLevel::avx512) {
+        return __builtin_cpu_supports("avx512f") and __builtin_cpu_supports("avx512vl");
+    } else if (level==SimdLevel::avx2) {
+        return __builtin_cpu_supports("avx2");
+    }
+#else
+    if (level!=SimdLevel::scalar) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+SimdLevel detect_simd_level()
+{
+    /** Best instruction set supported by the running CPU (cached after first call). */
+    static const SimdLevel level = simd_level_supported(SimdLevel::avx512) ? SimdLevel::avx512
+                                 : simd_level_supported(SimdLevel::avx2) ? SimdLevel::avx2
+                                 : SimdLevel::scalar;
+    return level;
+}
+
+std::string simd_level_name(SimdLevel level)
+{
+    /** Printable name of an instruction set level. */
+    if (level==SimdLevel::avx512) {
+        return "avx512";
+    } else if (level==SimdLevel::avx2) {
+        return "avx2";
+    }
+    return "scalar";
+}
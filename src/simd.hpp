@@ -0,0 +1,18 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <string>
+
+enum class SimdLevel
+{
+    /** Instruction set extensions that the vector kernels know how to use. */
+    scalar,
+    avx2,
+    avx512
+};
+
+SimdLevel detect_simd_level();  // Best instruction set supported by the running CPU (cached after first call).
+bool simd_level_supported(SimdLevel level);  // Checks if the running CPU can execute kernels built for level.
+std::string simd_level_name(SimdLevel level);  // Printable name of an instruction set level.
+
+#endif
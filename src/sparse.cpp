@@ -0,0 +1,381 @@
+#include "sparse.hpp"
+#include "datasets.hpp"
+#include <assert.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/*
+ * SPARSE MATRIX - CONSTRUCTORS :
+ */
+
+
+SparseMatrix::SparseMatrix()
+{
+    /** Empty matrix. */
+    this->num_rows_ = 0;
+    this->num_cols_ = 0;
+    this->row_ptr_ = {0};
+    this->col_ptr_ = {0};
+}
+
+SparseMatrix::SparseMatrix(int num_cols, const std::vector<int64_t>& row_ptr, const std::vector<int32_t>& cols,
+                           const std::vector<double>& values, const std::vector<double>& labels)
+{
+    /**
+     * Build from CSR arrays (entries of row r are [row_ptr[r], row_ptr[r+1])).
+     * Entries may come in any column order within a row; explicit zeros are dropped.
+     * Throws std::invalid_argument on out-of-range or repeated columns.
+     */
+    if ((row_ptr.size() != labels.size()+1) or (row_ptr.front() != 0) or (row_ptr.back() != (int64_t)cols.size()) or (cols.size() != values.size())) {
+        throw std::invalid_argument( "Inconsistent CSR arrays" );
+    }
+    this->num_rows_ = labels.size();
+    this->num_cols_ = num_cols;
+    this->labels_ = labels;
+    this->row_ptr_.assign(1, 0);
+    std::vector<std::pair<int32_t,double>> entries;
+    for (int r = 0; r < this->num_rows_; r++)
+    {
+        entries.clear();
+        for (int64_t k = row_ptr[r]; k < row_ptr[r+1]; k++)
+        {
+            if ((cols[k] < 0) or (cols[k] >= num_cols)) {
+                throw std::invalid_argument( "Column "+std::to_string(cols[k])+" out of range in row "+std::to_string(r) );
+            }
+            if (values[k] != 0.0) { entries.push_back(std::make_pair(cols[k], values[k])); }
+        }
+        std::sort(entries.begin(), entries.end());
+        for (size_t k = 0; k < entries.size(); k++)
+        {
+            if ((k > 0) and (entries[k].first == entries[k-1].first)) {
+                throw std::invalid_argument( "Column "+std::to_string(entries[k].first)+" repeated in row "+std::to_string(r) );
+            }
+            this->row_cols_.push_back(entries[k].first);
+            this->row_values_.push_back(entries[k].second);
+        }
+        this->row_ptr_.push_back(this->row_cols_.size());
+    }
+    this->buildColumns();
+}
+
+SparseMatrix::SparseMatrix(const DataFrame& dataframe)
+{
+    /** Copy the non-zero features of a dense frame (labels in right-most column). */
+    this->num_rows_ = dataframe.length();
+    this->num_cols_ = dataframe.width()-1;
+    this->row_ptr_.assign(1, 0);
+    for (int r = 0; r < this->num_rows_; r++)
+    {
+        const DataVector* row = dataframe.row(r);
+        for (int c = 0; c < this->num_cols_; c++)
+        {
+            double v = row->value(c);
+            if (v != 0.0) {
+                this->row_cols_.push_back(c);
+                this->row_values_.push_back(v);
+            }
+        }
+        this->row_ptr_.push_back(this->row_cols_.size());
+        this->labels_.push_back(row->value(-1));
+    }
+    this->buildColumns();
+}
+
+void SparseMatrix::buildColumns()
+{
+    /** Derive the CSC arrays from the CSR arrays, each column sorted by (value, row). */
+    const int64_t nnz = this->row_cols_.size();
+    this->col_ptr_.assign(this->num_cols_+1, 0);
+    for (int64_t k = 0; k < nnz; k++) { this->col_ptr_[this->row_cols_[k]+1] += 1; }
+    for (int c = 0; c < this->num_cols_; c++) { this->col_ptr_[c+1] += this->col_ptr_[c]; }
+    this->col_rows_.resize(nnz);
+    this->col_values_.resize(nnz);
+    std::vector<int64_t> next(this->col_ptr_.begin(), this->col_ptr_.end()-1);
+    for (int r = 0; r < this->num_rows_; r++)
+    {
+        for (int64_t k = this->row_ptr_[r]; k < this->row_ptr_[r+1]; k++)
+        {
+            int64_t dest = next[this->row_cols_[k]]++;
+            this->col_rows_[dest] = r;
+            this->col_values_[dest] = this->row_values_[k];
+        }
+    }
+    std::vector<std::pair<double,int32_t>> column;
+    for (int c = 0; c < this->num_cols_; c++)
+    {
+        const int64_t begin = this->col_ptr_[c];
+        const int64_t end = this->col_ptr_[c+1];
+        column.resize(end-begin);
+        for (int64_t k = begin; k < end; k++) { column[k-begin] = std::make_pair(this->col_values_[k], this->col_rows_[k]); }
+        std::sort(column.begin(), column.end());
+        for (int64_t k = begin; k < end; k++)
+        {
+            this->col_values_[k] = column[k-begin].first;
+            this->col_rows_[k] = column[k-begin].second;
+        }
+    }
+}
+
+
+/*
+ * SPARSE MATRIX - ACCESSORS :
+ */
+
+
+int SparseMatrix::length() const
+{
+    /** Returns number of rows. */
+    return this->num_rows_;
+}
+
+int SparseMatrix::width() const
+{
+    /** Returns number of feature columns. */
+    return this->num_cols_;
+}
+
+int64_t SparseMatrix::nnz() const
+{
+    /** Number of stored (non-zero) entries. */
+    return this->row_cols_.size();
+}
+
+double SparseMatrix::density() const
+{
+    /** nnz / (rows x columns). */
+    if ((this->num_rows_ == 0) or (this->num_cols_ == 0)) {
+        return 0.0;
+    }
+    return (double)this->nnz() / ((double)this->num_rows_ * this->num_cols_);
+}
+
+double SparseMatrix::label(int r) const
+{
+    /** Label of row r. */
+    assert ((r>=0) and (r<this->num_rows_));
+    return this->labels_[r];
+}
+
+const std::vector<double>& SparseMatrix::labels() const
+{
+    /** Labels of all rows. */
+    return this->labels_;
+}
+
+int64_t SparseMatrix::row_begin(int r) const
+{
+    /** First CSR entry of row r. */
+    return this->row_ptr_[r];
+}
+
+int64_t SparseMatrix::row_end(int r) const
+{
+    /** One past the last CSR entry of row r. */
+    return this->row_ptr_[r+1];
+}
+
+const int32_t* SparseMatrix::row_cols() const
+{
+    /** CSR column indices. */
+    return this->row_cols_.data();
+}
+
+const double* SparseMatrix::row_values() const
+{
+    /** CSR values. */
+    return this->row_values_.data();
+}
+
+int64_t SparseMatrix::col_begin(int c) const
+{
+    /** First CSC entry of column c. */
+    return this->col_ptr_[c];
+}
+
+int64_t SparseMatrix::col_end(int c) const
+{
+    /** One past the last CSC entry of column c. */
+    return this->col_ptr_[c+1];
+}
+
+const int32_t* SparseMatrix::col_rows() const
+{
+    /** CSC row indices. */
+    return this->col_rows_.data();
+}
+
+const double* SparseMatrix::col_values() const
+{
+    /** CSC values. */
+    return this->col_values_.data();
+}
+
+double SparseMatrix::value(int r, int c) const
+{
+    /** Value in given row and column (binary search in the row; 0 if not stored). */
+    assert ((r>=0) and (r<this->num_rows_) and (c>=0) and (c<this->num_cols_));
+    const int32_t* begin = this->row_cols_.data() + this->row_ptr_[r];
+    const int32_t* end = this->row_cols_.data() + this->row_ptr_[r+1];
+    const int32_t* it = std::lower_bound(begin, end, c);
+    if ((it == end) or (*it != c)) {
+        return 0.0;
+    }
+    return this->row_values_[it - this->row_cols_.data()];
+}
+
+
+/*
+ * SPARSE MATRIX - UTILITIES :
+ */
+
+
+DataFrame SparseMatrix::dense() const
+{
+    /** Dense copy with labels in the right-most column (only sensible for narrow data). */
+    DataFrame out = DataFrame();
+    for (int r = 0; r < this->num_rows_; r++)
+    {
+        std::vector<double> row(this->num_cols_+1, 0.0);
+        for (int64_t k = this->row_ptr_[r]; k < this->row_ptr_[r+1]; k++) { row[this->row_cols_[k]] = this->row_values_[k]; }
+        row[this->num_cols_] = this->labels_[r];
+        out.addRow(new DataVector(row, true));  // (Sized row: the frame takes its width from the first row.)
+    }
+    return out;
+}
+
+
+/*
+ * SPARSE LOADERS :
+ */
+
+
+SparseMatrix load_libsvm(const std::string& filename, int num_cols)
+{
+    /**
+     * Load a LIBSVM / SVMlight file: one row per line, "label index:value index:value ...",
+     * with 1-based increasing feature indices. Blank lines, "#" comments and "qid:" tokens
+     * are ignored. num_cols fixes the width (default: largest index seen).
+     * Throws std::runtime_error if the file cannot be read or a token is malformed.
+     */
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error( "Unable to open file: "+filename );
+    }
+    std::vector<int64_t> row_ptr = {0};
+    std::vector<int32_t> cols;
+    std::vector<double> values;
+    std::vector<double> labels;
+    int max_col = -1;
+    std::string line;
+    int line_num = 0;
+    while (std::getline(file, line))
+    {
+        line_num++;
+        line = line.substr(0, line.find('#'));
+        std::stringstream line_stream(line);
+        std::string token;
+        if (!(line_stream >> token)) {
+            continue;  // Blank line.
+        }
+        char* end;
+        double label = std::strtod(token.c_str(), &end);
+        if (*end != '\0') {
+            throw std::runtime_error( filename+":"+std::to_string(line_num)+": invalid label '"+token+"'" );
+        }
+        while (line_stream >> token)
+        {
+            size_t colon = token.find(':');
+            if (token.compare(0, 4, "qid:") == 0) {
+                continue;
+            }
+            long index = (colon == std::string::npos) ? 0 : std::strtol(token.c_str(), &end, 10);
+            if ((colon == std::string::npos) or (end != token.c_str()+colon) or (index < 1)) {
+                throw std::runtime_error( filename+":"+std::to_string(line_num)+": invalid entry '"+token+"'" );
+            }
+            double value = std::strtod(token.c_str()+colon+1, &end);
+            if (*end != '\0') {
+                throw std::runtime_error( filename+":"+std::to_string(line_num)+": invalid value in '"+token+"'" );
+            }
+            cols.push_back(index-1);
+            values.push_back(value);
+            max_col = std::max(max_col, (int)index-1);
+        }
+        row_ptr.push_back(cols.size());
+        labels.push_back(label);
+    }
+    if (num_cols == -1) {
+        num_cols = max_col+1;
+    } else if (max_col >= num_cols) {
+        throw std::runtime_error( filename+": feature index "+std::to_string(max_col+1)+" exceeds num_cols="+std::to_string(num_cols) );
+    }
+    try {
+        return SparseMatrix(num_cols, row_ptr, cols, values, labels);
+    } catch (const std::invalid_argument& e) {
+        throw std::runtime_error( filename+": "+e.what() );
+    }
+}
+
+SparseMatrix load_sparse_csv(const std::string& filename)
+{
+    /**
+     * Load a numeric CSV in the same layout as DataLoader (no header, labels in the
+     * right-most column) without materializing the dense rows: zeros are dropped while
+     * parsing. Unlike DataLoader, non-numeric cells are an error (std::runtime_error).
+     */
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error( "Unable to open file: "+filename );
+    }
+    std::vector<int64_t> row_ptr = {0};
+    std::vector<int32_t> cols;
+    std::vector<double> values;
+    std::vector<double> labels;
+    int width = -1;
+    std::string line;
+    int line_num = 0;
+    while (std::getline(file, line))
+    {
+        line_num++;
+        if (line.empty() or (line == "\r")) {
+            continue;
+        }
+        std::vector<double> cells;
+        const char* p = line.c_str();
+        while (true)
+        {
+            char* end;
+            double v = std::strtod(p, &end);
+            while ((*end == ' ') or (*end == '\r')) { end++; }
+            if ((end == p) or ((*end != ',') and (*end != '\0'))) {
+                throw std::runtime_error( filename+":"+std::to_string(line_num)+": non-numeric cell in column "+std::to_string(cells.size()) );
+            }
+            cells.push_back(v);
+            if (*end == '\0') {
+                break;
+            }
+            p = end+1;
+        }
+        if (width == -1) {
+            width = cells.size();
+        } else if ((int)cells.size() != width) {
+            throw std::runtime_error( filename+":"+std::to_string(line_num)+": expected "+std::to_string(width)+" columns, got "+std::to_string(cells.size()) );
+        }
+        for (int c = 0; c+1 < width; c++)
+        {
+            if (cells[c] != 0.0) {
+                cols.push_back(c);
+                values.push_back(cells[c]);
+            }
+        }
+        row_ptr.push_back(cols.size());
+        labels.push_back(cells.back());
+    }
+    return SparseMatrix(std::max(width-1, 0), row_ptr, cols, values, labels);
+}
@@ -0,0 +1,68 @@
+#ifndef SPARSE_HPP
+#define SPARSE_HPP
+
+#include "datasets.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class SparseMatrix
+{
+    /**
+     * A feature matrix that stores only non-zero entries, plus one label per row.
+     * Entries are kept twice: row-major (CSR) for gathering the rows of a tree node and
+     * for prediction, and column-major (CSC, each column sorted by value) for scanning
+     * a feature. Zeros are implicit, so memory and split search scale with the number
+     * of non-zeros rather than rows x columns.
+     * */
+
+private:
+
+    // Attributes:
+    int num_rows_;  // Number of rows.
+    int num_cols_;  // Number of feature columns (labels excluded).
+    std::vector<double> labels_;  // Label of each row.
+    std::vector<int64_t> row_ptr_;  // CSR: entries of row r are [row_ptr_[r], row_ptr_[r+1]).
+    std::vector<int32_t> row_cols_;  // CSR: column of each entry (increasing within a row).
+    std::vector<double> row_values_;  // CSR: value of each entry.
+    std::vector<int64_t> col_ptr_;  // CSC: entries of column c are [col_ptr_[c], col_ptr_[c+1]).
+    std::vector<int32_t> col_rows_;  // CSC: row of each entry (columns sorted by value, then row).
+    std::vector<double> col_values_;  // CSC: value of each entry.
+
+    // Utilities:
+    void buildColumns();  // Derive the CSC arrays from the CSR arrays.
+
+public:
+
+    // Accessors:
+    int length() const;  // Returns number of rows.
+    int width() const;  // Returns number of feature columns.
+    int64_t nnz() const;  // Number of stored (non-zero) entries.
+    double density() const;  // nnz / (rows x columns).
+    double label(int r) const;  // Label of row r.
+    const std::vector<double>& labels() const;  // Labels of all rows.
+    int64_t row_begin(int r) const;  // First CSR entry of row r.
+    int64_t row_end(int r) const;  // One past the last CSR entry of row r.
+    const int32_t* row_cols() const;  // CSR column indices.
+    const double* row_values() const;  // CSR values.
+    int64_t col_begin(int c) const;  // First CSC entry of column c.
+    int64_t col_end(int c) const;  // One past the last CSC entry of column c.
+    const int32_t* col_rows() const;  // CSC row indices.
+    const double* col_values() const;  // CSC values.
+    double value(int r, int c) const;  // Value in given row and column (binary search; 0 if not stored).
+
+    // Utilities:
+    DataFrame dense() const;  // Dense copy with labels in the right-most column.
+
+    // Constructors:
+    SparseMatrix(int num_cols, const std::vector<int64_t>& row_ptr, const std::vector<int32_t>& cols,
+                 const std::vector<double>& values, const std::vector<double>& labels);
+    SparseMatrix(const DataFrame& dataframe);  // From a dense frame (labels in right-most column).
+    SparseMatrix();
+
+};
+
+SparseMatrix load_libsvm(const std::string& filename, int num_cols=-1);  // "label index:value ..." rows, 1-based indices.
+SparseMatrix load_sparse_csv(const std::string& filename);  // Numeric CSV (labels in right-most column), zeros dropped while parsing.
+
+#endif
@@ -0,0 +1,88 @@
+#include "sparse_tree.hpp"
+#include "sparse.hpp"
+#include "model.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+/*
+ * SPARSE TREES - RUNTIME-CONFIGURED ENTRY POINTS :
+ */
+
+
+template<class Loss, class LabelT>
+static TreeModel train_sparse_(
+    const SparseMatrix& data, int mtry, int max_height, int max_leaves, int min_obs, double max_prop, int seed
+)
+{
+    /** Train one instantiation and return its model. */
+    return typed::SparseDecisionTree<Loss,LabelT>(data, mtry, max_height, max_leaves, min_obs, max_prop, seed).model();
+}
+
+template<class Loss>
+static TreeModel train_sparse_classifier_(
+    const SparseMatrix& data, int mtry, int max_height, int max_leaves, int min_obs, double max_prop, int seed
+)
+{
+    /** Classification labels as uint8_t class indices, or int32_t past 256 classes. */
+    std::vector<double> classes = data.labels();
+    std::sort(classes.begin(), classes.end());
+    if (std::unique(classes.begin(), classes.end()) - classes.begin() <= 256) {
+        return train_sparse_<Loss,uint8_t>(data, mtry, max_height, max_leaves, min_obs, max_prop, seed);
+    }
+    return train_sparse_<Loss,int32_t>(data, mtry, max_height, max_leaves, min_obs, max_prop, seed);
+}
+
+TreeModel train_sparse_tree(
+    const SparseMatrix& data, bool regression, std::string loss,
+    int mtry, int max_height, int max_leaves, int min_obs, double max_prop, int seed
+)
+{
+    /**
+     * Train a tree on sparse data and return it as a TreeModel.
+     * Arguments are the same as DecisionTree (loss names, stopping conditions, seed).
+     */
+    if (regression) {
+        if (loss=="mean_squared_error") {
+            return train_sparse_<typed::MeanSquaredError,double>(data, mtry, max_height, max_leaves, min_obs, max_prop, seed);
+        }
+        throw std::invalid_argument( "Received invalid loss method for regression tree: "+loss );
+    }
+    if (loss=="gini_impurity") {
+        return train_sparse_classifier_<typed::GiniImpurity>(data, mtry, max_height, max_leaves, min_obs, max_prop, seed);
+    } else if (loss=="cross_entropy") {
+        return train_sparse_classifier_<typed::CrossEntropy>(data, mtry, max_height, max_leaves, min_obs, max_prop, seed);
+    } else if (loss=="misclassification_error") {
+        return train_sparse_classifier_<typed::MisclassificationError>(data, mtry, max_height, max_leaves, min_obs, max_prop, seed);
+    }
+    throw std::invalid_argument( "Received invalid loss method for classification tree: "+loss );
+}
+
+std::vector<double> predict_sparse(const TreeModel& model, const SparseMatrix& data)
+{
+    /** Predictions for every row; each visited node looks its feature up in the row (binary search). */
+    if (data.width() > model.num_features()) {
+        throw std::invalid_argument( "Data has "+std::to_string(data.width())+" columns, model expects "+std::to_string(model.num_features()) );
+    }
+    const ModelNode* nodes = &model.nodes()[0];
+    const uint64_t* words = model.category_words().data();
+    std::vector<double> predictions(data.length());
+    for (int r = 0; r < data.length(); r++)
+    {
+        const int32_t* cols = data.row_cols() + data.row_begin(r);
+        const int32_t* cols_end = data.row_cols() + data.row_end(r);
+        const double* values = data.row_values() + data.row_begin(r);
+        int i = 0;
+        while (nodes[i].feature != -1)
+        {
+            const int32_t* it = std::lower_bound(cols, cols_end, nodes[i].feature);
+            const double value = ((it != cols_end) and (*it == nodes[i].feature)) ? values[it-cols] : 0.0;
+            i = goes_left(nodes[i], words, value) ? nodes[i].left : nodes[i].right;
+        }
+        predictions[r] = nodes[i].value;
+    }
+    return predictions;
+}
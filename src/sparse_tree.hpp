@@ -0,0 +1,324 @@
+#ifndef SPARSE_TREE_HPP
+#define SPARSE_TREE_HPP
+
+#include "sparse.hpp"
+#include "model.hpp"
+#include "typed_tree.hpp"
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace typed {
+
+template<class Loss, class LabelT>
+class SparseDecisionTree
+{
+    /**
+     * Decision tree trained on a SparseMatrix, visiting only the non-zero entries.
+     * For every candidate feature, the node's non-zero (value, label) pairs are swept
+     * in value order and all rows holding zero form one implicit bucket at value 0:
+     * its statistics are the node totals minus the non-zero ones, so zeros are never
+     * enumerated. Pairs come from one of two sources, whichever is cheaper at the node:
+     *     CSC scan   : walk the pre-sorted column, keeping entries of rows in the node
+     *                  (no sort; best near the root).
+     *     CSR gather : walk the node's rows and bucket their entries by column, then
+     *                  sort each bucket (best for small nodes of wide data).
+     * Stopping rules, tie-breaking and the random feature order match ::DecisionTree,
+     * so on the same (dense-convertible) data classification trees are identical.
+     * */
+
+public:
+
+    typedef typename Loss::template Stats<LabelT> Stats;
+
+private:
+
+    // Attributes:
+    const SparseMatrix* data_;  // Training data (only used while fitting).
+    std::vector<ModelNode> nodes_;  // Trained nodes, pre-order.
+    std::vector<double> classes_;  // Original label value of each class index (classification).
+    std::vector<LabelT> labels_;  // Label (class index or target) of each row.
+    int num_features_;  // Number of feature columns.
+    int mtry_;  // Hyperparameter: Number of features to use at each split.
+    int max_height_;  // Stopping condition: max height of tree.
+    int max_leaves_;  // Stopping condition: max number of leaves.
+    int min_obs_;  // Stopping condition: minimum number of observations in a leaf.
+    double max_prop_;  // Stopping condition: maximum proportion of majority class in a leaf.
+    int num_leaves_;  // State variable: Number of leaves currently in tree.
+    SeedGenerator seed_gen_;  // Random seed generator (same sequence as ::DecisionTree).
+    EntropyTable table_;  // n*log2(n) lookups (CrossEntropy only).
+
+    // Scratch (reused across nodes):
+    std::vector<int32_t> rows_;  // Row ids, partitioned in place so every node owns a range.
+    std::vector<char> in_node_;  // Per row: 1 if it belongs to the node being split (CSC scan).
+    std::vector<int> rank_;  // Per column: position in this node's feature order, or -1 if not a candidate.
+    std::vector<std::vector<std::pair<double,LabelT>>> buckets_;  // Per column: gathered non-zero pairs (CSR gather).
+
+    // Utilities:
+    int fit_(int begin, int end, int depth);  // Grow the subtree over rows_[begin,end) and return its index.
+    bool findBestSplit(int begin, int end, const Stats& node, int* feature, double* threshold);  // Best split over rows_[begin,end).
+    void sweep_(int col, const std::pair<double,LabelT>* pairs, int n_pairs, const Stats& node,
+                bool* first_pass, double* best_loss, int* feature, double* threshold);  // Score one column.
+
+public:
+
+    // Constructors:
+    SparseDecisionTree(
+        const SparseMatrix& data, int mtry=-1, int max_height=-1, int max_leaves=-1,
+        int min_obs=-1, double max_prop=-1, int seed=-1
+    );
+
+    // Getters:
+    int getSize() const;  // Number of nodes in tree.
+    TreeModel model() const;  // Trained tree as a serializable model.
+
+};
+
+template<class Loss, class LabelT>
+SparseDecisionTree<Loss,LabelT>::SparseDecisionTree(
+    const SparseMatrix& data, int mtry, int max_height, int max_leaves, int min_obs, double max_prop, int seed
+)
+{
+    /** Train a tree on a sparse matrix. Hyperparameters have the same meaning as in ::DecisionTree. */
+    assert ((data.length()>0) and (data.width()>0));
+    assert ((max_height==-1) or (max_height>=1));
+    assert ((max_leaves==-1) or (max_leaves>=1));
+    assert ((min_obs==-1) or (min_obs>=1));
+    assert ((max_prop==-1) or ((max_prop>0) and (max_prop<=1) and Loss::classification));
+    assert ((mtry>=-1) and (mtry<=data.width()));
+    const int n = data.length();
+    this->data_ = &data;
+    this->num_features_ = data.width();
+    this->mtry_ = (mtry==-1) ? data.width() : mtry;
+    this->max_height_ = max_height;
+    this->max_leaves_ = max_leaves;
+    this->min_obs_ = min_obs;
+    this->max_prop_ = max_prop;
+    this->seed_gen_ = SeedGenerator(seed);
+    // Encode labels:
+    this->labels_.resize(n);
+    if (Loss::classification) {
+        this->classes_ = data.labels();
+        std::sort(this->classes_.begin(), this->classes_.end());
+        this->classes_.erase(std::unique(this->classes_.begin(), this->classes_.end()), this->classes_.end());
+        if (this->classes_.size()-1 > (size_t)std::numeric_limits<LabelT>::max()) {
+            throw std::invalid_argument( "Too many classes for label type: "+std::to_string(this->classes_.size()) );
+        }
+        for (int r = 0; r < n; r++)
+        {
+            this->labels_[r] = std::lower_bound(this->classes_.begin(), this->classes_.end(), data.label(r)) - this->classes_.begin();
+        }
+        this->table_ = EntropyTable(n);
+    } else {
+        for (int r = 0; r < n; r++) { this->labels_[r] = (LabelT)data.label(r); }
+    }
+    // Perform training:
+    this->rows_.resize(n);
+    std::iota(this->rows_.begin(), this->rows_.end(), 0);
+    this->in_node_.assign(n, 0);
+    this->rank_.assign(data.width(), -1);
+    this->buckets_.resize(data.width());
+    this->num_leaves_ = 1;
+    this->fit_(0, n, 0);
+    // Release training state:
+    this->data_ = nullptr;
+    std::vector<int32_t>().swap(this->rows_);
+    std::vector<char>().swap(this->in_node_);
+    std::vector<int>().swap(this->rank_);
+    std::vector<std::vector<std::pair<double,LabelT>>>().swap(this->buckets_);
+    this->table_ = EntropyTable();
+}
+
+template<class Loss, class LabelT>
+int SparseDecisionTree<Loss,LabelT>::getSize() const
+{
+    /** Number of nodes in tree. */
+    return this->nodes_.size();
+}
+
+template<class Loss, class LabelT>
+TreeModel SparseDecisionTree<Loss,LabelT>::model() const
+{
+    /** Trained tree as a serializable model (features are the sparse column indices). */
+    return TreeModel(this->num_features_, !Loss::classification, this->nodes_);
+}
+
+template<class Loss, class LabelT>
+int SparseDecisionTree<Loss,LabelT>::fit_(int begin, int end, int depth)
+{
+    /** Grow the subtree over rows_[begin,end) (pre-order, left first) and return its index. */
+    Stats stats;
+    stats.reset(this->classes_.size());
+    for (int i = begin; i < end; i++) { stats.add(this->labels_[this->rows_[i]]); }
+    const int index = this->nodes_.size();
+    ModelNode node = {-1, -1, -1, end-begin, 0.0, 0.0, -1, 0};
+    node.value = Loss::classification ? this->classes_[(int)stats.prediction()] : (double)stats.prediction();
+    this->nodes_.push_back(node);
+    // Stopping conditions (same order as ::DecisionTree::fit_):
+    const int length = end-begin;
+    if ( stats.pure() ) {
+        return index;  // Prune if there is only one label left.
+    } else if ( length<2 ) {
+        return index;  // Prune if there is not enough data to split.
+    } else if ( (this->max_height_!=-1) and (depth+1>=this->max_height_) ) {
+        return index;  // Prune if adding children would exceed max depth.
+    } else if ( (this->max_leaves_!=-1) and (this->num_leaves_+1>=this->max_leaves_) ) {
+        return index;  // Prune if adding children would exceed max leaves.
+    } else if ( (this->min_obs_!=-1) and (length<=this->min_obs_) ) {
+        return index;  // Prune if node is below minimum leave size.
+    } else if ( (this->max_prop_!=-1) and (stats.majority()>=this->max_prop_) ) {
+        return index;  // Prune if proportion of majority label is above threshold.
+    }
+    int feature;
+    double threshold;
+    if (!this->findBestSplit(begin, end, stats, &feature, &threshold)) {
+        return index;  // All candidate columns are constant at this node.
+    }
+    // Partition rows (stable, so children see rows in training order):
+    const SparseMatrix& data = *this->data_;
+    int32_t* mid = std::stable_partition(&this->rows_[begin], &this->rows_[0]+end,
+                                         [&data, feature, threshold] (int32_t r) { return data.value(r, feature) <= threshold; });
+    const int split = mid - &this->rows_[0];
+    if ( (split==begin) or (split==end) ) {
+        return index;  // Prune if best split does not actually split the dataset.
+    }
+    this->num_leaves_ += 1;  // Each split causes net addition of 1 leaf.
+    const int left = this->fit_(begin, split, depth+1);
+    const int right = this->fit_(split, end, depth+1);
+    this->nodes_[index].feature = feature;
+    this->nodes_[index].threshold = threshold;
+    this->nodes_[index].left = left;
+    this->nodes_[index].right = right;
+    return index;
+}
+
+template<class Loss, class LabelT>
+bool SparseDecisionTree<Loss,LabelT>::findBestSplit(int begin, int end, const Stats& node, int* feature, double* threshold)
+{
+    /** Best split over rows_[begin,end), scanning columns or gathering rows (see class comment). */
+    const SparseMatrix& data = *this->data_;
+    const int width = data.width();
+    // Feature order (shuffled with the same generator calls as ::DecisionTree):
+    std::vector<int> shuf_inds(width);
+    std::iota(shuf_inds.begin(), shuf_inds.end(), 0);
+    if (this->mtry_ < width) {
+        srand((unsigned) this->seed_gen_.new_seed());
+        for (int i = 0; i < width; i++){
+            std::swap(shuf_inds[i], shuf_inds[i+(std::rand() % (width-i))]);
+        }
+    }
+    // Cost of each strategy, in entries visited:
+    int64_t scan_cost = 0;
+    int64_t gather_cost = 0;
+    for (int i = 0; i < this->mtry_; i++) { scan_cost += data.col_end(shuf_inds[i]) - data.col_begin(shuf_inds[i]); }
+    for (int i = begin; i < end; i++) { gather_cost += data.row_end(this->rows_[i]) - data.row_begin(this->rows_[i]); }
+    gather_cost = (int64_t)(gather_cost * (1.0 + std::log2(1.0 + (double)gather_cost/std::max(1, this->mtry_))));  // Bucket sorts.
+    bool first_pass = true;
+    double best_loss = 0.0;
+    if (scan_cost <= gather_cost) {
+        // CSC scan: columns are already sorted by value.
+        for (int i = begin; i < end; i++) { this->in_node_[this->rows_[i]] = 1; }
+        std::vector<std::pair<double,LabelT>> pairs;
+        for (int i = 0; i < this->mtry_; i++)
+        {
+            const int col = shuf_inds[i];
+            pairs.clear();
+            for (int64_t k = data.col_begin(col); k < data.col_end(col); k++)
+            {
+                const int32_t r = data.col_rows()[k];
+                if (this->in_node_[r]) { pairs.push_back(std::make_pair(data.col_values()[k], this->labels_[r])); }
+            }
+            this->sweep_(col, pairs.data(), pairs.size(), node, &first_pass, &best_loss, feature, threshold);
+        }
+        for (int i = begin; i < end; i++) { this->in_node_[this->rows_[i]] = 0; }
+    } else {
+        // CSR gather: bucket the node's entries by candidate column, then sort each bucket.
+        for (int i = 0; i < this->mtry_; i++) { this->rank_[shuf_inds[i]] = i; }
+        for (int i = begin; i < end; i++)
+        {
+            const int32_t r = this->rows_[i];
+            for (int64_t k = data.row_begin(r); k < data.row_end(r); k++)
+            {
+                const int32_t col = data.row_cols()[k];
+                if (this->rank_[col] != -1) { this->buckets_[col].push_back(std::make_pair(data.row_values()[k], this->labels_[r])); }
+            }
+        }
+        for (int i = 0; i < this->mtry_; i++)
+        {
+            const int col = shuf_inds[i];
+            std::vector<std::pair<double,LabelT>>& bucket = this->buckets_[col];
+            std::sort(bucket.begin(), bucket.end());
+            this->sweep_(col, bucket.data(), bucket.size(), node, &first_pass, &best_loss, feature, threshold);
+            bucket.clear();
+            this->rank_[col] = -1;
+        }
+    }
+    return !first_pass;
+}
+
+template<class Loss, class LabelT>
+void SparseDecisionTree<Loss,LabelT>::sweep_(int col, const std::pair<double,LabelT>* pairs, int n_pairs, const Stats& node,
+                                             bool* first_pass, double* best_loss, int* feature, double* threshold)
+{
+    /**
+     * Score every threshold of one column from its sorted non-zero pairs. Rows not in
+     * `pairs` hold zero: they join the left side as one bucket between the negative and
+     * the positive values.
+     */
+    Stats nonzero;
+    nonzero.reset(this->classes_.size());
+    for (int j = 0; j < n_pairs; j++) { nonzero.add(pairs[j].second); }
+    const bool has_zeros = (nonzero.size < node.size);
+    Stats left;
+    left.reset(this->classes_.size());
+    auto consider = [&] (double value) {
+        if (left.size == node.size) {
+            return;  // Right side would be empty.
+        }
+        const double loss = Loss::split_loss(left, node, this->table_);
+        if ((*first_pass) or (loss<*best_loss)) {
+            *first_pass = false;
+            *best_loss = loss;
+            *feature = col;
+            *threshold = value;
+        }
+    };
+    bool zeros_added = !has_zeros;
+    for (int j = 0; j < n_pairs; j++)
+    {
+        if ((!zeros_added) and (pairs[j].first > 0)) {
+            left.add_difference(node, nonzero);  // Zero bucket, between negatives and positives.
+            zeros_added = true;
+            consider(0.0);
+        }
+        left.add(pairs[j].second);
+        const bool last_of_value = (j+1 == n_pairs) or (pairs[j+1].first != pairs[j].first);
+        if (last_of_value) {
+            consider(pairs[j].first);
+        }
+    }
+    if (!zeros_added) {
+        left.add_difference(node, nonzero);  // Only non-positive values: zeros come last.
+        consider(0.0);
+    }
+}
+
+}  // namespace typed
+
+TreeModel train_sparse_tree(
+    const SparseMatrix& data, bool regression=false, std::string loss="gini_impurity",
+    int mtry=-1, int max_height=-1, int max_leaves=-1, int min_obs=-1,
+    double max_prop=-1, int seed=-1
+);  // Train the SparseDecisionTree matching the runtime arguments (same arguments as DecisionTree).
+
+std::vector<double> predict_sparse(const TreeModel& model, const SparseMatrix& data);  // Predictions for every row, looking up only the visited features.
+
+#endif
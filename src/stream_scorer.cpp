@@ -0,0 +1,299 @@
+#include "stream_scorer.hpp"
+#include "bounded_queue.hpp"
+#include "model.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct TextChunk
+{
+    long long seq;  // Position in the input.
+    std::vector<char> text;  // Whole lines, the last one ending in '\n', then '\0'.
+};
+
+struct ParsedChunk
+{
+    long long seq;
+    int lines;  // Lines in the chunk (blank ones included).
+    int rows;  // Rows parsed.
+    std::vector<double> values;  // Row-major, num_features per row.
+    int error_line;  // Line of the chunk (from 1) that failed to parse.
+    std::string error;  // Empty if every line parsed.
+};
+
+struct ScoredChunk
+{
+    long long seq;
+    std::vector<double> predictions;
+};
+
+ScorerConfig default_scorer_config()
+{
+    /** Hardware threads, 1 MiB chunks, 4 chunks in flight per parse thread, no header, missing cells rejected. */
+    ScorerConfig config;
+    config.threads = std::max(1u, std::thread::hardware_concurrency());
+    config.chunk_bytes = 1 << 20;
+    config.queue_chunks = 4*config.threads;
+    config.header = false;
+    config.missing_as_nan = false;
+    return config;
+}
+
+static bool isMissingText(const char* begin, const char* end)
+{
+    /** Whether a cell marks a missing value (the markers DataLoader accepts, any case, blanks ignored). */
+    char value[5];
+    int length = 0;
+    for (const char* p = begin; p < end; p++)
+    {
+        if (std::isspace((unsigned char)*p)) { continue; }
+        if (length == 4) { return false; }
+        value[length++] = std::tolower((unsigned char)*p);
+    }
+    value[length] = '\0';
+    return (length == 0) or !std::strcmp(value, "na") or !std::strcmp(value, "n/a") or !std::strcmp(value, "nan")
+           or !std::strcmp(value, "null") or !std::strcmp(value, "?");
+}
+
+static void parseChunk(const TextChunk& chunk, int width, bool missing_as_nan, ParsedChunk& parsed)
+{
+    /** Parse every line of a chunk into row-major values (stops at the first malformed line). */
+    const char* p = chunk.text.data();
+    const char* end = p + chunk.text.size()-1;  // Without the '\0'.
+    parsed.lines = 0;
+    parsed.rows = 0;
+    parsed.error_line = 0;
+    parsed.values.reserve((std::size_t)width*(chunk.text.size()/(2*width+1)+1));
+    while (p < end)
+    {
+        const char* line_end = (const char*)std::memchr(p, '\n', end-p);
+        parsed.lines += 1;
+        if (std::all_of(p, line_end, [] (char ch) { return std::isspace((unsigned char)ch); })) {
+            p = line_end+1;  // Blank line.
+            continue;
+        }
+        int cells = 0;
+        const char* cell = p;
+        while (true)
+        {
+            const char* comma = (const char*)std::memchr(cell, ',', line_end-cell);
+            if (comma == nullptr) { comma = line_end; }
+            double value = std::numeric_limits<double>::quiet_NaN();
+            if (isMissingText(cell, comma)) {
+                if (!missing_as_nan) {
+                    parsed.error_line = parsed.lines;
+                    parsed.error = "missing value '"+std::string(cell, comma)+"' (score with missing_as_nan for a model trained on NaN)";
+                    return;
+                }
+            } else {
+                char* stop;
+                value = std::strtod(cell, &stop);
+                while ((stop < comma) and std::isspace((unsigned char)*stop)) { stop++; }
+                if ((stop == cell) or (stop != comma)) {
+                    parsed.error_line = parsed.lines;
+                    parsed.error = "cannot parse '"+std::string(cell, comma)+"' as a number";
+                    return;
+                }
+            }
+            parsed.values.push_back(value);
+            cells += 1;
+            if (comma == line_end) { break; }
+            cell = comma+1;
+        }
+        if (cells == width+1) {
+            parsed.values.pop_back();  // Trailing label.
+        } else if (cells != width) {
+            parsed.error_line = parsed.lines;
+            parsed.error = "expected "+std::to_string(width)+" or "+std::to_string(width+1)+" cells, got "+std::to_string(cells);
+            return;
+        }
+        parsed.rows += 1;
+        p = line_end+1;
+    }
+}
+
+static std::size_t formatPrediction(double value, char* buffer)
+{
+    /** Integral predictions (class labels) without a decimal point, others with full precision. */
+    if ((value == std::floor(value)) and (std::fabs(value) < 1e15)) {
+        return std::snprintf(buffer, 32, "%lld\n", (long long)value);
+    }
+    return std::snprintf(buffer, 32, "%.17g\n", value);
+}
+
+
+/*
+ * STREAM SCORER :
+ */
+
+
+StreamScorer::StreamScorer(const TreeModel& model, const ScorerConfig& config)
+    : model_(model), config_(config)
+{
+    if ((config.threads < 1) or (config.chunk_bytes < 1) or (config.queue_chunks < 1)) {
+        throw std::invalid_argument( "Need threads, chunk_bytes and queue_chunks >= 1" );
+    }
+}
+
+ScorerStats StreamScorer::score(std::FILE* input, std::FILE* output) const
+{
+    /**
+     * Score every row of input and write one prediction per line to output, in input
+     * order. Throws std::runtime_error on a malformed row (naming its line) or an I/O
+     * error; predictions of the rows before it may already be written.
+     */
+    const int width = this->model_.num_features();
+    const int threads = this->config_.threads;
+    BoundedQueue<char> window(this->config_.queue_chunks);  // One token per chunk between read and write.
+    BoundedQueue<TextChunk> text_queue(2*threads);
+    BoundedQueue<ParsedChunk> parsed_queue(2*threads);
+    BoundedQueue<ScoredChunk> scored_queue(2);
+    std::mutex error_mutex;
+    std::string error;
+    std::atomic<bool> failed(false);
+    auto fail = [&] (const std::string& message) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (error.empty()) { error = message; }
+        }
+        failed = true;
+        window.close();
+        text_queue.close();
+        parsed_queue.close();
+        scored_queue.close();
+    };
+    ScorerStats stats = {0, 0, 0, 0.0, 0.0, 0.0, 0.0};
+    const auto start = std::chrono::steady_clock::now();
+
+    // Read: chunks of whole lines, at most queue_chunks of them not yet written.
+    std::thread reader([&] () {
+        std::vector<char> carry;  // Start of a line that continues in the next read.
+        bool skip_header = this->config_.header;
+        bool eof = false;
+        while (!eof and !failed)
+        {
+            std::vector<char> text;
+            text.swap(carry);
+            const std::size_t filled = text.size();
+            text.resize(filled+this->config_.chunk_bytes);
+            const std::size_t n = std::fread(&text[filled], 1, this->config_.chunk_bytes, input);
+            text.resize(filled+n);
+            stats.bytes += n;
+            if (n < this->config_.chunk_bytes) {
+                if (std::ferror(input)) {
+                    fail("Cannot read the input");
+                    break;
+                }
+                eof = true;
+            }
+            if (eof and !text.empty() and (text.back() != '\n')) { text.push_back('\n'); }
+            auto last_newline = std::find(text.rbegin(), text.rend(), '\n');
+            if (last_newline == text.rend()) {
+                carry.swap(text);  // A line longer than a chunk: read on.
+                continue;
+            }
+            carry.assign(last_newline.base(), text.end());
+            text.erase(last_newline.base(), text.end());
+            if (skip_header) {
+                text.erase(text.begin(), std::find(text.begin(), text.end(), '\n')+1);
+                skip_header = false;
+            }
+            if (text.empty()) { continue; }
+            text.push_back('\0');
+            if (!window.push(0) or !text_queue.push(TextChunk{stats.chunks, std::move(text)})) { break; }
+            stats.chunks += 1;
+        }
+        text_queue.close();
+    });
+
+    // Parse: any number of chunks at once, in any order.
+    std::atomic<int> parsing(threads);
+    std::vector<std::thread> parsers;
+    for (int t = 0; t < threads; t++)
+    {
+        parsers.emplace_back([&] () {
+            TextChunk chunk;
+            while (!failed and text_queue.pop(chunk))
+            {
+                ParsedChunk parsed;
+                parsed.seq = chunk.seq;
+                parseChunk(chunk, width, this->config_.missing_as_nan, parsed);
+                if (!parsed_queue.push(std::move(parsed))) { break; }
+            }
+            if (--parsing == 0) { parsed_queue.close(); }
+        });
+    }
+
+    // Predict: chunks back in input order, one predict_batch call each.
+    std::thread predictor([&] () {
+        std::map<long long, ParsedChunk> reorder;  // At most queue_chunks entries (the window).
+        long long next = 0;
+        long long lines_before = this->config_.header ? 1 : 0;
+        ParsedChunk parsed;
+        while (!failed and parsed_queue.pop(parsed))
+        {
+            reorder.insert(std::make_pair(parsed.seq, std::move(parsed)));
+            while (!failed and !reorder.empty() and (reorder.begin()->first == next))
+            {
+                const ParsedChunk& chunk = reorder.begin()->second;
+                if (!chunk.error.empty()) {
+                    fail("Line "+std::to_string(lines_before+chunk.error_line)+": "+chunk.error);
+                    break;
+                }
+                ScoredChunk scored{next, std::vector<double>(chunk.rows)};
+                this->model_.predict_batch(chunk.values.data(), chunk.rows, width, scored.predictions.data());
+                stats.rows += chunk.rows;
+                lines_before += chunk.lines;
+                reorder.erase(reorder.begin());
+                next += 1;
+                if (!scored_queue.push(std::move(scored))) { break; }
+            }
+        }
+        scored_queue.close();
+    });
+
+    // Write (this thread): in order, then let the reader start one more chunk.
+    ScoredChunk scored;
+    std::vector<char> text;
+    char number[32];
+    while (scored_queue.pop(scored))
+    {
+        text.clear();
+        for (double prediction : scored.predictions)
+        {
+            const std::size_t length = formatPrediction(prediction, number);
+            text.insert(text.end(), number, number+length);
+        }
+        if (std::fwrite(text.data(), 1, text.size(), output) != text.size()) {
+            fail("Cannot write the output");
+            break;
+        }
+        char token;
+        window.pop(token);
+    }
+    if (!failed and (std::fflush(output) != 0)) { fail("Cannot write the output"); }
+
+    reader.join();
+    for (std::thread& parser : parsers) { parser.join(); }
+    predictor.join();
+    if (failed) {
+        throw std::runtime_error( error );
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.read_wait_seconds = window.push_wait_seconds() + text_queue.push_wait_seconds();
+    stats.parse_wait_seconds = parsed_queue.push_wait_seconds();
+    stats.predict_wait_seconds = scored_queue.push_wait_seconds();
+    return stats;
+}
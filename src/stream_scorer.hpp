@@ -0,0 +1,72 @@
+#ifndef STREAM_SCORER_HPP
+#define STREAM_SCORER_HPP
+
+#include "model.hpp"
+#include <cstddef>
+#include <cstdio>
+
+/*
+ * Streaming batch scoring of CSV rows with a TreeModel.
+ *
+ * Input is read in chunks of whole lines and flows through four stages joined by
+ * BoundedQueues (src/bounded_queue.hpp):
+ *     read (1 thread)  ->  parse (N threads)  ->  predict (1 thread)  ->  write (1 thread)
+ * Parse threads take chunks in any order; the predict stage puts them back in input order
+ * and scores each with one TreeModel::predict_batch call, so predictions come out one per
+ * input row, in input order. Every queue is bounded and at most queue_chunks chunks are
+ * in flight between read and write, so a slow stage (or a slow consumer of the output)
+ * stalls the reader instead of buffering the input in memory.
+ *
+ * Rows have num_features cells, or num_features+1 (a trailing label, ignored). Cells are
+ * numbers. Empty, "NA", "N/A", "NaN", "null" and "?" cells are missing values: with
+ * missing_as_nan they score as NaN, as DataLoader(path, true) loads them; otherwise they are
+ * rejected, since a default DataLoader dictionary-encodes them and their codes are unknown
+ * here. Blank lines are skipped. Category names are not accepted either, for the same
+ * reason, so categorical columns must be given as codes.
+ */
+
+struct ScorerConfig
+{
+    int threads;  // Parse threads.
+    std::size_t chunk_bytes;  // Bytes read at a time (a chunk is extended to the end of its last line).
+    int queue_chunks;  // Chunks in flight between read and write (bounds memory).
+    bool header;  // Skip the first line of the input.
+    bool missing_as_nan;  // Score missing cells as NaN (as DataLoader(path, true) loads them); else reject them.
+};
+
+ScorerConfig default_scorer_config();  // Hardware threads, 1 MiB chunks, 4 chunks per parse thread, no header, no NaN.
+
+struct ScorerStats
+{
+    long long rows;  // Rows scored.
+    long long bytes;  // Input bytes read.
+    long long chunks;  // Chunks read.
+    double seconds;  // Wall time.
+    double read_wait_seconds;  // Reader blocked on a full window/parse queue (the stages after it are slower).
+    double parse_wait_seconds;  // Parse threads blocked on a full predict queue.
+    double predict_wait_seconds;  // Predict stage blocked on a full write queue (the output is the bottleneck).
+};
+
+class StreamScorer
+{
+    /**
+     * Scores a CSV stream with a model (see above).
+     * */
+
+private:
+
+    // Attributes:
+    const TreeModel& model_;
+    ScorerConfig config_;
+
+public:
+
+    // Utilities:
+    ScorerStats score(std::FILE* input, std::FILE* output) const;  // One prediction per line of output (throws std::runtime_error).
+
+    // Constructors:
+    StreamScorer(const TreeModel& model, const ScorerConfig& config);
+
+};
+
+#endif
@@ -0,0 +1,408 @@
+#include "synthetic.hpp"
+#include "datasets.hpp"
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+/*
+ * ROW STREAMS :
+ */
+
+
+static uint64_t next_random(uint64_t& state)
+{
+    /** SplitMix64: advance the state and return 64 random bits. */
+    state += 0x9E3779B97F4A7C15ULL;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t row_state(uint64_t seed, uint64_t r)
+{
+    /** Starting state of the stream of row r (independent of every other row). */
+    uint64_t state = seed ^ 0x5DEECE66DULL;
+    uint64_t mixed = next_random(state) ^ r;
+    return next_random(mixed);
+}
+
+static double next_uniform(uint64_t& state)
+{
+    /** Uniform in [0, 1). */
+    return (next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double next_normal(uint64_t& state)
+{
+    /** Standard normal (Box-Muller, one value per call). */
+    double u = 1.0 - next_uniform(state);  // In (0, 1].
+    double v = next_uniform(state);
+    return std::sqrt(-2.0*std::log(u)) * std::cos(6.283185307179586*v);
+}
+
+
+/*
+ * SYNTHETIC GENERATOR - CONSTRUCTORS :
+ */
+
+
+SyntheticGenerator::SyntheticGenerator(
+    int64_t num_rows, int num_features, int num_classes, int cardinality,
+    double balance, double noise, double informative, double categorical,
+    int categorical_levels, double missing, uint64_t seed
+)
+{
+    /**
+     * Parametric mode. num_classes=0 gives a regression target; cardinality=0 gives
+     * continuous (standard normal) numeric features, otherwise integer values 0..cardinality-1.
+     * Throws std::invalid_argument on out-of-range parameters.
+     */
+    if ((num_rows < 0) or (num_features < 1)) {
+        throw std::invalid_argument( "Need num_rows>=0 and num_features>=1" );
+    }
+    if ((num_classes < 0) or (num_classes == 1) or (cardinality < 0) or (cardinality == 1) or (categorical_levels < 2)) {
+        throw std::invalid_argument( "Need num_classes 0 or >=2, cardinality 0 or >=2 and categorical_levels>=2" );
+    }
+    if ((balance <= 0.0) or (noise < 0.0) or (informative < 0.0) or (informative > 1.0)
+            or (categorical < 0.0) or (categorical > 1.0) or (missing < 0.0) or (missing >= 1.0)) {
+        throw std::invalid_argument( "Need balance>0, noise>=0, and informative, categorical, missing in [0,1]" );
+    }
+    this->num_rows_ = num_rows;
+    this->num_features_ = num_features;
+    this->num_classes_ = num_classes;
+    this->cardinality_ = cardinality;
+    this->balance_ = balance;
+    this->noise_ = noise;
+    this->informative_ = informative;
+    this->categorical_ = categorical;
+    this->categorical_levels_ = categorical_levels;
+    this->missing_ = missing;
+    this->seed_ = seed;
+    this->calibrate();
+}
+
+SyntheticGenerator::SyntheticGenerator(const DataFrame& source, int64_t num_rows, double jitter, uint64_t seed)
+{
+    /**
+     * Scaled mode: each row is a uniformly drawn source row (labels in right-most column).
+     * Columns with more than 16 distinct values get Gaussian noise of sd jitter*(column sd),
+     * clamped to the column range and rounded if the column holds integers only; other
+     * columns (binary flags, counts, codes) and the label are copied unchanged.
+     */
+    if ((source.length() == 0) or (source.width() < 2) or (num_rows < 0) or (jitter < 0.0)) {
+        throw std::invalid_argument( "Need a non-empty source with features, num_rows>=0 and jitter>=0" );
+    }
+    this->num_rows_ = num_rows;
+    this->num_features_ = source.width()-1;
+    this->cardinality_ = 0;
+    this->balance_ = 1.0;
+    this->noise_ = 0.0;
+    this->informative_ = 0.0;
+    this->categorical_ = 0.0;
+    this->categorical_levels_ = 2;
+    this->missing_ = 0.0;
+    this->seed_ = seed;
+    this->signal_sd_ = 0.0;
+    this->source_ = source.matrix();
+    const int width = source.width();
+    this->jitter_sd_.assign(width, 0.0);
+    this->column_min_.assign(width, 0.0);
+    this->column_max_.assign(width, 0.0);
+    this->integer_.assign(width, true);
+    std::vector<double> column(source.length());
+    for (int c = 0; c < width; c++)
+    {
+        double sum = 0.0;
+        for (int r = 0; r < source.length(); r++)
+        {
+            column[r] = this->source_[r][c];
+            sum += column[r];
+            this->integer_[c] = this->integer_[c] and (column[r] == std::floor(column[r]));
+        }
+        const double mean = sum / column.size();
+        double square = 0.0;
+        for (double v : column) { square += (v-mean)*(v-mean); }
+        std::sort(column.begin(), column.end());
+        this->column_min_[c] = column.front();
+        this->column_max_[c] = column.back();
+        const int distinct = std::unique(column.begin(), column.end()) - column.begin();
+        if ((c < width-1) and (distinct > 16)) {
+            this->jitter_sd_[c] = jitter * std::sqrt(square / column.size());
+        }
+        if (c == width-1) {
+            this->num_classes_ = (this->integer_[c] and (distinct <= 64)) ? distinct : 0;
+        }
+    }
+}
+
+void SyntheticGenerator::calibrate()
+{
+    /**
+     * Pick the informative and categorical features and their effects, then place the class
+     * cuts at quantiles of the signal (over 20000 draws) so that class k has a prior
+     * proportional to balance^k.
+     */
+    uint64_t state = row_state(this->seed_, ~(uint64_t)0);
+    const int num_features = this->num_features_;
+    std::vector<int> order(num_features);
+    for (int c = 0; c < num_features; c++) { order[c] = c; }
+    for (int c = num_features-1; c > 0; c--) { std::swap(order[c], order[next_random(state) % (c+1)]); }
+    const int num_categorical = (int)std::lround(this->categorical_ * num_features);
+    this->is_categorical_.assign(num_features, false);
+    for (int i = 0; i < num_categorical; i++) { this->is_categorical_[order[i]] = true; }
+    for (int c = num_features-1; c > 0; c--) { std::swap(order[c], order[next_random(state) % (c+1)]); }
+    const int num_informative = std::max(1, (int)std::lround(this->informative_ * num_features));
+    this->weights_.assign(num_features, 0.0);
+    for (int i = 0; i < num_informative; i++)
+    {
+        const double sign = (next_random(state) & 1) ? 1.0 : -1.0;
+        this->weights_[order[i]] = sign * (0.5 + next_uniform(state));
+    }
+    // Categorical level effects are standardized so every informative feature weighs alike:
+    this->level_effects_.assign((size_t)num_features*this->categorical_levels_, 0.0);
+    for (int c = 0; c < num_features; c++)
+    {
+        if (!this->is_categorical_[c]) { continue; }
+        double* effects = &this->level_effects_[(size_t)c*this->categorical_levels_];
+        double mean = 0.0, square = 0.0;
+        for (int l = 0; l < this->categorical_levels_; l++) { effects[l] = next_normal(state); mean += effects[l]; }
+        mean /= this->categorical_levels_;
+        for (int l = 0; l < this->categorical_levels_; l++) { square += (effects[l]-mean)*(effects[l]-mean); }
+        const double sd = std::max(std::sqrt(square / this->categorical_levels_), 1e-12);
+        for (int l = 0; l < this->categorical_levels_; l++) { effects[l] = (effects[l]-mean) / sd; }
+    }
+    // Distribution of the signal:
+    const int num_draws = 20000;
+    std::vector<double> signals(num_draws);
+    std::vector<double> row(num_features);
+    double mean = 0.0, square = 0.0;
+    for (int i = 0; i < num_draws; i++)
+    {
+        this->draw_features(state, &row[0]);
+        signals[i] = this->signal(&row[0]);
+        mean += signals[i];
+    }
+    mean /= num_draws;
+    for (double s : signals) { square += (s-mean)*(s-mean); }
+    this->signal_sd_ = std::sqrt(square / num_draws);
+    std::sort(signals.begin(), signals.end());
+    this->class_cuts_.clear();
+    double total = 0.0;
+    for (int k = 0; k < this->num_classes_; k++) { total += std::pow(this->balance_, k); }
+    double cumulative = 0.0;
+    for (int k = 0; k+1 < this->num_classes_; k++)
+    {
+        cumulative += std::pow(this->balance_, k) / total;
+        const int index = std::min(num_draws-1, (int)(cumulative * num_draws));
+        this->class_cuts_.push_back(signals[index]);
+    }
+}
+
+
+/*
+ * SYNTHETIC GENERATOR - ACCESSORS :
+ */
+
+
+int64_t SyntheticGenerator::length() const
+{
+    /** Number of rows generated. */
+    return this->num_rows_;
+}
+
+int SyntheticGenerator::width() const
+{
+    /** Number of columns, label included. */
+    return this->num_features_+1;
+}
+
+bool SyntheticGenerator::is_regression() const
+{
+    /** Whether the label is continuous. */
+    return this->num_classes_ == 0;
+}
+
+std::vector<int> SyntheticGenerator::categorical_columns() const
+{
+    /** Columns holding categorical codes 0..categorical_levels-1 (none in scaled mode). */
+    std::vector<int> columns;
+    for (int c = 0; c < (int)this->is_categorical_.size(); c++)
+    {
+        if (this->is_categorical_[c]) { columns.push_back(c); }
+    }
+    return columns;
+}
+
+
+/*
+ * SYNTHETIC GENERATOR - UTILITIES :
+ */
+
+
+void SyntheticGenerator::draw_features(uint64_t& state, double* row) const
+{
+    /** Feature values of one row (no missing cells yet), drawn from the given stream. */
+    for (int c = 0; c < this->num_features_; c++)
+    {
+        if (this->is_categorical_[c]) {
+            row[c] = (double)(next_random(state) % this->categorical_levels_);
+        } else if (this->cardinality_ == 0) {
+            row[c] = next_normal(state);
+        } else {
+            row[c] = (double)(next_random(state) % this->cardinality_);
+        }
+    }
+}
+
+double SyntheticGenerator::signal(const double* row) const
+{
+    /** Weighted sum of the informative features (integer levels rescaled to unit variance). */
+    double score = 0.0;
+    for (int c = 0; c < this->num_features_; c++)
+    {
+        const double weight = this->weights_[c];
+        if (weight == 0.0) { continue; }
+        if (this->is_categorical_[c]) {
+            score += weight * this->level_effects_[(size_t)c*this->categorical_levels_ + (int)row[c]];
+        } else if (this->cardinality_ == 0) {
+            score += weight * row[c];
+        } else {
+            const double levels = this->cardinality_;
+            score += weight * (row[c] - (levels-1)/2) * std::sqrt(12.0 / (levels*levels - 1));
+        }
+    }
+    return score;
+}
+
+void SyntheticGenerator::fill_row(int64_t r, double* row) const
+{
+    /** Write the width() values of row r (label last); the same r always gives the same row. */
+    assert ((r >= 0) and (r < this->num_rows_));
+    uint64_t state = row_state(this->seed_, (uint64_t)r);
+    const int num_features = this->num_features_;
+    if (!this->source_.empty()) {
+        // Scaled mode:
+        const std::vector<double>& source_row = this->source_[next_random(state) % this->source_.size()];
+        for (int c = 0; c <= num_features; c++)
+        {
+            double value = source_row[c];
+            if (this->jitter_sd_[c] > 0.0) {
+                value += this->jitter_sd_[c] * next_normal(state);
+                if (this->integer_[c]) { value = std::round(value); }
+                value = std::min(std::max(value, this->column_min_[c]), this->column_max_[c]);
+            }
+            row[c] = value;
+        }
+        return;
+    }
+    this->draw_features(state, row);
+    const double score = this->signal(row);
+    if (this->num_classes_ == 0) {
+        row[num_features] = score + this->noise_ * this->signal_sd_ * next_normal(state);
+    } else if (next_uniform(state) < this->noise_) {
+        row[num_features] = (double)(next_random(state) % this->num_classes_);
+    } else {
+        row[num_features] = (double)(std::upper_bound(this->class_cuts_.begin(), this->class_cuts_.end(), score) - this->class_cuts_.begin());
+    }
+    // Cells go missing after the label is drawn, so missingness carries no signal:
+    if (this->missing_ > 0.0) {
+        for (int c = 0; c < num_features; c++)
+        {
+            if (next_uniform(state) < this->missing_) { row[c] = std::numeric_limits<double>::quiet_NaN(); }
+        }
+    }
+}
+
+DataFrame SyntheticGenerator::generate() const
+{
+    /** All rows as a DataFrame (label in right-most column). */
+    return this->generate(0, this->num_rows_);
+}
+
+DataFrame SyntheticGenerator::generate(int64_t begin, int64_t end) const
+{
+    /** Rows [begin, end) as a DataFrame (label in right-most column). */
+    if ((begin < 0) or (end > this->num_rows_) or (begin > end) or (end-begin > std::numeric_limits<int>::max())) {
+        throw std::invalid_argument( "Row range ["+std::to_string(begin)+", "+std::to_string(end)+") out of range" );
+    }
+    DataFrame dataframe = DataFrame();
+    std::vector<double> row(this->width());
+    for (int64_t r = begin; r < end; r++)
+    {
+        this->fill_row(r, &row[0]);
+        dataframe.addRow(new DataVector(row, true));
+    }
+    return dataframe;
+}
+
+void SyntheticGenerator::save(const std::string& path, int64_t chunk_rows) const
+{
+    /**
+     * Write all rows as a binary frame: "PDTD", uint32 version, uint32 width, int64 rows,
+     * then the rows as little-endian doubles, row-major. Rows are produced chunk_rows at a
+     * time, so memory does not grow with length().
+     */
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error( "Cannot open data file for writing: "+path );
+    }
+    const uint32_t header[2] = {1, (uint32_t)this->width()};
+    file.write("PDTD", 4);
+    file.write((const char*)header, sizeof(header));
+    file.write((const char*)&this->num_rows_, sizeof(int64_t));
+    chunk_rows = std::max<int64_t>(chunk_rows, 1);
+    std::vector<double> chunk;
+    for (int64_t begin = 0; begin < this->num_rows_; begin += chunk_rows)
+    {
+        const int64_t end = std::min(begin + chunk_rows, this->num_rows_);
+        chunk.resize((size_t)(end-begin)*this->width());
+        for (int64_t r = begin; r < end; r++) { this->fill_row(r, &chunk[(size_t)(r-begin)*this->width()]); }
+        file.write((const char*)chunk.data(), chunk.size()*sizeof(double));
+    }
+    if (!file) {
+        throw std::runtime_error( "Failed to write data file: "+path );
+    }
+}
+
+DataFrame load_binary_frame(const std::string& path)
+{
+    /** Read a frame written by SyntheticGenerator::save (throws std::runtime_error). */
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error( "Cannot open data file: "+path );
+    }
+    char magic[4];
+    uint32_t header[2] = {0, 0};
+    int64_t num_rows = 0;
+    file.read(magic, 4);
+    file.read((char*)header, sizeof(header));
+    file.read((char*)&num_rows, sizeof(int64_t));
+    if (!file or (std::memcmp(magic, "PDTD", 4) != 0)) {
+        throw std::runtime_error( "Not a binary data file: "+path );
+    }
+    if (header[0] != 1) {
+        throw std::runtime_error( "Unsupported data file version "+std::to_string(header[0])+" in "+path );
+    }
+    if ((header[1] < 1) or (num_rows < 0) or (num_rows > std::numeric_limits<int>::max())) {
+        throw std::runtime_error( "Corrupt data file: "+path );
+    }
+    DataFrame dataframe = DataFrame();
+    std::vector<double> row(header[1]);
+    for (int64_t r = 0; r < num_rows; r++)
+    {
+        file.read((char*)row.data(), row.size()*sizeof(double));
+        if (!file) {
+            throw std::runtime_error( "Truncated data file: "+path );
+        }
+        dataframe.addRow(new DataVector(row, true));
+    }
+    return dataframe;
+}
@@ -0,0 +1,83 @@
+#ifndef SYNTHETIC_HPP
+#define SYNTHETIC_HPP
+
+#include "datasets.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class SyntheticGenerator
+{
+    /**
+     * Deterministic generator of benchmark workloads with any number of rows.
+     * Every row is drawn from its own random stream (seeded by the generator seed and
+     * the row index), so a row's values do not depend on how many rows are generated,
+     * in what order, or in which chunk, and files of millions of rows are written
+     * without holding them in memory.
+     *
+     * Two modes:
+     *  - parametric: F features of given cardinality, of which a fraction is informative
+     *    (the label is a function of those) and a fraction is categorical (integer codes
+     *    whose effect on the label is not monotonic), with class balance, label noise and
+     *    missing cells (NaN) under control;
+     *  - scaled: rows resampled from a real dataset (e.g. hmeq) with continuous columns
+     *    jittered, so the data keeps the source's marginals and correlations.
+     * */
+
+private:
+
+    // Attributes:
+    int64_t num_rows_;  // Number of rows to generate.
+    int num_features_;  // Number of feature columns (label excluded).
+    int num_classes_;  // Number of classes, or 0 for a regression target.
+    int cardinality_;  // Distinct values of each numeric feature (0 for continuous values).
+    double balance_;  // Prior of class k is proportional to balance^k (1 for balanced classes).
+    double noise_;  // Probability of a random label (classification), or noise sd relative to the signal sd (regression).
+    double informative_;  // Fraction of features that the label depends on.
+    double categorical_;  // Fraction of features that are categorical codes.
+    int categorical_levels_;  // Number of levels of each categorical feature.
+    double missing_;  // Probability that a feature cell is missing (NaN).
+    uint64_t seed_;  // Seed of every row stream.
+    std::vector<bool> is_categorical_;  // Parametric: whether each feature is categorical.
+    std::vector<double> weights_;  // Parametric: signal weight of each feature (0 for uninformative ones).
+    std::vector<double> level_effects_;  // Parametric: effect of level l of feature c at [c*categorical_levels_+l].
+    std::vector<double> class_cuts_;  // Parametric: quantiles of the signal that separate the classes.
+    double signal_sd_;  // Parametric: standard deviation of the signal.
+    std::vector<std::vector<double>> source_;  // Scaled: rows of the source dataset (label last).
+    std::vector<double> jitter_sd_;  // Scaled: noise sd of each column (0 for discrete columns and the label).
+    std::vector<double> column_min_;  // Scaled: smallest value of each column (jittered values are clamped).
+    std::vector<double> column_max_;  // Scaled: largest value of each column.
+    std::vector<bool> integer_;  // Scaled: columns with integer values only (jittered values are rounded).
+
+    // Utilities:
+    void draw_features(uint64_t& state, double* row) const;  // Parametric: feature values of a row, before missing cells.
+    double signal(const double* row) const;  // Parametric: noiseless score of a row.
+    void calibrate();  // Parametric: draw weights and level effects, and place the class cuts.
+
+public:
+
+    // Accessors:
+    int64_t length() const;  // Number of rows generated.
+    int width() const;  // Number of columns, label included.
+    bool is_regression() const;  // Whether the label is continuous.
+    std::vector<int> categorical_columns() const;  // Columns holding categorical codes (for typed::make_tree).
+
+    // Utilities:
+    void fill_row(int64_t r, double* row) const;  // Write the width() values of row r (label last).
+    DataFrame generate() const;  // All rows as a DataFrame (label in right-most column).
+    DataFrame generate(int64_t begin, int64_t end) const;  // Rows [begin, end) as a DataFrame.
+    void save(const std::string& path, int64_t chunk_rows=65536) const;  // Write all rows as a binary frame (throws std::runtime_error).
+
+    // Constructors:
+    SyntheticGenerator(
+        int64_t num_rows, int num_features, int num_classes=2, int cardinality=0,
+        double balance=1.0, double noise=0.1, double informative=0.5, double categorical=0.0,
+        int categorical_levels=16, double missing=0.0, uint64_t seed=42
+    );
+    SyntheticGenerator(const DataFrame& source, int64_t num_rows, double jitter=0.05, uint64_t seed=42);  // Scaled mode.
+
+};
+
+DataFrame load_binary_frame(const std::string& path);  // Read a frame written by SyntheticGenerator::save (throws std::runtime_error).
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Timeline tracing of tree growth, exported as Chrome trace JSON (chrome://tracing, Perfetto).
+ *
+ * A TraceScope records one complete event (name, category, start, duration, one integer
+ * argument) into the ring buffer of its thread when it closes; scopes of a thread nest like
+ * the calls they wrap. Each buffer belongs to one thread, so recording takes no lock (only a
+ * thread's first event registers its buffer). A full buffer overwrites its oldest events.
+ *
+ * The facility only exists when compiled with -DPDT_TRACE; otherwise TraceScope is an empty
+ * class and nothing is recorded.
+ */
+
+struct TraceEvent
+{
+    /** One complete ("ph":"X") event. */
+    const char* name;  // Static string.
+    const char* category;  // Static string.
+    int64_t start_ns;  // Since the trace epoch.
+    int64_t duration_ns;
+    int64_t arg;  // Event argument (feature, fold, depth, rows...), or -1 for none.
+};
+
+
+/*
+ * PER-THREAD RING BUFFERS :
+ */
+
+class TraceBuffer
+{
+    /** Events of one thread, overwriting the oldest beyond capacity. */
+
+private:
+
+    // Attributes:
+    std::vector<TraceEvent> events_;  // Ring storage.
+    uint64_t written_;  // Events recorded since the last clear.
+    int thread_;  // Index of the thread (order of first event).
+
+public:
+
+    // Accessors:
+    int thread() const { return this->thread_; }
+    uint64_t written() const { return this->written_; }
+    uint64_t dropped() const { return (this->written_ > this->events_.size()) ? this->written_ - this->events_.size() : 0; }
+
+    // Utilities:
+    void record(const TraceEvent& event)
+    {
+        this->events_[this->written_ % this->events_.size()] = event;
+        this->written_ += 1;
+    }
+    std::vector<TraceEvent> events() const
+    {
+        /** Retained events, oldest first. */
+        std::vector<TraceEvent> out;
+        const uint64_t first = this->dropped();
+        for (uint64_t i = first; i < this->written_; i++) { out.push_back(this->events_[i % this->events_.size()]); }
+        return out;
+    }
+    void clear() { this->written_ = 0; }
+
+    // Constructors:
+    TraceBuffer(int thread, size_t capacity) : events_(capacity), written_(0), thread_(thread) {}
+
+};
+
+class Tracer
+{
+    /** Registry of the thread buffers, and the export. */
+
+private:
+
+    static std::mutex& mutex() { static std::mutex m; return m; }
+    static std::vector<std::unique_ptr<TraceBuffer>>& buffers() { static std::vector<std::unique_ptr<TraceBuffer>> b; return b; }
+
+public:
+
+    static const size_t kCapacity = 1 << 16;  // Events kept per thread.
+
+    static bool enabled()
+    {
+        /** Whether tracing was compiled in (-DPDT_TRACE). */
+#ifdef PDT_TRACE
+        return true;
+#else
+        return false;
+#endif
+    }
+    static int64_t now_ns()
+    {
+        /** Nanoseconds since the trace epoch (first call). */
+        static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+    static TraceBuffer& thread_buffer()
+    {
+        /** Buffer of the calling thread, registered on first use (owned by the registry, so it outlives the thread). */
+        thread_local TraceBuffer* buffer = nullptr;
+        if (buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex());
+            buffers().emplace_back(new TraceBuffer((int)buffers().size(), kCapacity));
+            buffer = buffers().back().get();
+        }
+        return *buffer;
+    }
+    static void clear()
+    {
+        /** Drop every recorded event (no thread may be recording). */
+        std::lock_guard<std::mutex> lock(mutex());
+        for (std::unique_ptr<TraceBuffer>& b : buffers()) { b->clear(); }
+    }
+    static uint64_t dropped()
+    {
+        /** Events overwritten because a buffer was full. */
+        std::lock_guard<std::mutex> lock(mutex());
+        uint64_t total = 0;
+        for (const std::unique_ptr<TraceBuffer>& b : buffers()) { total += b->dropped(); }
+        return total;
+    }
+    static size_t write_chrome_json(const std::string& path)
+    {
+        /**
+         * Write every retained event as Chrome trace JSON (no thread may be recording);
+         * returns the number of events. Throws std::runtime_error if the file cannot be written.
+         */
+        std::ofstream file(path);
+        if (!file) {
+            throw std::runtime_error( "Cannot open trace file for writing: "+path );
+        }
+        std::lock_guard<std::mutex> lock(mutex());
+        size_t count = 0;
+        file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"paralleldecisiontrees\"}}";
+        for (const std::unique_ptr<TraceBuffer>& b : buffers())
+        {
+            file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->thread()
+                 << ",\"args\":{\"name\":\"thread " << b->thread() << "\"}}";
+            for (const TraceEvent& e : b->events())
+            {
+                // Chrome trace times are microseconds (fractions allowed):
+                file << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"" << e.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->thread()
+                     << ",\"ts\":" << e.start_ns / 1000 << "." << std::to_string(1000 + e.start_ns % 1000).substr(1)
+                     << ",\"dur\":" << e.duration_ns / 1000 << "." << std::to_string(1000 + e.duration_ns % 1000).substr(1);
+                if (e.arg != -1) { file << ",\"args\":{\"value\":" << e.arg << "}"; }
+                file << "}";
+                count += 1;
+            }
+        }
+        file << "\n]}\n";
+        if (!file) {
+            throw std::runtime_error( "Failed to write trace file: "+path );
+        }
+        return count;
+    }
+
+};
+
+
+/*
+ * SCOPES :
+ */
+
+#ifdef PDT_TRACE
+
+class TraceScope
+{
+    /** Records the enclosing region as one event of the calling thread. */
+
+private:
+
+    // Attributes:
+    const char* name_;
+    const char* category_;
+    int64_t arg_;
+    int64_t start_ns_;
+    bool running_;
+
+public:
+
+    void stop()
+    {
+        /** Close the event early (the destructor then does nothing). */
+        if (!this->running_) {
+            return;
+        }
+        this->running_ = false;
+        const int64_t end_ns = Tracer::now_ns();
+        Tracer::thread_buffer().record({this->name_, this->category_, this->start_ns_, end_ns - this->start_ns_, this->arg_});
+    }
+
+    TraceScope(const char* name, const char* category, int64_t arg=-1)
+        : name_(name), category_(category), arg_(arg), start_ns_(Tracer::now_ns()), running_(true) {}
+    ~TraceScope() { this->stop(); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+};
+
+#else
+
+class TraceScope
+{
+    /** Compiled out: no state, no work. */
+public:
+    void stop() {}
+    TraceScope(const char*, const char*, int64_t=-1) {}
+};
+
+#endif
+
+#endif
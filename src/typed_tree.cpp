@@ -0,0 +1,94 @@
+#include "typed_tree.hpp"
+#include "datasets.hpp"
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <cstdint>
+
+namespace typed {
+
+
+/*
+ * RUNTIME-CONFIGURED WRAPPER :
+ */
+
+
+template<class Loss, class FeatureT, class LabelT>
+static std::unique_ptr<AnyTree> train_(
+    const DataFrame& dataframe, const std::string& name,
+    int mtry, int max_height, int max_leaves, int min_obs, double max_prop, int seed, const std::vector<int>& categorical,
+    const std::vector<int>& counts
+)
+{
+    /** Train one instantiation and wrap it. */
+    typedef DecisionTree<Loss,FeatureT,LabelT> Tree;
+    return std::unique_ptr<AnyTree>(new AnyTreeImpl<Tree>(
+        Tree(dataframe, mtry, max_height, max_leaves, min_obs, max_prop, seed, categorical, counts), name
+    ));
+}
+
+template<class Loss, class FeatureT>
+static std::unique_ptr<AnyTree> train_classifier_(
+    const DataFrame& dataframe, const std::string& name,
+    int mtry, int max_height, int max_leaves, int min_obs, double max_prop, int seed, const std::vector<int>& categorical,
+    const std::vector<int>& counts
+)
+{
+    /** Classification labels as uint8_t class indices, or int32_t past 256 classes. */
+    std::vector<double> classes = dataframe.col(-1).vector();
+    std::sort(classes.begin(), classes.end());
+    if (std::unique(classes.begin(), classes.end()) - classes.begin() <= 256) {
+        return train_<Loss,FeatureT,uint8_t>(dataframe, name+",uint8", mtry, max_height, max_leaves, min_obs, max_prop, seed, categorical, counts);
+    }
+    return train_<Loss,FeatureT,int32_t>(dataframe, name+",int32", mtry, max_height, max_leaves, min_obs, max_prop, seed, categorical, counts);
+}
+
+template<class FeatureT>
+static std::unique_ptr<AnyTree> train_any_(
+    const DataFrame& dataframe, bool regression, const std::string& loss, const std::string& feature_type,
+    int mtry, int max_height, int max_leaves, int min_obs, double max_prop, int seed, const std::vector<int>& categorical,
+    const std::vector<int>& counts
+)
+{
+    /** Select the loss policy (same validation as ::DecisionTree). */
+    if (regression) {
+        if (loss=="mean_squared_error") {
+            return train_<MeanSquaredError,FeatureT,double>(dataframe, loss+","+feature_type+",double", mtry, max_height, max_leaves, min_obs, max_prop, seed, categorical, counts);
+        }
+        throw std::invalid_argument( "Received invalid loss method for regression tree: "+loss );
+    }
+    if (loss=="gini_impurity") {
+        return train_classifier_<GiniImpurity,FeatureT>(dataframe, loss+","+feature_type, mtry, max_height, max_leaves, min_obs, max_prop, seed, categorical, counts);
+    } else if (loss=="cross_entropy") {
+        return train_classifier_<CrossEntropy,FeatureT>(dataframe, loss+","+feature_type, mtry, max_height, max_leaves, min_obs, max_prop, seed, categorical, counts);
+    } else if (loss=="misclassification_error") {
+        return train_classifier_<MisclassificationError,FeatureT>(dataframe, loss+","+feature_type, mtry, max_height, max_leaves, min_obs, max_prop, seed, categorical, counts);
+    }
+    throw std::invalid_argument( "Received invalid loss method for classification tree: "+loss );
+}
+
+std::unique_ptr<AnyTree> make_tree(
+    const DataFrame& dataframe, bool regression, std::string loss,
+    int mtry, int max_height, int max_leaves, int min_obs, double max_prop, int seed, bool single_precision,
+    const std::vector<int>& categorical, const std::vector<int>& counts
+)
+{
+    /**
+     * Train the compile-time specialized tree matching the runtime arguments.
+     * Arguments are the same as ::DecisionTree; single_precision stores features as float
+     * and categorical lists the dictionary-encoded feature columns to split by category
+     * subset (e.g. DataLoader::categorical_columns()). counts gives the number of copies
+     * of each row when training on DataFrame::deduplicate output.
+     * The instantiations compiled here are
+     *     {GiniImpurity, CrossEntropy, MisclassificationError} x {double, float} x {uint8_t, int32_t}
+     *     MeanSquaredError x {double, float} x double
+     */
+    if (single_precision) {
+        return train_any_<float>(dataframe, regression, loss, "float", mtry, max_height, max_leaves, min_obs, max_prop, seed, categorical, counts);
+    }
+    return train_any_<double>(dataframe, regression, loss, "double", mtry, max_height, max_leaves, min_obs, max_prop, seed, categorical, counts);
+}
+
+}  // namespace typed
@@ -0,0 +1,843 @@
+#ifndef TYPED_TREE_HPP
+#define TYPED_TREE_HPP
+
+#include "datasets.hpp"
+#include "impurity.hpp"
+#include "model.hpp"
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Compile-time specialized decision trees.
+ *
+ * typed::DecisionTree<Loss, FeatureT, LabelT> trains the same trees as ::DecisionTree,
+ * but the loss is a policy type instead of a string, feature values are stored as
+ * FeatureT (e.g. float) and labels as LabelT (class indices such as uint8_t, or the
+ * regression target type). The split sweep calls Loss::split_loss directly, so the
+ * compiler inlines it into the loop over sorted rows for each loss separately.
+ *
+ * Columns listed as categorical hold category codes (as produced by DataLoader's
+ * dictionary encoding) and are split by category subset instead of by threshold:
+ * the node's categories are ordered by their share of the node's majority class
+ * (classification) or by mean target (regression), and the best prefix of that order
+ * is sent left. For two classes and for regression this is the optimal subset split
+ * (Breiman et al., 1984) found in one pass over the rows plus a sort of the categories;
+ * for more classes it is a heuristic.
+ *
+ * Missing values (NaN, as loaded by DataLoader from empty or "NA" cells) are routed
+ * instead of dropped: each split learns a default direction for them from the same
+ * sweep that scores its thresholds, and prediction follows it. On data without NaN the
+ * trees are unchanged (and every default direction is right, like DataFrame::split).
+ *
+ * typed::make_tree() is the runtime-configured entry point: it takes the same
+ * arguments as ::DecisionTree and instantiates one of the common combinations.
+ */
+
+namespace typed {
+
+
+/*
+ * NODE STATISTICS :
+ */
+
+
+template<class LabelT>
+struct ClassStats
+{
+    /** Class counts of a set of rows (labels are class indices 0..num_classes-1). */
+
+    // Attributes:
+    int size;  // Number of rows (copies of duplicated rows included).
+    std::vector<int32_t> counts;  // Rows per class.
+
+    // Utilities:
+    void reset(int num_classes) { this->size = 0; this->counts.assign(num_classes, 0); }
+    void add(LabelT label, int weight=1) { this->size += weight; this->counts[label] += weight; }  // Add `weight` copies of a row.
+    void add_difference(const ClassStats& all, const ClassStats& some)  // Add the rows of `all` that are not in `some`.
+    {
+        this->size += all.size - some.size;
+        for (int k = 0; k < (int)this->counts.size(); k++) { this->counts[k] += all.counts[k] - some.counts[k]; }
+    }
+    void merge(const ClassStats& other)  // Add the rows of `other`.
+    {
+        this->size += other.size;
+        for (int k = 0; k < (int)this->counts.size(); k++) { this->counts[k] += other.counts[k]; }
+    }
+    bool pure() const { return *std::max_element(this->counts.begin(), this->counts.end())==this->size; }
+    double majority() const { return *std::max_element(this->counts.begin(), this->counts.end()) / (double)this->size; }
+    int prediction() const { return std::max_element(this->counts.begin(), this->counts.end()) - this->counts.begin(); }  // First (smallest) majority class.
+};
+
+template<class LabelT>
+struct MomentStats
+{
+    /** Sum and sum of squares of the targets of a set of rows. */
+
+    // Attributes:
+    int size;  // Number of rows (copies of duplicated rows included).
+    double sum;  // Sum of targets.
+    double square;  // Sum of squared targets.
+    LabelT low;  // Smallest target.
+    LabelT high;  // Largest target.
+
+    // Utilities:
+    void reset(int)  // Empty set: low/high at +/-infinity (the type's extremes for integer targets).
+    {
+        typedef std::numeric_limits<LabelT> limits;
+        this->size = 0;
+        this->sum = 0.0;
+        this->square = 0.0;
+        this->low = limits::has_infinity ? limits::infinity() : limits::max();
+        this->high = limits::has_infinity ? -limits::infinity() : limits::lowest();
+    }
+    void add(LabelT label, int weight=1)  // Add `weight` copies of a row.
+    {
+        this->low = (this->size==0) ? label : std::min(this->low, label);
+        this->high = (this->size==0) ? label : std::max(this->high, label);
+        this->size += weight;
+        this->sum += (double)label*weight;
+        this->square += (double)label*label*weight;
+    }
+    void add_difference(const MomentStats& all, const MomentStats& some)  // Add the rows of `all` that are not in `some` (low/high unchanged).
+    {
+        this->size += all.size - some.size;
+        this->sum += all.sum - some.sum;
+        this->square += all.square - some.square;
+    }
+    void merge(const MomentStats& other)  // Add the rows of `other`.
+    {
+        if (other.size==0) { return; }
+        this->low = (this->size==0) ? other.low : std::min(this->low, other.low);
+        this->high = (this->size==0) ? other.high : std::max(this->high, other.high);
+        this->size += other.size;
+        this->sum += other.sum;
+        this->square += other.square;
+    }
+    bool pure() const { return this->low==this->high; }
+    double majority() const { return 1.0; }  // Not defined for regression (max_prop is classification only).
+    double prediction() const { return this->sum / this->size; }
+};
+
+template<class LabelT>
+double category_key(const ClassStats<LabelT>& stats, int target)
+{
+    /** Order of a category in a subset split: its share of class `target`. */
+    return stats.counts[target] / (double)stats.size;
+}
+
+template<class LabelT>
+double category_key(const MomentStats<LabelT>& stats, int)
+{
+    /** Order of a category in a subset split: its mean target. */
+    return stats.sum / stats.size;
+}
+
+
+/*
+ * LOSS POLICIES :
+ *
+ * split_loss(left, node, table) returns the weighted child loss of sending the rows
+ * counted in `left` to the left child (and the rest of `node` to the right), with the
+ * same operations in the same order as the threshold kernels in impurity.cpp, so both
+ * engines pick the same splits.
+ */
+
+
+struct GiniImpurity
+{
+    /** Gini impurity: sum_k p_k*(1-p_k). */
+    static const bool classification = true;
+    template<class LabelT> using Stats = ClassStats<LabelT>;
+
+    template<class LabelT>
+    static double split_loss(const ClassStats<LabelT>& left, const ClassStats<LabelT>& node, const EntropyTable&)
+    {
+        const double total = node.size;
+        const double n_left = left.size;
+        const double n_right = total - n_left;
+        double left_loss = 0;
+        double right_loss = 0;
+        for (int k = 0; k < (int)node.counts.size(); k++)
+        {
+            double p_left = left.counts[k] / n_left;
+            double p_right = (node.counts[k] - left.counts[k]) / n_right;
+            left_loss += p_left*(1-p_left);
+            right_loss += p_right*(1-p_right);
+        }
+        return (left_loss*n_left/total) + (right_loss*n_right/total);
+    }
+};
+
+struct MisclassificationError
+{
+    /** Misclassification error: 1 - max_k p_k. */
+    static const bool classification = true;
+    template<class LabelT> using Stats = ClassStats<LabelT>;
+
+    template<class LabelT>
+    static double split_loss(const ClassStats<LabelT>& left, const ClassStats<LabelT>& node, const EntropyTable&)
+    {
+        const double total = node.size;
+        const double n_left = left.size;
+        const double n_right = total - n_left;
+        int32_t max_left = 0;
+        int32_t max_right = 0;
+        for (int k = 0; k < (int)node.counts.size(); k++)
+        {
+            max_left = std::max(max_left, left.counts[k]);
+            max_right = std::max(max_right, node.counts[k] - left.counts[k]);
+        }
+        double left_loss = (n_left - max_left) / n_left;
+        double right_loss = (n_right - max_right) / n_right;
+        return (left_loss*n_left/total) + (right_loss*n_right/total);
+    }
+};
+
+struct CrossEntropy
+{
+    /** Cross entropy, weighted by child size through n*log2(n) lookups (see EntropyTable). */
+    static const bool classification = true;
+    template<class LabelT> using Stats = ClassStats<LabelT>;
+
+    template<class LabelT>
+    static double split_loss(const ClassStats<LabelT>& left, const ClassStats<LabelT>& node, const EntropyTable& table)
+    {
+        const int n_left = left.size;
+        const int n_right = node.size - n_left;
+        double left_loss = table.nlog2n(n_left);
+        double right_loss = table.nlog2n(n_right);
+        for (int k = 0; k < (int)node.counts.size(); k++)
+        {
+            left_loss -= table.nlog2n(left.counts[k]);
+            right_loss -= table.nlog2n(node.counts[k] - left.counts[k]);
+        }
+        return (left_loss + right_loss) / (double)node.size;
+    }
+};
+
+struct MeanSquaredError
+{
+    /** Mean squared error around the child means (regression). */
+    static const bool classification = false;
+    template<class LabelT> using Stats = MomentStats<LabelT>;
+
+    template<class LabelT>
+    static double split_loss(const MomentStats<LabelT>& left, const MomentStats<LabelT>& node, const EntropyTable&)
+    {
+        const double total = node.size;
+        const double n_left = left.size;
+        const double n_right = total - n_left;
+        const double s_right = node.sum - left.sum;
+        const double q_right = node.square - left.square;
+        double left_loss = std::max(0.0, (left.square - left.sum*left.sum/n_left)/n_left);
+        double right_loss = std::max(0.0, (q_right - s_right*s_right/n_right)/n_right);
+        return (left_loss*n_left/total) + (right_loss*n_right/total);
+    }
+};
+
+
+/*
+ * DECISION TREE :
+ */
+
+
+template<class FeatureT, class LabelT>
+struct SortEntry
+{
+    /** One row of a column being swept: ordered by value, then label (like std::pair). */
+    FeatureT value;  // Feature value.
+    LabelT label;  // Class index or target.
+    int32_t weight;  // Number of copies of the row.
+    bool operator<(const SortEntry& other) const
+    {
+        return (this->value < other.value) or (!(other.value < this->value) and (this->label < other.label));
+    }
+};
+
+
+template<class FeatureT>
+struct Node
+{
+    /** One node of a trained tree (nodes are stored in pre-order, root first). */
+    int feature;  // Splitting column, or -1 for a leaf.
+    FeatureT threshold;  // Rows with value <= threshold go left.
+    int left;  // Index of the left child (-1 for a leaf).
+    int right;  // Index of the right child (-1 for a leaf).
+    double value;  // Prediction at this node (majority label or mean target).
+    int size;  // Number of training rows (copies of duplicated rows included).
+    int categories;  // Offset of the left-going category set in the tree's category words, or -1 for a threshold split.
+    bool default_left;  // Rows missing the feature (NaN) go left.
+};
+
+template<class Loss, class FeatureT, class LabelT>
+class DecisionTree
+{
+    /**
+     * A decision tree whose loss, feature type and label type are fixed at compile time.
+     * Same hyperparameters, stopping rules, tie-breaking and random feature order
+     * (for a given seed) as ::DecisionTree; nodes are kept in one flat vector.
+     * */
+
+public:
+
+    typedef typename Loss::template Stats<LabelT> Stats;
+
+private:
+
+    // Attributes:
+    std::vector<Node<FeatureT>> nodes_;  // Trained nodes, pre-order.
+    std::vector<double> classes_;  // Original label value of each class index (classification).
+    int num_features_;  // Number of feature columns.
+    std::vector<int> cardinality_;  // Number of categories of each categorical column (0 for numeric columns).
+    std::vector<uint64_t> category_words_;  // Category sets of categorical splits ({num_categories, bit words...} each).
+    int height_;  // Height of tree (a single leaf has height 1).
+    int mtry_;  // Hyperparameter: Number of features to use at each split.
+    int max_height_;  // Stopping condition: max height of tree.
+    int max_leaves_;  // Stopping condition: max number of leaves.
+    int min_obs_;  // Stopping condition: minimum number of observations in a leaf.
+    double max_prop_;  // Stopping condition: maximum proportion of majority class in a leaf.
+    int num_leaves_;  // State variable: Number of leaves currently in tree.
+    SeedGenerator seed_gen_;  // Random seed generator (same sequence as ::DecisionTree).
+
+    // Training state (released after fitting):
+    int num_rows_;  // Number of training rows.
+    std::vector<FeatureT> features_;  // Column-major feature values.
+    std::vector<LabelT> labels_;  // Label (class index or target) of each row.
+    std::vector<int32_t> weights_;  // Number of copies of each row (all 1 unless counts are given).
+    std::vector<int32_t> rows_;  // Row ids, partitioned in place so every node owns a range.
+    std::vector<SortEntry<FeatureT,LabelT>> pairs_;  // Scratch: sorted (value, label, weight) of one column.
+    std::vector<Stats> category_stats_;  // Scratch: statistics of each category of one column.
+    std::vector<int> category_order_;  // Scratch: categories present at the node, in sweep order.
+    std::vector<int> best_categories_;  // Left-going categories of the best categorical split so far.
+    EntropyTable table_;  // n*log2(n) lookups (CrossEntropy only).
+
+    // Utilities:
+    int fit_(int begin, int end, int depth);  // Grow the subtree over rows_[begin,end) and return its index.
+    bool findBestSplit(int begin, int end, int* feature, FeatureT* threshold, bool* default_left);  // Best split over rows_[begin,end).
+    void sweepCategories_(int begin, int end, int col, bool* first_pass, double* best_loss, int* feature, bool* default_left);  // Best subset split of one categorical column.
+
+public:
+
+    // Constructors:
+    DecisionTree(
+        const DataFrame& dataframe, int mtry=-1, int max_height=-1, int max_leaves=-1,
+        int min_obs=-1, double max_prop=-1, int seed=-1,
+        const std::vector<int>& categorical=std::vector<int>(),
+        const std::vector<int>& counts=std::vector<int>()
+    );
+
+    // Getters:
+    int getSize() const;  // Number of nodes in tree.
+    int getHeight() const;  // Height of tree.
+    int getNumLeaves() const;  // Number of leaves.
+    const std::vector<Node<FeatureT>>& nodes() const;  // Trained nodes, pre-order.
+    const std::vector<uint64_t>& category_words() const;  // Category sets of categorical splits.
+    TreeModel model() const;  // Trained tree as a serializable model.
+
+    // Utilities:
+    template<class T> double predict(const T* observation) const;  // Prediction for one row of feature values.
+    DataVector predict(DataFrame* testdata) const;  // Perform prediction sequentially on each observation.
+
+};
+
+template<class Loss, class FeatureT, class LabelT>
+DecisionTree<Loss,FeatureT,LabelT>::DecisionTree(
+    const DataFrame& dataframe, int mtry, int max_height, int max_leaves, int min_obs, double max_prop, int seed,
+    const std::vector<int>& categorical, const std::vector<int>& counts
+)
+{
+    /**
+     * Train a tree on dataframe (with labels in right-most column).
+     * Hyperparameters have the same meaning as in ::DecisionTree; the columns listed in
+     * categorical must hold non-negative integer codes (throws std::invalid_argument).
+     * counts, if given, is the number of copies of each row (see DataFrame::deduplicate):
+     * every statistic, stopping rule and leaf size counts a row that many times, so a
+     * classification tree trained on the distinct rows equals the one trained on all rows.
+     */
+    assert ((dataframe.length()>0) and dataframe.width()>0);
+    assert ((max_height==-1) or (max_height>=1));
+    assert ((max_leaves==-1) or (max_leaves>=1));
+    assert ((min_obs==-1) or (min_obs>=1));
+    assert ((max_prop==-1) or ((max_prop>0) and (max_prop<=1) and Loss::classification));
+    assert ((mtry>=-1) and (mtry<dataframe.width()));
+    this->num_rows_ = dataframe.length();
+    this->num_features_ = dataframe.width()-1;
+    this->mtry_ = (mtry==-1) ? this->num_features_ : mtry;
+    this->max_height_ = max_height;
+    this->max_leaves_ = max_leaves;
+    this->min_obs_ = min_obs;
+    this->max_prop_ = max_prop;
+    this->seed_gen_ = SeedGenerator(seed);
+    // Copy features column-major and encode labels:
+    const int n = this->num_rows_;
+    this->features_.resize((size_t)n*this->num_features_);
+    this->labels_.resize(n);
+    if (counts.empty()) {
+        this->weights_.assign(n, 1);
+    } else if ((int)counts.size() == n) {
+        this->weights_.assign(counts.begin(), counts.end());
+        if (*std::min_element(counts.begin(), counts.end()) < 1) {
+            throw std::invalid_argument( "Row counts must be positive" );
+        }
+    } else {
+        throw std::invalid_argument( "Expected "+std::to_string(n)+" row counts, got "+std::to_string(counts.size()) );
+    }
+    const int total = std::accumulate(this->weights_.begin(), this->weights_.end(), 0);
+    for (int r = 0; r < n; r++)
+    {
+        const DataVector* row = dataframe.row(r);
+        for (int c = 0; c < this->num_features_; c++)
+        {
+            this->features_[(size_t)c*n + r] = (FeatureT)row->value(c);
+        }
+    }
+    this->cardinality_.assign(this->num_features_, 0);
+    for (int c : categorical)
+    {
+        if ((c<0) or (c>=this->num_features_)) {
+            throw std::invalid_argument( "Categorical column out of range: "+std::to_string(c) );
+        }
+        int cardinality = 1;
+        for (int r = 0; r < n; r++)
+        {
+            const double code = this->features_[(size_t)c*n + r];
+            if (std::isnan(code)) {
+                continue;  // Missing.
+            }
+            if (!((code>=0) and (code==(int)code))) {
+                throw std::invalid_argument( "Categorical column "+std::to_string(c)+" holds "+std::to_string(code)+" (expected a category code)" );
+            }
+            cardinality = std::max(cardinality, (int)code+1);
+        }
+        this->cardinality_[c] = cardinality;
+    }
+    if (Loss::classification) {
+        this->classes_ = dataframe.col(-1).vector();
+        std::sort(this->classes_.begin(), this->classes_.end());
+        this->classes_.erase(std::unique(this->classes_.begin(), this->classes_.end()), this->classes_.end());
+        if (this->classes_.size()-1 > (size_t)std::numeric_limits<LabelT>::max()) {
+            throw std::invalid_argument( "Too many classes for label type: "+std::to_string(this->classes_.size()) );
+        }
+        for (int r = 0; r < n; r++)
+        {
+            this->labels_[r] = std::lower_bound(this->classes_.begin(), this->classes_.end(), dataframe.value(r, -1)) - this->classes_.begin();
+        }
+        this->table_ = EntropyTable(total);
+    } else {
+        for (int r = 0; r < n; r++) { this->labels_[r] = (LabelT)dataframe.value(r, -1); }
+    }
+    // Perform training:
+    this->rows_.resize(n);
+    std::iota(this->rows_.begin(), this->rows_.end(), 0);
+    this->height_ = 0;
+    this->num_leaves_ = 1;
+    this->fit_(0, n, 0);
+    // Release training state:
+    std::vector<FeatureT>().swap(this->features_);
+    std::vector<LabelT>().swap(this->labels_);
+    std::vector<int32_t>().swap(this->weights_);
+    std::vector<int32_t>().swap(this->rows_);
+    std::vector<SortEntry<FeatureT,LabelT>>().swap(this->pairs_);
+    std::vector<Stats>().swap(this->category_stats_);
+    std::vector<int>().swap(this->category_order_);
+    std::vector<int>().swap(this->best_categories_);
+    this->table_ = EntropyTable();
+}
+
+template<class Loss, class FeatureT, class LabelT>
+int DecisionTree<Loss,FeatureT,LabelT>::getSize() const
+{
+    /** Number of nodes in tree. */
+    return this->nodes_.size();
+}
+
+template<class Loss, class FeatureT, class LabelT>
+int DecisionTree<Loss,FeatureT,LabelT>::getHeight() const
+{
+    /** Height of tree (a single leaf has height 1). */
+    return this->height_;
+}
+
+template<class Loss, class FeatureT, class LabelT>
+int DecisionTree<Loss,FeatureT,LabelT>::getNumLeaves() const
+{
+    /** Number of leaves. */
+    return this->num_leaves_;
+}
+
+template<class Loss, class FeatureT, class LabelT>
+const std::vector<Node<FeatureT>>& DecisionTree<Loss,FeatureT,LabelT>::nodes() const
+{
+    /** Trained nodes, pre-order (root at index 0). */
+    return this->nodes_;
+}
+
+template<class Loss, class FeatureT, class LabelT>
+const std::vector<uint64_t>& DecisionTree<Loss,FeatureT,LabelT>::category_words() const
+{
+    /** Category sets of categorical splits ({num_categories, bit words...} each, at Node::categories). */
+    return this->category_words_;
+}
+
+template<class Loss, class FeatureT, class LabelT>
+TreeModel DecisionTree<Loss,FeatureT,LabelT>::model() const
+{
+    /** Trained tree as a serializable model (float thresholds are widened to double). */
+    std::vector<ModelNode> nodes(this->nodes_.size());
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        const Node<FeatureT>& node = this->nodes_[i];
+        nodes[i] = ModelNode{node.feature, node.left, node.right, node.size, (double)node.threshold, node.value, node.categories, node.default_left ? 1 : 0};
+    }
+    return TreeModel(this->num_features_, !Loss::classification, nodes, this->category_words_);
+}
+
+template<class Loss, class FeatureT, class LabelT>
+int DecisionTree<Loss,FeatureT,LabelT>::fit_(int begin, int end, int depth)
+{
+    /** Grow the subtree over rows_[begin,end) (pre-order, left first) and return its index. */
+    Stats stats;
+    stats.reset(this->classes_.size());
+    for (int i = begin; i < end; i++) { stats.add(this->labels_[this->rows_[i]], this->weights_[this->rows_[i]]); }
+    const int index = this->nodes_.size();
+    Node<FeatureT> node = {-1, FeatureT(), -1, -1, 0.0, stats.size, -1, false};
+    node.value = Loss::classification ? this->classes_[(int)stats.prediction()] : (double)stats.prediction();
+    this->nodes_.push_back(node);
+    this->height_ = std::max(this->height_, depth+1);
+    // Stopping conditions (same order as ::DecisionTree::fit_):
+    const int length = stats.size;  // Rows, counting duplicates.
+    if ( stats.pure() ) {
+        return index;  // Prune if there is only one label left.
+    } else if ( length<2 ) {
+        return index;  // Prune if there is not enough data to split.
+    } else if ( (this->max_height_!=-1) and (depth+1>=this->max_height_) ) {
+        return index;  // Prune if adding children would exceed max depth.
+    } else if ( (this->max_leaves_!=-1) and (this->num_leaves_+1>=this->max_leaves_) ) {
+        return index;  // Prune if adding children would exceed max leaves.
+    } else if ( (this->min_obs_!=-1) and (length<=this->min_obs_) ) {
+        return index;  // Prune if node is below minimum leave size.
+    } else if ( (this->max_prop_!=-1) and (stats.majority()>=this->max_prop_) ) {
+        return index;  // Prune if proportion of majority label is above threshold.
+    }
+    int feature;
+    FeatureT threshold;
+    bool default_left;
+    if (!this->findBestSplit(begin, end, &feature, &threshold, &default_left)) {
+        return index;  // All columns within mtry are constant.
+    }
+    // Partition rows (stable, so children see rows in training order like DataFrame::split):
+    const int n = this->num_rows_;
+    const FeatureT* values = &this->features_[(size_t)feature*n];
+    const int cardinality = this->cardinality_[feature];
+    int32_t* mid;
+    if (cardinality > 0) {
+        std::vector<char> in_left(cardinality, 0);
+        for (int k : this->best_categories_) { in_left[k] = 1; }
+        mid = std::stable_partition(&this->rows_[begin], &this->rows_[0]+end,
+                                    [values, &in_left, default_left] (int32_t r) {
+                                        return std::isnan(values[r]) ? default_left : (in_left[(int)values[r]] != 0);
+                                    });
+        // Store the left-going set as {num_categories, bit words...}:
+        this->nodes_[index].categories = this->category_words_.size();
+        this->category_words_.push_back(cardinality);
+        this->category_words_.resize(this->category_words_.size() + (cardinality+63)/64, 0);
+        uint64_t* bits = &this->category_words_[this->nodes_[index].categories + 1];
+        for (int k : this->best_categories_) { bits[k>>6] |= (uint64_t)1 << (k&63); }
+    } else {
+        mid = std::stable_partition(&this->rows_[begin], &this->rows_[0]+end,
+                                    [values, threshold, default_left] (int32_t r) {
+                                        return std::isnan(values[r]) ? default_left : (values[r] <= threshold);
+                                    });
+    }
+    const int split = mid - &this->rows_[0];
+    if ( (split==begin) or (split==end) ) {
+        return index;  // Prune if best split does not actually split the dataset.
+    }
+    this->num_leaves_ += 1;  // Each split causes net addition of 1 leaf.
+    const int left = this->fit_(begin, split, depth+1);
+    const int right = this->fit_(split, end, depth+1);
+    this->nodes_[index].feature = feature;
+    this->nodes_[index].threshold = (cardinality > 0) ? FeatureT() : threshold;
+    this->nodes_[index].left = left;
+    this->nodes_[index].right = right;
+    this->nodes_[index].default_left = default_left;
+    return index;
+}
+
+template<class Loss, class FeatureT, class LabelT>
+bool DecisionTree<Loss,FeatureT,LabelT>::findBestSplit(int begin, int end, int* feature, FeatureT* threshold, bool* default_left)
+{
+    /**
+     * Best split over rows_[begin,end): sort each candidate column once and sweep its
+     * thresholds with Loss::split_loss inlined. Returns false if every column is constant.
+     * Rows missing the column (NaN) are counted while gathering the column and left out
+     * of the sort; every threshold is then scored with them on the right and, if there
+     * are any, on the left, and the better side becomes the node's default direction.
+     * Sending all present rows left and the missing ones right is a candidate as well.
+     */
+    // Feature order (shuffled with the same generator calls as ::DecisionTree):
+    std::vector<int> shuf_inds(this->num_features_);
+    std::iota(shuf_inds.begin(), shuf_inds.end(), 0);
+    if (this->mtry_ < this->num_features_) {
+        srand((unsigned) this->seed_gen_.new_seed());
+        for (int i = 0; i < this->num_features_; i++){
+            std::swap(shuf_inds[i], shuf_inds[i+(std::rand() % (this->num_features_-i))]);
+        }
+    }
+    const int n = this->num_rows_;
+    const int length = end-begin;
+    this->pairs_.resize(length);
+    bool first_pass = true;
+    double best_loss = 0.0;
+    Stats node, left, missing, left_missing;
+    for (int i = 0; i < this->mtry_; i++)
+    {
+        const int col = shuf_inds[i];
+        if (this->cardinality_[col] > 0) {
+            this->sweepCategories_(begin, end, col, &first_pass, &best_loss, feature, default_left);
+            continue;
+        }
+        const FeatureT* values = &this->features_[(size_t)col*n];
+        missing.reset(this->classes_.size());
+        int present = 0;
+        for (int j = 0; j < length; j++)
+        {
+            const int32_t r = this->rows_[begin+j];
+            if (std::isnan(values[r])) {
+                missing.add(this->labels_[r], this->weights_[r]);
+            } else {
+                this->pairs_[present++] = {values[r], this->labels_[r], this->weights_[r]};
+            }
+        }
+        std::sort(this->pairs_.begin(), this->pairs_.begin()+present);
+        // Node totals in sorted order (regression sums then round exactly like the sweep kernels):
+        node.reset(this->classes_.size());
+        for (int j = 0; j < present; j++) { node.add(this->pairs_[j].label, this->pairs_[j].weight); }
+        const bool has_missing = (missing.size > 0);
+        if (has_missing) { node.merge(missing); }
+        left_missing = missing;  // Set for every column, so no stale or unset stats are ever read.
+        left.reset(this->classes_.size());
+        for (int j = 0; j < present; j++)
+        {
+            left.add(this->pairs_[j].label, this->pairs_[j].weight);
+            if (has_missing) { left_missing.add(this->pairs_[j].label, this->pairs_[j].weight); }
+            const bool last = (j+1 == present);
+            if ((!last) and (this->pairs_[j+1].value == this->pairs_[j].value)) {
+                continue;  // Not a boundary between two values.
+            }
+            if ((!last) or has_missing) {
+                // Missing values go right:
+                const double loss = Loss::split_loss(left, node, this->table_);
+                if ((first_pass) or (loss<best_loss)) {
+                    first_pass = false;
+                    best_loss = loss;
+                    *feature = col;
+                    *threshold = this->pairs_[j].value;
+                    *default_left = false;
+                }
+            }
+            if ((!last) and has_missing) {
+                // Missing values go left:
+                const double loss = Loss::split_loss(left_missing, node, this->table_);
+                if (loss<best_loss) {
+                    best_loss = loss;
+                    *feature = col;
+                    *threshold = this->pairs_[j].value;
+                    *default_left = true;
+                }
+            }
+        }
+    }
+    return !first_pass;
+}
+
+template<class Loss, class FeatureT, class LabelT>
+void DecisionTree<Loss,FeatureT,LabelT>::sweepCategories_(int begin, int end, int col, bool* first_pass, double* best_loss, int* feature, bool* default_left)
+{
+    /**
+     * Best subset split of a categorical column: gather per-category statistics (and those
+     * of rows missing the column) in one pass over the node's rows, order the categories
+     * present by category_key and score every prefix of that order as the left child, with
+     * missing rows on either side as in findBestSplit. Updates best_categories_ on improvement.
+     */
+    const int n = this->num_rows_;
+    const FeatureT* values = &this->features_[(size_t)col*n];
+    const int cardinality = this->cardinality_[col];
+    this->category_stats_.resize(cardinality);
+    for (int k = 0; k < cardinality; k++) { this->category_stats_[k].reset(this->classes_.size()); }
+    Stats missing;
+    missing.reset(this->classes_.size());
+    for (int j = begin; j < end; j++)
+    {
+        const int32_t r = this->rows_[j];
+        if (std::isnan(values[r])) {
+            missing.add(this->labels_[r], this->weights_[r]);
+        } else {
+            this->category_stats_[(int)values[r]].add(this->labels_[r], this->weights_[r]);
+        }
+    }
+    const bool has_missing = (missing.size > 0);
+    Stats node;
+    node.reset(this->classes_.size());
+    this->category_order_.clear();
+    for (int k = 0; k < cardinality; k++)
+    {
+        if (this->category_stats_[k].size == 0) { continue; }
+        this->category_order_.push_back(k);
+        node.merge(this->category_stats_[k]);
+    }
+    const int num_present = this->category_order_.size();
+    if ((num_present==0) or ((num_present==1) and !has_missing)) {
+        return;  // Constant at this node.
+    }
+    if (has_missing) { node.merge(missing); }
+    const int target = Loss::classification ? (int)node.prediction() : 0;
+    std::vector<double> keys(cardinality);
+    for (int k : this->category_order_) { keys[k] = category_key(this->category_stats_[k], target); }
+    std::stable_sort(this->category_order_.begin(), this->category_order_.end(),
+                     [&keys] (int a, int b) { return keys[a] < keys[b]; });
+    Stats left, left_missing;
+    left.reset(this->classes_.size());
+    left_missing = missing;
+    for (int m = 0; m < num_present; m++)
+    {
+        const bool last = (m+1 == num_present);
+        left.merge(this->category_stats_[this->category_order_[m]]);
+        if ((!last) or has_missing) {
+            // Missing values go right:
+            const double loss = Loss::split_loss(left, node, this->table_);
+            if ((*first_pass) or (loss<*best_loss)) {
+                *first_pass = false;
+                *best_loss = loss;
+                *feature = col;
+                *default_left = false;
+                this->best_categories_.assign(this->category_order_.begin(), this->category_order_.begin()+m+1);
+            }
+        }
+        if ((!last) and has_missing) {
+            // Missing values go left:
+            left_missing.merge(this->category_stats_[this->category_order_[m]]);
+            const double loss = Loss::split_loss(left_missing, node, this->table_);
+            if (loss<*best_loss) {
+                *best_loss = loss;
+                *feature = col;
+                *default_left = true;
+                this->best_categories_.assign(this->category_order_.begin(), this->category_order_.begin()+m+1);
+            }
+        }
+    }
+}
+
+template<class Loss, class FeatureT, class LabelT>
+template<class T>
+double DecisionTree<Loss,FeatureT,LabelT>::predict(const T* observation) const
+{
+    /** Prediction for one row of feature values (label column, if any, is ignored). */
+    const Node<FeatureT>* nodes = &this->nodes_[0];
+    const uint64_t* words = this->category_words_.data();
+    int i = 0;
+    while (nodes[i].feature != -1)
+    {
+        const Node<FeatureT>& node = nodes[i];
+        const double value = observation[node.feature];
+        bool left;
+        if (std::isnan(value)) {
+            left = node.default_left;
+        } else {
+            left = (node.categories == -1) ? ((FeatureT)value <= node.threshold) : in_category_set(words + node.categories, value);
+        }
+        i = left ? node.left : node.right;
+    }
+    return nodes[i].value;
+}
+
+template<class Loss, class FeatureT, class LabelT>
+DataVector DecisionTree<Loss,FeatureT,LabelT>::predict(DataFrame* testdata) const
+{
+    /** Perform prediction sequentially on each observation and collect a vector of predictions. */
+    assert ( (testdata->width()==this->num_features_) or (testdata->width()==this->num_features_+1) );
+    DataVector predictions = DataVector(false);  // is_row=false.
+    std::vector<double> observation(this->num_features_);
+    for (int r = 0; r < testdata->length(); r++)
+    {
+        const DataVector* row = testdata->row(r);
+        for (int c = 0; c < this->num_features_; c++) { observation[c] = row->value(c); }
+        predictions.addValue(this->predict(&observation[0]));
+    }
+    return predictions;
+}
+
+
+/*
+ * RUNTIME-CONFIGURED WRAPPER :
+ */
+
+
+class AnyTree
+{
+    /** Type-erased typed::DecisionTree, as returned by make_tree(). */
+
+public:
+
+    virtual ~AnyTree() {}
+
+    // Getters:
+    virtual int getSize() const = 0;  // Number of nodes in tree.
+    virtual int getHeight() const = 0;  // Height of tree.
+    virtual std::string name() const = 0;  // Loss and types of the instantiation.
+    virtual TreeModel model() const = 0;  // Trained tree as a serializable model.
+
+    // Utilities:
+    virtual double predict(const double* observation) const = 0;  // Prediction for one row.
+    virtual DataVector predict(DataFrame* testdata) const = 0;  // Perform prediction sequentially on each observation.
+
+};
+
+template<class Tree>
+class AnyTreeImpl : public AnyTree
+{
+    /** AnyTree holding one concrete instantiation. */
+
+private:
+
+    // Attributes:
+    Tree tree_;  // The wrapped tree.
+    std::string name_;  // Loss and types of the instantiation.
+
+public:
+
+    AnyTreeImpl(Tree&& tree, const std::string& name) : tree_(std::move(tree)), name_(name) {}
+    const Tree& tree() const { return this->tree_; }
+    int getSize() const override { return this->tree_.getSize(); }
+    int getHeight() const override { return this->tree_.getHeight(); }
+    std::string name() const override { return this->name_; }
+    TreeModel model() const override { return this->tree_.model(); }
+    double predict(const double* observation) const override { return this->tree_.predict(observation); }
+    DataVector predict(DataFrame* testdata) const override { return this->tree_.predict(testdata); }
+
+};
+
+// Train the instantiation matching the runtime arguments (same arguments as ::DecisionTree).
+// single_precision stores features as float instead of double; categorical lists the
+// columns to split by category subset; counts holds the copies of each (deduplicated) row.
+std::unique_ptr<AnyTree> make_tree(
+    const DataFrame& dataframe, bool regression=false, std::string loss="gini_impurity",
+    int mtry=-1, int max_height=-1, int max_leaves=-1, int min_obs=-1,
+    double max_prop=-1, int seed=-1, bool single_precision=false,
+    const std::vector<int>& categorical=std::vector<int>(),
+    const std::vector<int>& counts=std::vector<int>()
+);
+
+}  // namespace typed
+
+#endif
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <iomanip>
+#include <omp.h>
+
+// This program always builds with tracing (src/trace.hpp):
+#ifndef PDT_TRACE
+#define PDT_TRACE
+#endif
+
+// Include the PARALLEL modules
+#include "src-openmp/datasets.cpp"
+#include "src-openmp/losses.cpp"
+#include "src/simd.cpp"
+#include "src/impurity.cpp"
+#include "src/bitsets.cpp"
+#include "src-openmp/metrics.cpp"
+#include "src-openmp/tree_node.cpp"
+#include "src-openmp/decision_tree.cpp"
+#include "src-openmp/cv.cpp"
+
+/*
+ * Timeline of a parallel fit, a parallel predict and a parallel 4-fold CV, written as
+ * Chrome trace JSON (open in chrome://tracing or https://ui.perfetto.dev). Events:
+ *   fit_tree, expand_node (arg: depth)           tree construction, nested by node
+ *   find_best_split, split_feature (arg: column)  split search; one split_feature per OpenMP task
+ *   partition (arg: column)                       DataFrame::split and child bitsets
+ *   predict                                       each thread's share of the rows
+ *   cv_fold (arg: fold)                           one fold (its tree's events nest inside)
+ * Gaps between events of a thread are time it spent waiting or outside the traced code.
+ *
+ *   ./trace_fit [--dataset hmeq] [--depth 8] [--threads N] [--out trace_fit.json]
+ */
+
+int main(int argc, char** argv) {
+    std::string dataset = "hmeq";
+    std::string output = "trace_fit.json";
+    int depth = 8;
+    int threads = omp_get_max_threads();
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool has_value = (i + 1 < argc);
+        if ((arg == "--dataset") and has_value) { dataset = argv[++i]; }
+        else if ((arg == "--depth") and has_value) { depth = std::stoi(argv[++i]); }
+        else if ((arg == "--threads") and has_value) { threads = std::stoi(argv[++i]); }
+        else if ((arg == "--out") and has_value) { output = argv[++i]; }
+        else {
+            std::cerr << "Error: Unknown or incomplete option: " << arg << std::endl;
+            return 1;
+        }
+    }
+    omp_set_num_threads(threads);
+    std::cout << "=== Trace of Parallel Fit / Predict / CV ===" << std::endl;
+    std::cout << "Dataset: " << dataset << ", depth: " << depth << ", threads: " << threads << std::endl;
+
+    DataFrame data = DataLoader("data/" + dataset + "_clean.csv").load();
+    std::vector<DataFrame> split_data = data.train_test_split(0.2, 42);
+    DataFrame train_data = split_data[0];
+    DataFrame test_data = split_data[1];
+
+    // Warm up (untraced), then trace one of each:
+    DecisionTree warmup_tree(train_data, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+    Tracer::clear();
+    auto start = std::chrono::high_resolution_clock::now();
+    DecisionTree tree(train_data, false, "gini_impurity", -1, depth, -1, 1, -1, 42);
+    DataVector predictions = tree.predict(&test_data);
+    CrossValidator validator(train_data, 4, 42);
+    CVResult cv_result = validator.validateDepth(depth, dataset);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << std::endl;
+
+    try {
+        const size_t events = Tracer::write_chrome_json(output);
+        std::cout << "Traced " << std::fixed << std::setprecision(2) << std::chrono::duration<double, std::milli>(end - start).count()
+                  << "ms: " << events << " events (" << Tracer::dropped() << " dropped), tree of " << tree.getSize()
+                  << " nodes, test accuracy " << std::setprecision(4) << accuracy(test_data.col(-1), predictions)
+                  << ", CV accuracy " << cv_result.mean_cv_accuracy << std::endl;
+        std::cout << "Trace saved to " << output << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}